@@ -22,7 +22,7 @@ const unsigned char wifi_disconnected_bits[] PROGMEM = {
   0x01, 0x01, 0x00, 0x00 };
 
 // ==========================================
-// Face types (drawn with primitives in main.cpp)
+// Face types (drawn with primitives in pipeline_steps.cpp)
 // ==========================================
 #define FACE_HAPPY       0
 #define FACE_THIRSTY     1
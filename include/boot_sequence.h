@@ -0,0 +1,126 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <stdint.h>
+#include "stage_profiler.h"
+
+// ==========================================
+// NON-BLOCKING BOOT (network bring-up and reconnects)
+// ==========================================
+// setup() only starts local hardware and shows a face from the last-known
+// thresholds. The network comes up in the background: the network task
+// calls step() on every wake-up and runs the action it returns.
+//
+//   LINK_FAST  join the cached AP directly (BSSID + channel, no scan)
+//   LINK_SCAN  normal join by SSID (fast join failed, or no cache yet)
+//   LINK_WAIT  gave up for now; rejoin after a backoff
+//   AUTH       link is up: sign in to the backend
+//   AUTH_WAIT  sign-in failed; retry after a backoff
+//   ONLINE     signed in: fetch thresholds, open the stream, start uploading
+//
+// The same machine brings the network back after a drop. Losing the link
+// from ONLINE goes to LINK_WAIT, losing the backend to AUTH_WAIT, and
+// reaching ONLINE again re-runs the sync. Each failed join or sign-in in a
+// row doubles the wait (backoffMinMs up to backoffMaxMs), and each wait is
+// drawn from its upper half so a rack of units that lost the same AP don't
+// all come back at the same instant. Sensing and the face never wait for
+// any of this; they run in their own tasks.
+//
+// Pure logic (no Arduino/WiFi calls), so a boot or a flapping network can
+// be replayed on the host with scripted linkUp/cloudReady inputs.
+
+struct BootTimeouts {
+  uint32_t fastLinkMs;   // Give up on the cached BSSID/channel after this
+  uint32_t scanLinkMs;   // Give up on a full join after this
+  uint32_t authRetryMs;  // Give up on a sign-in if the backend isn't ready by then
+  uint32_t backoffMinMs; // First wait after a failed attempt or a drop
+  uint32_t backoffMaxMs; // Longest wait between attempts
+};
+
+enum BootStage : uint8_t {
+  BOOT_START = 0,
+  BOOT_LINK_FAST,
+  BOOT_LINK_SCAN,
+  BOOT_LINK_WAIT,
+  BOOT_AUTH,
+  BOOT_AUTH_WAIT,
+  BOOT_ONLINE
+};
+
+enum BootAction : uint8_t {
+  BOOT_ACT_NONE = 0,
+  BOOT_ACT_CONNECT_FAST,  // WiFi.begin(ssid, pass, channel, bssid)
+  BOOT_ACT_CONNECT_SCAN,  // WiFi.begin(ssid, pass)
+  BOOT_ACT_AUTH,          // cloud.begin()
+  BOOT_ACT_SYNC           // Fetch thresholds, open the stream (once, on reaching ONLINE)
+};
+
+// Milliseconds since reset; 0 = not reached yet
+struct BootMetrics {
+  uint32_t firstFaceMs;
+  uint32_t linkMs;
+  uint32_t cloudMs;
+  uint32_t firstUploadMs;
+  bool     fastLink;      // Joined through the cached BSSID/channel
+};
+
+// Connectivity once the first connection is made
+struct LinkMetrics {
+  uint32_t     drops;            // ONLINE lost (link or backend)
+  uint32_t     attempts;         // Joins and sign-ins started, boot included
+  uint32_t     failures;         // Joins and sign-ins that timed out
+  uint64_t     trackedMs;        // Since the first time ONLINE
+  uint64_t     onlineMs;         // Of which ONLINE
+  uint32_t     lastOutageMs;
+  uint32_t     longestOutageMs;
+  LogHistogram reconnectMs;      // Drop → ONLINE again
+
+  // Share of the tracked time spent ONLINE, 0..1 (1 before the first drop)
+  float uptime() const { return trackedMs ? (float)((double)onlineMs / trackedMs) : 1.0f; }
+};
+
+class BootSequence {
+public:
+  explicit BootSequence(const BootTimeouts &t) : t(t) {}
+
+  // Call before the first step(): start with LINK_FAST if an AP is cached.
+  // seed varies the backoff jitter between units (any value but 0).
+  void setCachedAp(bool have) { cachedAp = have; }
+  void setSeed(uint32_t seed)  { if (seed) rng = seed; }
+
+  BootAction step(bool linkUp, bool cloudReady, uint32_t nowMs);
+
+  BootStage stage() const  { return current; }
+  bool      online() const { return current == BOOT_ONLINE; }
+  // Time left before the next attempt (LINK_WAIT / AUTH_WAIT), else 0
+  uint32_t  retryInMs(uint32_t nowMs) const;
+
+  // Record the user-visible milestones (first call wins)
+  void markFirstFace(uint32_t nowMs)   { if (!metrics.firstFaceMs) metrics.firstFaceMs = nowMs ? nowMs : 1; }
+  void markFirstUpload(uint32_t nowMs) { if (!metrics.firstUploadMs) metrics.firstUploadMs = nowMs ? nowMs : 1; }
+
+  BootMetrics metrics = {0, 0, 0, 0, false};
+  LinkMetrics link    = {};
+
+private:
+  BootAction enter(BootStage s, uint32_t nowMs);
+  BootAction fail(BootStage wait, uint32_t nowMs);   // Attempt timed out: back off
+  BootAction drop(BootStage wait, uint32_t nowMs);   // Lost ONLINE: back off, start the outage
+  BootAction reachOnline(uint32_t nowMs);
+  BootAction retryLink(uint32_t nowMs);
+  void       account(uint32_t nowMs);
+  uint32_t   nextRandom();
+
+  BootTimeouts t;
+  bool         cachedAp = false;
+  BootStage    current  = BOOT_START;
+  uint32_t     since    = 0;   // When the current stage began
+  uint32_t     waitMs   = 0;   // Backoff of the current LINK_WAIT / AUTH_WAIT
+  uint8_t      failed   = 0;   // Failed attempts in a row (sets the backoff)
+  bool         tracking = false;
+  uint32_t     lastStep = 0;
+  uint32_t     outageStart = 0;
+  uint32_t     rng      = 0x9E3779B9u;
+};
+
+#endif
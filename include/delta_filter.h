@@ -0,0 +1,65 @@
+#ifndef DELTA_FILTER_H
+#define DELTA_FILTER_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// ==========================================
+// FIELD-LEVEL DELTA UPLOADS
+// ==========================================
+// Remembers the last value uploaded for each telemetry field and reports
+// which fields have moved past their deadband, so the network task only
+// writes what changed. A heartbeat re-sends everything at a maximum interval
+// so the app can tell a quiet plant from a dead device.
+
+// A field counts as changed when |new - last| > max(absolute, relative × |last|)
+struct Deadband {
+  float absolute;
+  float relative;
+};
+
+struct DeltaConfig {
+  Deadband      deadband[FIELD_COUNT];
+  unsigned long heartbeatMs;   // Send every field at least this often
+};
+
+// Upload accounting, reset by the caller whenever it reports
+struct DeltaStats {
+  uint32_t samples;     // Samples offered to the filter
+  uint32_t requests;    // Writes actually issued
+  uint32_t fullBytes;   // Payload bytes a full write per sample would have cost
+  uint32_t sentBytes;   // Payload bytes actually sent
+};
+
+// Field accessors shared with the cloud backends
+float       telemetryFieldValue(const Telemetry &t, int field);
+void        telemetrySetField(Telemetry &t, int field, float v);   // Int fields are rounded
+const char *telemetryFieldKey(int field);   // RTDB key, e.g. "soil_moisture"
+
+// JSON body size of a single-plant write containing `mask` (+ timestamp)
+size_t telemetryPayloadBytes(const Telemetry &t, uint8_t mask);
+
+class DeltaFilter {
+public:
+  DeltaFilter() : cfg{} {}   // For arrays (one per plant); assign a configured one before use
+  explicit DeltaFilter(const DeltaConfig &cfg) : cfg(cfg) {}
+
+  // Fields that need uploading now (FIELD_MASK_ALL on first use / heartbeat, 0 = skip)
+  uint8_t changedFields(const Telemetry &t, unsigned long nowMs) const;
+
+  // Call after a successful upload of `mask`
+  void commit(const Telemetry &t, uint8_t mask, unsigned long nowMs);
+
+  // Bookkeeping for the savings report
+  void account(const Telemetry &t, uint8_t mask);
+
+  DeltaStats stats = {0, 0, 0, 0};
+
+private:
+  DeltaConfig   cfg;
+  float         last[FIELD_COUNT];
+  bool          primed = false;
+  unsigned long lastFullMs = 0;
+};
+
+#endif
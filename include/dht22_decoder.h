@@ -0,0 +1,49 @@
+#ifndef DHT22_DECODER_H
+#define DHT22_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==========================================
+// DHT22 PULSE-TRAIN DECODER (pure)
+// ==========================================
+// Turns a captured waveform into a reading. No hardware access, so it can be
+// fed recorded or synthetic pulse trains anywhere.
+//
+// Expected waveform after the host's start pulse:
+//   response: LOW ~80 µs, HIGH ~80 µs
+//   40 bits:  LOW ~50 µs, then HIGH ~26-28 µs (0) or ~70 µs (1)
+//   data bytes: RH hi, RH lo, T hi (bit 7 = sign), T lo, checksum
+
+enum DhtStatus {
+  DHT_OK = 0,
+  DHT_ERR_NO_RESPONSE,   // No 80/80 µs response found
+  DHT_ERR_TIMING,        // A bit pulse was outside the protocol windows
+  DHT_ERR_SHORT,         // Waveform ended before 40 bits
+  DHT_ERR_CHECKSUM,      // Sum of the data bytes doesn't match
+  DHT_ERR_RANGE,         // Decoded but physically impossible (RH > 100 %)
+  DHT_ERR_TIMEOUT,       // Driver: nothing captured
+  DHT_PENDING            // Driver: no reading yet
+};
+
+struct DhtPulse {
+  uint8_t  level;        // 0 = line low, 1 = line high
+  uint16_t us;           // Duration in microseconds
+};
+
+struct DhtReading {
+  float     temperature;  // °C
+  float     humidity;     // %
+  DhtStatus status;
+  uint32_t  timestampMs;  // millis() when the frame was captured (set by the driver)
+};
+
+// Raw 5 data bytes from a pulse train
+DhtStatus dhtDecodeBits(const DhtPulse *pulses, size_t count, uint8_t bytes[5]);
+
+// Full decode: bits, checksum, scaling and range check. out.timestampMs is untouched.
+DhtStatus dht22Decode(const DhtPulse *pulses, size_t count, DhtReading &out);
+
+const char *dhtStatusName(DhtStatus status);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef DHT22_RMT_H
+#define DHT22_RMT_H
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#include "dht22_decoder.h"
+
+// ==========================================
+// NON-BLOCKING DHT22 DRIVER (RMT capture)
+// ==========================================
+// The Adafruit library bit-bangs the protocol with interrupts disabled for
+// ~5 ms. Here the start pulse is timed by an esp_timer and the pulse train
+// is captured by the RMT peripheral in the background, so start() and poll()
+// both return immediately:
+//
+//   start()  - pull the line low, arm a 1.2 ms one-shot timer
+//   (timer)  - start RMT RX and release the line; the sensor answers
+//   poll()   - if a frame landed in the RMT ring buffer, decode it
+//
+// The DHT22 can't be sampled faster than every 2 s; start() enforces that.
+
+#define DHT22_MIN_INTERVAL_MS 2000
+
+class Dht22Rmt {
+public:
+  Dht22Rmt(uint8_t pin, rmt_channel_t channel) : pin((gpio_num_t)pin), channel(channel) {}
+
+  bool begin();
+  bool start();                     // false if busy or called too soon
+  bool poll(DhtReading &out);       // true when a new frame was decoded (valid or not)
+  bool busy() const { return state != IDLE; }
+
+  const DhtReading &last() const { return lastValid; }  // Most recent DHT_OK reading
+
+  uint32_t frames = 0;
+  uint32_t errors = 0;
+
+private:
+  enum State : uint8_t { IDLE, HOLD_LOW, CAPTURING };
+
+  static void onStartPulseDone(void *arg);
+
+  gpio_num_t         pin;
+  rmt_channel_t      channel;
+  RingbufHandle_t    ring  = NULL;
+  esp_timer_handle_t timer = NULL;
+  volatile State     state = IDLE;
+  uint32_t           startedMs = 0;
+  bool               everStarted = false;
+  DhtReading         lastValid = { NAN, NAN, DHT_PENDING, 0 };
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==========================================
+// LOW-POWER DUTY CYCLE (pure scheduling logic)
+// ==========================================
+// Battery units don't run the two pipeline tasks. They wake on a timer, take
+// one sample, and sleep again. The radio only comes up when an upload is
+// due. DutyCycle decides what each wake does and for how long to sleep. It
+// also keeps an energy ledger. It holds no hardware state: the board supplies
+// a PowerHal (hal.h) to actually sleep, so the same logic runs on the host.
+//
+// All of DutyCycleState is plain data, meant to live in RTC memory
+// (RTC_DATA_ATTR) so it survives deep sleep. millis() restarts on every deep
+// sleep wake, so the scheduler keeps its own clock: awake time + slept time.
+
+struct DutyCycleConfig {
+  uint32_t samplePeriodMs;   // Wake-to-wake period
+  uint32_t uploadPeriodMs;   // Bring the radio up at least this often
+  uint8_t  batchMax;         // ...or as soon as this many samples are waiting
+  uint32_t lightSleepMaxMs;  // Shorter sleeps use light sleep (RAM kept, faster wake)
+};
+
+enum SleepKind : uint8_t {
+  SLEEP_LIGHT = 0,
+  SLEEP_DEEP
+};
+
+struct SleepPlan {
+  SleepKind kind;
+  uint32_t  ms;
+};
+
+// Average supply current (mA) in each state, for the budget estimate.
+// Rough numbers: measure your own board for real figures.
+struct PowerModel {
+  float awakeMa;             // CPU + sensors, radio off
+  float radioMa;             // WiFi associated + TLS
+  float lightSleepMa;
+  float deepSleepMa;         // Includes whatever stays powered (OLED, probe)
+};
+
+struct EnergyLedger {
+  uint32_t cycles;
+  uint32_t uploads;
+  uint64_t awakeUs;          // Includes radioUs
+  uint64_t radioUs;
+  uint64_t lightSleepUs;
+  uint64_t deepSleepUs;
+
+  float    mAh(const PowerModel &m) const;
+  float    averageMa(const PowerModel &m) const;
+};
+
+struct DutyCycleState {
+  uint32_t     magic;          // DUTY_CYCLE_MAGIC once initialized
+  uint64_t     clockMs;        // Scheduler clock (survives deep sleep)
+  uint32_t     clockRemUs;     // Sub-millisecond awake time not yet in clockMs
+  uint64_t     lastAttemptMs;  // Start of the last wake that brought the radio up
+  bool         attempted;
+  bool         lastFailed;     // Offline: retry only once per upload period
+  EnergyLedger ledger;
+};
+
+#define DUTY_CYCLE_MAGIC 0x47414941u  // "GAIA"
+
+class DutyCycle {
+public:
+  DutyCycle(const DutyCycleConfig &cfg, DutyCycleState &state) : cfg(cfg), st(state) {}
+
+  // False after a cold boot or power loss: RTC memory holds garbage
+  bool resumed() const { return st.magic == DUTY_CYCLE_MAGIC; }
+  void reset();
+
+  uint64_t nowMs(uint32_t awakeUs) const { return st.clockMs + (st.clockRemUs + (uint64_t)awakeUs) / 1000; }
+
+  // Should this wake bring the radio up? `pending` samples are waiting;
+  // `urgent` (e.g. the face changed) skips the wait for a full batch.
+  bool uploadDue(size_t pending, bool urgent, uint32_t awakeUs) const;
+
+  // Close the cycle: book the time, advance the clock and return how long to
+  // sleep so wake-ups stay one samplePeriodMs apart
+  SleepPlan finish(bool attempted, bool uploaded, uint32_t awakeUs, uint32_t radioUs);
+
+  const EnergyLedger &ledger() const { return st.ledger; }
+
+private:
+  DutyCycleConfig cfg;
+  DutyCycleState &st;
+};
+
+#endif
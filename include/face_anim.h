@@ -0,0 +1,115 @@
+#ifndef FACE_ANIM_H
+#define FACE_ANIM_H
+
+#include <Arduino.h>
+#include "face_cache.h"
+#include "oled_frame.h"
+#include "stage_profiler.h"
+
+// ==========================================
+// FACE ANIMATION (blink, breathing, dissolve)
+// ==========================================
+// Animates the cached faces (face_cache.h) at a fixed frame rate. Each frame
+// is built column by column: a column of the 128x64 panel is one 64-bit word
+// (its 8 page bytes), so every effect is a few shifts and masks:
+//   - blink:      the eye band is squashed toward the eye line and back,
+//                 every blinkGapMs on average (jittered so it looks alive)
+//   - breathing:  the face sinks up to breathPx rows and rises again
+//   - transition: a new face dissolves in through a 4x4 ordered-dither mask
+// The status bar rows (0..11) are rasterized by the caller whenever they
+// change and laid over every frame unmoved.
+//
+// render() first works out the frame's inputs (face, dissolve level, lid
+// position, breath offset, status bar). If they match the previous frame,
+// nothing is drawn and nothing needs to go over I2C, which is most frames.
+// Plain C++ apart from LogHistogram, so it builds on the host.
+
+struct AnimConfig {
+  uint16_t frameMs;        // Frame period (33 ≈ 30 fps)
+  uint16_t blinkMs;        // Lids closing and opening again
+  uint16_t blinkGapMs;     // Mean time between blinks (each gap 0.5-1.5x)
+  uint16_t blinkFaces;     // Bit per FACE_* whose eyes blink
+  uint16_t breathMs;       // One breath
+  uint8_t  breathPx;       // How far the face sinks at the bottom of a breath
+  uint16_t transitionMs;   // Dissolve from one face to the next
+};
+
+// Eye band: the rows and columns a blink squashes (eye line at y=28)
+#define ANIM_EYE_ROW    28
+#define ANIM_EYE_TOP    16
+#define ANIM_EYE_BOTTOM 40
+#define ANIM_EYE_LEFT   30
+#define ANIM_EYE_RIGHT  98
+
+class FaceAnimator {
+public:
+  FaceAnimator(const FaceCache &faces, const AnimConfig &cfg) : faces(faces), cfg(cfg) {}
+
+  // Show `face` from now on. A different face dissolves in over transitionMs;
+  // the first call just shows it.
+  void setFace(int face, unsigned long nowMs);
+
+  // Take rows 0..11 (status bar and divider) of a rendered framebuffer
+  void setStatusBar(const uint8_t *frame);
+
+  // Build the frame for nowMs into `frame` (OLED_FRAME_BYTES). Returns false,
+  // leaving `frame` untouched, if it would equal the last frame rendered.
+  bool render(unsigned long nowMs, uint8_t *frame);
+
+  int  face() const { return target; }
+  bool transitioning() const { return from >= 0; }
+
+private:
+  // Everything a frame depends on; equal keys mean equal frames
+  struct FrameKey {
+    int8_t   face;
+    int8_t   from;        // -1 = no transition
+    uint8_t  level;       // Dissolve, 0..16
+    uint8_t  lid;         // Blink, 0 (open)..ANIM_EYE_ROW - ANIM_EYE_TOP (shut)
+    uint8_t  breath;      // Rows the face sinks
+    uint32_t status;      // setStatusBar() calls
+  };
+
+  FrameKey frameKey(unsigned long nowMs);
+  uint32_t nextRandom();
+
+  const FaceCache &faces;
+  AnimConfig    cfg;
+  int8_t        target = -1;
+  int8_t        from   = -1;
+  unsigned long transitionStart = 0;
+  unsigned long blinkStart      = 0;
+  unsigned long nextBlink       = 0;
+  bool          blinkArmed      = false;
+  uint16_t      status[OLED_COLUMNS] = {};   // Rows 0..11 per column
+  uint32_t      statusVersion   = 0;
+  FrameKey      last            = { -1, -1, 0, 0, 0, 0 };
+  bool          drawn           = false;
+  uint32_t      rng             = 0x9E3779B9u;
+};
+
+// Frame timing of the animation task against its frame period
+class FrameBudget {
+public:
+  void begin(uint32_t periodUs) { this->periodUs = periodUs; }
+
+  // Every tick, drawn or not. A tick that starts more than half a period
+  // behind schedule is late (the task was starved or the last frame overran).
+  void tick(uint32_t nowUs);
+  // A drawn frame: render and I2C flush times
+  void record(uint32_t renderUs, uint32_t flushUs);
+  void reset();
+
+  uint32_t     periodUs = 0;
+  uint32_t     ticks    = 0;
+  uint32_t     drawn    = 0;   // Frames that changed (the rest cost nothing)
+  uint32_t     overruns = 0;   // Render + flush longer than the period
+  uint32_t     late     = 0;
+  LogHistogram renderUs;
+  LogHistogram flushUs;
+
+private:
+  uint32_t lastTickUs = 0;
+};
+
+#endif
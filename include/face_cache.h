@@ -0,0 +1,39 @@
+#ifndef FACE_CACHE_H
+#define FACE_CACHE_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "oled_frame.h"
+
+// ==========================================
+// PRE-RASTERIZED FACES
+// ==========================================
+// Each FACE_* is drawn once at boot (with the same primitives as before) and
+// kept as SSD1306 pages 1..7. The face area is y=12..63, so rows 8..11 of
+// page 1 are masked off for the status bar divider. A frame is then just a
+// memcpy plus the status bar.
+
+#define FACE_COUNT      9
+#define FACE_FIRST_PAGE 1
+#define FACE_PAGES      (OLED_PAGES - FACE_FIRST_PAGE)
+#define FACE_TOP_ROW    12
+
+class FaceCache {
+public:
+  // render(face) must draw one face onto screen.canvas() (already cleared)
+  void build(DisplayHal &screen, void (*render)(int face));
+
+  // Clear the status bar pages and copy the cached face into the framebuffer
+  void compose(int face, uint8_t *frame) const;
+
+  bool ready() const { return built; }
+
+  // Pages 1..7 of one face, FACE_PAGES × OLED_COLUMNS bytes (face_anim.h)
+  const uint8_t *facePages(int face) const { return &pages[face][0][0]; }
+
+private:
+  uint8_t pages[FACE_COUNT][FACE_PAGES][OLED_COLUMNS];
+  bool    built = false;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef FACE_RULES_H
+#define FACE_RULES_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "delta_filter.h"
+#include "plant_rack.h"
+
+// ==========================================
+// FACE CLASSIFIER (RULE TABLE)
+// ==========================================
+// The face is picked from an ordered table of rules instead of an if/else
+// chain. Each rule compares one telemetry field against one threshold and
+// latches with hysteresis: it trips when the value crosses the threshold and
+// only clears once the value is back inside by the rule's band. A rule must
+// also hold its new state for `dwellMs` before it counts, so a reading that
+// hovers on a boundary can't flicker the face.
+//
+// The active rule with the lowest priority wins (table order breaks ties);
+// no active rule = FACE_HAPPY. Listeners are called only when the face
+// actually changes.
+//
+// Every plant of the rack (plant_rack.h) is classified in one pass: rule by
+// rule, over all plants. Rule latches are kept as plant bitmasks, so picking
+// each plant's winner is a handful of mask operations.
+
+#define FACE_NONE          0xFF   // "from" of the first event after boot
+#define FACE_RULE_COUNT    8      // Entries in FACE_RULES (face_rules.cpp)
+#define FACE_MAX_LISTENERS 4
+
+enum FaceComparator {
+  CMP_BELOW = 0,   // Trips when value < threshold
+  CMP_ABOVE        // Trips when value > threshold
+};
+
+struct FaceRule {
+  uint8_t       field;       // TelemetryField
+  uint8_t       cmp;         // FaceComparator
+  uint8_t       threshold;   // ThresholdField
+  uint8_t       face;        // FACE_*
+  uint8_t       priority;    // 0 = most urgent
+  Deadband      hysteresis;  // Clears at threshold ∓ max(absolute, relative × |threshold|)
+  unsigned long dwellMs;     // New state must hold this long to take effect
+};
+
+// Emitted on every face change
+struct FaceEvent {
+  uint8_t       plant;       // Index into the plant table
+  uint8_t       from;        // Previous FACE_* (FACE_NONE on the first one)
+  uint8_t       to;          // New FACE_*
+  int8_t        rule;        // Index of the winning rule, -1 = all clear
+  unsigned long atMs;
+};
+
+extern const FaceRule FACE_RULES[FACE_RULE_COUNT];
+
+typedef void (*FaceListener)(const FaceEvent &ev);
+
+struct FaceRuleStats {
+  uint32_t evaluations;  // Samples classified
+  uint32_t transitions;  // Face changes emitted
+  uint32_t debounced;    // Rule flips abandoned before their dwell time ran out
+};
+
+const char *faceName(int face);   // "happy", "thirsty", ... (RTDB status value)
+
+class FaceClassifier {
+public:
+  FaceClassifier();
+
+  // Register a callback for face changes (false if the table is full)
+  bool subscribe(FaceListener listener);
+
+  // Update every rule for every plant in the rack and store the faces in
+  // rack.face[]. Returns a mask of the plants whose face changed (listeners
+  // already notified). NAN readings leave their rules as they were.
+  uint32_t evaluate(PlantRack &rack, unsigned long nowMs);
+
+  uint8_t face(uint8_t plant) const { return current[plant]; }
+
+  FaceRuleStats stats = {0, 0, 0};
+
+private:
+  // Bit p of a mask = plant p
+  uint32_t      active[FACE_RULE_COUNT];
+  uint32_t      pending[FACE_RULE_COUNT];         // Candidate flip waiting out its dwell time
+  unsigned long pendingSince[FACE_RULE_COUNT][MAX_PLANTS];
+  uint8_t       current[MAX_PLANTS];
+  FaceListener  listeners[FACE_MAX_LISTENERS];
+  uint8_t       listenerCount = 0;
+  uint32_t      primed = 0;  // A plant's first sample applies without dwell
+};
+
+#endif
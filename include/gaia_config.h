@@ -0,0 +1,115 @@
+#ifndef GAIA_CONFIG_H
+#define GAIA_CONFIG_H
+
+#include <Arduino.h>
+#include "bitmaps.h"
+#include "boot_sequence.h"
+#include "delta_filter.h"
+#include "duty_cycle.h"
+#include "face_anim.h"
+#include "sensor_schedule.h"
+
+// ==========================================
+// PIPELINE CONFIGURATION
+// ==========================================
+// The tuning values of the sample → face → frame → upload path. The
+// firmware (main.cpp), the host tests and benchmarks in test/ and the tools/
+// simulators all include this file, so they run with the same values.
+// Board wiring, credentials and the backend stay in section 1 of main.cpp.
+
+// NETWORK BRING-UP (boot_sequence.h)
+// Join, sign-in and reconnect timeouts; the network task steps through them.
+const BootTimeouts BOOT_TIMEOUTS = {
+  /* fastLinkMs   */ 3000,    // Cached BSSID/channel join normally takes < 1 s
+  /* scanLinkMs   */ 20000,
+  /* authRetryMs  */ 15000,
+  /* backoffMinMs */ 2000,    // Doubles per failed attempt in a row...
+  /* backoffMaxMs */ 120000   // ...up to 2 min
+};
+
+// SAMPLE TICK
+// The sensor task runs once per period; each sensor is read on its own
+// period within it (SENSE_CONFIG below).
+#define SAMPLE_PERIOD_MS     1000
+
+// OLED
+#define OLED_PLANT_PERIOD_MS 5000   // With several plants, the screen shows each one this long
+
+// FACE ANIMATION (face_anim.h): 30 fps, a blink every ~4 s, one breath per
+// 4 s. X_X, sleeping and squinting eyes don't blink.
+const AnimConfig ANIM_CONFIG = {
+  33,      // frameMs
+  180,     // blinkMs
+  4000,    // blinkGapMs
+  0xFFFF & ~((1 << FACE_THIRSTY) | (1 << FACE_DARK) | (1 << FACE_BRIGHT)),   // blinkFaces
+  4000,    // breathMs
+  1,       // breathPx
+  400,     // transitionMs
+};
+
+// ADAPTIVE SAMPLING (sensor_schedule.h)
+// Each plant's sensors are read on their own period within the 1 s tick:
+// fast near a threshold, slower while readings hold still. readUs is what a
+// read keeps the sensor's wire or bus busy (estimates, for the savings report).
+// Light's near band is narrow: at 10% of a 100..2000 lux span, 0 lux at night
+// would count as near lux low and be read every second until morning.
+const SenseConfig SENSE_CONFIG[SENSE_COUNT] = {
+  // fixedMs baseMs fastMs slowMs maxAgeMs near   stable readUs
+  {  2000,   2000,  2000,  8000,  20000,  0.10f, 0.02f, 5700 },   // Air: DHT22 start pulse + 40-bit frame
+  {  1000,   5000,  1000,  60000, 180000, 0.10f, 0.02f, 0    },   // Soil: the ADC DMA runs anyway
+  {  1000,   2000,  1000,  10000, 30000,  0.03f, 0.02f, 250  },   // Light: BH1750 (+ mux) I2C read
+};
+
+// DELTA UPLOADS (delta_filter.h)
+// Only fields that moved past their deadband are written. Everything is
+// re-sent at least once per heartbeat. Used by the always-on build only with
+// LIVE_UPLOADS 1 (off by default), and by low-power mode's batched uploads.
+const DeltaConfig DELTA_CONFIG = {
+  {
+    /* temperature   */ { 0.2f, 0.0f  },   // °C
+    /* humidity      */ { 1.0f, 0.0f  },   // %
+    /* soil_moisture */ { 1.0f, 0.0f  },   // %
+    /* soil_raw      */ { 40.0f, 0.0f },   // ADC counts
+    /* light         */ { 5.0f, 0.05f },   // lux, or 5% of the last value
+  },
+  /* heartbeatMs */ 60000
+};
+
+// OFFLINE LOG (sample_log.h)
+// Samples that can't be uploaded go to flash at a reduced rate and are
+// replayed into /plants/<id>/history in batched writes later.
+#define OFFLINE_LOG_INTERVAL_MS 10000  // One logged sample per 10 s while offline
+#define BACKLOG_BATCH           64     // Samples per catch-up request
+
+// LOW-POWER MODE (duty_cycle.h, GAIA_LOW_POWER builds)
+#define LP_SAMPLE_PERIOD_MS    60000    // One sample per minute
+#define LP_UPLOAD_PERIOD_MS    900000   // Radio up at least every 15 min...
+#define LP_BATCH_MAX           15       // ...or once this many samples wait
+#define LP_LIGHT_SLEEP_MAX_MS  5000     // Shorter sleeps use light sleep
+
+const DutyCycleConfig DUTY_CONFIG = {
+  LP_SAMPLE_PERIOD_MS, LP_UPLOAD_PERIOD_MS, LP_BATCH_MAX, LP_LIGHT_SLEEP_MAX_MS
+};
+
+// Typical ESP32-WROOM figures. The lit OLED (~4 mA showing a face) and the
+// DHT22/probe idle current are counted in deep sleep, because they stay powered.
+const PowerModel POWER_MODEL = {
+  /* awakeMa      */ 35.0f,
+  /* radioMa      */ 120.0f,
+  /* lightSleepMa */ 5.0f,
+  /* deepSleepMa  */ 4.2f
+};
+
+// WINDOWED SUMMARIES (window_stats.h)
+#define STATS_MINUTE_MS      60000     // Short window
+#define STATS_HOUR_MS        3600000   // Long window (a multiple of the short one)
+#define STATS_PENDING_MAX    32        // Held while offline; minutes are dropped first
+// 1 = also stream the live fields at the sample rate (delta-filtered).
+// 0 (the default) = the live fields get the last minute's means, once a
+// minute, and the delta filter does not run in the always-on build.
+// tools/delta_replay compares the two on a recorded trace.
+#ifndef LIVE_UPLOADS
+#define LIVE_UPLOADS         0
+#endif
+
+#endif
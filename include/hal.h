@@ -0,0 +1,172 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "plant_thresholds.h"
+
+// ==========================================
+// HARDWARE ABSTRACTION LAYER
+// ==========================================
+// main.cpp only reaches the sensors, the OLED and the cloud through these
+// interfaces. The ESP32 implementations live in hal_esp32.h; anything else
+// (fakes, replay drivers) just has to implement the same virtuals.
+
+// One row of telemetry as it is uploaded to /plants/<id>
+struct Telemetry {
+  float         temperature;   // °C
+  float         humidity;      // %
+  int           soilMoisture;  // % (calibrated)
+  int           soilRaw;       // Raw ADC counts
+  float         lux;           // lux (clamped to >= 0)
+  unsigned long timestamp;     // millis() uptime
+};
+
+// Telemetry fields, for partial (delta) uploads. The timestamp is always sent.
+enum TelemetryField {
+  FIELD_TEMPERATURE = 0,
+  FIELD_HUMIDITY,
+  FIELD_SOIL_MOISTURE,
+  FIELD_SOIL_RAW,
+  FIELD_LIGHT,
+  FIELD_COUNT
+};
+
+#define FIELD_BIT(f)   (1u << (f))
+#define FIELD_MASK_ALL ((1u << FIELD_COUNT) - 1)
+
+// A sample replayed from the offline log; seq is its position in the log and
+// doubles as a stable, ordered key under /plants/<id>/history. data.timestamp
+// is millis() of boot number `boot`, so it only compares within one boot.
+struct LoggedSample {
+  uint32_t  seq;
+  uint8_t   plant;
+  uint32_t  boot;
+  Telemetry data;
+};
+
+// One board can serve several plants (plant_rack.h); every reading is per
+// plant. Plants that share a sensor simply get the same value.
+class SensorHal {
+public:
+  virtual ~SensorHal() {}
+  virtual bool    begin() = 0;
+  virtual uint8_t plantCount() = 0;
+  virtual float   readTemperature(uint8_t plant) = 0;  // °C, NAN on failure
+  virtual float   readHumidity(uint8_t plant) = 0;     // %, NAN on failure
+  virtual int     readMoistureRaw(uint8_t plant) = 0;  // ADC counts (filtered where the board supports it)
+  virtual int     readMoisturePercent(uint8_t plant) = 0;  // 0..100, calibrated
+  virtual float   readLux(uint8_t plant) = 0;          // lux, negative on failure
+  // millis() when the air values returned by readTemperature()/readHumidity()
+  // were measured; the DHT22 answers in the background, so they can be a read old
+  virtual unsigned long airReadingMs(uint8_t plant) = 0;
+
+  // Low-power mode: beginOneShot() replaces begin(); then one sampleOnce()
+  // per wake takes a fresh reading of every sensor before the read*() calls.
+  // Sensors stay idle (or powered down) in between.
+  virtual bool    beginOneShot() = 0;
+  virtual bool    sampleOnce() = 0;       // false if any sensor failed
+};
+
+class DisplayHal {
+public:
+  virtual ~DisplayHal() {}
+  virtual bool          begin() = 0;
+  virtual Adafruit_GFX &canvas() = 0;   // 128x64 drawing surface
+  virtual void          clear() = 0;
+  virtual void          flush() = 0;    // Push the whole framebuffer to the panel
+  // Raw 128x64 framebuffer behind canvas(), SSD1306 layout: 8 pages × 128
+  // column bytes, LSB = top row of the page
+  virtual uint8_t      *framebuffer() = 0;
+  // Send columns col0..col1 of one page; returns bytes put on the bus
+  virtual size_t        writeRegion(uint8_t page, uint8_t col0, uint8_t col1) = 0;
+};
+
+// Sleep control for the low-power mode (duty_cycle.h)
+class PowerHal {
+public:
+  virtual ~PowerHal() {}
+  virtual bool     wokeFromDeepSleep() = 0;
+  virtual uint64_t nowUs() = 0;                // Since boot / deep sleep wake
+  virtual void     lightSleep(uint32_t ms) = 0;  // Returns after ms, RAM intact
+  virtual void     deepSleep(uint32_t ms) = 0;   // Never returns; wakes into setup()
+};
+
+// Heap health, sampled by the firmware and reported periodically. A largest
+// free block far below the free total means the heap is fragmenting.
+struct HeapStats {
+  uint32_t freeBytes;
+  uint32_t largestBlock;   // Biggest single allocation that would succeed
+  uint32_t minFreeBytes;   // Low-water mark since boot
+  unsigned long uptimeMs;
+};
+
+// Timing summary of one profiled stage (stage_profiler.h), in µs
+struct StageSummary {
+  const char *name;
+  uint32_t    count;
+  uint32_t    p50Us;
+  uint32_t    p95Us;
+  uint32_t    maxUs;
+};
+
+// Cloud transport counters since boot (times in ms)
+struct TransportStats {
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t retries;             // Writes re-sent on a fresh connection
+  uint32_t pipelined;           // Requests sent without waiting for the one before
+  uint32_t connects;
+  uint32_t fullHandshakes;
+  uint32_t resumedHandshakes;   // TLS session resumed: no key exchange
+  uint32_t fullHandshakeMs;     // Means
+  uint32_t resumedHandshakeMs;
+  uint32_t latencyP50Ms;        // Request sent → answer read
+  uint32_t latencyP95Ms;
+  uint32_t latencyMaxMs;
+};
+
+struct WindowSummary;   // window_stats.h
+struct ThirstForecast;  // thirst_forecast.h
+
+// Plant-scoped calls take an index into the plant table the backend was
+// built with (its RTDB node is /plants/<id>).
+class CloudHal {
+public:
+  virtual ~CloudHal() {}
+  virtual bool   begin() = 0;           // Sign in; true if auth succeeded
+  virtual bool   linkUp() = 0;          // Network link (WiFi) is up
+  virtual bool   ready() = 0;           // Authenticated and able to talk to the backend
+  // Partial write of every plant's fields in fieldMasks[plant] (+ timestamp),
+  // as one request; plants with a 0 mask are skipped. Other children of the
+  // plant nodes (thresholds, profile, ...) are left untouched.
+  virtual bool   uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t plants) = 0;
+  virtual bool   uploadBacklog(const LoggedSample *samples, size_t count) = 0;  // One request
+  // Current face ("happy", "thirsty", ...) and when it was entered (millis())
+  virtual bool   uploadFaceState(uint8_t plant, const char *face, unsigned long sinceMs) = 0;
+  // Closed window statistics, each under <id>/stats/<window>/<boot>_<index>; one request
+  virtual bool   uploadSummaries(const WindowSummary *summaries, size_t count) = 0;
+  // Every plant's /forecast node (one entry per plant), one request
+  virtual bool   uploadForecasts(const ThirstForecast *forecasts, uint8_t plants) = 0;
+  // Device health under the first plant's node (/diagnostics)
+  virtual bool   uploadHeapStats(const HeapStats &heap) = 0;
+  virtual bool   uploadStageSummaries(const StageSummary *stages, uint8_t count) = 0;  // .../diagnostics/stages
+  virtual bool   uploadTransportStats(const TransportStats &stats) = 0;                // .../diagnostics/transport
+  virtual TransportStats transportStats() = 0;
+  // Threshold reads don't wait for their answer: requestThresholds() sends
+  // the read, and the answer comes back with the next upload (or
+  // finishRequests()). takeThresholds() returns true once the read is over,
+  // with `ok` false if it failed. Keys missing from the node keep the
+  // values passed to requestThresholds().
+  virtual bool   requestThresholds(uint8_t plant, const PlantThresholds &current) = 0;
+  virtual void   finishRequests() = 0;
+  virtual bool   takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) = 0;
+  // Server-push threshold sync for plant 0: open once, then poll cheaply.
+  // poll returns true when pushed changes were applied to `out`.
+  virtual bool   beginThresholdStream() = 0;
+  virtual bool   pollThresholdStream(PlantThresholds &out) = 0;
+  virtual bool   thresholdStreamAlive() = 0;
+  virtual String lastError() = 0;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef HAL_ESP32_H
+#define HAL_ESP32_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+#include <BH1750.h>
+#include <Adafruit_SSD1306.h>
+#include "hal.h"
+#include "dht22_rmt.h"
+#include "soil_moisture.h"
+#include "plant_rack.h"
+#include "rtdb_rest.h"
+#include "mqtt_client.h"
+
+// ==========================================
+// ESP32 BOARD IMPLEMENTATIONS
+// ==========================================
+
+// DHT22 (air, RMT capture) + capacitive soil probe on ADC1 (DMA) + BH1750 (light) on I2C,
+// per plant of the table (plant_rack.h). Each distinct DHT22 pin gets its own
+// RMT channel; BH1750s behind the TCA9548A mux sit at 0x5C (ADDR->VCC) so
+// they never collide with the main-bus one at 0x23.
+// Air readings are non-blocking: each read returns the newest valid DHT22
+// frame (captured in the background), or NAN if there is none recent.
+// Moisture reads return the latest background-filtered value.
+class Esp32Sensors : public SensorHal {
+public:
+  // `plants` must stay valid (normally the static table in main.cpp)
+  Esp32Sensors(const PlantConfig *plants, uint8_t count, int dryRaw, int wetRaw);
+  bool    begin() override;
+  uint8_t plantCount() override { return count; }
+  float   readTemperature(uint8_t plant) override;
+  float   readHumidity(uint8_t plant) override;
+  int     readMoistureRaw(uint8_t plant) override;
+  int     readMoisturePercent(uint8_t plant) override;
+  float   readLux(uint8_t plant) override;
+  unsigned long airReadingMs(uint8_t plant) override { return dht[dhtOf[plant]]->last().timestampMs; }
+  bool    beginOneShot() override;
+  bool    sampleOnce() override;
+
+  SoilMoistureAdc &moistureProbe() { return moisture; }  // Calibration access
+
+private:
+  bool    beginDhts();
+  bool    beginLight(BH1750::Mode mode);
+  bool    airFresh(uint8_t dht);
+  float   measureLux(uint8_t plant);
+  void    selectMux(int8_t channel);   // NO_PIN = all mux channels off
+
+  const PlantConfig *plants;
+  uint8_t         count;
+  uint8_t         moisturePins[MAX_PLANTS];
+  Dht22Rmt       *dht[MAX_PLANTS];     // One per distinct pin (RMT channel = index)
+  int8_t          dhtPins[MAX_PLANTS];
+  uint8_t         dhtCount = 0;
+  uint8_t         dhtOf[MAX_PLANTS];   // Plant → dht[] index
+  BH1750          lightMeter;          // Main bus, shared
+  BH1750          muxMeters[MAX_PLANTS];
+  SoilMoistureAdc moisture;
+  int             dryRaw;   // Calibration defaults until NVS has saved points
+  int             wetRaw;
+  bool            oneShot = false;
+  float           oneShotLux[MAX_PLANTS];
+};
+
+// Timer wake-ups via esp_sleep
+class Esp32Power : public PowerHal {
+public:
+  bool     wokeFromDeepSleep() override;
+  uint64_t nowUs() override;
+  void     lightSleep(uint32_t ms) override;
+  void     deepSleep(uint32_t ms) override;
+};
+
+// SSD1306 on the shared I2C bus (tries the primary address, then 0x3D).
+// Transfers run at i2cHz; many modules take 800 kHz-1 MHz, well past the
+// 400 kHz the BH1750s allow, so the clock is raised only while the OLED
+// holds the bus. Safe to flush from another task than the sensor reads.
+class Ssd1306Display : public DisplayHal {
+public:
+  Ssd1306Display(uint8_t width, uint8_t height, uint8_t addr, uint32_t i2cHz = 400000);
+  bool          begin() override;
+  Adafruit_GFX &canvas() override { return oled; }
+  void          clear() override  { oled.clearDisplay(); }
+  void          flush() override;
+  uint8_t      *framebuffer() override { return oled.getBuffer(); }
+  size_t        writeRegion(uint8_t page, uint8_t col0, uint8_t col1) override;
+
+private:
+  Adafruit_SSD1306 oled;
+  uint8_t          addr;
+  uint32_t         i2cHz;
+};
+
+// Firebase RTDB. The Mobizt client does the anonymous sign-up, keeps the
+// ID token fresh and runs the thresholds stream. Every plant of the table is
+// a node under /plants. Per-cycle writes for all of them go out as one
+// multi-path update at /plants. Writes and threshold reads go through
+// RtdbRest (rtdb_rest.h) on one resumable TLS session, with the reads
+// pipelined ahead of the next write.
+class FirebaseCloud : public CloudHal {
+public:
+  FirebaseCloud(const char *apiKey, const char *databaseUrl, const char *caCert,
+                const PlantConfig *plants, uint8_t count);
+  bool   begin() override;
+  bool   linkUp() override;
+  bool   ready() override;
+  bool   uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t plants) override;
+  bool   uploadBacklog(const LoggedSample *samples, size_t count) override;
+  bool   uploadFaceState(uint8_t plant, const char *face, unsigned long sinceMs) override;
+  bool   uploadSummaries(const WindowSummary *summaries, size_t count) override;
+  bool   uploadForecasts(const ThirstForecast *forecasts, uint8_t plants) override;
+  bool   uploadHeapStats(const HeapStats &heap) override;
+  bool   uploadStageSummaries(const StageSummary *stages, uint8_t count) override;
+  bool   uploadTransportStats(const TransportStats &stats) override;
+  TransportStats transportStats() override;
+  bool   requestThresholds(uint8_t plant, const PlantThresholds &current) override;
+  void   finishRequests() override { rest.finish(); }
+  bool   takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) override;
+  bool   beginThresholdStream() override;
+  bool   pollThresholdStream(PlantThresholds &out) override;
+  bool   thresholdStreamAlive() override { return streamOK; }
+  String lastError() override;
+
+private:
+  enum FetchState : uint8_t { FETCH_IDLE, FETCH_SENT, FETCH_DONE, FETCH_FAILED };
+  struct ThresholdFetch {
+    PlantThresholds value;
+    FetchState      state;
+  };
+
+  static void onThresholds(void *ctx, int status, const char *body, size_t len);
+  static void applyThresholdsJson(FirebaseJson &json, PlantThresholds &out);
+  static bool applyThresholdKey(const char *key, FirebaseData &data, PlantThresholds &out);
+  void        plantPath(uint8_t plant, const char *child, char *out, size_t len) const;  // "/plants/gaia_01<child>"
+  bool        patch(const char *path, RtdbRest::BodyWriter body, const void *ctx);
+
+  FirebaseData       stream;      // Dedicated connection for plant 0's thresholds SSE stream
+  FirebaseAuth       auth;
+  FirebaseConfig     config;
+  RtdbRest           rest;        // Writes + threshold reads
+  ThresholdFetch     fetches[MAX_PLANTS];
+  const char        *apiKey;
+  const char        *databaseUrl;
+  const char        *caCert;      // For RtdbRest; NULL = the public roots
+  const PlantConfig *plants;
+  uint8_t            count;
+  bool               signupOK = false;
+  bool               streamOK = false;
+};
+
+struct MqttConfig {
+  const char *brokerUrl;      // "mqtts://host[:port]"
+  const char *user;           // "" = anonymous
+  const char *password;
+  uint8_t     telemetryQos;   // Live samples: 0 = fire and forget, 1 = acknowledged
+  const char *caCert;         // PEM of a private CA; NULL = the public roots
+};
+
+// An MQTT broker instead of the RTDB REST API (mqtt_client.h), for dense
+// deployments: one session, then a few dozen bytes per sample. A bridge on
+// the broker side (e.g. a rule writing to the RTDB) forwards the topics to
+// the app. Every plant has its own under gaia/<id>/:
+//   telemetry       CBOR sample (cborTelemetry), changed fields only  telemetryQos
+//   history/<seq>   CBOR, replayed offline log (cborLoggedSample)    QoS 1
+//   face            {"face":..,"face_since":..}, retained            QoS 1
+//   thresholds      retained, written by the app; subscribed         QoS 1
+// and the first plant carries the rest of the device's writes:
+//   update          multi-path update relative to /plants, exactly
+//                   the RTDB backend's body (summaries, forecasts)   QoS 1
+//   diagnostics[/stages|/transport]  retained                        QoS 0
+// QoS 1 writes return once the broker has acknowledged all of them.
+class MqttCloud : public CloudHal {
+public:
+  MqttCloud(const MqttConfig &config, const PlantConfig *plants, uint8_t count);
+  bool   begin() override;
+  bool   linkUp() override;
+  bool   ready() override { return mqtt.connected(); }
+  bool   uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t plants) override;
+  bool   uploadBacklog(const LoggedSample *samples, size_t count) override;
+  bool   uploadFaceState(uint8_t plant, const char *face, unsigned long sinceMs) override;
+  bool   uploadSummaries(const WindowSummary *summaries, size_t count) override;
+  bool   uploadForecasts(const ThirstForecast *forecasts, uint8_t plants) override;
+  bool   uploadHeapStats(const HeapStats &heap) override;
+  bool   uploadStageSummaries(const StageSummary *stages, uint8_t count) override;
+  bool   uploadTransportStats(const TransportStats &stats) override;
+  TransportStats transportStats() override;
+  bool   requestThresholds(uint8_t plant, const PlantThresholds &current) override;
+  void   finishRequests() override;
+  bool   takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) override;
+  bool   beginThresholdStream() override;
+  bool   pollThresholdStream(PlantThresholds &out) override;
+  bool   thresholdStreamAlive() override { return streamOK && mqtt.connected(); }
+  String lastError() override { return String(mqtt.lastError()); }
+
+private:
+  enum FetchState : uint8_t { FETCH_IDLE, FETCH_SENT, FETCH_DONE, FETCH_FAILED };
+  struct ThresholdFetch {
+    PlantThresholds value;    // Last known, with every pushed change applied
+    FetchState      state;
+  };
+
+  static void onMessage(void *ctx, const char *topic, size_t topicLen, const uint8_t *payload, size_t len);
+  void        plantTopic(uint8_t plant, const char *child, char *out, size_t len) const;  // "gaia/gaia_01/<child>"
+  bool        subscribeThresholds(uint16_t plantMask);
+
+  MqttClient         mqtt;
+  MqttConfig         config;
+  ThresholdFetch     fetches[MAX_PLANTS];
+  const PlantConfig *plants;
+  uint8_t            count;
+  uint16_t           subscribed = 0;     // Plants whose thresholds topic this session listens to
+  bool               streamOK    = false;
+  bool               streamDirty = false;   // Plant 0 changed since the last poll
+};
+
+#endif
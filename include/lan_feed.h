@@ -0,0 +1,102 @@
+#ifndef LAN_FEED_H
+#define LAN_FEED_H
+
+#include <Arduino.h>
+#include "face_rules.h"
+#include "plant_rack.h"
+#include "telemetry_json.h"
+
+// ==========================================
+// LAN FEED (live samples + face changes for local dashboards)
+// ==========================================
+// Dashboards on the same network subscribe to the device directly instead
+// of waiting for the cloud round trip. Every sample and face change is
+// serialized to JSON once, into a byte log that keeps the most recent
+// messages (LAN_FEED_BYTES, at most LAN_FEED_ENTRIES of them). Each
+// subscriber only has a cursor into that log:
+//   - pump() hands each subscriber the messages after its cursor, until
+//     the transport says that client is busy (its send queue is full)
+//   - a subscriber that falls so far behind that its next message has
+//     been overwritten skips ahead to the oldest one kept; the gap shows
+//     in the message seq numbers and in the `lagged` count
+// So a slow phone only ever costs its own messages, and publishing never
+// waits for anyone. The log doubles as the recent history in snapshots.
+//
+// Not thread-safe: the caller serializes publish*, attach/detach, pump and
+// writeSnapshot (main.cpp holds a mutex). Plain C++, so it builds on the host.
+
+#define LAN_FEED_BYTES     8192   // Message log (a 1-plant sample is ~150 B)
+#define LAN_FEED_ENTRIES   64     // Messages kept at most
+#define LAN_FEED_MSG_MAX   1280   // Largest message: a sample of MAX_PLANTS plants
+#define LAN_FEED_CLIENTS   64     // Subscriber slots (the transport may allow fewer)
+
+struct LanFeedStats {
+  uint32_t published;     // Messages put in the log
+  uint32_t oversize;      // Messages over LAN_FEED_MSG_MAX, not published
+  uint32_t delivered;     // Messages handed to the transport, all clients
+  uint32_t busy;          // pump() stops at a busy client
+  uint32_t lagged;        // Messages slow clients skipped
+  uint32_t attached;      // Subscribers ever accepted
+  uint32_t refused;       // Subscribers turned away (all slots taken)
+  uint8_t  clients;       // Subscribed now
+  uint8_t  peakClients;
+};
+
+class LanFeed {
+public:
+  // Hand one message to a subscriber; false = its queue is full, try again later
+  typedef bool (*Send)(void *ctx, uint8_t client, const char *msg, size_t len);
+
+  // maxClients is capped at LAN_FEED_CLIENTS
+  void configure(const PlantConfig *plants, uint8_t count, uint8_t maxClients);
+
+  // {"type":"sample","seq":N,"plants":{"<id>":{<telemetry>},...}}
+  void publishSample(const RackSample &s);
+  // {"type":"face","seq":N,"plant":"<id>","face":"thirsty","from":"happy","at_ms":T}
+  void publishFace(const FaceEvent &ev);
+
+  // A new subscriber gets messages published from now on. Returns its
+  // slot, or -1 if every slot is taken.
+  int  attach();
+  void detach(uint8_t client);
+
+  // Deliver what each subscriber hasn't had yet. Returns the messages sent.
+  uint32_t pump(Send send, void *ctx);
+
+  // {"seq":N,"uptime_ms":T,"thresholds":{"<id>":{...}},"faces":{"<id>":"happy"},
+  //  "recent":[<messages in the log, oldest first>]}
+  // seq is the newest message included; live messages continue from seq + 1.
+  void writeSnapshot(JsonOut &out, const ThresholdSet &thresholds, unsigned long nowMs) const;
+
+  uint32_t            newestSeq() const { return next - 1; }   // 0 = nothing published yet
+  const LanFeedStats &stats() const     { return st; }
+
+private:
+  struct Entry {
+    uint16_t offset;
+    uint16_t length;
+  };
+
+  struct Subscriber {
+    bool     active;
+    uint32_t next;   // Seq of the next message to send
+  };
+
+  void         append(const char *msg, size_t len);
+  const Entry &entry(uint32_t seq) const { return entries[seq % LAN_FEED_ENTRIES]; }
+
+  const PlantConfig *plants     = NULL;
+  uint8_t            count      = 0;
+  uint8_t            maxClients = 0;
+  uint8_t            faces[MAX_PLANTS];
+  char               log[LAN_FEED_BYTES];
+  Entry              entries[LAN_FEED_ENTRIES];
+  uint32_t           first    = 1;   // Oldest seq still in the log
+  uint32_t           next     = 1;   // Seq the next message gets
+  uint16_t           writePos = 0;
+  char               scratch[LAN_FEED_MSG_MAX];
+  Subscriber         subs[LAN_FEED_CLIENTS] = {};
+  LanFeedStats       st = {};
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include "mqtt_packet.h"
+#include "tls_session.h"
+#include "stage_profiler.h"
+
+// ==========================================
+// MQTT CLIENT (persistent session, no heap per message)
+// ==========================================
+// The REST client pays a request line, headers and the ~1 KB ID token on
+// every write, plus a response. Over MQTT the session is authenticated once
+// by CONNECT; after that a sample is one PUBLISH of a few dozen bytes and,
+// at QoS 0, no answer at all. Packets stream through a fixed buffer over a
+// resumable TLS session (tls_session.h), with a counting pass for the
+// Remaining Length, as in rtdb_rest.h.
+//
+// QoS 1 publishes don't wait for their PUBACK: awaitAcks() collects them,
+// so a batch of messages costs one round trip. Packets from the broker
+// (PUBLISHes on subscribed topics included) are read whenever the client
+// waits for something, and by service() in between.
+
+#define MQTT_TX_BUFFER    512
+#define MQTT_RX_BUFFER    512     // Largest incoming PUBLISH (a thresholds node is ~250 B)
+#define MQTT_INFLIGHT     16      // QoS 1 publishes + SUBSCRIBEs awaiting their ack
+#define MQTT_TIMEOUT_MS   5000
+#define MQTT_KEEPALIVE_S  60      // Pinged after half of it without hearing from the broker
+
+// Session accounting, kept since boot
+struct MqttStats {
+  uint32_t     published;    // PUBLISH packets sent
+  uint32_t     acked;        // PUBACKs received
+  uint32_t     received;     // PUBLISH packets from the broker
+  uint32_t     failures;     // Refused connects, lost sessions, missing acks
+  uint32_t     pipelined;    // QoS 1 packets sent with an earlier one unacknowledged
+  uint32_t     txBytes;
+  uint32_t     rxBytes;
+  LogHistogram latencyMs;    // PUBLISH → PUBACK, SUBSCRIBE → SUBACK, PINGREQ → PINGRESP
+};
+
+class MqttClient {
+public:
+  // Fills the payload; called twice per message (count, then send)
+  typedef void (*BodyWriter)(JsonOut &out, const void *ctx);
+  // A PUBLISH from the broker; topic is not terminated
+  typedef void (*Handler)(void *ctx, const char *topic, size_t topicLen, const uint8_t *payload, size_t len);
+
+  // brokerUrl "mqtts://host[:port]" (port 8883 if omitted). Empty user = anonymous.
+  // caCert: PEM of a private CA to trust instead of the public roots (NULL).
+  void begin(const char *brokerUrl, const char *clientId, const char *user, const char *password,
+             const char *caCert = NULL);
+  void onMessage(Handler handler, void *ctx);
+
+  // TLS connect + CONNECT; true once the broker accepted the session
+  bool connect();
+  bool connected() const { return session; }
+
+  // QoS 0 returns once the packet is written; QoS 1 once it is sent, with
+  // the PUBACK read by a later awaitAcks()
+  bool publish(const char *topic, BodyWriter body, const void *ctx, uint8_t qos, bool retain);
+  bool subscribe(const char *const *filters, uint8_t n, uint8_t qos);
+
+  // Read until every QoS 1 publish and SUBSCRIBE is acknowledged
+  bool awaitAcks();
+  // PINGREQ, then read until its PINGRESP. The broker handles packets in
+  // order, so whatever was sent before has been processed by then.
+  bool roundTrip();
+  // Handle what has arrived and keep the session alive; doesn't wait
+  bool service();
+
+  void        stop();   // DISCONNECT, then close (the TLS session is kept for resumption)
+  const char *lastError() const { return error; }
+  const MqttStats &stats() const { return st; }
+  const TlsStats  &tlsStats() const { return tls.stats(); }
+
+private:
+  struct Inflight {
+    uint16_t      packetId;
+    unsigned long sentMs;
+  };
+
+  bool     readPacket();          // Next packet into rx (blocks up to MQTT_TIMEOUT_MS)
+  void     handlePacket();
+  void     track(uint16_t packetId);
+  void     acked(uint16_t packetId);
+  bool     sendPing();
+  uint16_t nextPacketId();
+  bool     fail(const char *reason);
+  void     drop();
+  static bool drain(void *ctx, const char *data, size_t len);
+
+  TlsSession    tls;
+  char          host[64] = "";
+  uint16_t      port = 8883;
+  const char   *clientId = "";
+  const char   *user     = "";
+  const char   *password = "";
+  Handler       handler = NULL;
+  void         *handlerCtx = NULL;
+  bool          session = false;
+  char          tx[MQTT_TX_BUFFER];
+  uint8_t       rx[MQTT_RX_BUFFER];
+  uint8_t       rxHeader = 0;
+  size_t        rxLen = 0;           // Kept bytes of the body
+  bool          rxTruncated = false;
+  char          error[40] = "";
+  Inflight      inflight[MQTT_INFLIGHT];
+  uint8_t       inflightCount = 0;
+  uint16_t      packetId = 0;
+  unsigned long lastRxMs   = 0;
+  unsigned long pingSentMs = 0;
+  bool          pingOut    = false;  // PINGREQ sent, PINGRESP not yet read
+  MqttStats     st = {};
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_json.h"
+
+// ==========================================
+// MQTT 3.1.1 PACKET CODEC
+// ==========================================
+// Just the packets a sensor needs: CONNECT, PUBLISH (QoS 0/1), PUBACK,
+// SUBSCRIBE, PINGREQ and DISCONNECT out; CONNACK, PUBLISH, PUBACK, SUBACK
+// and PINGRESP in. Packets are written into a JsonOut, so they can stream
+// straight to the socket through its drain. Plain C++: the host benchmark
+// (tools/transport_bench) links the same code.
+
+enum MqttPacketType : uint8_t {
+  MQTT_CONNECT    = 1,
+  MQTT_CONNACK    = 2,
+  MQTT_PUBLISH    = 3,
+  MQTT_PUBACK     = 4,
+  MQTT_SUBSCRIBE  = 8,
+  MQTT_SUBACK     = 9,
+  MQTT_PINGREQ    = 12,
+  MQTT_PINGRESP   = 13,
+  MQTT_DISCONNECT = 14
+};
+
+#define MQTT_TYPE(header) ((uint8_t)(header) >> 4)
+
+// Clean session; user/password left out when empty
+void mqttConnect(JsonOut &out, const char *clientId, const char *user, const char *password,
+                 uint16_t keepAliveS);
+// Fixed header, topic and (QoS 1) packet id; the caller writes payloadLen bytes after it
+void mqttPublishHead(JsonOut &out, const char *topic, size_t payloadLen, uint8_t qos, bool retain,
+                     uint16_t packetId);
+void mqttSubscribe(JsonOut &out, uint16_t packetId, const char *const *filters, uint8_t n, uint8_t qos);
+void mqttPuback(JsonOut &out, uint16_t packetId);
+void mqttPingreq(JsonOut &out);
+void mqttDisconnect(JsonOut &out);
+
+// Remaining Length, one byte at a time: 1 = complete (value set), 0 = more
+// bytes follow, -1 = malformed (over 4 bytes). Start with value = count = 0.
+int mqttLengthByte(uint8_t byte, uint32_t &value, uint8_t &count);
+
+// An incoming PUBLISH; topic and payload point into the packet body
+struct MqttPublish {
+  const char    *topic;
+  size_t         topicLen;
+  const uint8_t *payload;
+  size_t         length;
+  uint16_t       packetId;   // 0 for QoS 0
+  uint8_t        qos;
+  bool           retain;
+};
+
+// header = first byte of the packet, body = everything after the Remaining Length
+bool mqttParsePublish(uint8_t header, const uint8_t *body, size_t len, MqttPublish &out);
+
+// An incoming PUBACK, SUBACK or PINGRESP
+struct MqttAck {
+  uint8_t  type;       // MQTT_PUBACK, MQTT_SUBACK or MQTT_PINGRESP
+  uint16_t packetId;   // 0 for PINGRESP
+  uint8_t  refused;    // SUBACK: filters the broker refused (return code 0x80)
+};
+
+// False for other packets and for acks with the wrong flags or length
+bool mqttParseAck(uint8_t header, const uint8_t *body, size_t len, MqttAck &out);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef OLED_FRAME_H
+#define OLED_FRAME_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// ==========================================
+// FRAME DIFF + DIRTY-PAGE FLUSH
+// ==========================================
+// The SSD1306 framebuffer is 8 pages of 128 column bytes (each byte = 8
+// vertical pixels). FrameFlusher keeps a copy of what the panel currently
+// shows and only sends the changed column span of each page, so an
+// unchanged frame costs no I2C traffic at all.
+
+#define OLED_PAGES        8
+#define OLED_COLUMNS      128
+#define OLED_FRAME_BYTES  (OLED_PAGES * OLED_COLUMNS)
+// What a full Adafruit display() puts on the bus: 1024 data bytes plus the
+// addressing commands and per-chunk address/control bytes (for comparison)
+#define OLED_FULL_FRAME_I2C_BYTES 1050
+
+struct DirtySpan {
+  int16_t first;  // First changed column (first > last = page is clean)
+  int16_t last;   // Last changed column
+};
+
+// Pure diff: fills spans[] for every page and returns the number of dirty pages
+uint8_t frameDiff(const uint8_t *frame, const uint8_t *shown, DirtySpan spans[OLED_PAGES]);
+
+class FrameFlusher {
+public:
+  // Send whatever changed in screen.framebuffer(); returns I2C bytes sent
+  size_t flush(DisplayHal &screen);
+  // Forget what the panel shows (after a full display() elsewhere)
+  void   invalidate() { valid = false; }
+
+  // Running totals for reporting
+  uint32_t frames        = 0;
+  uint32_t cleanFrames   = 0;  // Frames that needed no I2C traffic
+  uint32_t i2cBytes      = 0;
+
+private:
+  alignas(4) uint8_t shown[OLED_FRAME_BYTES];  // Word-compared in frameDiff()
+  bool    valid = false;
+};
+
+#endif
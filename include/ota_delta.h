@@ -0,0 +1,135 @@
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==========================================
+// DELTA FIRMWARE PATCHES (format + streaming applier)
+// ==========================================
+// A new image is sent as the difference to the image already running,
+// bsdiff style: most of a rebuilt firmware is the old code with shifted
+// addresses, so "new = old + small difference" bytes compress far better
+// than the image itself. The patch body is a stream of records
+//   addLen, copyLen, seek          LEB128 varints (seek zigzag-signed)
+//   addLen bytes                   new[i] = old[oldPos + i] + byte
+//   copyLen bytes                  new bytes as they are
+// after which the old position moves by seek. The records are interleaved
+// (bsdiff keeps three separate streams), so the patch applies front to back
+// as it arrives. The whole body is LZ-compressed: a bit stream, MSB first,
+// of literals (1 + 8 bits) and matches (0 + 12-bit distance - 1 + Elias
+// gamma of length - DELTA_MIN_MATCH + 1) into the last 4 KB of output.
+//
+// A patch against nothing (oldSize 0) is the compressed full image; the
+// update server sends that to devices whose image it doesn't know.
+//
+// The header is a signed manifest: it names the image the patch applies to
+// and the SHA-256 of the image it makes, and it is followed by a signature
+// block, a 16-bit length and the DER ECDSA P-256 signature of the header's
+// SHA-256, zero-padded. Signing the header covers the image, which has to
+// hash to newId before it can boot. The body follows the block.
+//
+// Images are identified the way ESP-IDF does (esp_partition_get_sha256):
+// the SHA-256 appended to the image, or of the whole image without one.
+// Plain C++: the host tools (tools/ota_delta) link the same code.
+
+#define DELTA_MAGIC        "GDLT"
+#define DELTA_VERSION      2
+#define DELTA_HEADER_SIZE  84
+#define DELTA_SIG_MAX      72     // Longest DER encoding of a P-256 signature
+#define DELTA_SIG_SIZE     (2 + DELTA_SIG_MAX)
+#define DELTA_PREFIX_SIZE  (DELTA_HEADER_SIZE + DELTA_SIG_SIZE)   // Before the body
+#define DELTA_ID_LEN       32
+#define DELTA_WINDOW_BITS  12
+#define DELTA_WINDOW       (1u << DELTA_WINDOW_BITS)
+#define DELTA_MIN_MATCH    3
+#define DELTA_MAX_MATCH    (DELTA_MIN_MATCH + 65534)   // Gamma code of at most 31 bits
+#define DELTA_OUT_CHUNK    1024   // New image bytes per write
+#define DELTA_OLD_CHUNK    256    // Old image bytes per read
+
+// Header, little-endian:
+//   0  "GDLT"  4 version  5 window bits  6 reserved (2)
+//   8  oldSize  12 oldId (32)  44 newSize  48 newId (32)  80 bodySize
+// then the signature block:
+//   84 signature length  86 signature (DELTA_SIG_MAX, zero-padded)
+struct DeltaHeader {
+  uint32_t oldSize;                 // 0 = no base image
+  uint8_t  oldId[DELTA_ID_LEN];
+  uint32_t newSize;
+  uint8_t  newId[DELTA_ID_LEN];
+  uint32_t bodySize;                // Compressed bytes after the header
+};
+
+// false if it isn't a patch this code can apply
+bool deltaParseHeader(const uint8_t *buf, size_t len, DeltaHeader &out);
+void deltaWriteHeader(const DeltaHeader &h, uint8_t *buf);
+
+// Signature of the header at prefix (DELTA_PREFIX_SIZE bytes); returns its
+// length, 0 if the patch is unsigned
+size_t deltaSignature(const uint8_t *prefix, const uint8_t **sig);
+void   deltaWriteSignature(const uint8_t *sig, size_t len, uint8_t *prefix);
+
+class DeltaPatcher {
+public:
+  // Read len old bytes at offset / take the next new bytes; false aborts
+  typedef bool (*ReadOld)(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+  typedef bool (*WriteNew)(void *ctx, const uint8_t *data, size_t len);
+
+  void begin(const DeltaHeader &h, ReadOld readOld, WriteNew writeNew, void *ctx);
+
+  // Body bytes, cut anywhere. false on a malformed patch or a failed
+  // read/write (see error()); don't feed more after that.
+  bool feed(const uint8_t *data, size_t len);
+
+  // The whole body was fed and exactly newSize bytes written
+  bool        done() const { return finished && received == hdr.bodySize; }
+  uint32_t    written() const { return total; }
+  uint32_t    oldReads() const { return reads; }
+  const char *error() const { return err; }
+
+private:
+  enum Step : uint8_t { ADD_LEN, COPY_LEN, SEEK, ADD, COPY };
+
+  bool     token();
+  bool     command(uint8_t b);
+  bool     endRecord();
+  bool     put(uint8_t b);
+  bool     flush();
+  bool     oldByte(uint32_t pos, uint8_t &b);
+  bool     fail(const char *reason);
+  uint32_t take(uint8_t n);
+
+  DeltaHeader hdr;
+  ReadOld     readOld  = NULL;
+  WriteNew    writeNew = NULL;
+  void       *ctx      = NULL;
+  const char *err      = "";
+
+  // LZ decoder
+  uint64_t bits      = 0;     // Unread bits, left-aligned
+  uint8_t  bitCount  = 0;
+  uint32_t received  = 0;     // Body bytes fed
+  uint32_t unpacked  = 0;     // Bytes decompressed (window fill)
+  uint8_t  window[DELTA_WINDOW];
+
+  // Records
+  Step     step      = ADD_LEN;
+  uint32_t varValue  = 0;
+  uint8_t  varShift  = 0;
+  uint32_t addLeft   = 0;
+  uint32_t copyLeft  = 0;
+  int64_t  seek      = 0;
+  uint32_t oldPos    = 0;
+  bool     finished  = false;
+
+  // Output + old image reads
+  uint8_t  out[DELTA_OUT_CHUNK];
+  size_t   outLen    = 0;
+  uint32_t total     = 0;
+  uint8_t  oldBuf[DELTA_OLD_CHUNK];
+  uint32_t oldStart  = 0;
+  uint32_t oldLen    = 0;
+  uint32_t reads     = 0;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/pk.h>
+#include "ota_delta.h"
+
+// ==========================================
+// DELTA OTA UPDATES (local update server)
+// ==========================================
+// check() asks the update server (tools/ota_delta/ota_server.py) for
+// GET /ota/<id of the running image>. The answer is 204 when there is
+// nothing newer, or a patch (ota_delta.h): against the running image if the
+// server knows it, else the compressed full image. The patch is applied as
+// it arrives: old bytes are read from the running slot, new ones written
+// into the other slot, so nothing waits for the whole download and only
+// the patch crosses the air. Afterwards the new slot has to pass ESP-IDF's
+// image check and have the id the patch promised. Only then is it made the
+// boot slot, which is one otadata write: a power cut before that leaves the
+// old image booting, as if nothing happened.
+//
+// Nothing is installed unless the patch header (the manifest naming the
+// old and new image ids) carries a valid signature by the release key, a
+// P-256 public key compiled in (begin()). It is checked before the first
+// byte is written, and the image id check after the last one ties the
+// image to it. The transport is plain HTTP on the LAN; the server needs
+// the private key only to make patches, not to be trusted.
+//
+// A new image boots on probation until confirm() keeps it; rollback()
+// returns to the previous image on purpose. probationExpired() only counts
+// time the device could reach the cloud, so a unit that is offline stays on
+// probation instead of blaming the new image. A bootloader built with
+// rollback support (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE) keeps the
+// probation itself (PENDING_VERIFY) and returns to the previous image if
+// the new one resets before confirm(). The stock Arduino bootloader has no
+// rollback, so the updater also keeps it in software: install() records the
+// new and the previous slot in NVS, begin() counts the new image's boots,
+// and after OTA_TRIAL_BOOTS unconfirmed ones (a crash or a boot loop) it
+// makes the previous slot the boot slot again and restarts.
+//
+// Runs in its own task: a check blocks for the whole transfer, and the
+// flash writes briefly stall both cores.
+
+#define OTA_HTTP_TIMEOUT_MS 10000
+#define OTA_NET_CHUNK       1024    // Socket read size
+#define OTA_NVS_NAMESPACE   "ota"   // Software probation: slot on trial, previous slot, boots
+#define OTA_TRIAL_BOOTS     3       // Unconfirmed boots before the previous image comes back
+
+enum OtaResult : uint8_t {
+  OTA_UP_TO_DATE,
+  OTA_READY,         // New image verified and set to boot: restart into it
+  OTA_FAILED         // lastError() says why; the running image is untouched
+};
+
+struct OtaStats {
+  uint32_t checks;
+  uint32_t updates;        // Images installed
+  uint32_t failures;
+  uint32_t patchBytes;     // Last update: bytes received
+  uint32_t imageBytes;     //              bytes written
+  uint32_t updateMs;       //              request to verified image
+  bool     delta;          //              against the running image (else full)
+};
+
+class OtaUpdater {
+public:
+  // serverUrl "http://host[:port]"; signingKey is the release's public key
+  // (PEM). Without a usable key every check fails and nothing is installed.
+  // Counts a boot on probation, so call it early: past OTA_TRIAL_BOOTS it
+  // restarts into the previous image.
+  void begin(const char *serverUrl, const char *signingKey);
+
+  OtaResult check();
+
+  // Probation of a freshly installed image
+  bool pendingVerify() const { return pending; }
+  void confirm();
+  bool rollback();         // Restarts into the previous image; false if there is none
+  // Call regularly with whether the cloud is reachable. True once the image
+  // has spent limitMs reachable without being confirmed.
+  bool     probationExpired(bool online, uint32_t limitMs);
+  uint32_t probationOnlineMs() const { return onlineMs; }
+
+  const char     *runningSlot() const { return running ? running->label : "?"; }
+  const char     *lastError() const { return error; }
+  const OtaStats &stats() const { return st; }
+
+private:
+  const char *request(const char *idHex, int &status, uint32_t &length);   // NULL or why not
+  bool      readLine(char *out, size_t max);
+  OtaResult install(uint32_t length);
+  bool      signedByRelease(const uint8_t *prefix);
+  bool      startTrialBoot();
+  void      endTrial();
+  bool      readFully(uint8_t *buf, size_t len);
+  bool      mapRunning(uint32_t size);
+  void      unmapRunning();
+  OtaResult fail(const char *reason);
+  static bool readOld(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+  static bool writeNew(void *ctx, const uint8_t *data, size_t len);
+
+  char                   host[64] = "";
+  uint16_t               port = 80;
+  WiFiClient             http;
+  DeltaPatcher           patcher;
+  const esp_partition_t *running = NULL;
+  const esp_partition_t *target  = NULL;
+  esp_ota_handle_t       handle  = 0;
+  const uint8_t         *oldMap  = NULL;   // Running image mapped for reads (else esp_partition_read)
+  spi_flash_mmap_handle_t mapHandle = 0;
+  uint8_t                runningId[DELTA_ID_LEN];
+  bool                   haveId  = false;
+  mbedtls_pk_context     releaseKey;
+  bool                   haveKey = false;
+  volatile bool          pending = false;
+  bool                   bootloaderTrial = false;   // PENDING_VERIFY (else probation is kept in NVS)
+  char                   previousSlot[17] = "";     // Software probation: label to roll back to
+  bool                   wasOnline = false;
+  unsigned long          lastProbationMs = 0;
+  uint32_t               onlineMs = 0;      // Probation time with the cloud reachable
+  char                   error[48] = "";
+  OtaStats               st = {};
+};
+
+#endif
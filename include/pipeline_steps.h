@@ -0,0 +1,135 @@
+#ifndef PIPELINE_STEPS_H
+#define PIPELINE_STEPS_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "delta_filter.h"
+#include "face_anim.h"
+#include "face_rules.h"
+#include "plant_rack.h"
+#include "sensor_schedule.h"
+#include "window_stats.h"
+
+// ==========================================
+// PER-TICK PIPELINE STEPS
+// ==========================================
+// What the pipeline tasks do each tick, written against the hal.h interfaces
+// only. The FreeRTOS tasks in main.cpp add the timing, the hand-offs between
+// tasks and the logging around them; the host benchmark (test_cycle_bench)
+// calls the same functions with the fakes, so it times the firmware's code.
+//   sensorTask   readDueSensors → foldIntoWindows → classifyRack → SceneSelector
+//   animTask     showScene (drawStatusBar), then FaceAnimator + FrameFlusher
+//   networkTask  queueSummary → uploadWindows (LIVE_UPLOADS 0) or
+//                uploadChanges (LIVE_UPLOADS 1)
+// drawFace() rasterizes the faces into the face cache at boot.
+// Plain C++, so it builds on the host.
+
+// ---------------- Sensor task ----------------
+
+// Both air fields read (a failed DHT22 read gives NAN)
+bool airValid(const Telemetry &t);
+
+// Read each plant's due sensors and fill `sample` with every plant's newest
+// values (held ones included), timestamped nowMs. fresh[p] gets the
+// FIELD_BIT()s read this tick. Returns the number of plants without an air
+// reading.
+uint8_t readDueSensors(SensorHal &sensors, SensorScheduler &sched, const PlantRack &rack,
+                       uint8_t plants, unsigned long nowMs, RackSample &sample, uint8_t *fresh);
+
+// Fold the sample into each plant's windows (NAN air fields are skipped) and
+// copy the windows that closed to `closed` (room for plants × AGG_WINDOWS),
+// with their plant and boot set. Returns how many closed.
+size_t foldIntoWindows(WindowAggregator *aggregators, const RackSample &sample, const uint8_t *fresh,
+                       uint32_t boot, WindowSummary *closed);
+
+// Run the face rules over the new readings. Returns the mask of plants whose
+// face changed (the classifier's listeners are already notified).
+uint32_t classifyRack(PlantRack &rack, FaceClassifier &classifier, const RackSample &sample,
+                      unsigned long nowMs);
+
+// ---------------- Screen ----------------
+// The species label in the status bar is laid out once per threshold update,
+// not per frame: truncated into a fixed buffer, with its centered x precomputed.
+#define STATUS_LABEL_CHARS 14   // Fits between the WiFi and battery icons at text size 1
+#define STATUS_CHAR_WIDTH  6    // Built-in 5x7 font + 1 px spacing, text size 1
+
+struct StatusLabel {
+  char    text[STATUS_LABEL_CHARS + 1];   // "" = nothing to show
+  int16_t x;
+};
+
+// Only show the species if known. With several plants it is prefixed with
+// the plant number (falling back to its id), e.g. "2:Fern".
+void layoutStatusLabel(StatusLabel &label, uint8_t plant, uint8_t plants, const char *plantId,
+                       const PlantThresholds &thresholds);
+
+// Status bar (rows 0..10): WiFi icon, species label, battery
+void drawStatusBar(Adafruit_GFX &gfx, int batteryPercent, const StatusLabel &label, bool online);
+
+// One FACE_* in the face area (y=12..63), drawn with Adafruit_GFX primitives
+void drawFace(Adafruit_GFX &gfx, int faceType);
+
+// What the OLED shows: one plant's face and the status bar
+struct ScreenScene {
+  int         face;
+  StatusLabel label;
+  bool        online;
+  int         batteryPercent;
+};
+
+// Picks the scene after each sample. A new one is only handed out when
+// something on it changed: a face change of the plant on screen or new
+// thresholds (markDirty()), a WiFi icon change, or the next plant's turn.
+class SceneSelector {
+public:
+  void configure(uint8_t plants, unsigned long plantPeriodMs);
+
+  void    markDirty() { dirty = true; }
+  uint8_t shown() const { return shownPlant; }
+
+  // Fills `scene` and returns true when the screen needs it
+  bool select(const FaceClassifier &classifier, const StatusLabel *labels, bool linkUp,
+              int batteryPercent, unsigned long nowMs, ScreenScene &scene);
+
+  uint32_t skipped = 0;   // Samples that left the scene as it was
+
+private:
+  uint8_t       plants        = 1;
+  unsigned long plantPeriodMs = 0;
+  uint8_t       shownPlant    = 0;
+  unsigned long shownSinceMs  = 0;
+  bool          dirty         = true;
+  bool          lastLinkUp    = false;
+};
+
+// Rasterize a new scene's status bar and hand it and the face to the
+// animator; the frames are rendered from there
+void showScene(DisplayHal &screen, FaceAnimator &animator, const ScreenScene &scene, unsigned long nowMs);
+
+// ---------------- Network task ----------------
+
+// Append a closed window to the pending list. When it is full (a long
+// outage), the oldest minute summary makes room: hours are what the history
+// is built from. Returns false if one was dropped.
+bool queueSummary(WindowSummary *pending, size_t &count, size_t capacity, const WindowSummary &s);
+
+// The live fields show each plant's newest minute means (one write)
+bool uploadMinuteMeans(CloudHal &cloud, const WindowSummary *pending, size_t count, uint8_t plants);
+
+// Upload the pending summaries (one request) and, with LIVE_UPLOADS 0, the
+// minute means for the live fields. False if either failed.
+bool uploadWindows(CloudHal &cloud, const WindowSummary *pending, size_t count, uint8_t plants);
+
+enum ChangeUpload : uint8_t {
+  CHANGES_NONE = 0,   // Nothing past its deadband, nothing sent
+  CHANGES_SENT,
+  CHANGES_FAILED
+};
+
+// Delta upload of one sample (LIVE_UPLOADS 1): each plant's fields past
+// their deadband (fields[p]), all plants in one write, committed to the
+// filters once it landed. Plants without an air reading send nothing.
+ChangeUpload uploadChanges(CloudHal &cloud, DeltaFilter *filters, const RackSample &sample,
+                           unsigned long nowMs, uint8_t *fields);
+
+#endif
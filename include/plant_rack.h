@@ -0,0 +1,72 @@
+#ifndef PLANT_RACK_H
+#define PLANT_RACK_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "plant_thresholds.h"
+
+// ==========================================
+// MULTI-PLANT RACK (struct-of-arrays)
+// ==========================================
+// One controller can drive several pots. Each plant is a row in a static
+// PlantConfig table (main.cpp): its own ADC1 moisture pin, and optionally
+// its own DHT22 and its own BH1750 behind a TCA9548A I2C mux. Plants without
+// their own air/light sensor share plant 0's (same shelf).
+//
+// The sensor task keeps everything the face rules need in PlantRack, one
+// array per field with one entry per plant. Each rule then runs as a flat
+// loop over all plants (face_rules.cpp).
+
+// ADC1 has 8 channels, so the firmware stops at 8. The rack logic itself
+// allows 32; host tools override this (tools/rack_bench builds with 32).
+#ifndef MAX_PLANTS
+#define MAX_PLANTS 8
+#endif
+static_assert(MAX_PLANTS >= 1 && MAX_PLANTS <= 32, "Plant masks are 32-bit");
+
+#define NO_PIN -1
+
+struct PlantConfig {
+  const char *id;           // RTDB key under /plants, e.g. "gaia_01"
+  uint8_t     moisturePin;  // ADC1 pin (GPIO 32-39)
+  int8_t      dhtPin;       // NO_PIN = share plant 0's DHT22
+  int8_t      lightMux;     // TCA9548A channel of its BH1750; NO_PIN = shared BH1750 on the main bus
+};
+
+// PlantThresholds members a rule can compare against
+enum ThresholdField {
+  TH_MOISTURE_LOW = 0,
+  TH_MOISTURE_HIGH,
+  TH_TEMP_HIGH,
+  TH_TEMP_LOW,
+  TH_LUX_LOW,
+  TH_LUX_HIGH,
+  TH_HUMIDITY_HIGH,
+  TH_HUMIDITY_LOW,
+  TH_COUNT
+};
+
+float plantThresholdValue(const PlantThresholds &th, int field);
+
+// Thresholds for every plant, as handed from the network task to the sensor task
+struct ThresholdSet {
+  PlantThresholds plant[MAX_PLANTS];
+};
+
+// One sensor tick for every plant (sensor task → network task)
+struct RackSample {
+  uint8_t   count;
+  Telemetry plant[MAX_PLANTS];
+};
+
+struct PlantRack {
+  uint8_t count;
+  float   reading[FIELD_COUNT][MAX_PLANTS];   // By TelemetryField; NAN = no reading
+  float   threshold[TH_COUNT][MAX_PLANTS];    // By ThresholdField
+  uint8_t face[MAX_PLANTS];                   // Written by FaceClassifier
+};
+
+void rackSetReadings(PlantRack &rack, const RackSample &s);
+void rackSetThresholds(PlantRack &rack, const ThresholdSet &th);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef PLANT_THRESHOLDS_H
+#define PLANT_THRESHOLDS_H
+
+#include <Arduino.h>
+
+// ================= PLANT THRESHOLDS (Dynamic from Firebase) =================
+// These defaults match common houseplants. The Flutter app writes species-specific
+// values to Firebase, and the ESP32 pulls them periodically so the OLED faces
+// react according to the actual plant's needs.
+#define SPECIES_NAME_MAX 32      // Including the terminator; longer names are truncated
+
+// Plain data (no String), so copies never touch the heap
+struct PlantThresholds {
+  // Soil moisture (%)
+  int   moistureLow;      // Below this → FACE_THIRSTY
+  int   moistureHigh;     // Above this → FACE_OVERWATERED
+  // Temperature (°C)
+  float tempHigh;         // Above this → FACE_HOT
+  float tempLow;          // Below this → FACE_COLD
+  // Light (lux)
+  float luxLow;           // Below this → FACE_DARK
+  float luxHigh;          // Above this → FACE_BRIGHT
+  // Humidity (%)
+  float humidityHigh;     // Above this → FACE_HUMID
+  float humidityLow;      // Below this → FACE_DRY_AIR
+  // Species info
+  char  speciesName[SPECIES_NAME_MAX];   // e.g. "Rose", "Cactus", "Fern"
+};
+
+// Sensible defaults (used until Firebase supplies species-specific values)
+#define PLANT_THRESHOLDS_DEFAULT { \
+  /* moistureLow  */  30,          \
+  /* moistureHigh */  85,          \
+  /* tempHigh     */  30.0,        \
+  /* tempLow      */  15.0,        \
+  /* luxLow       */  100.0,       \
+  /* luxHigh      */  2000.0,      \
+  /* humidityHigh */  80.0,        \
+  /* humidityLow  */  30.0,        \
+  /* speciesName  */  "Unknown"    \
+}
+
+// Parsing of the app's thresholds node (keys moisture_low, moisture_high,
+// temp_high, temp_low, lux_low, lux_high, humidity_high, humidity_low,
+// species). Plain C++, so it builds on the host.
+
+// One numeric key; false if it isn't a threshold
+bool thresholdsApplyNumber(const char *key, float v, PlantThresholds &out);
+
+// A flat JSON object of some or all of the keys, e.g. a GET answer or an
+// MQTT message. Keys left out keep their values; unknown keys and values of
+// the wrong type are skipped. On malformed input nothing is applied and the
+// result is false. A bare null (node deleted) changes nothing.
+bool thresholdsApplyJson(const char *json, size_t len, PlantThresholds &out);
+
+#endif
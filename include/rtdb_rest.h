@@ -0,0 +1,99 @@
+#ifndef RTDB_REST_H
+#define RTDB_REST_H
+
+#include <Arduino.h>
+#include "telemetry_json.h"
+#include "tls_session.h"
+#include "stage_profiler.h"
+
+// ==========================================
+// RAW RTDB REST CLIENT (no heap per request)
+// ==========================================
+// The Mobizt client only takes FirebaseJson bodies: a heap-allocated tree
+// per write. The per-cycle traffic doesn't need it. Writes go out as
+// PATCH /<path>.json?print=silent and reads as GET /<path>.json, all over one
+// kept-alive TLS session (tls_session.h, resumed after a reconnect). The
+// request head and the body stream through a fixed 1 KB buffer. The body is
+// generated twice: a counting pass for Content-Length, then the real pass,
+// so even a 64-sample backlog needs no buffer of its own.
+//
+// Reads are pipelined: get() sends the request and returns. Its answer is
+// read in order by the next patch() (or finish()), so a threshold read and
+// the cycle's write share one round trip.
+
+#define RTDB_TX_BUFFER   1024     // One TLS record per flush
+#define RTDB_RX_BUFFER   512      // Largest GET body (a thresholds node is ~250 B)
+#define RTDB_PIPELINE    9        // Requests in flight: a threshold read per plant (MAX_PLANTS) + a write
+#define RTDB_TIMEOUT_MS  5000
+
+// Request accounting, kept since boot
+struct RtdbStats {
+  uint32_t     requests;
+  uint32_t     failures;
+  uint32_t     retries;      // Writes re-sent after a kept-alive connection had died
+  uint32_t     pipelined;    // Requests sent with an earlier one still unanswered
+  LogHistogram latencyMs;    // Send to complete answer
+};
+
+class RtdbRest {
+public:
+  // Fills the body; called twice per request (count, then send)
+  typedef void (*BodyWriter)(JsonOut &out, const void *ctx);
+  // Gets a GET's answer: status 0 = no answer (connection failed)
+  typedef void (*BodyReader)(void *ctx, int status, const char *body, size_t len);
+
+  // databaseUrl as given to the Firebase client, e.g. "https://x.firebaseio.com/".
+  // A port may be given ("https://192.168.1.20:8443/" for a local stand-in).
+  // caCert: PEM of a private CA to trust instead of the public roots (NULL).
+  void begin(const char *databaseUrl, const char *caCert = NULL);
+
+  // PATCH <path>.json, authenticated with the Firebase ID token. Reads any
+  // earlier pipelined answers first. Returns true on a 2xx answer.
+  bool patch(const char *path, BodyWriter body, const void *ctx, const char *idToken);
+
+  // GET <path>.json without waiting. `reader` runs when the answer is read:
+  // by the next patch() or finish(). False (reader already called) if the
+  // request couldn't be sent.
+  bool get(const char *path, BodyReader reader, void *ctx, const char *idToken);
+
+  // Read every outstanding answer
+  void finish();
+
+  void        stop();
+  int         lastStatus() const { return status; }   // HTTP status, or 0 (no answer)
+  const char *lastError() const  { return error; }
+  const RtdbStats &stats() const { return st; }
+  const TlsStats  &tlsStats() const { return tls.stats(); }
+
+private:
+  struct Pending {
+    BodyReader    reader;      // NULL for a PATCH
+    void         *ctx;
+    unsigned long sentMs;
+  };
+
+  bool connect();
+  bool sendRequest(const char *method, const char *path, BodyWriter body, const void *ctx, const char *idToken);
+  bool readResponse(Pending &p);
+  size_t readLine(char *line, size_t max);
+  size_t readBody(size_t len, size_t &kept);
+  bool readChunked(size_t &kept, size_t &total);
+  bool readPending();
+  void abortPending();
+  bool fail(const char *reason);
+  static bool drain(void *ctx, const char *data, size_t len);
+
+  TlsSession tls;
+  char       host[64] = "";
+  uint16_t   port = 443;
+  char       tx[RTDB_TX_BUFFER];
+  char       rx[RTDB_RX_BUFFER];
+  char       error[40] = "";
+  int        status = 0;
+  bool       keepAlive = false;
+  Pending    pending[RTDB_PIPELINE];
+  uint8_t    pendingCount = 0;
+  RtdbStats  st = {};
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// ==========================================
+// STORE-AND-FORWARD SAMPLE LOG (LittleFS)
+// ==========================================
+// Samples that could not be uploaded are appended to an on-flash ring and
+// drained in batches once the cloud is back.
+//
+// Layout: /log/<base>.seg segment files of SEG_RECORDS fixed-size records,
+// named after the sequence number of their first record, plus /log/tail
+// holding the sequence number of the oldest record not yet uploaded.
+//  - head (next seq to write) is recovered from the newest segment's size,
+//    so appends never rewrite existing data (LittleFS appends are atomic).
+//  - tail is rewritten only once per drained batch.
+//  - when the ring is full the oldest segment is deleted (oldest data lost).
+// All plants of a rack share one ring; each record carries its plant index.
+//
+// Timestamps are millis(), which restart at every boot, so each record also
+// carries the low 8 bits of the boot counter it was taken in. peek() widens
+// them against the current boot: a record is placed correctly as long as it
+// is less than 256 boots old.
+
+#define LOG_SEG_RECORDS 256   // 4 KB per segment (one flash sector)
+#define LOG_MAX_SEGMENTS 64   // 256 KB = 16384 records ≈ 45 h at one record / 10 s
+
+// 16-byte on-flash record (little-endian, packed)
+struct __attribute__((packed)) LogRecord {
+  uint32_t timestamp;     // millis() uptime when sampled
+  int16_t  tempCenti;     // °C × 100
+  uint16_t humidCenti;    // % × 100
+  uint32_t luxPlantBoot;  // Bits 0-19: lux × 10, 20-23: plant index, 24-31: boot (low 8 bits)
+  uint16_t soilRaw;       // Raw ADC counts
+  uint8_t  moisture;      // % (calibrated)
+  uint8_t  crc;           // CRC-8 over the 15 bytes above
+};
+
+// Pure conversions (no flash access). Unpack widens the record's boot
+// against currentBoot.
+void logRecordPack(const Telemetry &t, uint8_t plant, uint32_t boot, LogRecord &out);
+void logRecordUnpack(const LogRecord &r, uint32_t currentBoot, LoggedSample &out);
+bool logRecordValid(const LogRecord &r);
+
+class SampleLog {
+public:
+  // Mount LittleFS and recover head/tail. boot (the NVS boot counter) is
+  // stamped on every record appended from now on.
+  bool     begin(uint32_t boot);
+  bool     append(const Telemetry &t, uint8_t plant = 0);
+  // Copies up to `max` of the oldest pending samples into `out` without
+  // consuming them; returns how many were read.
+  size_t   peek(LoggedSample *out, size_t max);
+  void     consumePeeked();              // Everything returned by the last peek() was uploaded
+  uint32_t pending() const { return headSeq - tailSeq; }
+  uint32_t droppedRecords() const { return dropped; }
+
+private:
+  void     persistTail();
+  void     dropOldestSegment();
+  static uint32_t segBase(uint32_t seq) { return seq - (seq % LOG_SEG_RECORDS); }
+  static void     segPath(uint32_t base, char *out, size_t len);
+
+  uint32_t headSeq = 0;   // Next sequence number to write
+  uint32_t tailSeq = 0;   // Oldest sequence number not yet uploaded
+  uint32_t peekEnd = 0;   // Sequence number just past the last peek()
+  uint32_t dropped = 0;   // Records lost to ring overflow or corruption
+  uint32_t boot    = 0;
+  bool     mounted = false;
+};
+
+#endif
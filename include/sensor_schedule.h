@@ -0,0 +1,104 @@
+#ifndef SENSOR_SCHEDULE_H
+#define SENSOR_SCHEDULE_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "plant_rack.h"
+
+// ==========================================
+// ADAPTIVE PER-SENSOR SAMPLING
+// ==========================================
+// The sensor task ticks every second, but few readings need that: the DHT22
+// gives a new frame every 2 s at best, soil moisture moves over minutes and
+// most light readings repeat. Each plant's air, soil and light sensors get
+// their own period:
+//   - fastMs while a reading is near one of the plant's thresholds (within
+//     nearFraction of the low..high span of either end), so faces aren't late
+//   - baseMs while readings move
+//   - doubled after each read that moved less than stableFraction of the
+//     span, up to slowMs
+// A failed read retries after baseMs. Between reads the last value is held.
+// Every value carries the time it was measured and a validity flag, and
+// values older than maxAgeMs are handed out as missing, like a failed read.
+// Nothing waits for a sensor: fill() only hands out what is there.
+//
+// Reads saved against the old fixed schedule (one per fixedMs) are counted
+// at readUs each, the time a read keeps the sensor's bus or wire busy.
+// Plain C++, so it builds on the host.
+
+enum SenseKind : uint8_t {
+  SENSE_AIR = 0,    // DHT22: temperature + humidity
+  SENSE_SOIL,       // Moisture percent + raw counts
+  SENSE_LIGHT,      // BH1750
+  SENSE_COUNT
+};
+
+struct SenseConfig {
+  uint32_t fixedMs;        // Period of the fixed schedule (baseline for the savings)
+  uint32_t baseMs;
+  uint32_t fastMs;
+  uint32_t slowMs;
+  uint32_t maxAgeMs;
+  float    nearFraction;
+  float    stableFraction;
+  uint32_t readUs;
+};
+
+struct SensedValue {
+  float         value;    // Last successful read (NAN before the first)
+  unsigned long atMs;     // millis() when it was measured
+  bool          valid;    // Read and not older than maxAgeMs, as of the last fill()
+};
+
+struct SenseStats {
+  uint32_t ticks;         // due() calls, one per plant per tick
+  uint32_t reads;
+  uint32_t nearReads;     // Reads that found a value near a threshold
+  uint32_t failedReads;
+};
+
+class SensorScheduler {
+public:
+  // cfg[SENSE_COUNT] must stay valid. tickMs is the caller's tick period.
+  void configure(const SenseConfig *cfg, uint8_t plants, uint32_t tickMs);
+
+  // Should the caller read `kind` for `plant` now? Call once per plant and kind each tick.
+  bool due(uint8_t plant, SenseKind kind, unsigned long nowMs);
+
+  // One field of a due read. NAN = failed; the old value is kept until it ages out.
+  void store(uint8_t plant, TelemetryField field, float v, unsigned long measuredMs);
+
+  // After storing a due read's fields: pick the next period from how near
+  // they are to the plant's thresholds (rack) and how much they moved.
+  void reschedule(uint8_t plant, SenseKind kind, const PlantRack &rack, unsigned long nowMs);
+
+  // Held values into t. Missing air fields are NAN and missing light is 0 lux
+  // (as a failed read always was). Returns the fields stored since the last fill().
+  uint8_t fill(uint8_t plant, Telemetry &t, unsigned long nowMs);
+
+  const SensedValue &value(uint8_t plant, TelemetryField f) const { return values[plant][f]; }
+  uint32_t          period(uint8_t plant, SenseKind kind) const   { return channels[plant][kind].periodMs; }
+  const SenseStats &stats(SenseKind kind) const                   { return st[kind]; }
+
+  // Bus / wire time the skipped reads saved, per hour of running
+  uint32_t savedUsPerHour(SenseKind kind) const;
+  // Mean time between reads of one plant's sensor
+  uint32_t meanPeriodMs(SenseKind kind) const;
+
+private:
+  struct Channel {
+    unsigned long nextMs;
+    uint32_t      periodMs;
+  };
+
+  const SenseConfig *cfg = NULL;
+  uint8_t     plants = 0;
+  uint32_t    tickMs = 1000;
+  Channel     channels[MAX_PLANTS][SENSE_COUNT];
+  SensedValue values[MAX_PLANTS][FIELD_COUNT];
+  float       previous[MAX_PLANTS][FIELD_COUNT];   // Value before the latest store()
+  uint8_t     stored[MAX_PLANTS];                  // Fields stored since the last fill()
+  SenseStats  st[SENSE_COUNT];
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SIGNAL_FILTERS_H
+#define SIGNAL_FILTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ==========================================
+// SIGNAL FILTER KERNELS (pure)
+// ==========================================
+// Robust reductions for noisy ADC frames and a one-pole IIR smoother.
+// Plain C++ with no hardware access; the reductions reorder `buf` in place.
+
+// Median of n samples (n > 0)
+uint16_t medianU16(uint16_t *buf, size_t n);
+
+// Mean of the samples left after discarding the `trim` lowest and `trim`
+// highest (2 * trim < n). Selection is O(n), the summing loop is branch-free.
+float trimmedMeanU16(uint16_t *buf, size_t n, size_t trim);
+
+// One-pole low-pass (exponential moving average): y += alpha * (x - y)
+struct EmaFilter {
+  float alpha;          // 0 < alpha <= 1; smaller = smoother
+  float value  = 0;
+  bool  primed = false;
+
+  explicit EmaFilter(float alpha) : alpha(alpha) {}
+  float update(float x) {
+    if (!primed) { value = x; primed = true; }
+    else         value += alpha * (x - value);
+    return value;
+  }
+};
+
+#endif
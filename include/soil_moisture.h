@@ -0,0 +1,75 @@
+#ifndef SOIL_MOISTURE_H
+#define SOIL_MOISTURE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_adc_cal.h>
+#include "signal_filters.h"
+
+// ==========================================
+// SOIL MOISTURE: ADC1 DMA SAMPLING + FILTERING
+// ==========================================
+// The probes (one per plant, up to the 8 ADC1 channels) are sampled
+// continuously by the ADC's DMA engine (20 kHz, the ESP32's lowest
+// continuous rate, split round-robin across the channels) on a background task:
+//   each 10 ms frame  → per-channel trimmed mean (drops spikes) → 100 readings/s
+//   readings          → EMA low-pass                             → published raw value
+// (Battery units use beginOneShot() instead: a short burst per wake.)
+// Raw counts are converted to millivolts with the chip's eFuse ADC
+// calibration, and millivolts to % with per-probe dry/wet points stored in NVS.
+
+#define MOISTURE_MAX_CHANNELS 8   // ADC1_CHANNEL_0..7 (GPIO 32-39)
+
+struct MoistureCalibration {
+  uint16_t dryMv;   // Probe in air → 0 %
+  uint16_t wetMv;   // Probe in water → 100 %
+};
+
+class SoilMoistureAdc {
+public:
+  // `pins` must stay valid (normally a static table); probe i = pins[i]
+  SoilMoistureAdc(const uint8_t *pins, uint8_t count) : pins(pins), count(count) {}
+
+  // Defaults (raw counts) are used until calibration points are saved to NVS
+  bool begin(int defaultDryRaw, int defaultWetRaw);
+
+  // Low-power alternative to begin(): no DMA task; call sampleBurst() once
+  // per wake. The EMA state can be carried across deep sleep by the caller.
+  bool  beginOneShot(int defaultDryRaw, int defaultWetRaw);
+  void  sampleBurst();                    // Every probe
+  float filterState(uint8_t probe) const { return ema[probe].value; }
+  void  restoreFilter(uint8_t probe, float value);
+
+  uint8_t  probes() const { return count; }
+  float    raw(uint8_t probe) const;          // Filtered ADC counts
+  uint32_t millivolts(uint8_t probe) const;   // Filtered, eFuse-calibrated
+  int      percent(uint8_t probe) const;      // 0..100 from the calibration points
+
+  MoistureCalibration calibration(uint8_t probe) const { return cal[probe]; }
+  void     setCalibration(uint8_t probe, const MoistureCalibration &c);  // Persists to NVS
+  uint32_t readingsPerSecond() const { return rate; }   // Per probe
+  bool     continuous() const { return running; }
+
+private:
+  bool        setup(int defaultDryRaw, int defaultWetRaw);
+  static void task(void *arg);
+  void        processFrame(const uint8_t *bytes, size_t len);
+
+  const uint8_t             *pins;
+  uint8_t                    count;
+  uint8_t                    channel[MOISTURE_MAX_CHANNELS];
+  esp_adc_cal_characteristics_t chars;
+  MoistureCalibration        cal[MOISTURE_MAX_CHANNELS] = {};
+  EmaFilter                  ema[MOISTURE_MAX_CHANNELS] = {  // ~20-reading (200 ms) time constant
+    EmaFilter{0.05f}, EmaFilter{0.05f}, EmaFilter{0.05f}, EmaFilter{0.05f},
+    EmaFilter{0.05f}, EmaFilter{0.05f}, EmaFilter{0.05f}, EmaFilter{0.05f}
+  };
+  std::atomic<float>         filtered[MOISTURE_MAX_CHANNELS] = {};
+  bool                       running = false;
+  bool                       oneShot = false;
+  uint32_t                   rate = 0;     // Filtered readings in the last second
+  uint32_t                   rateCount = 0;
+  uint32_t                   rateStart = 0;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// ==========================================
+// LOCK-FREE SINGLE-PRODUCER / SINGLE-CONSUMER RING
+// ==========================================
+// One task pushes, one other task pops; no locks, no allocation.
+// head/tail are free-running counters, so "full" is head - tail == N and
+// N must be a power of two. Plain C++ (no Arduino/FreeRTOS) so the same
+// header builds on the host.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  // Producer side. Returns false (and drops the item) when the ring is full.
+  bool push(const T &item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == N) return false;
+    slots[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when the ring is empty.
+  bool pop(T &out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = slots[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called from a third party; exact from either side.
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  T slots[N];
+  std::atomic<uint32_t> head{0};  // Written only by the producer
+  std::atomic<uint32_t> tail{0};  // Written only by the consumer
+};
+
+#endif
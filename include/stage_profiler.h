@@ -0,0 +1,108 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <stdint.h>
+#include "hal.h"
+
+// ==========================================
+// HOT-PATH STAGE PROFILER
+// ==========================================
+// PROFILE_STAGE(stage) times the rest of the enclosing scope with the CPU
+// cycle counter. The result goes into that stage's log-scale histogram,
+// kept in RAM. Summaries (count, p50, p95, max) are printed by the `prof`
+// serial command and written to /plants/<id>/diagnostics/stages.
+//
+// Build with -DGAIA_PROFILING=1 to enable. Otherwise PROFILE_STAGE expands
+// to nothing and the histograms are not even allocated. LogHistogram itself
+// is plain C++ and builds on the host.
+//
+// Each stage is recorded by a single task, and every task is pinned to one
+// core, so a stage always reads the same core's cycle counter. Readers on
+// another task may see a count and buckets that disagree by one sample.
+// That is fine for diagnostics. The 32-bit counter wraps after ~17 s at
+// 240 MHz, longer than any stage (HTTPS requests time out after 5 s).
+
+#ifndef GAIA_PROFILING
+#define GAIA_PROFILING 0
+#endif
+
+// ---- Histogram: 4 buckets per power of two (≤ 25 % error), 0..~67 s in µs ----
+#define HIST_SUB_BITS  2
+#define HIST_SUB       (1 << HIST_SUB_BITS)
+#define HIST_LINEAR    (2 * HIST_SUB)      // 0..7 get a bucket each
+#define HIST_MAX_LOG2  26                  // Values ≥ 2^26 µs share the last bucket
+#define HIST_BUCKETS   (HIST_LINEAR + (HIST_MAX_LOG2 - HIST_SUB_BITS - 1) * HIST_SUB + 1)   // + overflow
+
+class LogHistogram {
+public:
+  void     record(uint32_t v);
+  void     reset();
+  uint32_t count() const   { return n; }
+  uint32_t maximum() const { return maxV; }
+  uint32_t mean() const    { return n ? (uint32_t)(total / n) : 0; }
+  // Upper edge of the bucket holding the q-quantile (never above maximum())
+  uint32_t percentile(float q) const;
+
+  static uint8_t  bucketOf(uint32_t v);
+  static uint32_t bucketHigh(uint8_t b);
+
+private:
+  uint32_t buckets[HIST_BUCKETS] = {};
+  uint32_t n    = 0;
+  uint32_t maxV = 0;
+  uint64_t total = 0;
+};
+
+// ---- Stages ----
+enum Stage : uint8_t {
+  // setup(), once per boot
+  STAGE_SETUP = 0,
+  STAGE_SETUP_DISPLAY,
+  STAGE_SETUP_SENSORS,
+  STAGE_SETUP_FACE_CACHE,
+  // sensorTask, every tick
+  STAGE_SENSOR_CYCLE,
+  STAGE_READ_AIR,          // DHT22 temperature + humidity (one plant)
+  STAGE_READ_SOIL,         // Moisture raw + percent (one plant)
+  STAGE_READ_LIGHT,        // BH1750 (one plant)
+  STAGE_AGGREGATE,         // Window statistics, all plants
+  STAGE_FACE_RULES,
+  // animTask, drawn frames
+  STAGE_SCREEN,            // I2C flush of a changed frame
+  // networkTask, every wake
+  STAGE_NETWORK_CYCLE,
+  STAGE_BOOT_STEP,
+  STAGE_THRESHOLD_SYNC,
+  STAGE_FACE_STATUS,
+  STAGE_UPLOAD,            // HTTPS telemetry write
+  STAGE_BACKLOG,
+  STAGE_COUNT
+};
+
+const char  *stageName(Stage s);   // RTDB key, e.g. "read_air"
+StageSummary summarizeStage(const LogHistogram &h, Stage s);
+
+#if GAIA_PROFILING
+extern LogHistogram stageTimes[STAGE_COUNT];
+extern uint32_t     profileCyclesPerUs;
+
+void profilerBegin();   // Reads the CPU clock; call first thing in setup()
+
+class ScopedStage {
+public:
+  explicit ScopedStage(Stage s) : stage(s), start(ESP.getCycleCount()) {}
+  ~ScopedStage() { stageTimes[stage].record((ESP.getCycleCount() - start) / profileCyclesPerUs); }
+
+private:
+  Stage    stage;
+  uint32_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT2(a, b)
+#define PROFILE_STAGE(stage)  ScopedStage PROFILE_CONCAT(profileScope_, __LINE__)(stage)
+#else
+#define PROFILE_STAGE(stage)  ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TELEMETRY_JSON_H
+#define TELEMETRY_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal.h"
+
+// ==========================================
+// ALLOCATION-FREE TELEMETRY SERIALIZER
+// ==========================================
+// Writes the RTDB update bodies straight into a caller-owned buffer, so no
+// FirebaseJson tree and no String is built on every upload cycle. A
+// compile-time descriptor table gives each field's key, type and precision.
+// Numbers are formatted with integer arithmetic instead of printf. A compact
+// CBOR encoding of the same telemetry is available for binary transports.
+
+enum FieldKind : uint8_t {
+  FIELD_KIND_FLOAT = 0,
+  FIELD_KIND_INT
+};
+
+struct TelemetryFieldDesc {
+  const char *key;        // RTDB key (must match the schema used by the app)
+  uint8_t     keyLen;
+  FieldKind   kind;
+  uint8_t     decimals;   // Floats: digits after the point (trailing zeros trimmed)
+  uint8_t     offset;     // offsetof(Telemetry, ...)
+};
+
+extern const TelemetryFieldDesc TELEMETRY_FIELDS[FIELD_COUNT];
+
+// Byte sink over a fixed buffer. When the buffer fills, drain() (if set)
+// gets the bytes so far and the buffer is reused. Without drain(), the
+// overflowing output is dropped and ok() turns false. A null buffer only
+// counts bytes (for Content-Length).
+class JsonOut {
+public:
+  typedef bool (*Drain)(void *ctx, const char *data, size_t len);
+
+  JsonOut(char *buf, size_t cap, Drain drain = NULL, void *ctx = NULL)
+    : buf(buf), cap(cap), drainFn(drain), ctx(ctx) {}
+
+  // Raw bytes
+  void put(char c);
+  void put(const char *s, size_t n);
+  void put(const char *s);
+
+  // JSON building blocks; key() adds the comma between members
+  void beginObject() { put('{'); first = true; }
+  void endObject()   { put('}'); first = false; }   // The object was a member of its parent
+  void key(const char *prefix, const char *name, size_t nameLen);
+  void key(const char *prefix, const char *name);
+  void string(const char *s);              // Escapes ", \ and control characters
+  void integer(int32_t v);
+  void uinteger(uint32_t v);
+  void fixed(float v, uint8_t decimals);   // NaN/inf → null
+
+  bool   finish();                 // Drain what is left; false if anything was lost
+  bool   ok() const     { return good; }
+  size_t total() const  { return flushed + len; }   // Bytes produced so far
+  const char *data() const { return buf; }          // Undrained bytes (not terminated)
+  size_t length() const { return len; }
+
+private:
+  char   *buf;
+  size_t  cap;
+  Drain   drainFn;
+  void   *ctx;
+  size_t  len = 0;
+  size_t  flushed = 0;
+  bool    good = true;
+  bool    first = true;
+};
+
+// "<prefix><key>":value for every field in mask, then "<prefix>timestamp".
+// Use inside beginObject()/endObject(); prefix is e.g. "gaia_01/" or "".
+void jsonTelemetry(JsonOut &out, const char *prefix, const Telemetry &t, uint8_t mask);
+
+// CBOR map {field index: value, ..., FIELD_COUNT: timestamp}: floats as
+// float32, ints as CBOR integers. Returns bytes written, 0 if cap is too small.
+#define TELEMETRY_CBOR_TIMESTAMP_KEY FIELD_COUNT
+#define TELEMETRY_CBOR_MAX           (1 + FIELD_COUNT * 6 + 6)
+size_t cborTelemetry(const Telemetry &t, uint8_t mask, uint8_t *out, size_t cap);
+
+// A sample replayed from the offline log: every field, the timestamp and
+// TELEMETRY_CBOR_BOOT_KEY: boot (the timestamp is millis() of that boot)
+#define TELEMETRY_CBOR_BOOT_KEY   (FIELD_COUNT + 1)
+#define TELEMETRY_CBOR_LOGGED_MAX (TELEMETRY_CBOR_MAX + 6)
+size_t cborLoggedSample(const LoggedSample &s, uint8_t *out, size_t cap);
+
+// Reader for small flat answers ({"key": number | "string" | true | null, ...}),
+// such as a thresholds node. Calls member() once per key; value is the
+// unescaped string or the literal's text. Values longer than
+// JSON_SCAN_VALUE_MAX - 1 are truncated. A bare null counts as an empty
+// object. Returns false on nested objects, arrays or malformed input.
+#define JSON_SCAN_KEY_MAX   32
+#define JSON_SCAN_VALUE_MAX 48
+typedef void (*JsonMember)(void *ctx, const char *key, const char *value, bool isString);
+bool jsonScanObject(const char *json, size_t len, JsonMember member, void *ctx);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef THIRST_FORECAST_H
+#define THIRST_FORECAST_H
+
+#include <stdint.h>
+
+// ==========================================
+// TIME-TO-THIRSTY FORECAST (recursive least squares)
+// ==========================================
+// Tracks each pot's soil moisture level and drying rate with a two-parameter
+// RLS fit (level + slope) and exponential forgetting. Its memory is about
+// 1 / (1 - lambda) samples. The fit is kept at the current time: every update
+// first slides the line forward to "now", so the numbers stay well-scaled in
+// float over weeks of uptime. A jump above the fitted level larger than
+// wateringStep is a watering event, and the fit restarts from that level.
+//
+// Soil dries fast when wet and slower as it approaches a residual level, so
+// a straight line forecasts thirst too early. A second RLS fit, fed
+// (level, slope) pairs across drydowns, learns rate = a + b × level. The
+// fitted slope lags a curve by a few hours, so each pair uses the level at
+// the time the slope belongs to (tracked from the fit's weighted sample
+// ages). It survives waterings. Once it has rateMinFits points, the forecast
+// follows the exponential that relation implies.
+//
+// Fed one minute mean at a time (window_stats.h). The soil percentage is
+// an integer, so 1 Hz samples are too coarse to show a slope of a few tenths
+// of a percent per hour. Memory is constant: a 2x2 covariance, two
+// parameters and four age moments. An update is a few dozen float
+// operations. Plain C++, so it builds on the host.
+
+struct ForecastConfig {
+  float lambda;         // Forgetting factor per sample (0.9944 ≈ 3 h at one sample/min)
+  float wateringStep;   // % above the fitted level that counts as watering
+  float minDryingRate;  // %/h; slower drying doesn't produce a forecast
+  float maxHours;       // Longer forecasts are reported as "none"
+  uint16_t warmup;      // Samples after a restart before forecasting
+  float rateLambda;     // Forgetting factor of the rate model, per point
+  uint16_t rateEvery;   // Samples between rate model points
+  uint16_t rateMinFits; // Points before the rate model is used
+};
+
+#define FORECAST_CONFIG_DEFAULT { 0.9944f, 5.0f, 0.05f, 720.0f, 120, 0.99f, 60, 24 }
+
+// What the app sees under /plants/<id>/forecast
+struct ThirstForecast {
+  float         hoursToThirsty;   // NAN = no forecast (warming up, not drying, or too far out)
+  float         level;            // Fitted moisture now (%); NAN before the first reading
+  float         dryingRate;       // %/h, positive while drying; NAN before the first reading
+  unsigned long atMs;             // millis() of the newest reading; the countdown starts here
+  unsigned long lastWateredMs;    // millis() of the last detected watering (0 = none seen)
+  uint32_t      waterings;        // Since boot
+};
+
+class ThirstForecaster {
+public:
+  ThirstForecaster() : cfg(FORECAST_CONFIG_DEFAULT) { reset(); }
+  explicit ThirstForecaster(const ForecastConfig &cfg) : cfg(cfg) { reset(); }
+
+  void reset();
+
+  // One moisture reading (%) at nowMs. Returns true if it started a new watering.
+  bool update(float moisture, unsigned long nowMs);
+
+  // Forecast against the plant's current moistureLow
+  ThirstForecast forecast(int moistureLow) const;
+
+  bool primed() const { return samples > 0; }
+
+private:
+  void restart(float level);
+  void ageMoments(float dt);
+  float slopeAge() const;
+
+  ForecastConfig cfg;
+  float         theta[2];      // Level (%), slope (%/h) at lastMs
+  float         P[2][2];       // Parameter covariance (scaled)
+  float         age[4];        // Weighted sums of sample age^0..3 (hours)
+  float         rate[2];       // Slope at 50 %, slope change per % of level
+  float         rateP[2][2];
+  uint32_t      rateFits;
+  unsigned long lastMs;
+  unsigned long wateredMs;
+  uint32_t      samples;       // Since the last restart
+  uint32_t      waterings;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef THRESHOLD_CACHE_H
+#define THRESHOLD_CACHE_H
+
+#include <Arduino.h>
+#include "plant_thresholds.h"
+
+// ==========================================
+// LAST-KNOWN THRESHOLDS (NVS / RTC)
+// ==========================================
+// A fixed-size, String-free copy of PlantThresholds. It can be stored in NVS
+// so the face is right from the first frame after a reboot, or kept in RTC
+// memory across deep sleep. The version stamp changes whenever this layout
+// does; a blob with another version is ignored and the defaults are used.
+
+#define THRESHOLD_CACHE_VERSION 1
+
+struct PackedThresholds {
+  uint16_t version;
+  int16_t  moistureLow;
+  int16_t  moistureHigh;
+  float    tempHigh;
+  float    tempLow;
+  float    luxLow;
+  float    luxHigh;
+  float    humidityHigh;
+  float    humidityLow;
+  char     species[SPECIES_NAME_MAX];
+};
+
+void packThresholds(const PlantThresholds &th, PackedThresholds &out);
+bool unpackThresholds(const PackedThresholds &p, PlantThresholds &out);  // false on version mismatch
+
+// NVS namespace "thresholds", one key per plant ("last" for plant 0, as
+// before racks). save() skips the flash write if nothing changed.
+bool loadCachedThresholds(uint8_t plant, PlantThresholds &out);
+void saveCachedThresholds(uint8_t plant, const PlantThresholds &th);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <Arduino.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+// ==========================================
+// RESUMABLE TLS CLIENT (mbedTLS)
+// ==========================================
+// WiFiClientSecure runs a full handshake on every connect. On the ESP32
+// that means ECDHE + certificate parsing: 1-3 s of CPU and two round trips.
+// This client keeps the session it negotiated (session ID and, if the
+// server issues one, a ticket) and offers it on the next connect. A
+// reconnect after a WiFi drop or a server-side idle close is then an
+// abbreviated handshake: one round trip and no public-key math. A rejected
+// offer just falls back to a full handshake.
+//
+// The server certificate is verified against the core's CA bundle (the
+// public roots, esp_crt_bundle.h), or against the one CA given to
+// setCaCert(), and must match the host name. A resumed session was verified
+// when it was first negotiated.
+//
+// Reads block up to the timeout given to connect(). The record buffers are
+// allocated by connect() and freed by stop().
+
+struct TlsStats {
+  uint32_t connects;          // Attempts
+  uint32_t failures;          // TCP or handshake failures
+  uint32_t fullHandshakes;
+  uint32_t resumed;           // Abbreviated handshakes (saved session accepted)
+  uint32_t fullMsTotal;       // Handshake time, for the means
+  uint32_t resumedMsTotal;
+  uint32_t handshakeMsMax;
+};
+
+class TlsSession {
+public:
+  TlsSession();
+  ~TlsSession();
+
+  // PEM of the only CA to trust (a private broker, a local RTDB stand-in);
+  // NULL = the CA bundle. Before the first connect; the text must stay valid.
+  void setCaCert(const char *pem);
+
+  bool connect(const char *host, uint16_t port, uint32_t timeoutMs);
+  void stop();                  // Keeps the saved session for the next connect
+  void forgetSession();
+  bool connected() const { return open; }
+
+  // True if an idle connection can't be reused: the server closed it (FIN or
+  // close_notify) or sent something nobody asked for. Only meaningful with
+  // no response outstanding.
+  bool stale();
+  // True if a read would find data without waiting (buffered, or arriving on
+  // the socket). For connections the server also writes on unasked (MQTT).
+  bool readable();
+
+  bool   write(const uint8_t *data, size_t len);
+  size_t readUntil(char term, char *out, size_t max);   // Like Stream::readBytesUntil
+  size_t read(uint8_t *out, size_t len);                // Blocks until len bytes, close or timeout
+
+  const TlsStats &stats() const { return st; }
+
+private:
+  bool setup();
+  bool fill();
+  bool fail();
+
+  mbedtls_net_context      net;
+  mbedtls_ssl_context      ssl;
+  mbedtls_ssl_config       conf;
+  mbedtls_entropy_context  entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_ssl_session      saved;
+  mbedtls_x509_crt         ca;
+  const char              *caPem       = NULL;
+  bool                     configured  = false;
+  bool                     haveSession = false;
+  bool                     open        = false;
+  uint8_t                  rx[256];    // Small reads (header lines) come from here
+  size_t                   rxPos = 0;
+  size_t                   rxLen = 0;
+  TlsStats                 st = {0, 0, 0, 0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+
+// ==========================================
+// LOCK-FREE SNAPSHOT (TRIPLE BUFFER)
+// ==========================================
+// One writer publishes whole values, one reader always sees the latest
+// complete one. Each of the three slots is owned by exactly one side at a
+// time (writer's back, shared middle, reader's front). T is plain data
+// (ThresholdSet, animation scenes): slots are copied by value and never
+// allocate, so a publish costs no heap traffic on either core.
+template <typename T>
+class TripleBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "TripleBuffer holds plain data");
+
+public:
+  explicit TripleBuffer(const T &initial) {
+    for (int i = 0; i < 3; i++) slots[i] = initial;
+  }
+
+  // ---- Writer side ----
+  T &back() { return slots[backIdx]; }
+
+  // Hand the back slot over to the reader and take the old middle slot.
+  void publish() {
+    uint8_t prev = middle.exchange(backIdx | DIRTY, std::memory_order_acq_rel);
+    backIdx = prev & INDEX_MASK;
+  }
+
+  // ---- Reader side ----
+  // Picks up the newest published value; returns true if it changed.
+  bool update() {
+    if (!(middle.load(std::memory_order_acquire) & DIRTY)) return false;
+    uint8_t prev = middle.exchange(frontIdx, std::memory_order_acq_rel);
+    frontIdx = prev & INDEX_MASK;
+    return true;
+  }
+
+  const T &front() const { return slots[frontIdx]; }
+
+private:
+  static const uint8_t DIRTY      = 0x80;
+  static const uint8_t INDEX_MASK = 0x03;
+
+  T slots[3];
+  std::atomic<uint8_t> middle{1};
+  uint8_t backIdx  = 0;  // Writer-owned
+  uint8_t frontIdx = 2;  // Reader-owned
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include "hal.h"
+
+// ==========================================
+// WINDOWED AGGREGATION (Welford)
+// ==========================================
+// At 1 Hz, most raw points are near-duplicates. The sensor task feeds every
+// sample into per-plant aggregates instead. Each closed window keeps
+// n/min/max/mean/variance per field, and those summaries are what the
+// network task uploads (stats/minute, stats/hour). Per sample this is O(1): one
+// Welford update per field. Hour windows are built by merging the minute
+// summaries (Chan et al.), not by revisiting samples. Plain C++, so it
+// builds on the host.
+
+// Welford running statistics. float is enough: windows hold at most a few
+// thousand samples, and Welford doesn't cancel catastrophically like
+// sum/sum-of-squares does. The ESP32 has no double-precision FPU.
+struct RunningStats {
+  uint32_t n;
+  float    min;
+  float    max;
+  float    mean;
+  float    m2;     // Sum of squared deviations from the mean
+
+  void  reset();
+  void  add(float x);
+  void  merge(const RunningStats &o);
+  float variance() const { return n > 1 ? m2 / (n - 1) : 0.0f; }   // Sample variance
+  float stddev() const;
+};
+
+enum AggWindow : uint8_t {
+  AGG_MINUTE = 0,
+  AGG_HOUR,
+  AGG_WINDOWS
+};
+
+// Fields summarized (soil_raw is only a debugging aid)
+#define AGG_FIELD_MASK (FIELD_MASK_ALL & ~FIELD_BIT(FIELD_SOIL_RAW))
+
+struct WindowSummary {
+  uint8_t       plant;        // Set by the caller
+  AggWindow     window;
+  uint32_t      boot;         // Boot counter, set by the caller: with index, unique across reboots
+  uint32_t      index;        // Window number since boot (startMs / length)
+  unsigned long startMs;
+  uint32_t      lengthMs;
+  RunningStats  field[FIELD_COUNT];   // Only AGG_FIELD_MASK fields are filled
+};
+
+class WindowAggregator {
+public:
+  // Window lengths in ms; the hour length must be a multiple of the minute length
+  WindowAggregator(uint32_t minuteMs = 60000, uint32_t hourMs = 3600000)
+    : lengthMs{ minuteMs, hourMs } { clear(); }
+
+  void clear();
+
+  // NaN fields are skipped (a failed DHT22 read doesn't poison the window),
+  // and so are fields outside `fields` (values held from an earlier read)
+  void add(const Telemetry &t, unsigned long nowMs, uint8_t fields = FIELD_MASK_ALL);
+
+  // Closed windows, each returned once. A window closes on the first sample
+  // past its end. Windows with no samples at all are never reported.
+  bool takeClosed(AggWindow w, WindowSummary &out);
+
+  uint32_t length(AggWindow w) const { return lengthMs[w]; }
+
+private:
+  void roll(unsigned long nowMs);
+
+  uint32_t      lengthMs[AGG_WINDOWS];
+  bool          started;
+  uint32_t      index[AGG_WINDOWS];
+  RunningStats  open[AGG_WINDOWS][FIELD_COUNT];
+  bool          hasClosed[AGG_WINDOWS];
+  WindowSummary closed[AGG_WINDOWS];
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "boot_sequence.h"
+
+// xorshift32: the jitter only has to differ between units
+uint32_t BootSequence::nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+BootAction BootSequence::enter(BootStage s, uint32_t nowMs) {
+  current = s;
+  since   = nowMs;
+  switch (s) {
+    case BOOT_LINK_FAST: link.attempts++; return BOOT_ACT_CONNECT_FAST;
+    case BOOT_LINK_SCAN: link.attempts++; return BOOT_ACT_CONNECT_SCAN;
+    case BOOT_AUTH:      link.attempts++; return BOOT_ACT_AUTH;
+    case BOOT_ONLINE:    return BOOT_ACT_SYNC;
+    default:             return BOOT_ACT_NONE;
+  }
+}
+
+// Wait min * 2^(failed-1), capped, drawn from the upper half of that
+BootAction BootSequence::fail(BootStage wait, uint32_t nowMs) {
+  if (failed < 31) failed++;
+  uint32_t d = t.backoffMinMs;
+  for (uint8_t i = 1; i < failed && d < t.backoffMaxMs; i++) d *= 2;
+  if (d > t.backoffMaxMs) d = t.backoffMaxMs;
+  waitMs = d - (d / 2 ? nextRandom() % (d / 2 + 1) : 0);
+  return enter(wait, nowMs);
+}
+
+BootAction BootSequence::drop(BootStage wait, uint32_t nowMs) {
+  link.drops++;
+  outageStart = nowMs;
+  failed      = 0;
+  return fail(wait, nowMs);
+}
+
+BootAction BootSequence::reachOnline(uint32_t nowMs) {
+  if (!metrics.cloudMs) metrics.cloudMs = nowMs;
+  if (tracking) {
+    uint32_t outage = nowMs - outageStart;
+    link.reconnectMs.record(outage);
+    link.lastOutageMs = outage;
+    if (outage > link.longestOutageMs) link.longestOutageMs = outage;
+  }
+  tracking = true;
+  failed   = 0;
+  return enter(BOOT_ONLINE, nowMs);
+}
+
+BootAction BootSequence::retryLink(uint32_t nowMs) {
+  return enter(cachedAp ? BOOT_LINK_FAST : BOOT_LINK_SCAN, nowMs);
+}
+
+void BootSequence::account(uint32_t nowMs) {
+  uint32_t dt = nowMs - lastStep;
+  lastStep = nowMs;
+  if (!tracking) return;
+  link.trackedMs += dt;
+  if (current == BOOT_ONLINE) link.onlineMs += dt;
+}
+
+uint32_t BootSequence::retryInMs(uint32_t nowMs) const {
+  if (current != BOOT_LINK_WAIT && current != BOOT_AUTH_WAIT) return 0;
+  uint32_t elapsed = nowMs - since;
+  return elapsed < waitMs ? waitMs - elapsed : 0;
+}
+
+BootAction BootSequence::step(bool linkUp, bool cloudReady, uint32_t nowMs) {
+  account(nowMs);
+  uint32_t elapsed = nowMs - since;
+
+  switch (current) {
+    case BOOT_START:
+      return retryLink(nowMs);
+
+    case BOOT_LINK_FAST:
+    case BOOT_LINK_SCAN:
+    case BOOT_LINK_WAIT:
+      if (linkUp) {
+        // A join can still complete after its attempt timed out, so LINK_WAIT can land here too
+        if (!metrics.linkMs) {
+          metrics.linkMs   = nowMs;
+          metrics.fastLink = current == BOOT_LINK_FAST;
+        }
+        cachedAp = true;   // The caller saves the AP it just joined
+        // After a short drop the sign-in is usually still good
+        return cloudReady ? reachOnline(nowMs) : enter(BOOT_AUTH, nowMs);
+      }
+      if (current == BOOT_LINK_FAST && elapsed >= t.fastLinkMs) return enter(BOOT_LINK_SCAN, nowMs);
+      if (current == BOOT_LINK_SCAN && elapsed >= t.scanLinkMs) {
+        link.failures++;
+        return fail(BOOT_LINK_WAIT, nowMs);
+      }
+      if (current == BOOT_LINK_WAIT && elapsed >= waitMs) return retryLink(nowMs);
+      return BOOT_ACT_NONE;
+
+    case BOOT_AUTH:
+    case BOOT_AUTH_WAIT:
+      if (cloudReady) return reachOnline(nowMs);
+      if (!linkUp) return fail(BOOT_LINK_WAIT, nowMs);
+      if (current == BOOT_AUTH && elapsed >= t.authRetryMs) {
+        link.failures++;
+        return fail(BOOT_AUTH_WAIT, nowMs);
+      }
+      if (current == BOOT_AUTH_WAIT && elapsed >= waitMs) return enter(BOOT_AUTH, nowMs);
+      return BOOT_ACT_NONE;
+
+    case BOOT_ONLINE:
+      if (!linkUp)     return drop(BOOT_LINK_WAIT, nowMs);
+      if (!cloudReady) return drop(BOOT_AUTH_WAIT, nowMs);
+      return BOOT_ACT_NONE;
+  }
+  return BOOT_ACT_NONE;
+}
@@ -0,0 +1,67 @@
+#include "delta_filter.h"
+#include "telemetry_json.h"
+
+const char *telemetryFieldKey(int field) {
+  return (field >= 0 && field < FIELD_COUNT) ? TELEMETRY_FIELDS[field].key : "";
+}
+
+float telemetryFieldValue(const Telemetry &t, int field) {
+  switch (field) {
+    case FIELD_TEMPERATURE:   return t.temperature;
+    case FIELD_HUMIDITY:      return t.humidity;
+    case FIELD_SOIL_MOISTURE: return t.soilMoisture;
+    case FIELD_SOIL_RAW:      return t.soilRaw;
+    case FIELD_LIGHT:         return t.lux;
+  }
+  return 0;
+}
+
+void telemetrySetField(Telemetry &t, int field, float v) {
+  switch (field) {
+    case FIELD_TEMPERATURE:   t.temperature  = v; break;
+    case FIELD_HUMIDITY:      t.humidity     = v; break;
+    case FIELD_SOIL_MOISTURE: t.soilMoisture = lroundf(v); break;
+    case FIELD_SOIL_RAW:      t.soilRaw      = lroundf(v); break;
+    case FIELD_LIGHT:         t.lux          = v; break;
+  }
+}
+
+uint8_t DeltaFilter::changedFields(const Telemetry &t, unsigned long nowMs) const {
+  if (!primed || nowMs - lastFullMs >= cfg.heartbeatMs) return FIELD_MASK_ALL;
+
+  uint8_t mask = 0;
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    float v    = telemetryFieldValue(t, f);
+    float band = max(cfg.deadband[f].absolute, cfg.deadband[f].relative * fabsf(last[f]));
+    if (fabsf(v - last[f]) > band) mask |= FIELD_BIT(f);
+  }
+  return mask;
+}
+
+void DeltaFilter::commit(const Telemetry &t, uint8_t mask, unsigned long nowMs) {
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (mask & FIELD_BIT(f)) last[f] = telemetryFieldValue(t, f);
+  }
+  if (mask == FIELD_MASK_ALL) {
+    primed = true;
+    lastFullMs = nowMs;
+  }
+}
+
+void DeltaFilter::account(const Telemetry &t, uint8_t mask) {
+  stats.samples++;
+  stats.fullBytes += telemetryPayloadBytes(t, FIELD_MASK_ALL);
+  if (mask) {
+    stats.requests++;
+    stats.sentBytes += telemetryPayloadBytes(t, mask);
+  }
+}
+
+size_t telemetryPayloadBytes(const Telemetry &t, uint8_t mask) {
+  // Exactly what the serializer would write for a single plant
+  JsonOut out(NULL, 0);
+  out.beginObject();
+  jsonTelemetry(out, "", t, mask);
+  out.endObject();
+  return out.total();
+}
@@ -0,0 +1,75 @@
+#include "dht22_decoder.h"
+#include <math.h>
+
+// Acceptance windows (µs). Generous on purpose: the sensor's own timing
+// drifts with supply voltage and cable length.
+#define DHT_RESPONSE_MIN  60
+#define DHT_RESPONSE_MAX  110
+#define DHT_BIT_LOW_MIN   30
+#define DHT_BIT_LOW_MAX   85
+#define DHT_BIT_HIGH_MIN  10
+#define DHT_BIT_HIGH_MAX  95
+#define DHT_ONE_THRESHOLD 48   // HIGH longer than this = 1
+
+DhtStatus dhtDecodeBits(const DhtPulse *pulses, size_t count, uint8_t bytes[5]) {
+  // Locate the sensor's response (LOW ~80 µs followed by HIGH ~80 µs)
+  size_t i = 0;
+  for (; i + 1 < count; i++) {
+    if (pulses[i].level == 0 && pulses[i + 1].level == 1 &&
+        pulses[i].us >= DHT_RESPONSE_MIN && pulses[i].us <= DHT_RESPONSE_MAX &&
+        pulses[i + 1].us >= DHT_RESPONSE_MIN && pulses[i + 1].us <= DHT_RESPONSE_MAX) {
+      break;
+    }
+  }
+  if (i + 1 >= count) return DHT_ERR_NO_RESPONSE;
+  i += 2;
+
+  for (int b = 0; b < 5; b++) bytes[b] = 0;
+
+  for (int bit = 0; bit < 40; bit++, i += 2) {
+    if (i + 1 >= count) return DHT_ERR_SHORT;
+    const DhtPulse &lo = pulses[i];
+    const DhtPulse &hi = pulses[i + 1];
+    if (lo.level != 0 || hi.level != 1) return DHT_ERR_TIMING;
+    if (lo.us < DHT_BIT_LOW_MIN || lo.us > DHT_BIT_LOW_MAX) return DHT_ERR_TIMING;
+    if (hi.us < DHT_BIT_HIGH_MIN || hi.us > DHT_BIT_HIGH_MAX) return DHT_ERR_TIMING;
+
+    bytes[bit / 8] <<= 1;
+    if (hi.us > DHT_ONE_THRESHOLD) bytes[bit / 8] |= 1;
+  }
+  return DHT_OK;
+}
+
+DhtStatus dht22Decode(const DhtPulse *pulses, size_t count, DhtReading &out) {
+  uint8_t b[5];
+  out.temperature = NAN;
+  out.humidity    = NAN;
+
+  out.status = dhtDecodeBits(pulses, count, b);
+  if (out.status != DHT_OK) return out.status;
+
+  if ((uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4]) return out.status = DHT_ERR_CHECKSUM;
+
+  float humidity = ((b[0] << 8) | b[1]) * 0.1f;
+  float temp     = (((b[2] & 0x7F) << 8) | b[3]) * 0.1f;
+  if (b[2] & 0x80) temp = -temp;
+  if (humidity > 100.0f || temp < -40.0f || temp > 80.0f) return out.status = DHT_ERR_RANGE;
+
+  out.humidity    = humidity;
+  out.temperature = temp;
+  return out.status = DHT_OK;
+}
+
+const char *dhtStatusName(DhtStatus status) {
+  switch (status) {
+    case DHT_OK:              return "ok";
+    case DHT_ERR_NO_RESPONSE: return "no response";
+    case DHT_ERR_TIMING:      return "bad timing";
+    case DHT_ERR_SHORT:       return "short frame";
+    case DHT_ERR_CHECKSUM:    return "checksum";
+    case DHT_ERR_RANGE:       return "out of range";
+    case DHT_ERR_TIMEOUT:     return "timeout";
+    case DHT_PENDING:         return "pending";
+  }
+  return "?";
+}
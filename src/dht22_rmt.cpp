@@ -0,0 +1,87 @@
+#include "dht22_rmt.h"
+
+#define DHT_START_LOW_US    1200   // Host start pulse (datasheet: ≥ 1 ms)
+#define DHT_IDLE_US         200    // Line idle this long = frame complete
+#define DHT_CAPTURE_TIMEOUT 20     // ms; a full frame takes ~5 ms
+#define DHT_MAX_PULSES      96     // 2 response + 80 bit pulses + slack
+
+bool Dht22Rmt::begin() {
+  rmt_config_t cfg = RMT_DEFAULT_CONFIG_RX(pin, channel);
+  cfg.clk_div = 80;                              // 80 MHz APB / 80 = 1 µs ticks
+  cfg.mem_block_num = 1;                         // 64 items = 128 pulses
+  cfg.rx_config.idle_threshold = DHT_IDLE_US;
+  cfg.rx_config.filter_en = true;
+  cfg.rx_config.filter_ticks_thresh = 100;       // Ignore glitches < 1.25 µs (APB ticks)
+
+  if (rmt_config(&cfg) != ESP_OK) return false;
+  if (rmt_driver_install(channel, 1024, 0) != ESP_OK) return false;
+  rmt_get_ringbuf_handle(channel, &ring);
+
+  // Open-drain with pull-up: we can pull the line low while the RMT keeps
+  // listening on the same pin
+  gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+  gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_set_level(pin, 1);
+
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = &Dht22Rmt::onStartPulseDone;
+  timerArgs.arg = this;
+  timerArgs.name = "dht22";
+  return esp_timer_create(&timerArgs, &timer) == ESP_OK;
+}
+
+bool Dht22Rmt::start() {
+  if (state != IDLE || !timer) return false;
+  if (everStarted && millis() - startedMs < DHT22_MIN_INTERVAL_MS) return false;
+
+  startedMs = millis();
+  everStarted = true;
+  state = HOLD_LOW;
+  gpio_set_level(pin, 0);
+  esp_timer_start_once(timer, DHT_START_LOW_US);
+  return true;
+}
+
+// esp_timer task context: begin capturing, then let the sensor talk
+void Dht22Rmt::onStartPulseDone(void *arg) {
+  Dht22Rmt *self = (Dht22Rmt *)arg;
+  rmt_rx_start(self->channel, true);
+  gpio_set_level(self->pin, 1);
+  self->state = CAPTURING;
+}
+
+bool Dht22Rmt::poll(DhtReading &out) {
+  if (state != CAPTURING) return false;
+
+  size_t bytes = 0;
+  rmt_item32_t *items = (rmt_item32_t *)xRingbufferReceive(ring, &bytes, 0);
+  if (!items) {
+    if (millis() - startedMs < DHT_CAPTURE_TIMEOUT) return false;
+    rmt_rx_stop(channel);
+    state = IDLE;
+    out = { NAN, NAN, DHT_ERR_TIMEOUT, (uint32_t)millis() };
+    errors++;
+    return true;
+  }
+
+  // Flatten RMT items (two level/duration halves each) into pulses
+  DhtPulse pulses[DHT_MAX_PULSES];
+  size_t n = 0;
+  size_t itemCount = bytes / sizeof(rmt_item32_t);
+  for (size_t i = 0; i < itemCount && n + 2 <= DHT_MAX_PULSES; i++) {
+    if (items[i].duration0 == 0) break;
+    pulses[n++] = { (uint8_t)items[i].level0, (uint16_t)items[i].duration0 };
+    if (items[i].duration1 == 0) break;
+    pulses[n++] = { (uint8_t)items[i].level1, (uint16_t)items[i].duration1 };
+  }
+  vRingbufferReturnItem(ring, items);
+  rmt_rx_stop(channel);
+  state = IDLE;
+
+  dht22Decode(pulses, n, out);
+  out.timestampMs = startedMs;
+  frames++;
+  if (out.status == DHT_OK) lastValid = out;
+  else errors++;
+  return true;
+}
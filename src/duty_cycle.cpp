@@ -0,0 +1,60 @@
+#include "duty_cycle.h"
+
+#define MIN_SLEEP_MS 10  // Always sleep a little, even if the cycle overran
+
+// ================= ENERGY LEDGER =================
+// mA × µs → mA·h: divide by 3.6e9
+float EnergyLedger::mAh(const PowerModel &m) const {
+  double cpuUs = (double)(awakeUs - radioUs);
+  double mAus  = cpuUs * m.awakeMa + (double)radioUs * m.radioMa +
+                 (double)lightSleepUs * m.lightSleepMa + (double)deepSleepUs * m.deepSleepMa;
+  return (float)(mAus / 3.6e9);
+}
+
+float EnergyLedger::averageMa(const PowerModel &m) const {
+  uint64_t totalUs = awakeUs + lightSleepUs + deepSleepUs;
+  return totalUs ? (float)(mAh(m) * 3.6e9 / (double)totalUs) : 0.0f;
+}
+
+// ================= SCHEDULER =================
+void DutyCycle::reset() {
+  st = DutyCycleState{};
+  st.magic = DUTY_CYCLE_MAGIC;
+}
+
+bool DutyCycle::uploadDue(size_t pending, bool urgent, uint32_t awakeUs) const {
+  bool periodDue = nowMs(awakeUs) - st.lastAttemptMs >= cfg.uploadPeriodMs;
+  if (st.lastFailed) return periodDue;  // Don't burn the battery on a dead network
+  return !st.attempted || urgent || pending >= cfg.batchMax || periodDue;
+}
+
+SleepPlan DutyCycle::finish(bool attempted, bool uploaded, uint32_t awakeUs, uint32_t radioUs) {
+  // Stamp the attempt with its wake, not its end: the radio time would push
+  // every retry one whole sample period late
+  if (attempted) {
+    st.lastAttemptMs = st.clockMs;
+    st.attempted     = true;
+    st.lastFailed    = !uploaded;
+    if (uploaded) st.ledger.uploads++;
+  }
+
+  // Carry the sub-millisecond part, or the clock loses up to 1 ms per cycle
+  uint64_t awakeTotalUs = st.clockRemUs + (uint64_t)awakeUs;
+  uint32_t awakeMs      = (uint32_t)(awakeTotalUs / 1000);
+  st.clockRemUs = (uint32_t)(awakeTotalUs % 1000);
+  st.clockMs   += awakeMs;
+
+  // Sleep for whatever is left of the period
+  SleepPlan p;
+  p.ms   = awakeMs + MIN_SLEEP_MS < cfg.samplePeriodMs ? cfg.samplePeriodMs - awakeMs : MIN_SLEEP_MS;
+  p.kind = p.ms <= cfg.lightSleepMaxMs ? SLEEP_LIGHT : SLEEP_DEEP;
+  st.clockMs += p.ms;
+
+  EnergyLedger &l = st.ledger;
+  l.cycles++;
+  l.awakeUs += awakeUs;
+  l.radioUs += radioUs;
+  if (p.kind == SLEEP_LIGHT) l.lightSleepUs += (uint64_t)p.ms * 1000;
+  else                       l.deepSleepUs  += (uint64_t)p.ms * 1000;
+  return p;
+}
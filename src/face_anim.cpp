@@ -0,0 +1,157 @@
+#include "face_anim.h"
+
+// Rows as bits of a 64-bit panel column (bit n = row n)
+#define FACE_AREA  (~0ULL << FACE_TOP_ROW)
+#define EYE_BAND   ((~0ULL << ANIM_EYE_TOP) & (~0ULL >> (63 - ANIM_EYE_BOTTOM)))
+#define LID_MAX    (ANIM_EYE_ROW - ANIM_EYE_TOP)
+#define DISSOLVE_LEVELS 16
+
+// 4x4 ordered dither: a pixel shows the new face once the level passes its entry
+static const uint8_t BAYER4[4][4] = {
+  {  0,  8,  2, 10 },
+  { 12,  4, 14,  6 },
+  {  3, 11,  1,  9 },
+  { 15,  7, 13,  5 },
+};
+
+static inline uint64_t gatherColumn(const uint8_t *pages, int c) {
+  uint64_t col = 0;
+  for (int p = 0; p < FACE_PAGES; p++) col |= (uint64_t)pages[p * OLED_COLUMNS + c] << (8 * (p + FACE_FIRST_PAGE));
+  return col;
+}
+
+// xorshift32: blink gaps only need to look irregular
+uint32_t FaceAnimator::nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+void FaceAnimator::setFace(int face, unsigned long nowMs) {
+  if (face < 0 || face >= FACE_COUNT) face = 0;
+  if (face == target) return;
+  if (target >= 0) {
+    from            = target;   // Mid-dissolve: restart from the face being left
+    transitionStart = nowMs;
+  }
+  target = face;
+}
+
+void FaceAnimator::setStatusBar(const uint8_t *frame) {
+  const uint8_t rowsOfPage1 = (uint8_t)(0xFF >> (16 - FACE_TOP_ROW));   // Rows 8..11
+  for (int c = 0; c < OLED_COLUMNS; c++) {
+    status[c] = frame[c] | (uint16_t)(frame[OLED_COLUMNS + c] & rowsOfPage1) << 8;
+  }
+  statusVersion++;
+}
+
+FaceAnimator::FrameKey FaceAnimator::frameKey(unsigned long nowMs) {
+  FrameKey k = { target, -1, DISSOLVE_LEVELS, 0, 0, statusVersion };
+
+  if (from >= 0) {
+    unsigned long t = nowMs - transitionStart;
+    if (t >= cfg.transitionMs) {
+      from = -1;
+    } else {
+      k.from  = from;
+      k.level = (uint8_t)(t * DISSOLVE_LEVELS / cfg.transitionMs);
+    }
+  }
+
+  // Blinks that come due mid-dissolve or on a face without blinking eyes are skipped
+  if (!blinkArmed) {
+    blinkStart = nowMs - cfg.blinkMs;
+    nextBlink  = nowMs + cfg.blinkGapMs / 2 + nextRandom() % (cfg.blinkGapMs + 1);
+    blinkArmed = true;
+  }
+  if ((long)(nowMs - nextBlink) >= 0) {
+    if (from < 0 && (cfg.blinkFaces & (1u << target))) blinkStart = nowMs;
+    nextBlink = nowMs + cfg.blinkMs + cfg.blinkGapMs / 2 + nextRandom() % (cfg.blinkGapMs + 1);
+  }
+  unsigned long b = nowMs - blinkStart;
+  if (from < 0 && b < cfg.blinkMs) {
+    uint32_t half = cfg.blinkMs / 2 ? cfg.blinkMs / 2 : 1;
+    uint32_t x    = b < half ? b : cfg.blinkMs - b;        // Shut at the midpoint
+    k.lid = (uint8_t)min((x * LID_MAX + half / 2) / half, (uint32_t)LID_MAX);
+  }
+
+  if (cfg.breathPx && cfg.breathMs >= 2) {
+    uint32_t half  = cfg.breathMs / 2;
+    uint32_t phase = nowMs % cfg.breathMs;
+    uint32_t x     = phase < half ? phase : cfg.breathMs - phase;
+    k.breath = (uint8_t)((cfg.breathPx * x + half / 2) / half);
+  }
+  return k;
+}
+
+bool FaceAnimator::render(unsigned long nowMs, uint8_t *frame) {
+  if (target < 0 || !faces.ready()) return false;
+  FrameKey k = frameKey(nowMs);
+  if (drawn && k.face == last.face && k.from == last.from && k.level == last.level &&
+      k.lid == last.lid && k.breath == last.breath && k.status == last.status) return false;
+  last  = k;
+  drawn = true;
+
+  const uint8_t *to  = faces.facePages(k.face);
+  const uint8_t *old = k.from >= 0 ? faces.facePages(k.from) : NULL;
+
+  // Dissolve masks for the four column phases of the dither pattern
+  uint64_t reveal[4];
+  for (int x = 0; x < 4; x++) {
+    uint64_t nibble = 0;
+    for (int r = 0; r < 4; r++) {
+      if (BAYER4[r][x] < k.level) nibble |= 1u << r;
+    }
+    reveal[x] = nibble * 0x1111111111111111ULL;
+  }
+
+  // Blink: each row of the eye band shows a row further from the eye line
+  int8_t lidSource[ANIM_EYE_BOTTOM - ANIM_EYE_TOP + 1];
+  if (k.lid) {
+    int open = LID_MAX - k.lid;
+    for (int y = ANIM_EYE_TOP; y <= ANIM_EYE_BOTTOM; y++) {
+      int d   = y - ANIM_EYE_ROW;
+      int src = open ? ANIM_EYE_ROW + d * LID_MAX / open : (d ? -1 : ANIM_EYE_ROW);
+      lidSource[y - ANIM_EYE_TOP] = src >= ANIM_EYE_TOP && src <= ANIM_EYE_BOTTOM ? src : -1;
+    }
+  }
+
+  for (int c = 0; c < OLED_COLUMNS; c++) {
+    uint64_t col = gatherColumn(to, c);
+    if (old) {
+      uint64_t m = reveal[c & 3];
+      col = (gatherColumn(old, c) & ~m) | (col & m);
+    } else if (k.lid && c >= ANIM_EYE_LEFT && c <= ANIM_EYE_RIGHT && (col & EYE_BAND)) {
+      uint64_t squashed = col & ~EYE_BAND;
+      for (int y = ANIM_EYE_TOP; y <= ANIM_EYE_BOTTOM; y++) {
+        int8_t src = lidSource[y - ANIM_EYE_TOP];
+        if (src >= 0 && ((col >> src) & 1)) squashed |= 1ULL << y;
+      }
+      col = squashed;
+    }
+    col = ((col << k.breath) & FACE_AREA) | status[c];
+    for (int p = 0; p < OLED_PAGES; p++) frame[p * OLED_COLUMNS + c] = (uint8_t)(col >> (8 * p));
+  }
+  return true;
+}
+
+// ================= FRAME BUDGET =================
+void FrameBudget::tick(uint32_t nowUs) {
+  if (ticks && nowUs - lastTickUs > periodUs + periodUs / 2) late++;
+  lastTickUs = nowUs;
+  ticks++;
+}
+
+void FrameBudget::record(uint32_t render, uint32_t flush) {
+  drawn++;
+  renderUs.record(render);
+  flushUs.record(flush);
+  if (render + flush > periodUs) overruns++;
+}
+
+void FrameBudget::reset() {
+  ticks = drawn = overruns = late = 0;
+  renderUs.reset();
+  flushUs.reset();
+}
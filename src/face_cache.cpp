@@ -0,0 +1,21 @@
+#include "face_cache.h"
+
+void FaceCache::build(DisplayHal &screen, void (*render)(int face)) {
+  // Page 1 holds rows 8..15; keep only the face rows (12..15)
+  const uint8_t faceMask = (uint8_t)(0xFF << (FACE_TOP_ROW - FACE_FIRST_PAGE * 8));
+
+  for (int face = 0; face < FACE_COUNT; face++) {
+    screen.clear();
+    render(face);
+    memcpy(pages[face], screen.framebuffer() + FACE_FIRST_PAGE * OLED_COLUMNS, sizeof(pages[face]));
+    for (int c = 0; c < OLED_COLUMNS; c++) pages[face][0][c] &= faceMask;
+  }
+  screen.clear();
+  built = true;
+}
+
+void FaceCache::compose(int face, uint8_t *frame) const {
+  if (face < 0 || face >= FACE_COUNT) face = 0;
+  memset(frame, 0, FACE_FIRST_PAGE * OLED_COLUMNS);
+  memcpy(frame + FACE_FIRST_PAGE * OLED_COLUMNS, pages[face], sizeof(pages[face]));
+}
@@ -0,0 +1,111 @@
+#include "face_rules.h"
+#include "bitmaps.h"
+
+// ================= RULE TABLE =================
+// Same order and outcome as the old if/else chain: soil first, then air
+// temperature, humidity and light. Bands/dwell are sized to the sensors'
+// noise: the DHT22 wobbles ±0.5 °C / ±2 %RH, light drifts with clouds.
+constexpr FaceRule FACE_RULES[FACE_RULE_COUNT] = {
+  // field                cmp        threshold          face              prio  hysteresis      dwell
+  { FIELD_SOIL_MOISTURE, CMP_BELOW, TH_MOISTURE_LOW,   FACE_THIRSTY,     0,   { 2.0f,  0.0f }, 10000 },
+  { FIELD_SOIL_MOISTURE, CMP_ABOVE, TH_MOISTURE_HIGH,  FACE_OVERWATERED, 0,   { 2.0f,  0.0f }, 10000 },
+  { FIELD_TEMPERATURE,   CMP_ABOVE, TH_TEMP_HIGH,      FACE_HOT,         1,   { 0.5f,  0.0f }, 10000 },
+  { FIELD_TEMPERATURE,   CMP_BELOW, TH_TEMP_LOW,       FACE_COLD,        1,   { 0.5f,  0.0f }, 10000 },
+  { FIELD_HUMIDITY,      CMP_ABOVE, TH_HUMIDITY_HIGH,  FACE_HUMID,       2,   { 2.0f,  0.0f }, 10000 },
+  { FIELD_HUMIDITY,      CMP_BELOW, TH_HUMIDITY_LOW,   FACE_DRY_AIR,     2,   { 2.0f,  0.0f }, 10000 },
+  { FIELD_LIGHT,         CMP_BELOW, TH_LUX_LOW,        FACE_DARK,        3,   { 10.0f, 0.1f }, 30000 },
+  { FIELD_LIGHT,         CMP_ABOVE, TH_LUX_HIGH,       FACE_BRIGHT,      3,   { 10.0f, 0.1f }, 30000 },
+};
+
+// evaluate() takes the first active rule, so the table must be sorted by priority
+constexpr bool rulesSorted(size_t i) {
+  return i + 1 >= FACE_RULE_COUNT ||
+         (FACE_RULES[i].priority <= FACE_RULES[i + 1].priority && rulesSorted(i + 1));
+}
+static_assert(rulesSorted(0), "FACE_RULES must be ordered by priority");
+
+static const char *const FACE_NAMES[] = {
+  "happy", "thirsty", "overwatered", "hot", "cold", "dark", "bright", "humid", "dry_air"
+};
+
+const char *faceName(int face) {
+  return (face >= 0 && face < (int)(sizeof(FACE_NAMES) / sizeof(FACE_NAMES[0]))) ? FACE_NAMES[face] : "none";
+}
+
+// ================= CLASSIFIER =================
+FaceClassifier::FaceClassifier() {
+  for (int i = 0; i < FACE_RULE_COUNT; i++) active[i] = pending[i] = 0;
+  for (int p = 0; p < MAX_PLANTS; p++) current[p] = FACE_NONE;
+}
+
+bool FaceClassifier::subscribe(FaceListener listener) {
+  if (listenerCount >= FACE_MAX_LISTENERS) return false;
+  listeners[listenerCount++] = listener;
+  return true;
+}
+
+uint32_t FaceClassifier::evaluate(PlantRack &rack, unsigned long nowMs) {
+  uint8_t  n      = rack.count;
+  uint32_t all    = n >= 32 ? 0xFFFFFFFFu : (1u << n) - 1;
+  uint32_t fresh  = all & ~primed;
+  uint32_t winner[FACE_RULE_COUNT];   // Plants for which rule i is the winning rule
+  uint32_t decided = 0;
+  stats.evaluations += n;
+
+  for (int i = 0; i < FACE_RULE_COUNT; i++) {
+    const FaceRule &r      = FACE_RULES[i];
+    const float    *value  = rack.reading[r.field];
+    const float    *limit  = rack.threshold[r.threshold];
+    uint32_t        act    = active[i];
+    uint32_t        pend   = pending[i];
+
+    for (uint8_t p = 0; p < n; p++) {
+      float v = value[p], th = limit[p];
+      if (isnan(v) || isnan(th)) continue;
+
+      // Tripped rules must come back past the band before they clear
+      uint32_t bit  = 1u << p;
+      bool     was  = act & bit;
+      float    band = was ? max(r.hysteresis.absolute, r.hysteresis.relative * fabsf(th)) : 0;
+      bool     trip = (r.cmp == CMP_BELOW) ? v < th + band : v > th - band;
+
+      if (fresh & bit) {
+        act = trip ? act | bit : act & ~bit;
+      } else if (trip == was) {
+        if (pend & bit) stats.debounced++;
+        pend &= ~bit;
+      } else if (!(pend & bit)) {
+        pend |= bit;
+        pendingSince[i][p] = nowMs;
+      } else if (nowMs - pendingSince[i][p] >= r.dwellMs) {
+        act ^= bit;
+        pend &= ~bit;
+      }
+    }
+
+    active[i]  = act;
+    pending[i] = pend;
+    winner[i]  = act & all & ~decided;
+    decided   |= winner[i];
+  }
+  primed |= all;
+
+  uint32_t changed = 0;
+  for (uint8_t p = 0; p < n; p++) {
+    uint32_t bit  = 1u << p;
+    int      rule = -1;
+    if (decided & bit) {
+      for (rule = 0; !(winner[rule] & bit); rule++) {}
+    }
+    uint8_t face = rule < 0 ? FACE_HAPPY : FACE_RULES[rule].face;
+    rack.face[p] = face;
+    if (face == current[p]) continue;
+
+    FaceEvent ev = { p, current[p], face, (int8_t)rule, nowMs };
+    current[p] = face;
+    changed |= bit;
+    stats.transitions++;
+    for (uint8_t i = 0; i < listenerCount; i++) listeners[i](ev);
+  }
+  return changed;
+}
@@ -0,0 +1,931 @@
+#include "hal_esp32.h"
+#include "thirst_forecast.h"
+#include "window_stats.h"
+#include <WiFi.h>
+#include <Wire.h>
+#include <esp_sleep.h>
+#include <freertos/semphr.h>
+
+// ================= SHARED I2C BUS =================
+// The BH1750s and mux (sensor task) share the bus with the OLED (animation
+// task). Wire locks single transactions, but a mux select + read + deselect
+// or an OLED clock change must not be split, so every such sequence holds
+// this mutex. The OLED takes it per page, so a light reading waits for at
+// most one page (~3 ms at 400 kHz). The mutex has priority inheritance.
+#define I2C_BUS_HZ 400000   // BH1750 and TCA9548A: fast mode at most
+
+static SemaphoreHandle_t i2cMutex = NULL;
+
+static void i2cBusBegin() {
+  if (!i2cMutex) i2cMutex = xSemaphoreCreateMutex();
+}
+
+// Holds the bus for a scope; a faster device clock applies only inside it
+class I2cBusLock {
+public:
+  explicit I2cBusLock(uint32_t hz = I2C_BUS_HZ) : hz(hz) {
+    if (i2cMutex) xSemaphoreTake(i2cMutex, portMAX_DELAY);
+    if (hz != I2C_BUS_HZ) Wire.setClock(hz);
+  }
+  ~I2cBusLock() {
+    if (hz != I2C_BUS_HZ) Wire.setClock(I2C_BUS_HZ);
+    if (i2cMutex) xSemaphoreGive(i2cMutex);
+  }
+
+private:
+  uint32_t hz;
+};
+
+// ================= SENSORS =================
+#define DHT_STALE_MS    10000  // Older air readings are reported as NAN
+#define MUX_ADDR        0x70   // TCA9548A, A0-A2 -> GND
+#define MUX_BH1750_ADDR 0x5C   // BH1750 with ADDR->VCC
+
+Esp32Sensors::Esp32Sensors(const PlantConfig *plants, uint8_t count, int dryRaw, int wetRaw)
+  : plants(plants), count(min(count, (uint8_t)MAX_PLANTS)), moisture(moisturePins, this->count),
+    dryRaw(dryRaw), wetRaw(wetRaw) {
+  for (uint8_t p = 0; p < this->count; p++) {
+    moisturePins[p] = plants[p].moisturePin;
+    oneShotLux[p]   = -1;
+
+    // Plants without their own DHT22 read plant 0's
+    int8_t pin = plants[p].dhtPin != NO_PIN ? plants[p].dhtPin : plants[0].dhtPin;
+    uint8_t k = 0;
+    while (k < dhtCount && dhtPins[k] != pin) k++;
+    if (k == dhtCount) {
+      dhtPins[k] = pin;
+      dht[dhtCount++] = new Dht22Rmt(pin, (rmt_channel_t)(RMT_CHANNEL_0 + k));
+    }
+    dhtOf[p] = k;
+  }
+}
+
+bool Esp32Sensors::beginDhts() {
+  bool ok = true;
+  for (uint8_t k = 0; k < dhtCount; k++) {
+    if (!dht[k]->begin()) {
+      Serial.printf("✗ DHT22 #%u RMT capture setup failed!\n", k);
+      ok = false;
+    } else if (!oneShot) {
+      dht[k]->start();  // First frame is ready well before the first sample tick
+    }
+  }
+  return ok;
+}
+
+bool Esp32Sensors::beginLight(BH1750::Mode mode) {
+  i2cBusBegin();
+  I2cBusLock lock;
+  bool ok = true;
+  bool shared = false;
+  for (uint8_t p = 0; p < count; p++) {
+    if (plants[p].lightMux == NO_PIN) {
+      shared = true;
+      continue;
+    }
+    selectMux(plants[p].lightMux);
+    if (!muxMeters[p].begin(mode, MUX_BH1750_ADDR, &Wire)) {
+      Serial.printf("✗ BH1750 for plant %u (mux channel %d) initialization failed!\n", p, plants[p].lightMux);
+      ok = false;
+    }
+  }
+  selectMux(NO_PIN);
+
+  if (shared) {
+    if (lightMeter.begin(mode)) {
+      Serial.println("✓ BH1750 initialized (ADDR->GND)");
+    } else {
+      Serial.println("✗ BH1750 initialization failed!");
+      Serial.println("  Check: ADDR->GND for 0x23 address");
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool Esp32Sensors::begin() {
+  // Initialize the BH1750(s)
+  bool ok = beginLight(BH1750::CONTINUOUS_HIGH_RES_MODE);
+
+  // Start Other Sensors
+  if (!beginDhts()) ok = false;
+  moisture.begin(dryRaw, wetRaw);  // Falls back to analogRead() if DMA fails
+  Serial.printf("✓ DHT22 (%u) and Moisture sensors (%u) initialized\n", dhtCount, count);
+  return ok;
+}
+
+// BH1750 one-time mode powers itself down after each conversion; low
+// resolution (4 lx) converts in ~16 ms instead of ~120 ms
+bool Esp32Sensors::beginOneShot() {
+  oneShot = true;
+  bool ok = beginLight(BH1750::ONE_TIME_LOW_RES_MODE);
+  if (!beginDhts()) ok = false;
+  moisture.beginOneShot(dryRaw, wetRaw);
+  return ok;
+}
+
+void Esp32Sensors::selectMux(int8_t channel) {
+  Wire.beginTransmission(MUX_ADDR);
+  Wire.write((uint8_t)(channel == NO_PIN ? 0 : 1 << channel));
+  Wire.endTransmission();
+}
+
+#define ONE_SHOT_TIMEOUT_MS 60  // DHT22 frame ≈ 5 ms, BH1750 low-res ≤ 24 ms
+
+// All conversions run in parallel: start the light and air sensors, sample
+// the soil probes while they work, then wait for everything to finish
+bool Esp32Sensors::sampleOnce() {
+  I2cBusLock lock;   // Low-power mode has no animation task; held for the whole burst
+  bool shared = false;
+  for (uint8_t p = 0; p < count; p++) {
+    oneShotLux[p] = -1;
+    if (plants[p].lightMux == NO_PIN) {
+      shared = true;
+      continue;
+    }
+    selectMux(plants[p].lightMux);
+    muxMeters[p].configure(BH1750::ONE_TIME_LOW_RES_MODE);
+  }
+  selectMux(NO_PIN);
+  if (shared) lightMeter.configure(BH1750::ONE_TIME_LOW_RES_MODE);
+  for (uint8_t k = 0; k < dhtCount; k++) dht[k]->start();
+  moisture.sampleBurst();
+
+  uint32_t airDone = 0, luxDone = 0, ok = 0;
+  uint32_t allAir = (1u << dhtCount) - 1, allLux = (1u << count) - 1;
+  uint32_t t0 = millis();
+  while ((airDone != allAir || luxDone != allLux) && millis() - t0 < ONE_SHOT_TIMEOUT_MS) {
+    for (uint8_t k = 0; k < dhtCount; k++) {
+      DhtReading r;
+      if ((airDone & (1u << k)) || !dht[k]->poll(r)) continue;
+      airDone |= 1u << k;
+      if (r.status == DHT_OK) ok |= 1u << k;
+      else Serial.printf("[DHT22] #%u read failed: %s\n", k, dhtStatusName(r.status));
+    }
+    if (shared && !(luxDone & 1u) && lightMeter.measurementReady()) {
+      float lux = lightMeter.readLightLevel();
+      for (uint8_t p = 0; p < count; p++) {
+        if (plants[p].lightMux == NO_PIN) {
+          oneShotLux[p] = lux;
+          luxDone |= 1u << p;
+        }
+      }
+    }
+    for (uint8_t p = 0; p < count; p++) {
+      if ((luxDone & (1u << p)) || plants[p].lightMux == NO_PIN) continue;
+      selectMux(plants[p].lightMux);
+      if (muxMeters[p].measurementReady()) {
+        oneShotLux[p] = muxMeters[p].readLightLevel();
+        luxDone |= 1u << p;
+      }
+    }
+    selectMux(NO_PIN);
+    if (airDone != allAir || luxDone != allLux) delay(1);
+  }
+  return ok == allAir && luxDone == allLux;
+}
+
+// Collect a finished capture (if any) and start the next one when allowed
+bool Esp32Sensors::airFresh(uint8_t k) {
+  DhtReading r;
+  if (dht[k]->poll(r) && r.status != DHT_OK) {
+    Serial.printf("[DHT22] #%u read failed: %s\n", k, dhtStatusName(r.status));
+  }
+  if (!oneShot) dht[k]->start();  // One-shot: sampleOnce() owns the captures
+
+  const DhtReading &last = dht[k]->last();
+  return last.status == DHT_OK && millis() - last.timestampMs < DHT_STALE_MS;
+}
+
+float Esp32Sensors::measureLux(uint8_t p) {
+  I2cBusLock lock;
+  if (plants[p].lightMux == NO_PIN) return lightMeter.readLightLevel();
+  selectMux(plants[p].lightMux);
+  float lux = muxMeters[p].readLightLevel();
+  selectMux(NO_PIN);
+  return lux;
+}
+
+float Esp32Sensors::readTemperature(uint8_t p) { return airFresh(dhtOf[p]) ? dht[dhtOf[p]]->last().temperature : NAN; }
+float Esp32Sensors::readHumidity(uint8_t p)    { return airFresh(dhtOf[p]) ? dht[dhtOf[p]]->last().humidity : NAN; }
+int   Esp32Sensors::readMoistureRaw(uint8_t p)     { return lroundf(moisture.raw(p)); }
+int   Esp32Sensors::readMoisturePercent(uint8_t p) { return moisture.percent(p); }
+float Esp32Sensors::readLux(uint8_t p)         { return oneShot ? oneShotLux[p] : measureLux(p); }
+
+// ================= POWER =================
+bool     Esp32Power::wokeFromDeepSleep() { return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER; }
+uint64_t Esp32Power::nowUs()             { return esp_timer_get_time(); }
+
+void Esp32Power::lightSleep(uint32_t ms) {
+  Serial.flush();  // The UART is clock-gated in light sleep
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+  esp_light_sleep_start();
+}
+
+void Esp32Power::deepSleep(uint32_t ms) {
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+  esp_deep_sleep_start();
+}
+
+// ================= DISPLAY =================
+// i2cHz during OLED transfers, I2C_BUS_HZ after: writeRegion() doesn't go
+// through the library, so the bus must not drop back to 100 kHz after a
+// full display()
+Ssd1306Display::Ssd1306Display(uint8_t width, uint8_t height, uint8_t addr, uint32_t i2cHz)
+  : oled(width, height, &Wire, -1, i2cHz, I2C_BUS_HZ), addr(addr), i2cHz(i2cHz) {}
+
+void Ssd1306Display::flush() {
+  I2cBusLock lock;   // display() switches the clock itself
+  oled.display();
+}
+
+bool Ssd1306Display::begin() {
+  i2cBusBegin();
+  I2cBusLock lock;
+  // Initialize OLED - try the configured address first, then 0x3D
+  if (oled.begin(SSD1306_SWITCHCAPVCC, addr)) {
+    Serial.printf("✓ OLED initialized at 0x%02X\n", addr);
+    return true;
+  }
+  if (addr != 0x3D && oled.begin(SSD1306_SWITCHCAPVCC, 0x3D)) {
+    Serial.println("✓ OLED initialized at 0x3D");
+    addr = 0x3D;
+    return true;
+  }
+  Serial.println("✗ OLED initialization FAILED!");
+  Serial.println("  Check: VCC->3.3V, GND->GND, SDA->21, SCL->22");
+  return false;
+}
+
+// Partial update: point the controller's page/column window at the span and
+// stream just those bytes (horizontal addressing mode, set by begin()).
+// Each transaction costs address + control byte + payload.
+#define OLED_I2C_CHUNK 64   // Stays well inside the ESP32 Wire buffer
+
+size_t Ssd1306Display::writeRegion(uint8_t page, uint8_t col0, uint8_t col1) {
+  const uint8_t cmds[] = { SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, col0, col1 };
+  size_t bytes = 0;
+  I2cBusLock lock(i2cHz);
+
+  Wire.beginTransmission(addr);
+  Wire.write((uint8_t)0x00);  // Co = 0, D/C = 0: command stream
+  Wire.write(cmds, sizeof(cmds));
+  Wire.endTransmission();
+  bytes += 2 + sizeof(cmds);
+
+  const uint8_t *data = oled.getBuffer() + page * oled.width() + col0;
+  size_t remaining = col1 - col0 + 1;
+  while (remaining > 0) {
+    size_t n = min(remaining, (size_t)OLED_I2C_CHUNK);
+    Wire.beginTransmission(addr);
+    Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1: data stream
+    Wire.write(data, n);
+    Wire.endTransmission();
+    bytes += 2 + n;
+    data += n;
+    remaining -= n;
+  }
+  return bytes;
+}
+
+// ================= FIREBASE =================
+#define PLANTS_ROOT "/plants"
+
+FirebaseCloud::FirebaseCloud(const char *apiKey, const char *databaseUrl, const char *caCert,
+                             const PlantConfig *plants, uint8_t count)
+  : apiKey(apiKey), databaseUrl(databaseUrl), caCert(caCert), plants(plants), count(min(count, (uint8_t)MAX_PLANTS)) {
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) fetches[p].state = FETCH_IDLE;
+}
+
+void FirebaseCloud::plantPath(uint8_t plant, const char *child, char *out, size_t len) const {
+  snprintf(out, len, PLANTS_ROOT "/%s%s", plants[plant].id, child);
+}
+
+bool FirebaseCloud::begin() {
+  config.api_key = apiKey;
+  config.database_url = databaseUrl;
+
+  // Sign up anonymously (Test Mode allows this)
+  if (Firebase.signUp(&config, &auth, "", "")) {
+    Serial.println("✓ Firebase Auth Successful");
+    signupOK = true;
+  } else {
+    Serial.printf("✗ Firebase Error: %s\n", config.signer.signupError.message.c_str());
+  }
+
+  Firebase.begin(&config, &auth);
+  Firebase.reconnectWiFi(false);   // Rejoins are the boot sequence's job (with backoff)
+  rest.begin(databaseUrl, caCert);
+  return signupOK;
+}
+
+bool FirebaseCloud::linkUp() { return WiFi.status() == WL_CONNECTED; }
+bool FirebaseCloud::ready()  { return Firebase.ready() && signupOK; }
+
+// Body writers for rest.patch(): each runs twice per request (count, send)
+struct TelemetryBody {
+  const PlantConfig *plants;
+  const Telemetry   *samples;
+  const uint8_t     *fieldMasks;
+  uint8_t            n;
+};
+
+struct BacklogBody {
+  const PlantConfig  *plants;
+  uint8_t             count;
+  const LoggedSample *samples;
+  size_t              n;
+};
+
+struct FaceBody {
+  const char   *face;
+  unsigned long sinceMs;
+};
+
+static void writeTelemetryBody(JsonOut &out, const void *ctx) {
+  const TelemetryBody &b = *(const TelemetryBody *)ctx;
+  char prefix[40];
+  out.beginObject();
+  for (uint8_t p = 0; p < b.n; p++) {
+    if (!b.fieldMasks[p]) continue;
+    snprintf(prefix, sizeof(prefix), "%s/", b.plants[p].id);
+    jsonTelemetry(out, prefix, b.samples[p], b.fieldMasks[p]);
+  }
+  out.endObject();
+}
+
+static void writeBacklogBody(JsonOut &out, const void *ctx) {
+  const BacklogBody &b = *(const BacklogBody *)ctx;
+  char prefix[56];
+  out.beginObject();
+  for (size_t i = 0; i < b.n; i++) {
+    if (b.samples[i].plant >= b.count) continue;  // Logged with a bigger plant table
+    snprintf(prefix, sizeof(prefix), "%s/history/%08lu/",
+             b.plants[b.samples[i].plant].id, (unsigned long)b.samples[i].seq);
+    jsonTelemetry(out, prefix, b.samples[i].data, FIELD_MASK_ALL);
+    out.key(prefix, "boot");
+    out.uinteger(b.samples[i].boot);
+  }
+  out.endObject();
+}
+
+struct SummariesBody {
+  const PlantConfig   *plants;
+  uint8_t              count;
+  const WindowSummary *summaries;
+  size_t               n;
+};
+
+static const char *const WINDOW_KEYS[AGG_WINDOWS] = { "minute", "hour" };
+
+// {"<id>/stats/minute/<boot>_<index>/temperature/mean":..,...}. Means and
+// spreads get one more decimal than the live field; empty fields are left out.
+static void writeSummariesBody(JsonOut &out, const void *ctx) {
+  const SummariesBody &b = *(const SummariesBody *)ctx;
+  char prefix[80];
+  out.beginObject();
+  for (size_t i = 0; i < b.n; i++) {
+    const WindowSummary &s = b.summaries[i];
+    if (s.plant >= b.count) continue;
+    int base = snprintf(prefix, sizeof(prefix), "%s/stats/%s/%05lu_%06lu/",
+                        b.plants[s.plant].id, WINDOW_KEYS[s.window],
+                        (unsigned long)s.boot, (unsigned long)s.index);
+    out.key(prefix, "start_ms");
+    out.uinteger((uint32_t)s.startMs);
+    out.key(prefix, "window_ms");
+    out.uinteger(s.lengthMs);
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      const RunningStats &r = s.field[f];
+      if (!r.n) continue;
+      const TelemetryFieldDesc &d = TELEMETRY_FIELDS[f];
+      snprintf(prefix + base, sizeof(prefix) - base, "%s/", d.key);
+      out.key(prefix, "n");
+      out.uinteger(r.n);
+      out.key(prefix, "min");
+      out.fixed(r.min, d.decimals);
+      out.key(prefix, "max");
+      out.fixed(r.max, d.decimals);
+      out.key(prefix, "mean");
+      out.fixed(r.mean, d.decimals + 1);
+      out.key(prefix, "sd");
+      out.fixed(r.stddev(), d.decimals + 1);
+    }
+  }
+  out.endObject();
+}
+
+struct ForecastBody {
+  const PlantConfig    *plants;
+  const ThirstForecast *forecasts;
+  uint8_t               n;
+};
+
+// {"<id>/forecast/hours_to_thirsty":..,...}; no forecast is written as null
+static void writeForecastBody(JsonOut &out, const void *ctx) {
+  const ForecastBody &b = *(const ForecastBody *)ctx;
+  char prefix[48];
+  out.beginObject();
+  for (uint8_t p = 0; p < b.n; p++) {
+    const ThirstForecast &f = b.forecasts[p];
+    snprintf(prefix, sizeof(prefix), "%s/forecast/", b.plants[p].id);
+    out.key(prefix, "hours_to_thirsty");
+    out.fixed(f.hoursToThirsty, 1);
+    out.key(prefix, "level");
+    out.fixed(f.level, 1);
+    out.key(prefix, "drying_rate");
+    out.fixed(f.dryingRate, 3);
+    out.key(prefix, "at_ms");
+    out.uinteger((uint32_t)f.atMs);
+    out.key(prefix, "last_watered_ms");
+    out.uinteger((uint32_t)f.lastWateredMs);
+    out.key(prefix, "waterings");
+    out.uinteger(f.waterings);
+  }
+  out.endObject();
+}
+
+static void writeTransportBody(JsonOut &out, const void *ctx) {
+  const TransportStats &t = *(const TransportStats *)ctx;
+  const struct { const char *key; uint32_t value; } fields[] = {
+    { "requests", t.requests },           { "failures", t.failures },
+    { "retries", t.retries },             { "pipelined", t.pipelined },
+    { "connects", t.connects },           { "full_handshakes", t.fullHandshakes },
+    { "resumed_handshakes", t.resumedHandshakes },
+    { "full_handshake_ms", t.fullHandshakeMs },
+    { "resumed_handshake_ms", t.resumedHandshakeMs },
+    { "latency_p50_ms", t.latencyP50Ms }, { "latency_p95_ms", t.latencyP95Ms },
+    { "latency_max_ms", t.latencyMaxMs },
+  };
+  out.beginObject();
+  for (const auto &f : fields) {
+    out.key(NULL, f.key);
+    out.uinteger(f.value);
+  }
+  out.endObject();
+}
+
+static void writeHeapBody(JsonOut &out, const void *ctx) {
+  const HeapStats &h = *(const HeapStats *)ctx;
+  out.beginObject();
+  out.key(NULL, "heap_free");
+  out.uinteger(h.freeBytes);
+  out.key(NULL, "heap_largest_block");
+  out.uinteger(h.largestBlock);
+  out.key(NULL, "heap_min_free");
+  out.uinteger(h.minFreeBytes);
+  out.key(NULL, "uptime_ms");
+  out.uinteger((uint32_t)h.uptimeMs);
+  out.endObject();
+}
+
+struct StagesBody {
+  const StageSummary *stages;
+  uint8_t             n;
+};
+
+// {"<stage>/p50_us":..,"<stage>/p95_us":..,...}: one multi-path update
+static void writeStagesBody(JsonOut &out, const void *ctx) {
+  const StagesBody &b = *(const StagesBody *)ctx;
+  char prefix[32];
+  out.beginObject();
+  for (uint8_t i = 0; i < b.n; i++) {
+    const StageSummary &s = b.stages[i];
+    if (!s.count) continue;
+    snprintf(prefix, sizeof(prefix), "%s/", s.name);
+    out.key(prefix, "count");
+    out.uinteger(s.count);
+    out.key(prefix, "p50_us");
+    out.uinteger(s.p50Us);
+    out.key(prefix, "p95_us");
+    out.uinteger(s.p95Us);
+    out.key(prefix, "max_us");
+    out.uinteger(s.maxUs);
+  }
+  out.endObject();
+}
+
+static void writeFaceBody(JsonOut &out, const void *ctx) {
+  const FaceBody &b = *(const FaceBody *)ctx;
+  out.beginObject();
+  out.key(NULL, "face");
+  out.string(b.face);
+  out.key(NULL, "face_since");
+  out.uinteger((uint32_t)b.sinceMs);
+  out.endObject();
+}
+
+bool FirebaseCloud::patch(const char *path, RtdbRest::BodyWriter body, const void *ctx) {
+  return rest.patch(path, body, ctx, Firebase.getToken());
+}
+
+// One multi-path PATCH at /plants: "<id>/<field>" for every changed field of
+// every plant, so a rack costs one HTTPS round trip per cycle, not one per plant
+bool FirebaseCloud::uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t n) {
+  // PATCH (not PUT) so the app-owned children survive; silent = no echoed body
+  TelemetryBody body = { plants, samples, fieldMasks, min(n, count) };
+  return patch(PLANTS_ROOT, writeTelemetryBody, &body);
+}
+
+// Writes every sample as <id>/history/<seq>/{...} in a single multi-path
+// update, so a backlog of N samples costs one HTTPS round trip instead of N.
+bool FirebaseCloud::uploadBacklog(const LoggedSample *samples, size_t n) {
+  BacklogBody body = { plants, count, samples, n };
+  return patch(PLANTS_ROOT, writeBacklogBody, &body);
+}
+
+// Written only when the face changes, next to the live telemetry
+bool FirebaseCloud::uploadFaceState(uint8_t plant, const char *face, unsigned long sinceMs) {
+  char path[48];
+  plantPath(plant, "", path, sizeof(path));
+  FaceBody body = { face, sinceMs };
+  return patch(path, writeFaceBody, &body);
+}
+
+// Every pending window of every plant in one multi-path update at /plants
+bool FirebaseCloud::uploadSummaries(const WindowSummary *summaries, size_t n) {
+  SummariesBody body = { plants, count, summaries, n };
+  return patch(PLANTS_ROOT, writeSummariesBody, &body);
+}
+
+bool FirebaseCloud::uploadForecasts(const ThirstForecast *forecasts, uint8_t n) {
+  ForecastBody body = { plants, forecasts, min(n, count) };
+  return patch(PLANTS_ROOT, writeForecastBody, &body);
+}
+
+// The device's health sits with its first plant, the one the app pairs with
+bool FirebaseCloud::uploadHeapStats(const HeapStats &heap) {
+  char path[56];
+  plantPath(0, "/diagnostics", path, sizeof(path));
+  return patch(path, writeHeapBody, &heap);
+}
+
+bool FirebaseCloud::uploadStageSummaries(const StageSummary *stages, uint8_t n) {
+  char path[64];
+  plantPath(0, "/diagnostics/stages", path, sizeof(path));
+  StagesBody body = { stages, n };
+  return patch(path, writeStagesBody, &body);
+}
+
+bool FirebaseCloud::uploadTransportStats(const TransportStats &t) {
+  char path[64];
+  plantPath(0, "/diagnostics/transport", path, sizeof(path));
+  return patch(path, writeTransportBody, &t);
+}
+
+TransportStats FirebaseCloud::transportStats() {
+  const RtdbStats &r = rest.stats();
+  const TlsStats  &s = rest.tlsStats();
+  TransportStats t;
+  t.requests           = r.requests;
+  t.failures           = r.failures;
+  t.retries            = r.retries;
+  t.pipelined          = r.pipelined;
+  t.connects           = s.connects;
+  t.fullHandshakes     = s.fullHandshakes;
+  t.resumedHandshakes  = s.resumed;
+  t.fullHandshakeMs    = s.fullHandshakes ? s.fullMsTotal / s.fullHandshakes : 0;
+  t.resumedHandshakeMs = s.resumed ? s.resumedMsTotal / s.resumed : 0;
+  t.latencyP50Ms       = r.latencyMs.percentile(0.50f);
+  t.latencyP95Ms       = r.latencyMs.percentile(0.95f);
+  t.latencyMaxMs       = r.latencyMs.maximum();
+  return t;
+}
+
+String FirebaseCloud::lastError() {
+  return String(rest.lastError());
+}
+
+// Expected keys (written by the Flutter app): moisture_low, moisture_high,
+// temp_high, temp_low, lux_low, lux_high, humidity_high, humidity_low, species
+void FirebaseCloud::applyThresholdsJson(FirebaseJson &json, PlantThresholds &out) {
+  FirebaseJsonData jsonData;
+
+  if (json.get(jsonData, "moisture_low"))    out.moistureLow  = jsonData.intValue;
+  if (json.get(jsonData, "moisture_high"))   out.moistureHigh = jsonData.intValue;
+  if (json.get(jsonData, "temp_high"))       out.tempHigh     = jsonData.floatValue;
+  if (json.get(jsonData, "temp_low"))        out.tempLow      = jsonData.floatValue;
+  if (json.get(jsonData, "lux_low"))         out.luxLow       = jsonData.floatValue;
+  if (json.get(jsonData, "lux_high"))        out.luxHigh      = jsonData.floatValue;
+  if (json.get(jsonData, "humidity_high"))   out.humidityHigh = jsonData.floatValue;
+  if (json.get(jsonData, "humidity_low"))    out.humidityLow  = jsonData.floatValue;
+  if (json.get(jsonData, "species"))         strlcpy(out.speciesName, jsonData.stringValue.c_str(), sizeof(out.speciesName));
+}
+
+// A single pushed key (stream event at /thresholds/<key>)
+bool FirebaseCloud::applyThresholdKey(const char *key, FirebaseData &data, PlantThresholds &out) {
+  String type = data.dataType();
+  if (strcmp(key, "species") == 0) {
+    if (type != "string") return false;
+    strlcpy(out.speciesName, data.stringData().c_str(), sizeof(out.speciesName));
+    return true;
+  }
+
+  if (type == "int")                            return thresholdsApplyNumber(key, data.intData(), out);
+  if (type == "float" || type == "double")      return thresholdsApplyNumber(key, data.floatData(), out);
+  return false;
+}
+
+void FirebaseCloud::onThresholds(void *ctx, int status, const char *body, size_t len) {
+  ThresholdFetch &f = *(ThresholdFetch *)ctx;
+  bool ok = status >= 200 && status < 300 && thresholdsApplyJson(body, len, f.value);
+  f.state = ok ? FETCH_DONE : FETCH_FAILED;
+}
+
+bool FirebaseCloud::requestThresholds(uint8_t plant, const PlantThresholds &current) {
+  if (plant >= count) return false;
+  ThresholdFetch &f = fetches[plant];
+  f.value = current;
+  f.state = FETCH_SENT;
+  char path[64];
+  plantPath(plant, "/thresholds", path, sizeof(path));
+  return rest.get(path, onThresholds, &f, Firebase.getToken());
+}
+
+bool FirebaseCloud::takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) {
+  if (plant >= count) return false;
+  ThresholdFetch &f = fetches[plant];
+  if (f.state != FETCH_DONE && f.state != FETCH_FAILED) return false;
+  ok = f.state == FETCH_DONE;
+  if (ok) out = f.value;
+  f.state = FETCH_IDLE;
+  return true;
+}
+
+// RTDB streams are Server-Sent Events over a kept-alive HTTPS connection:
+// the server pushes the full node once, then only changed keys. Steady state
+// costs nothing but the server's keep-alive events. Each stream holds its
+// own TLS session (~40 KB of heap), so only plant 0 gets one.
+bool FirebaseCloud::beginThresholdStream() {
+  if (streamOK) Firebase.RTDB.endStream(&stream);
+  char path[64];
+  plantPath(0, "/thresholds", path, sizeof(path));
+  streamOK = Firebase.RTDB.beginStream(&stream, path);
+  if (!streamOK) {
+    Serial.print("[Thresholds] Stream failed: ");
+    Serial.println(stream.errorReason());
+  }
+  return streamOK;
+}
+
+bool FirebaseCloud::pollThresholdStream(PlantThresholds &out) {
+  if (!streamOK) return false;
+
+  if (!Firebase.RTDB.readStream(&stream)) {
+    Serial.print("[Thresholds] Stream lost: ");
+    Serial.println(stream.errorReason());
+    streamOK = false;
+    return false;
+  }
+  if (!stream.streamAvailable()) return false;
+
+  String path = stream.dataPath();
+  if (path == "/") {
+    // Whole node (initial snapshot, or the app rewrote every key)
+    if (stream.dataType() != "json") return false;
+    applyThresholdsJson(stream.jsonObject(), out);
+    return true;
+  }
+  // Single key, e.g. "/temp_high"
+  return applyThresholdKey(path.c_str() + 1, stream, out);
+}
+
+// ================= MQTT =================
+#define MQTT_TOPIC_ROOT "gaia"
+
+MqttCloud::MqttCloud(const MqttConfig &config, const PlantConfig *plants, uint8_t count)
+  : config(config), plants(plants), count(min(count, (uint8_t)MAX_PLANTS)) {
+  const PlantThresholds defaults = PLANT_THRESHOLDS_DEFAULT;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) fetches[p] = { defaults, FETCH_IDLE };
+}
+
+void MqttCloud::plantTopic(uint8_t plant, const char *child, char *out, size_t len) const {
+  snprintf(out, len, MQTT_TOPIC_ROOT "/%s/%s", plants[plant].id, child);
+}
+
+// The first plant's id doubles as the client id: one session per device
+bool MqttCloud::begin() {
+  subscribed  = 0;
+  streamOK    = false;
+  streamDirty = false;
+  mqtt.begin(config.brokerUrl, plants[0].id, config.user, config.password, config.caCert);
+  mqtt.onMessage(onMessage, this);
+  if (!mqtt.connect()) {
+    Serial.printf("✗ MQTT Error: %s\n", mqtt.lastError());
+    return false;
+  }
+  Serial.println("✓ MQTT session open");
+  return true;
+}
+
+bool MqttCloud::linkUp() { return WiFi.status() == WL_CONNECTED; }
+
+struct CborBody {
+  const uint8_t *data;
+  size_t         len;
+};
+
+static void writeCborBody(JsonOut &out, const void *ctx) {
+  const CborBody &b = *(const CborBody *)ctx;
+  out.put((const char *)b.data, b.len);
+}
+
+// One PUBLISH per plant with changes; at QoS 1, one round trip for all of them
+bool MqttCloud::uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t n) {
+  char    topic[48];
+  uint8_t cbor[TELEMETRY_CBOR_MAX];
+  bool    ok = true;
+  for (uint8_t p = 0; p < min(n, count) && ok; p++) {
+    if (!fieldMasks[p]) continue;
+    plantTopic(p, "telemetry", topic, sizeof(topic));
+    CborBody body = { cbor, cborTelemetry(samples[p], fieldMasks[p], cbor, sizeof(cbor)) };
+    ok = mqtt.publish(topic, writeCborBody, &body, config.telemetryQos, false);
+  }
+  return ok && (!config.telemetryQos || mqtt.awaitAcks());
+}
+
+// Up to MQTT_INFLIGHT samples in flight at a time; the seq in the topic keeps
+// replays idempotent on the bridge
+bool MqttCloud::uploadBacklog(const LoggedSample *samples, size_t n) {
+  char    topic[64];
+  uint8_t cbor[TELEMETRY_CBOR_LOGGED_MAX];
+  for (size_t i = 0; i < n; i++) {
+    const LoggedSample &s = samples[i];
+    if (s.plant >= count) continue;   // Logged with a bigger plant table
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_ROOT "/%s/history/%08lu", plants[s.plant].id, (unsigned long)s.seq);
+    CborBody body = { cbor, cborLoggedSample(s, cbor, sizeof(cbor)) };
+    if (!mqtt.publish(topic, writeCborBody, &body, 1, false)) return false;
+  }
+  return mqtt.awaitAcks();
+}
+
+// Retained, so a dashboard that subscribes later still gets the current face
+bool MqttCloud::uploadFaceState(uint8_t plant, const char *face, unsigned long sinceMs) {
+  if (plant >= count) return false;
+  char topic[48];
+  plantTopic(plant, "face", topic, sizeof(topic));
+  FaceBody body = { face, sinceMs };
+  return mqtt.publish(topic, writeFaceBody, &body, 1, true) && mqtt.awaitAcks();
+}
+
+bool MqttCloud::uploadSummaries(const WindowSummary *summaries, size_t n) {
+  char topic[48];
+  plantTopic(0, "update", topic, sizeof(topic));
+  SummariesBody body = { plants, count, summaries, n };
+  return mqtt.publish(topic, writeSummariesBody, &body, 1, false) && mqtt.awaitAcks();
+}
+
+bool MqttCloud::uploadForecasts(const ThirstForecast *forecasts, uint8_t n) {
+  char topic[48];
+  plantTopic(0, "update", topic, sizeof(topic));
+  ForecastBody body = { plants, forecasts, min(n, count) };
+  return mqtt.publish(topic, writeForecastBody, &body, 1, false) && mqtt.awaitAcks();
+}
+
+// Diagnostics are periodic snapshots: the next one replaces a lost one
+bool MqttCloud::uploadHeapStats(const HeapStats &heap) {
+  char topic[48];
+  plantTopic(0, "diagnostics", topic, sizeof(topic));
+  return mqtt.publish(topic, writeHeapBody, &heap, 0, true);
+}
+
+bool MqttCloud::uploadStageSummaries(const StageSummary *stages, uint8_t n) {
+  char topic[56];
+  plantTopic(0, "diagnostics/stages", topic, sizeof(topic));
+  StagesBody body = { stages, n };
+  return mqtt.publish(topic, writeStagesBody, &body, 0, true);
+}
+
+bool MqttCloud::uploadTransportStats(const TransportStats &t) {
+  char topic[56];
+  plantTopic(0, "diagnostics/transport", topic, sizeof(topic));
+  return mqtt.publish(topic, writeTransportBody, &t, 0, true);
+}
+
+// Messages count as requests; nothing is ever re-sent by the client itself
+TransportStats MqttCloud::transportStats() {
+  const MqttStats &m = mqtt.stats();
+  const TlsStats  &s = mqtt.tlsStats();
+  TransportStats t;
+  t.requests           = m.published;
+  t.failures           = m.failures;
+  t.retries            = 0;
+  t.pipelined          = m.pipelined;
+  t.connects           = s.connects;
+  t.fullHandshakes     = s.fullHandshakes;
+  t.resumedHandshakes  = s.resumed;
+  t.fullHandshakeMs    = s.fullHandshakes ? s.fullMsTotal / s.fullHandshakes : 0;
+  t.resumedHandshakeMs = s.resumed ? s.resumedMsTotal / s.resumed : 0;
+  t.latencyP50Ms       = m.latencyMs.percentile(0.50f);
+  t.latencyP95Ms       = m.latencyMs.percentile(0.95f);
+  t.latencyMaxMs       = m.latencyMs.maximum();
+  return t;
+}
+
+// gaia/<id>/thresholds, as the app writes it to the RTDB node. Applied on top
+// of the last known values, so keys left out keep theirs.
+void MqttCloud::onMessage(void *ctx, const char *topic, size_t topicLen, const uint8_t *payload, size_t len) {
+  MqttCloud &c = *(MqttCloud *)ctx;
+  char expected[48];
+  for (uint8_t p = 0; p < c.count; p++) {
+    c.plantTopic(p, "thresholds", expected, sizeof(expected));
+    if (strlen(expected) != topicLen || memcmp(expected, topic, topicLen) != 0) continue;
+
+    ThresholdFetch &f = c.fetches[p];
+    if (!len) return;   // Retained message cleared: nothing to apply
+    if (!thresholdsApplyJson((const char *)payload, len, f.value)) {
+      Serial.printf("[Thresholds] Ignored a malformed message for %s\n", c.plants[p].id);
+      return;
+    }
+    // An answer to requestThresholds() completes with finishRequests();
+    // a push to plant 0 goes out through the stream poll, the others as a
+    // finished read
+    if (f.state == FETCH_SENT) return;
+    if (p == 0 && c.streamOK) c.streamDirty = true;
+    else                      f.state = FETCH_DONE;
+    return;
+  }
+}
+
+bool MqttCloud::subscribeThresholds(uint16_t plantMask) {
+  char        topics[MAX_PLANTS][48];
+  const char *filters[MAX_PLANTS];
+  uint8_t     n = 0;
+  for (uint8_t p = 0; p < count; p++) {
+    if (!(plantMask & (1u << p))) continue;
+    plantTopic(p, "thresholds", topics[n], sizeof(topics[n]));
+    filters[n] = topics[n];
+    n++;
+  }
+  if (!n) return true;
+  if (!mqtt.subscribe(filters, n, 1)) return false;
+  subscribed |= plantMask;
+  return true;
+}
+
+// The answer is the topic's retained message, which the broker sends right
+// after the SUBACK. A plant already subscribed to has had every change
+// pushed, so its read finishes at once without any traffic.
+bool MqttCloud::requestThresholds(uint8_t plant, const PlantThresholds &current) {
+  if (plant >= count) return false;
+  ThresholdFetch &f = fetches[plant];
+  if (subscribed & (1u << plant)) {
+    f.state = FETCH_DONE;
+    return true;
+  }
+  f.value = current;
+  f.state = FETCH_SENT;
+  if (subscribeThresholds(1u << plant)) return true;
+  f.state = FETCH_FAILED;
+  return false;
+}
+
+// No retained message (nothing written yet) means no answer at all, so the
+// reads end with a ping: the broker answers in order, so by the PINGRESP
+// every retained message it had for them has arrived.
+void MqttCloud::finishRequests() {
+  mqtt.service();   // Once per network cycle: also keeps an idle session alive
+  bool waiting = false;
+  for (uint8_t p = 0; p < count; p++) waiting |= fetches[p].state == FETCH_SENT;
+  if (!waiting) return;
+  bool ok = mqtt.roundTrip();
+  for (uint8_t p = 0; p < count; p++) {
+    if (fetches[p].state == FETCH_SENT) fetches[p].state = ok ? FETCH_DONE : FETCH_FAILED;
+  }
+}
+
+bool MqttCloud::takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) {
+  if (plant >= count) return false;
+  ThresholdFetch &f = fetches[plant];
+  if (f.state != FETCH_DONE && f.state != FETCH_FAILED) return false;
+  ok = f.state == FETCH_DONE;
+  if (ok) out = f.value;
+  f.state = FETCH_IDLE;
+  return true;
+}
+
+// Unlike the RTDB stream, a subscription costs no connection of its own:
+// every plant listens, on the session that carries the uploads
+bool MqttCloud::beginThresholdStream() {
+  uint16_t all = (uint16_t)((1u << count) - 1);
+  streamOK = subscribeThresholds(all & ~subscribed) && mqtt.awaitAcks();
+  if (!streamOK) {
+    Serial.print("[Thresholds] Subscribe failed: ");
+    Serial.println(mqtt.lastError());
+  }
+  return streamOK;
+}
+
+// Also what keeps the session alive between uploads (keep-alive pings)
+bool MqttCloud::pollThresholdStream(PlantThresholds &out) {
+  if (!mqtt.service()) {
+    Serial.print("[Thresholds] Session lost: ");
+    Serial.println(mqtt.lastError());
+    streamOK = false;
+    return false;
+  }
+  if (!streamDirty) return false;
+  streamDirty = false;
+  out = fetches[0].value;
+  return true;
+}
@@ -0,0 +1,161 @@
+#include "lan_feed.h"
+
+void LanFeed::configure(const PlantConfig *plants, uint8_t count, uint8_t maxClients) {
+  this->plants     = plants;
+  this->count      = min(count, (uint8_t)MAX_PLANTS);
+  this->maxClients = min(maxClients, (uint8_t)LAN_FEED_CLIENTS);
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) faces[p] = FACE_NONE;
+}
+
+// Messages are laid end to end and wrap to the start of the log when the
+// next one doesn't fit; the oldest are dropped to make room
+void LanFeed::append(const char *msg, size_t len) {
+  uint16_t pos     = writePos;
+  bool     wrapped = pos + len > LAN_FEED_BYTES;
+  if (wrapped) pos = 0;
+
+  while (first < next) {
+    const Entry &e = entry(first);
+    bool overlaps  = e.offset < pos + len && pos < e.offset + e.length;
+    bool skipped   = wrapped && e.offset >= writePos;   // In the unused tail: older than anything at 0
+    if (!overlaps && !skipped && next - first < LAN_FEED_ENTRIES) break;
+    first++;
+  }
+
+  memcpy(log + pos, msg, len);
+  entries[next % LAN_FEED_ENTRIES] = { pos, (uint16_t)len };
+  writePos = pos + len;
+  next++;
+  st.published++;
+}
+
+void LanFeed::publishSample(const RackSample &s) {
+  JsonOut out(scratch, sizeof(scratch));
+  out.beginObject();
+  out.key(NULL, "type");
+  out.string("sample");
+  out.key(NULL, "seq");
+  out.uinteger(next);
+  out.key(NULL, "plants");
+  out.beginObject();
+  for (uint8_t p = 0; p < min(s.count, count); p++) {
+    out.key(NULL, plants[p].id);
+    out.beginObject();
+    jsonTelemetry(out, NULL, s.plant[p], FIELD_MASK_ALL);
+    out.endObject();
+  }
+  out.endObject();
+  out.endObject();
+  if (out.ok()) append(scratch, out.length());
+  else          st.oversize++;
+}
+
+void LanFeed::publishFace(const FaceEvent &ev) {
+  if (ev.plant >= count) return;
+  faces[ev.plant] = ev.to;
+
+  JsonOut out(scratch, sizeof(scratch));
+  out.beginObject();
+  out.key(NULL, "type");
+  out.string("face");
+  out.key(NULL, "seq");
+  out.uinteger(next);
+  out.key(NULL, "plant");
+  out.string(plants[ev.plant].id);
+  out.key(NULL, "face");
+  out.string(faceName(ev.to));
+  out.key(NULL, "from");
+  out.string(faceName(ev.from));
+  out.key(NULL, "at_ms");
+  out.uinteger(ev.atMs);
+  out.endObject();
+  if (out.ok()) append(scratch, out.length());
+  else          st.oversize++;
+}
+
+int LanFeed::attach() {
+  for (uint8_t c = 0; c < maxClients; c++) {
+    if (subs[c].active) continue;
+    subs[c] = { true, next };
+    st.attached++;
+    st.clients++;
+    if (st.clients > st.peakClients) st.peakClients = st.clients;
+    return c;
+  }
+  st.refused++;
+  return -1;
+}
+
+void LanFeed::detach(uint8_t client) {
+  if (client >= LAN_FEED_CLIENTS || !subs[client].active) return;
+  subs[client].active = false;
+  st.clients--;
+}
+
+uint32_t LanFeed::pump(Send send, void *ctx) {
+  uint32_t sent = 0;
+  for (uint8_t c = 0; c < maxClients; c++) {
+    Subscriber &s = subs[c];
+    if (!s.active) continue;
+    if (s.next < first) {
+      st.lagged += first - s.next;
+      s.next = first;
+    }
+    while (s.next < next) {
+      const Entry &e = entry(s.next);
+      if (!send(ctx, c, log + e.offset, e.length)) {
+        st.busy++;
+        break;
+      }
+      s.next++;
+      sent++;
+    }
+  }
+  st.delivered += sent;
+  return sent;
+}
+
+void LanFeed::writeSnapshot(JsonOut &out, const ThresholdSet &thresholds, unsigned long nowMs) const {
+  out.beginObject();
+  out.key(NULL, "seq");
+  out.uinteger(newestSeq());
+  out.key(NULL, "uptime_ms");
+  out.uinteger(nowMs);
+
+  out.key(NULL, "thresholds");
+  out.beginObject();
+  for (uint8_t p = 0; p < count; p++) {
+    const PlantThresholds &th = thresholds.plant[p];
+    out.key(NULL, plants[p].id);
+    out.beginObject();
+    out.key(NULL, "moisture_low");  out.integer(th.moistureLow);
+    out.key(NULL, "moisture_high"); out.integer(th.moistureHigh);
+    out.key(NULL, "temp_high");     out.fixed(th.tempHigh, 1);
+    out.key(NULL, "temp_low");      out.fixed(th.tempLow, 1);
+    out.key(NULL, "lux_low");       out.fixed(th.luxLow, 1);
+    out.key(NULL, "lux_high");      out.fixed(th.luxHigh, 1);
+    out.key(NULL, "humidity_high"); out.fixed(th.humidityHigh, 1);
+    out.key(NULL, "humidity_low");  out.fixed(th.humidityLow, 1);
+    out.key(NULL, "species");       out.string(th.speciesName);
+    out.endObject();
+  }
+  out.endObject();
+
+  out.key(NULL, "faces");
+  out.beginObject();
+  for (uint8_t p = 0; p < count; p++) {
+    out.key(NULL, plants[p].id);
+    out.string(faceName(faces[p]));
+  }
+  out.endObject();
+
+  out.key(NULL, "recent");
+  out.put('[');
+  for (uint32_t seq = first; seq < next; seq++) {
+    if (seq != first) out.put(',');
+    const Entry &e = entry(seq);
+    out.put(log + e.offset, e.length);
+  }
+  out.put(']');
+  out.endObject();
+}
@@ -1,14 +1,39 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <Firebase_ESP_Client.h>
-#include <DHT.h>
 #include <Wire.h>
-#include <BH1750.h>
+#include <Preferences.h>
+#include <type_traits>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include <ESPAsyncWebServer.h>
 #include "bitmaps.h"
+#include "hal_esp32.h"
+#include "sample_log.h"
+#include "delta_filter.h"
+#include "boot_sequence.h"
+#include "threshold_cache.h"
+#include "duty_cycle.h"
+#include "face_anim.h"
+#include "face_cache.h"
+#include "face_rules.h"
+#include "gaia_config.h"
+#include "lan_feed.h"
+#include "oled_frame.h"
+#include "ota_update.h"
+#include "pipeline_steps.h"
+#include "plant_rack.h"
+#include "sensor_schedule.h"
+#include "spsc_ring.h"
+#include "stage_profiler.h"
+#include "thirst_forecast.h"
+#include "triple_buffer.h"
+#include "window_stats.h"
 
 // ================= 1. USER CONFIGURATION =================
+// The pipeline tuning (sample tick, sensor periods, deadbands, summary
+// windows, LIVE_UPLOADS, face animation) is in include/gaia_config.h, shared
+// with the host tests and tools/.
+
 // WIFI SETTINGS
 #define WIFI_SSID "<Your WiFi SSID>"
 #define WIFI_PASSWORD "<Your WiFi Password>"
@@ -16,11 +41,41 @@
 // FIREBASE SETTINGS
 #define API_KEY "<Your Firebase API Key>"
 #define DATABASE_URL "<Your Firebase Database URL>"
+// Writes and threshold reads verify the server against the public roots.
+// A local RTDB stand-in (tools/fleet_sim) needs its own CA here, as PEM text.
+#define DATABASE_CA_CERT NULL
+
+// CLOUD BACKEND
+// CLOUD_RTDB = Firebase RTDB over HTTPS. CLOUD_MQTT = an MQTT broker, far
+// less traffic per sample for dense deployments (README, MQTT Transport).
+// `net rtdb` / `net mqtt` on the serial console switch at run time.
+#define CLOUD_RTDB 0
+#define CLOUD_MQTT 1
+#define CLOUD_BACKEND CLOUD_RTDB
+
+// MQTT SETTINGS (CLOUD_MQTT)
+const MqttConfig MQTT_CONFIG = {
+  /* brokerUrl    */ "mqtts://<Your MQTT broker host>:8883",
+  /* user         */ "",   // "" = anonymous
+  /* password     */ "",
+  /* telemetryQos */ 0,    // A lost sample is replaced by the next one
+  /* caCert       */ NULL   // PEM of a private broker's CA; NULL = public roots
+};
 
-// SENSOR PINS
-#define DHTPIN 4        // Digital Pin for Air (Safe for WiFi)
-#define MOISTURE_PIN 34 // Analog Pin for Soil (ADC1 - Safe for WiFi)
-#define DHTTYPE DHT22   // Sensor Type
+// PLANT TABLE (SENSOR PINS)
+// One row per pot; each plant is its own node under /plants (see plant_rack.h).
+//   moisturePin - Analog Pin for Soil (ADC1 only, GPIO 32-39 - Safe for WiFi)
+//   dhtPin      - Digital Pin for Air (Safe for WiFi); NO_PIN = share plant 0's DHT22
+//   lightMux    - TCA9548A channel of the plant's own BH1750 (ADDR->VCC);
+//                 NO_PIN = share the BH1750 on the main I2C bus
+// Each distinct DHT22 pin takes one RMT channel (0, 1, ... in table order).
+const PlantConfig PLANTS[] = {
+  // id          moisturePin  dhtPin  lightMux
+  { "gaia_01",   34,          4,      NO_PIN },
+  // { "gaia_02", 35,         NO_PIN, 0      },  // Second pot on the same shelf, own light sensor
+};
+#define PLANT_COUNT ((uint8_t)(sizeof(PLANTS) / sizeof(PLANTS[0])))
+static_assert(sizeof(PLANTS) / sizeof(PLANTS[0]) <= MAX_PLANTS, "Too many plants (see MAX_PLANTS)");
 
 // I2C PINS
 #define SDA_PIN 21
@@ -30,393 +85,1485 @@
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_ADDR 0x3C
+#define OLED_I2C_HZ 400000          // OLED transfers only; most modules take up to 1000000
 
 // CALIBRATION (Adjust these after testing!)
+// Raw-count defaults only. Calibrate on the device with the "cal dry" /
+// "cal wet" serial commands instead; those points are stored in NVS.
 const int DRY_VAL = 3500; // Value in air
 const int WET_VAL = 1200; // Value in water
 
-// ================= 2. GLOBAL OBJECTS =================
-DHT dht(DHTPIN, DHTTYPE);
-BH1750 lightMeter;
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+// TASK LAYOUT
+// Sampling and the OLED animation run on core 1 at fixed rates; everything
+// that can block on the network runs on core 0 next to the WiFi stack.
+#define SENSOR_TASK_CORE   1
+#define ANIM_TASK_CORE     1
+#define NETWORK_TASK_CORE  0
+#define LAN_TASK_CORE      0
+#define OTA_TASK_CORE      0
+#define SENSOR_TASK_STACK  4096
+#define ANIM_TASK_STACK    4096
+#define NETWORK_TASK_STACK 8192
+#define LAN_TASK_STACK     4096
+#define OTA_TASK_STACK     6144
+#define SENSOR_TASK_PRIO   3   // Above the animation: a sample is never late for a frame
+#define ANIM_TASK_PRIO     2
+#define NETWORK_TASK_PRIO  2
+#define LAN_TASK_PRIO      1   // Local dashboards wait for everything else
+#define OTA_TASK_PRIO      1   // A firmware download never holds up an upload
 
-// Firebase objects
-FirebaseData fbdo;
-FirebaseAuth auth;
-FirebaseConfig config;
+// OTA UPDATES (ota_update.h)
+// The update server (tools/ota_delta/ota_server.py) sends a patch against
+// the running image, applied into the other app slot while the device
+// keeps sampling. Checked a minute after boot, then every 6 h, and on the
+// `ota` command. Only patches signed with the release key are installed:
+// paste the public key (ota_pub.pem, tools/ota_delta) as PEM text. NULL
+// turns updates off.
+#define OTA_SERVER_URL         "http://<Your update server>:8070"
+#define OTA_SIGNING_KEY        NULL
+#define OTA_FIRST_CHECK_MS     60000
+#define OTA_CHECK_INTERVAL_MS  21600000
+#define OTA_CONFIRM_TIMEOUT_MS 600000   // Online this long without an upload: roll back (offline time doesn't count)
 
-unsigned long sendDataPrevMillis = 0;
-bool signupOK = false;
+// LOW-POWER MODE (battery units)
+// 1 = no pipeline tasks: wake on a timer, sample, go back to sleep, and bring
+// the radio up only for batched uploads (section 3.1, duty_cycle.h).
+// Build with -DGAIA_LOW_POWER=1 (platformio.ini build_flags) to enable.
+#ifndef GAIA_LOW_POWER
+#define GAIA_LOW_POWER 0
+#endif
+// Wake, upload and sleep periods (DUTY_CONFIG) and POWER_MODEL: gaia_config.h.
+#define LP_WIFI_TIMEOUT_MS     10000
+#define LP_CLOUD_TIMEOUT_MS    5000
+#define BATTERY_CAPACITY_MAH   2000
+
+// ================= 2. GLOBAL OBJECTS =================
+// Board drivers. Everything below talks to them through the HAL interfaces
+// (hal.h), so alternative backends can be dropped in without touching the logic.
+Esp32Sensors   boardSensors(PLANTS, PLANT_COUNT, DRY_VAL, WET_VAL);
+Ssd1306Display boardDisplay(SCREEN_WIDTH, SCREEN_HEIGHT, OLED_ADDR, OLED_I2C_HZ);
+FirebaseCloud  firebaseCloud(API_KEY, DATABASE_URL, DATABASE_CA_CERT, PLANTS, PLANT_COUNT);
+MqttCloud      mqttCloud(MQTT_CONFIG, PLANTS, PLANT_COUNT);
+
+SensorHal    &sensors = boardSensors;
+DisplayHal   &screen  = boardDisplay;
+CloudHal     *cloud   = &firebaseCloud;   // Or &mqttCloud: selectCloudBackend(), first thing in setup()
+Adafruit_GFX &display = screen.canvas();
 
 // ================= 2.0 PLANT THRESHOLDS (Dynamic from Firebase) =================
-// These defaults match common houseplants. The Flutter app writes species-specific
-// values to Firebase, and the ESP32 pulls them periodically so the OLED faces
-// react according to the actual plant's needs.
-struct PlantThresholds {
-  // Soil moisture (%)
-  int   moistureLow;      // Below this → FACE_THIRSTY
-  int   moistureHigh;     // Above this → FACE_OVERWATERED
-  // Temperature (°C)
-  float tempHigh;         // Above this → FACE_HOT
-  float tempLow;          // Below this → FACE_COLD
-  // Light (lux)
-  float luxLow;           // Below this → FACE_DARK
-  float luxHigh;          // Above this → FACE_BRIGHT
-  // Humidity (%)
-  float humidityHigh;     // Above this → FACE_HUMID
-  float humidityLow;      // Below this → FACE_DRY_AIR
-  // Species info
-  String speciesName;     // e.g. "Rose", "Cactus", "Fern"
-};
+// See plant_thresholds.h for the field meanings and defaults.
+// The network task owns cloudThresholds (one entry per plant) and publishes
+// whole copies through thresholdsBuf; the sensor task only ever reads
+// thresholdsBuf.front().
+const PlantThresholds DEFAULT_THRESHOLDS = PLANT_THRESHOLDS_DEFAULT;
 
-// Sensible defaults (used until Firebase supplies species-specific values)
-PlantThresholds thresholds = {
-  /* moistureLow  */  30,
-  /* moistureHigh */  85,
-  /* tempHigh     */  30.0,
-  /* tempLow      */  15.0,
-  /* luxLow       */  100.0,
-  /* luxHigh      */  2000.0,
-  /* humidityHigh */  80.0,
-  /* humidityLow  */  30.0,
-  /* speciesName  */  "Unknown"
-};
+ThresholdSet defaultThresholdSet() {
+  ThresholdSet set;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) set.plant[p] = DEFAULT_THRESHOLDS;
+  return set;
+}
 
+ThresholdSet cloudThresholds = defaultThresholdSet();
+TripleBuffer<ThresholdSet> thresholdsBuf(cloudThresholds);
+
+// Plant 0's thresholds arrive by server push (RTDB stream). The other plants
+// are polled, one per interval in turn; plant 0 is polled only while its
+// stream is down, together with an attempt to re-open it.
 unsigned long lastThresholdFetch = 0;
-const unsigned long THRESHOLD_FETCH_INTERVAL = 30000; // Sync every 30 seconds
+uint8_t       nextThresholdPlant = 1;
+const unsigned long THRESHOLD_FETCH_INTERVAL = 30000; // Fallback poll / stream retry every 30 seconds
+
+// ================= 2.0.0 SAMPLE PIPELINE =================
+// Sensor task → network task, one RackSample (every plant) per tick. Sized for
+// ~16 s of samples so a slow HTTPS round trip never makes the producer wait;
+// overflow drops the newest sample.
+SpscRing<RackSample, 16> sampleRing;
+uint32_t droppedSamples = 0;
+
+// ================= 2.0.0.1 OFFLINE LOG (store-and-forward) =================
+// Samples that can't be uploaded go to flash (sample_log.h) at a reduced rate
+// and are replayed into /plants/<id>/history in batched writes later.
+// Rate and batch size: OFFLINE_LOG_INTERVAL_MS, BACKLOG_BATCH (gaia_config.h).
+
+SampleLog sampleLog;
+LoggedSample backlogBatch[BACKLOG_BATCH];
+unsigned long lastOfflineLog  = 0;
+unsigned long backlogStartMs  = 0;     // When the current catch-up began (0 = idle)
+uint32_t      backlogRequests = 0;
+uint32_t      backlogSent     = 0;
+
+// ================= 2.0.0.2 DELTA UPLOADS =================
+// Only fields that moved past their deadband are written (see delta_filter.h).
+// Everything is re-sent at least once per heartbeat. One filter per plant.
+// Used by the always-on build only with LIVE_UPLOADS 1 (off by default), and
+// by low-power mode's batched uploads. Deadbands: DELTA_CONFIG (gaia_config.h).
+#define DELTA_REPORT_INTERVAL_MS 600000    // Savings report every 10 min
+
+DeltaFilter deltaFilters[MAX_PLANTS];   // Configured in setup()
+unsigned long lastDeltaReport = 0;
+
+// ================= 2.0.0.3 HEAP HEALTH =================
+// The steady-state loop allocates nothing, so free heap should stay flat.
+// Free heap, largest free block and the low-water mark go to serial (and
+// the `heap` command) and to /plants/<id>/diagnostics, so slow leaks and
+// fragmentation show up on long runs.
+#define HEAP_REPORT_INTERVAL_MS 600000     // Every 10 min
+
+unsigned long lastHeapReport = 0;
+
+HeapStats readHeapStats() {
+  HeapStats h;
+  h.freeBytes    = ESP.getFreeHeap();
+  h.largestBlock = ESP.getMaxAllocHeap();
+  h.minFreeBytes = ESP.getMinFreeHeap();
+  h.uptimeMs     = millis();
+  return h;
+}
+
+void printHeapStats(const HeapStats &h) {
+  Serial.printf("[Heap] free %lu B | largest block %lu B (%.0f%% fragmented) | min ever %lu B\n",
+    (unsigned long)h.freeBytes, (unsigned long)h.largestBlock,
+    h.freeBytes ? 100.0f * (1.0f - (float)h.largestBlock / h.freeBytes) : 0.0f,
+    (unsigned long)h.minFreeBytes);
+}
+
+// ================= 2.0.0.4 STAGE PROFILING =================
+// Built with -DGAIA_PROFILING=1 only (stage_profiler.h): p50/p95/max per
+// stage since boot, on the `prof` command and every 10 min to serial and
+// /plants/<id>/diagnostics/stages. `prof reset` starts a new window.
+#if GAIA_PROFILING
+#define PROFILE_REPORT_INTERVAL_MS 600000
+
+unsigned long lastProfileReport = 0;
+
+void printProfile() {
+  Serial.println("[Prof] stage               count    p50 us    p95 us    max us");
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    StageSummary sum = summarizeStage(stageTimes[s], (Stage)s);
+    if (!sum.count) continue;
+    Serial.printf("[Prof] %-16s %8lu %9lu %9lu %9lu\n", sum.name, (unsigned long)sum.count,
+      (unsigned long)sum.p50Us, (unsigned long)sum.p95Us, (unsigned long)sum.maxUs);
+  }
+}
+
+void reportProfile(bool online) {
+  lastProfileReport = millis();
+  printProfile();
+  if (!online) return;
+
+  StageSummary sums[STAGE_COUNT];
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) sums[s] = summarizeStage(stageTimes[s], (Stage)s);
+  if (!cloud->uploadStageSummaries(sums, STAGE_COUNT)) {
+    Serial.print("[Prof] Diagnostics write FAILED: ");
+    Serial.println(cloud->lastError());
+  }
+}
+#endif
+
+// ================= 2.0.0.5 WINDOWED SUMMARIES =================
+// The sensor task folds every sample into per-plant minute/hour statistics
+// (window_stats.h); the network task uploads each closed window to
+// /plants/<id>/stats/<minute|hour>/<boot>_<index>. Windows follow uptime, and
+// the NVS boot counter keeps the keys of successive boots apart.
+// Window lengths and LIVE_UPLOADS: gaia_config.h.
+
+WindowAggregator aggregators[MAX_PLANTS];   // Configured in setup()
+
+SpscRing<WindowSummary, 16> summaryRing;   // Sensor task → network task
+WindowSummary pendingSummaries[STATS_PENDING_MAX];
+size_t        pendingSummaryCount = 0;
+uint32_t      droppedSummaries    = 0;
+uint32_t      bootCount           = 0;
+
+#define STATS_NVS_NAMESPACE "gaia"
+
+// Once per boot. Low-power units count cold boots only (rtc.boot): a deep
+// sleep wake keeps the duty-cycle clock running, so it is not a new boot.
+uint32_t countBoot() {
+  Preferences prefs;
+  prefs.begin(STATS_NVS_NAMESPACE, false);
+  uint32_t n = prefs.getUInt("boots", 0) + 1;
+  prefs.putUInt("boots", n);
+  prefs.end();
+  return n;
+}
+
+// ================= 2.0.0.6 THIRST FORECAST =================
+// Each minute's soil moisture mean updates the plant's drying model
+// (thirst_forecast.h). The predicted hours until moistureLow go to
+// /plants/<id>/forecast, so the app doesn't have to crunch the history.
+// Owned by the network task.
+#define FORECAST_REPORT_INTERVAL_MS 600000   // Serial summary every 10 min
+
+ThirstForecaster forecasters[MAX_PLANTS];
+bool          forecastDirty      = false;
+unsigned long lastForecastReport = 0;
+
+// ================= 2.0.0.7 TRANSPORT (backend + metrics) =================
+// Both backends keep one TLS session, resumed after a reconnect
+// (tls_session.h): the RTDB one for REST writes and pipelined threshold
+// reads (rtdb_rest.h), the MQTT one for the whole session (mqtt_client.h).
+// Request (message) counts, handshakes and latency go out with the heap
+// report (/diagnostics/transport) and on the `net` command.
+#define CLOUD_NVS_NAMESPACE "cloud"
+
+const char *cloudName = "Firebase";
+
+// CLOUD_BACKEND, unless `net rtdb` / `net mqtt` saved another choice
+void selectCloudBackend() {
+  Preferences prefs;
+  prefs.begin(CLOUD_NVS_NAMESPACE, true);
+  uint8_t backend = prefs.getUChar("backend", CLOUD_BACKEND);
+  prefs.end();
+  if (backend == CLOUD_MQTT) {
+    cloud     = &mqttCloud;
+    cloudName = "MQTT";
+  }
+}
+
+// The backend is picked once per boot: restart into the new one (the
+// offline log keeps anything not uploaded yet)
+void switchCloudBackend(uint8_t backend) {
+  Preferences prefs;
+  prefs.begin(CLOUD_NVS_NAMESPACE, false);
+  prefs.putUChar("backend", backend);
+  prefs.end();
+  Serial.printf("[Net] Backend set to %s - restarting\n", backend == CLOUD_MQTT ? "MQTT" : "Firebase RTDB");
+  Serial.flush();
+  ESP.restart();
+}
+
+void printTransportStats(const TransportStats &t) {
+  Serial.printf("[Net] %lu requests (%lu failed, %lu retried, %lu pipelined) | latency p50 %lu ms, p95 %lu ms, max %lu ms\n",
+    (unsigned long)t.requests, (unsigned long)t.failures, (unsigned long)t.retries,
+    (unsigned long)t.pipelined, (unsigned long)t.latencyP50Ms, (unsigned long)t.latencyP95Ms,
+    (unsigned long)t.latencyMaxMs);
+  Serial.printf("[Net] %lu connects: %lu full handshakes (avg %lu ms), %lu resumed (avg %lu ms)\n",
+    (unsigned long)t.connects, (unsigned long)t.fullHandshakes, (unsigned long)t.fullHandshakeMs,
+    (unsigned long)t.resumedHandshakes, (unsigned long)t.resumedHandshakeMs);
+}
+
+TaskHandle_t sensorTaskHandle  = NULL;
+TaskHandle_t networkTaskHandle = NULL;
+
+// ================= 2.0.0.8 ADAPTIVE SAMPLING =================
+// Sensor task only. Per-sensor periods and held values (sensor_schedule.h);
+// the savings are printed with the OLED report and by the `sense` command.
+SensorScheduler senseScheduler;
+
+void printSampling() {
+  static const char *const NAMES[SENSE_COUNT] = { "air", "soil", "light" };
+  uint32_t savedUs = 0;
+  Serial.print("[Sense]");
+  for (uint8_t k = 0; k < SENSE_COUNT; k++) {
+    const SenseStats &s = senseScheduler.stats((SenseKind)k);
+    Serial.printf(" %s: 1 read per %.1f s (%lu%% near a threshold, %lu failed) |", NAMES[k],
+      senseScheduler.meanPeriodMs((SenseKind)k) / 1000.0f,
+      (unsigned long)(s.reads ? 100ULL * s.nearReads / s.reads : 0), (unsigned long)s.failedReads);
+    savedUs += senseScheduler.savedUsPerHour((SenseKind)k);
+  }
+  Serial.printf(" sensor time saved %lu ms/h\n", (unsigned long)(savedUs / 1000));
+}
+
+// ================= 2.0.0.9 LAN FEED (local dashboards) =================
+// Samples and face changes also go straight to subscribers on the local
+// network, without the round trip through Firebase (lan_feed.h):
+//   ws://<device-ip>/ws                one JSON message per sample / face change
+//   http://<device-ip>/api/snapshot    thresholds, current faces, recent messages
+// The sensor task only pushes into two rings. lanTask (core 0, lowest
+// priority) serializes each message once and hands it to every subscriber
+// whose send queue has room. The web server runs in the AsyncTCP task: it
+// accepts connections, answers snapshots and drains the send queues.
+// lanMutex keeps the feed consistent between lanTask and the snapshot
+// handler; the send queues are only touched through AsyncWebSocket's by-id
+// calls, which take the library's own lock.
+// Lock order: lanMutex, then the library's lock. lanTask calls the library
+// while it holds lanMutex, so code the library runs under its lock (the
+// WebSocket event handler) must never take lanMutex. New connections are
+// handed to lanTask in a ring instead, and lanTask drops the slots of
+// clients the library no longer has.
+#define LAN_PORT        80
+#define LAN_MAX_CLIENTS 8     // WebSocket subscribers; lwIP has ~16 sockets for everything
+#define LAN_PUMP_MS     20    // Retry period for subscribers whose queue was full
+
+AsyncWebServer       lanServer(LAN_PORT);
+AsyncWebSocket       lanSocket("/ws");
+LanFeed              lanFeed;
+SemaphoreHandle_t    lanMutex = NULL;
+uint32_t             lanClientIds[LAN_FEED_CLIENTS];  // By feed slot, 0 = free; lanTask only
+SpscRing<uint32_t, 2 * LAN_MAX_CLIENTS> lanJoins;    // Web server → lanTask: ids of new connections
+SpscRing<RackSample, 4>             lanSamples;      // Sensor task → lanTask
+SpscRing<FaceEvent, 2 * MAX_PLANTS> lanFaces;        // Sensor task → lanTask
+TripleBuffer<ThresholdSet>          lanThresholdsBuf(cloudThresholds);   // Network task → web server
+TaskHandle_t         lanTaskHandle = NULL;
+uint32_t             lanDroppedSamples = 0;
+
+void printLanStats() {
+  const LanFeedStats &s = lanFeed.stats();
+  Serial.printf("[LAN] %u subscribers (peak %u, %lu refused) | %lu messages, %lu delivered, %lu skipped by slow subscribers | %lu samples dropped\n",
+    s.clients, s.peakClients, (unsigned long)s.refused, (unsigned long)s.published,
+    (unsigned long)s.delivered, (unsigned long)s.lagged, (unsigned long)lanDroppedSamples);
+}
+
+void queueLanFace(const FaceEvent &ev) {
+  if (lanFaces.push(ev)) xTaskNotifyGive(lanTaskHandle);
+}
+
+// Runs under the library's lock: no lanMutex here (lock order above).
+// Disconnects need nothing: lanTask notices the client is gone.
+void onLanSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
+                      void *arg, uint8_t *data, size_t len) {
+  if (type == WS_EVT_CONNECT) {
+    if (!lanJoins.push(client->id())) client->close(1013, "Too many subscribers");   // 1013 = try again later
+    else if (lanTaskHandle) xTaskNotifyGive(lanTaskHandle);   // Else picked up on its first pass
+  }
+  // Subscribers have nothing to say; incoming frames are ignored
+}
+
+// Attach the new connections and free the slots of the closed ones. Client
+// ids are never reused, and client(id) only returns a connected client, so
+// a slot whose id it no longer finds is gone for good. Under lanMutex.
+void lanUpdateSubscribers() {
+  uint32_t id;
+  while (lanJoins.pop(id)) {
+    int slot = lanFeed.attach();
+    if (slot >= 0) lanClientIds[slot] = id;
+    else lanSocket.close(id, 1013, "Too many subscribers");
+  }
+  for (uint8_t c = 0; c < LAN_FEED_CLIENTS; c++) {
+    if (!lanClientIds[c] || lanSocket.client(lanClientIds[c])) continue;
+    lanFeed.detach(c);
+    lanClientIds[c] = 0;
+  }
+}
+
+// Runs in lanTask, not the AsyncTCP task that drains the queues, so the
+// client is only ever named by id: availableForWrite() and text() look it up
+// and lock its queue (WS_MAX_QUEUED_MESSAGES deep), and fail once it is
+// gone. text() copies the message.
+bool lanSend(void *, uint8_t client, const char *msg, size_t len) {
+  uint32_t id = lanClientIds[client];
+  if (!id || !lanSocket.availableForWrite(id)) return false;
+  return lanSocket.text(id, msg, len);
+}
+
+bool lanSnapshotDrain(void *ctx, const char *data, size_t len) {
+  return ((AsyncResponseStream *)ctx)->write((const uint8_t *)data, len) == len;
+}
+
+void onLanSnapshot(AsyncWebServerRequest *request) {
+  char buf[256];
+  AsyncResponseStream *res = request->beginResponseStream("application/json");
+  res->addHeader("Access-Control-Allow-Origin", "*");   // Dashboards are served from elsewhere
+  JsonOut out(buf, sizeof(buf), lanSnapshotDrain, res);
+  lanThresholdsBuf.update();
+  xSemaphoreTake(lanMutex, portMAX_DELAY);
+  lanFeed.writeSnapshot(out, lanThresholdsBuf.front(), millis());
+  xSemaphoreGive(lanMutex);
+  out.finish();
+  request->send(res);
+}
+
+void startLanServer() {
+  lanMutex = xSemaphoreCreateMutex();
+  lanFeed.configure(PLANTS, PLANT_COUNT, LAN_MAX_CLIENTS);
+  lanSocket.onEvent(onLanSocketEvent);
+  lanServer.addHandler(&lanSocket);
+  lanServer.on("/api/snapshot", HTTP_GET, onLanSnapshot);
+  lanServer.begin();
+  Serial.printf("[LAN] Serving ws://<ip>:%d/ws and /api/snapshot\n", LAN_PORT);
+}
+
+// Wakes on every new sample, face change or connection, and every
+// LAN_PUMP_MS while a subscriber still has messages waiting for room in its
+// queue (a closed subscriber's slot is freed on one of those passes)
+void lanTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LAN_PUMP_MS));
+    RackSample sample;
+    FaceEvent  ev;
+    xSemaphoreTake(lanMutex, portMAX_DELAY);
+    lanUpdateSubscribers();
+    while (lanFaces.pop(ev)) lanFeed.publishFace(ev);
+    while (lanSamples.pop(sample)) lanFeed.publishSample(sample);
+    lanFeed.pump(lanSend, NULL);
+    xSemaphoreGive(lanMutex);
+  }
+}
+
+// ================= 2.0.0.10 FIRMWARE UPDATES (delta OTA) =================
+OtaUpdater    otaUpdater;
+TaskHandle_t  otaTaskHandle  = NULL;
+volatile bool cloudReachable = false;   // Signed in to the backend; set by the network task
+
+// Arduino core hook: keep a new image on probation (PENDING_VERIFY) instead
+// of confirming it before setup(). Only used with a bootloader built with
+// rollback support; otherwise OtaUpdater keeps the probation in NVS. Battery
+// wakes never upload in time, so those builds keep the core's default.
+extern "C" bool verifyRollbackLater() {
+  return !GAIA_LOW_POWER;
+}
+
+// The first upload proves a new image can do its job
+void confirmFirmware() {
+  if (!otaUpdater.pendingVerify()) return;
+  otaUpdater.confirm();
+  Serial.printf("[OTA] Image in %s confirmed\n", otaUpdater.runningSlot());
+}
+
+void printOtaStats() {
+  const OtaStats &s = otaUpdater.stats();
+  Serial.printf("[OTA] Running %s", otaUpdater.runningSlot());
+  if (otaUpdater.pendingVerify()) {
+    Serial.printf(" (on probation, %lu of %lu s online)", (unsigned long)(otaUpdater.probationOnlineMs() / 1000),
+      (unsigned long)(OTA_CONFIRM_TIMEOUT_MS / 1000));
+  }
+  Serial.printf(" | server %s | %lu checks, %lu failed", OTA_SERVER_URL, (unsigned long)s.checks,
+    (unsigned long)s.failures);
+  if (otaUpdater.lastError()[0]) Serial.printf(" | last error: %s", otaUpdater.lastError());
+  Serial.println();
+}
+
+// Checks OTA_FIRST_CHECK_MS after boot, then every OTA_CHECK_INTERVAL_MS,
+// and whenever the `ota` command notifies it. The patch streams into the
+// other slot while sampling goes on; the restart loses only the few
+// samples not yet uploaded (the offline log is in flash).
+// A new image is only blamed for missing uploads while the backend is
+// reachable: offline, probation just waits. Crashes and boot loops are
+// caught at boot: OTA_TRIAL_BOOTS unconfirmed boots roll back (begin()).
+void otaTask(void *) {
+  unsigned long nextCheck = OTA_FIRST_CHECK_MS;
+  for (;;) {
+    bool asked = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10000)) > 0;
+    if (otaUpdater.pendingVerify()) {
+      if (otaUpdater.probationExpired(cloudReachable, OTA_CONFIRM_TIMEOUT_MS)) {
+        Serial.println("[OTA] New image online without an upload - rolling back");
+        Serial.flush();
+        if (!otaUpdater.rollback()) {
+          Serial.println("[OTA] No previous image to go back to - keeping this one");
+          otaUpdater.confirm();
+        }
+      } else if (asked) {
+        Serial.println("[OTA] New image on probation - no checks until its first upload");
+      }
+      continue;
+    }
+    if (!asked && (long)(millis() - nextCheck) < 0) continue;
+    if (WiFi.status() != WL_CONNECTED) {
+      if (asked) Serial.println("[OTA] Offline - check skipped");
+      continue;
+    }
+    nextCheck = millis() + OTA_CHECK_INTERVAL_MS;
 
-// ================= 2.0.1 FETCH THRESHOLDS FROM FIREBASE =================
+    OtaResult r = otaUpdater.check();
+    if (r == OTA_UP_TO_DATE) {
+      if (asked) Serial.println("[OTA] Up to date");
+    } else if (r == OTA_FAILED) {
+      Serial.printf("[OTA] Update FAILED: %s\n", otaUpdater.lastError());
+    } else {
+      const OtaStats &s = otaUpdater.stats();
+      Serial.printf("[OTA] %lu B image from a %lu B %s patch (%.1f%%) in %.1f s - restarting\n",
+        (unsigned long)s.imageBytes, (unsigned long)s.patchBytes, s.delta ? "delta" : "full",
+        100.0f * s.patchBytes / s.imageBytes, s.updateMs / 1000.0f);
+      Serial.flush();
+      ESP.restart();
+    }
+  }
+}
+
+// ================= 2.0.1 SYNC THRESHOLDS FROM FIREBASE =================
 // Reads species-specific thresholds written by the Flutter app.
-// Expected Firebase path: /plants/gaia_01/thresholds/
+// Expected Firebase path: /plants/<id>/thresholds/
 // The Flutter app should write keys: moisture_low, moisture_high,
 // temp_high, temp_low, lux_low, lux_high, humidity_high, humidity_low, species
-void fetchThresholdsFromFirebase() {
-  if (!Firebase.ready() || !signupOK) return;
-
-  Serial.println("[Thresholds] Fetching from Firebase...");
-
-  if (Firebase.RTDB.getJSON(&fbdo, "/plants/gaia_01/thresholds")) {
-    FirebaseJson &json = fbdo.jsonData();
-    FirebaseJsonData jsonData;
-
-    if (json.get(jsonData, "moisture_low"))    thresholds.moistureLow  = jsonData.intValue;
-    if (json.get(jsonData, "moisture_high"))   thresholds.moistureHigh = jsonData.intValue;
-    if (json.get(jsonData, "temp_high"))       thresholds.tempHigh     = jsonData.floatValue;
-    if (json.get(jsonData, "temp_low"))        thresholds.tempLow      = jsonData.floatValue;
-    if (json.get(jsonData, "lux_low"))         thresholds.luxLow       = jsonData.floatValue;
-    if (json.get(jsonData, "lux_high"))        thresholds.luxHigh      = jsonData.floatValue;
-    if (json.get(jsonData, "humidity_high"))   thresholds.humidityHigh = jsonData.floatValue;
-    if (json.get(jsonData, "humidity_low"))    thresholds.humidityLow  = jsonData.floatValue;
-    if (json.get(jsonData, "species"))         thresholds.speciesName  = jsonData.stringValue;
-
-    Serial.println("[Thresholds] Updated for species: " + thresholds.speciesName);
-    Serial.printf("  Moisture: %d-%d%% | Temp: %.1f-%.1f°C | Lux: %.0f-%.0f | Humid: %.0f-%.0f%%\n",
-      thresholds.moistureLow, thresholds.moistureHigh,
-      thresholds.tempLow, thresholds.tempHigh,
-      thresholds.luxLow, thresholds.luxHigh,
-      thresholds.humidityLow, thresholds.humidityHigh);
-  } else {
-    Serial.print("[Thresholds] Fetch failed: ");
-    Serial.println(fbdo.errorReason());
-    Serial.println("[Thresholds] Using defaults/last known values.");
+
+// Publish a complete copy; the sensor task picks it up on its next tick.
+// Also remembered in NVS, so the next boot starts with the right faces.
+void publishThresholds(uint8_t plant) {
+  thresholdsBuf.back() = cloudThresholds;
+  thresholdsBuf.publish();
+  lanThresholdsBuf.back() = cloudThresholds;
+  lanThresholdsBuf.publish();
+
+  const PlantThresholds &th = cloudThresholds.plant[plant];
+  saveCachedThresholds(plant, th);
+  Serial.printf("[Thresholds] %s updated for species: %s\n", PLANTS[plant].id, th.speciesName);
+  Serial.printf("  Moisture: %d-%d%% | Temp: %.1f-%.1f°C | Lux: %.0f-%.0f | Humid: %.0f-%.0f%%\n",
+    th.moistureLow, th.moistureHigh,
+    th.tempLow, th.tempHigh,
+    th.luxLow, th.luxHigh,
+    th.humidityLow, th.humidityHigh);
+}
+
+// Sends the read; the answer comes back with the next upload (collectThresholds())
+void fetchThresholdsFromFirebase(uint8_t plant) {
+  if (!cloud->ready()) return;
+
+  Serial.printf("[Thresholds] Fetching %s from %s...\n", PLANTS[plant].id, cloudName);
+  cloud->requestThresholds(plant, cloudThresholds.plant[plant]);
+}
+
+// Apply every read that has finished
+void collectThresholds() {
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    PlantThresholds th;
+    bool ok;
+    if (!cloud->takeThresholds(p, th, ok)) continue;
+    if (ok) {
+      cloudThresholds.plant[p] = th;
+      publishThresholds(p);
+    } else {
+      Serial.printf("[Thresholds] Fetch of %s failed: ", PLANTS[p].id);
+      Serial.println(cloud->lastError());
+      Serial.println("[Thresholds] Using defaults/last known values.");
+    }
+  }
+}
+
+// Called every network-task wake-up (≤ 1 s), so pushed changes apply within a second
+void syncThresholds() {
+  PROFILE_STAGE(STAGE_THRESHOLD_SYNC);
+  collectThresholds();
+  bool streamAlive = cloud->thresholdStreamAlive();
+  if (streamAlive && cloud->pollThresholdStream(cloudThresholds.plant[0])) publishThresholds(0);
+  if (millis() - lastThresholdFetch <= THRESHOLD_FETCH_INTERVAL) return;
+  lastThresholdFetch = millis();
+
+  // The rest of the rack: one plant per interval
+  if (PLANT_COUNT > 1) {
+    fetchThresholdsFromFirebase(nextThresholdPlant);
+    nextThresholdPlant = nextThresholdPlant + 1 < PLANT_COUNT ? nextThresholdPlant + 1 : 1;
+  }
+
+  // Stream down: poll as before, and try to get the stream back
+  if (!streamAlive) {
+    fetchThresholdsFromFirebase(0);
+    if (cloud->beginThresholdStream()) Serial.println("[Thresholds] Listening for changes (stream)");
+  }
+}
+
+// ================= 2.0.2 NETWORK BRING-UP =================
+// Driven from the network task (see boot_sequence.h); nothing here blocks
+// for longer than one WiFi.begin() / sign-in call. Reconnects after a drop
+// go through the same steps, so the WiFi driver's own instant retries are
+// turned off (localStartup()). Timeouts and waits: BOOT_TIMEOUTS
+// (gaia_config.h).
+BootSequence boot(BOOT_TIMEOUTS);
+
+// Last AP we joined; lets the next boot skip the channel scan
+#define WIFI_NVS_NAMESPACE "wifi"
+uint8_t apBssid[6];
+int32_t apChannel = 0;
+
+bool loadCachedAp() {
+  Preferences prefs;
+  prefs.begin(WIFI_NVS_NAMESPACE, true);
+  bool ok = prefs.getBytes("bssid", apBssid, sizeof(apBssid)) == sizeof(apBssid);
+  apChannel = prefs.getUChar("channel", 0);
+  prefs.end();
+  return ok && apChannel > 0;
+}
+
+void saveCachedAp() {
+  const uint8_t *bssid = WiFi.BSSID();
+  int32_t channel = WiFi.channel();
+  if (!bssid || (channel == apChannel && memcmp(bssid, apBssid, sizeof(apBssid)) == 0)) return;
+
+  memcpy(apBssid, bssid, sizeof(apBssid));
+  apChannel = channel;
+  Preferences prefs;
+  prefs.begin(WIFI_NVS_NAMESPACE, false);
+  prefs.putBytes("bssid", apBssid, sizeof(apBssid));
+  prefs.putUChar("channel", (uint8_t)apChannel);
+  prefs.end();
+}
+
+void printWiFiTroubleshooting() {
+  Serial.println("✗ WiFi connection failed! Retrying in the background.");
+  Serial.println("Troubleshooting:");
+  Serial.println("  1. Check SSID name is correct");
+  Serial.println("  2. Check password is correct");
+  Serial.println("  3. Make sure WiFi is 2.4GHz (ESP32 doesn't support 5GHz)");
+  Serial.println("  4. Check WiFi router is powered on");
+  Serial.println("  5. Move ESP32 closer to router");
+  Serial.print("Current WiFi Status Code: ");
+  Serial.println(WiFi.status());
+  Serial.println("  0=IDLE, 1=NO_SSID, 3=CONNECTED, 4=FAILED, 6=DISCONNECTED");
+}
+
+void reportBootMetrics() {
+  const BootMetrics &m = boot.metrics;
+  Serial.printf("[Boot] First face %lu ms | WiFi %lu ms (%s) | cloud %lu ms | first upload %lu ms\n",
+    (unsigned long)m.firstFaceMs, (unsigned long)m.linkMs, m.fastLink ? "cached AP" : "scan",
+    (unsigned long)m.cloudMs, (unsigned long)m.firstUploadMs);
+}
+
+// Read from the serial console too: plain counters, a torn read only skews one line
+void printLinkStats() {
+  const LinkMetrics &l = boot.link;
+  Serial.printf("[Link] Online %.2f%% since first connect | %lu drops, reconnect p50 %lu ms, max %lu ms | %lu attempts (%lu timed out)",
+    l.uptime() * 100.0f, (unsigned long)l.drops, (unsigned long)l.reconnectMs.percentile(0.50f),
+    (unsigned long)l.longestOutageMs, (unsigned long)l.attempts, (unsigned long)l.failures);
+  if (boot.online()) Serial.println();
+  else Serial.printf(" | offline, next attempt in %lu ms\n", (unsigned long)boot.retryInMs(millis()));
+}
+
+// One step of the connection state machine (called every network-task wake-up)
+void runBootStep() {
+  BootStage before = boot.stage();
+  BootAction action = boot.step(cloud->linkUp(), cloud->ready(), millis());
+  BootStage after = boot.stage();
+
+  if (before <= BOOT_LINK_WAIT && after > BOOT_LINK_WAIT) {
+    Serial.print("✓ Connected with IP: ");
+    Serial.print(WiFi.localIP());
+    Serial.printf(" | %d dBm | %lu ms after boot\n", WiFi.RSSI(), millis());
+    saveCachedAp();
+  }
+  if (before == BOOT_ONLINE && after != BOOT_ONLINE) {
+    Serial.printf("[Link] %s lost - retrying in %lu ms\n", after == BOOT_LINK_WAIT ? "WiFi" : cloudName,
+      (unsigned long)boot.retryInMs(millis()));
+  }
+  if (after == BOOT_ONLINE && before != BOOT_ONLINE && boot.link.drops) {
+    Serial.printf("[Link] Back online after %lu ms\n", (unsigned long)boot.link.lastOutageMs);
+  }
+  if (before == BOOT_LINK_SCAN && after == BOOT_LINK_WAIT) {
+    if (!boot.metrics.linkMs) printWiFiTroubleshooting();
+    else Serial.printf("[WiFi] Join failed - retrying in %lu ms\n", (unsigned long)boot.retryInMs(millis()));
+  }
+
+  switch (action) {
+    case BOOT_ACT_CONNECT_FAST:
+      Serial.printf("[WiFi] Rejoining the cached AP on channel %ld\n", (long)apChannel);
+      WiFi.begin(WIFI_SSID, WIFI_PASSWORD, apChannel, apBssid);
+      break;
+
+    case BOOT_ACT_CONNECT_SCAN:
+      Serial.println("[WiFi] Connecting to " WIFI_SSID);
+      WiFi.disconnect();
+      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+      break;
+
+    case BOOT_ACT_AUTH:
+      cloud->begin();
+      break;
+
+    case BOOT_ACT_SYNC:
+      // Replace the cached thresholds, then listen for changes
+      // (all reads in flight at once: one round trip for the whole rack).
+      // Runs again after every reconnect: changes made meanwhile were missed.
+      for (uint8_t p = 0; p < PLANT_COUNT; p++) fetchThresholdsFromFirebase(p);
+      cloud->finishRequests();
+      collectThresholds();
+      lastThresholdFetch = millis();
+      if (cloud->beginThresholdStream()) Serial.println("[Thresholds] Listening for changes (stream)");
+      break;
+
+    case BOOT_ACT_NONE:
+      break;
   }
 }
 
 // ================= 2.1 DISPLAY LOGIC =================
-void drawStatusBar(int batteryPercent) {
-  // 1. Divider Line
-  display.drawLine(0, 10, 127, 10, SSD1306_WHITE);
+// The status bar, the faces and the scene choice are in pipeline_steps.cpp;
+// this section holds their state. Species labels are laid out once per
+// threshold update (sensor task), not per frame.
+StatusLabel statusLabels[MAX_PLANTS];
 
-  // 2. WiFi Icon (Left)
-  if (WiFi.status() == WL_CONNECTED) {
-    display.drawBitmap(0, 0, wifi_connected_bits, ICON_WIDTH, ICON_HEIGHT, SSD1306_WHITE);
-  } else {
-    display.drawBitmap(0, 0, wifi_disconnected_bits, ICON_WIDTH, ICON_HEIGHT, SSD1306_WHITE);
-  }
-
-  // 3. Species Name (Center) - Only show if known
-  if (thresholds.speciesName.length() > 0 && thresholds.speciesName != "Unknown") {
-    // Truncate long names to fit between icons
-    String displayName = thresholds.speciesName;
-    if (displayName.length() > 14) displayName = displayName.substring(0, 13) + ".";
-    int16_t x1, y1;
-    uint16_t w, h;
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.getTextBounds(displayName, 0, 0, &x1, &y1, &w, &h);
-    display.setCursor((SCREEN_WIDTH - w) / 2, 1);
-    display.print(displayName);
-  }
-
-  // 4. Battery Icon (Right)
-  // Battery Outline: 110, 1 -> 16x8
-  display.drawRect(110, 1, 16, 8, SSD1306_WHITE); 
-  // Positive Terminal (Bump)
-  display.drawLine(126, 3, 126, 6, SSD1306_WHITE);
-  
-  // Fill Bar
-  if (batteryPercent > 0) {
-    int barWidth = map(constrain(batteryPercent, 0, 100), 0, 100, 0, 12);
-    display.fillRect(112, 3, barWidth, 4, SSD1306_WHITE);
+void layoutStatusLabels(const ThresholdSet &thresholds) {
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    layoutStatusLabel(statusLabels[p], p, PLANT_COUNT, PLANTS[p].id, thresholds.plant[p]);
   }
 }
 
 // ================= FACE DRAWING (Primitives) =================
-// Draws faces using Adafruit_GFX shapes - no bitmaps needed!
-// Face area: y=12..63 (52px tall), x=0..127 (128px wide)
-// Eye line Y≈28, Mouth Y≈50, Left eye X=44, Right eye X=84
-void drawFace(int faceType) {
-  switch (faceType) {
-
-    case FACE_HAPPY: {
-      // Big round filled eyes
-      display.fillCircle(44, 28, 6, SSD1306_WHITE);
-      display.fillCircle(84, 28, 6, SSD1306_WHITE);
-      // U-shaped smile
-      display.drawLine(38, 48, 44, 54, SSD1306_WHITE);
-      display.drawLine(44, 54, 84, 54, SSD1306_WHITE);
-      display.drawLine(84, 54, 90, 48, SSD1306_WHITE);
-      display.drawLine(38, 49, 44, 55, SSD1306_WHITE);
-      display.drawLine(44, 55, 84, 55, SSD1306_WHITE);
-      display.drawLine(84, 55, 90, 49, SSD1306_WHITE);
-      break;
+// drawFace() runs once per face at boot to fill faceCache; frames are
+// animated from the cache (face_anim.h) and flushed as dirty spans (oled_frame.h).
+FaceCache    faceCache;
+FaceAnimator animator(faceCache, ANIM_CONFIG);
+FrameFlusher frameFlusher;
+FrameBudget  frameBudget;
+#define OLED_REPORT_INTERVAL_MS 600000  // I2C traffic report every 10 min
+unsigned long lastOledReport = 0;
+
+// FaceCache::build() hands over the face only; the canvas is the display's
+void renderFace(int faceType) {
+  drawFace(display, faceType);
+}
+
+// ================= FACE SELECTION =================
+// faceClassifier runs the rule table (face_rules.h) over the whole rack on
+// every sample; a new scene goes to the animation task only when a listener
+// marks it dirty (face change of the plant on screen, new thresholds, WiFi
+// icon change, next plant's turn). Face changes are also queued for the
+// network task, which writes them to the plant nodes.
+FaceClassifier faceClassifier;
+SceneSelector  sceneSelector;        // Sensor task only; configured in setup()
+TripleBuffer<ScreenScene> sceneBuf(ScreenScene{ FACE_HAPPY, { "", 0 }, false, 85 });   // Sensor task → animation task
+PlantRack      rack;                 // Sensor task only
+SpscRing<FaceEvent, 2 * MAX_PLANTS> faceEvents;   // Sensor task → network task
+
+void onFaceChanged(const FaceEvent &ev) {
+  if (ev.plant == sceneSelector.shown()) sceneSelector.markDirty();
+  Serial.printf("[Face] %s: %s -> %s\n", PLANTS[ev.plant].id, faceName(ev.from), faceName(ev.to));
+}
+
+void queueFaceStatus(const FaceEvent &ev) {
+  if (faceEvents.push(ev)) xTaskNotifyGive(networkTaskHandle);
+}
+
+void publishScene(unsigned long nowMs) {
+  static int batteryPercent = 85;   // Placeholder until there is a battery gauge
+  if (sceneSelector.select(faceClassifier, statusLabels, cloud->linkUp(), batteryPercent, nowMs, sceneBuf.back())) {
+    sceneBuf.publish();
+  }
+}
+
+// ================= 2.1.1 ANIMATION TASK =================
+// animTask (core 1, below the sensor task) owns the canvas from setup() on.
+// Each tick it picks up the newest scene, lets the animator render the
+// frame into the RAM framebuffer (the back buffer) and sends the changed
+// spans to the panel, which holds the frame being shown. Unchanged frames
+// (most of them: the face only moves during blinks, breaths and
+// transitions) cost a few µs and no I2C traffic.
+void animTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  frameBudget.begin(ANIM_CONFIG.frameMs * 1000UL);
+
+  for (;; vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(ANIM_CONFIG.frameMs))) {
+    uint32_t start = micros();
+    frameBudget.tick(start);
+
+    if (sceneBuf.update()) showScene(screen, animator, sceneBuf.front(), millis());
+
+    if (!animator.render(millis(), screen.framebuffer())) continue;
+    uint32_t rendered = micros();
+    {
+      PROFILE_STAGE(STAGE_SCREEN);
+      frameFlusher.flush(screen);   // Only the changed parts of the frame go over I2C
     }
+    frameBudget.record(rendered - start, micros() - rendered);
+    boot.markFirstFace(millis());
+  }
+}
 
-    case FACE_THIRSTY: {
-      // X_X dead eyes (crossed lines, thick)
-      // Left X
-      display.drawLine(36, 20, 52, 36, SSD1306_WHITE);
-      display.drawLine(52, 20, 36, 36, SSD1306_WHITE);
-      display.drawLine(37, 20, 53, 36, SSD1306_WHITE);
-      display.drawLine(53, 20, 37, 36, SSD1306_WHITE);
-      display.drawLine(38, 20, 54, 36, SSD1306_WHITE);
-      display.drawLine(54, 20, 38, 36, SSD1306_WHITE);
-      // Right X
-      display.drawLine(76, 20, 92, 36, SSD1306_WHITE);
-      display.drawLine(92, 20, 76, 36, SSD1306_WHITE);
-      display.drawLine(77, 20, 93, 36, SSD1306_WHITE);
-      display.drawLine(93, 20, 77, 36, SSD1306_WHITE);
-      display.drawLine(78, 20, 94, 36, SSD1306_WHITE);
-      display.drawLine(94, 20, 78, 36, SSD1306_WHITE);
-      // Flat line mouth
-      display.fillRect(44, 50, 40, 3, SSD1306_WHITE);
-      // Teardrop falling from right eye
-      display.fillTriangle(104, 20, 101, 30, 107, 30, SSD1306_WHITE);
-      display.fillCircle(104, 32, 4, SSD1306_WHITE);
-      break;
+void printFrameBudget() {
+  const FrameBudget &b = frameBudget;
+  Serial.printf("[Anim] %lu ticks, %lu drawn, %lu over the %lu µs budget, %lu late | render p95 %lu µs | flush p50 %lu µs, p95 %lu µs, max %lu µs\n",
+    (unsigned long)b.ticks, (unsigned long)b.drawn, (unsigned long)b.overruns, (unsigned long)b.periodUs,
+    (unsigned long)b.late, (unsigned long)b.renderUs.percentile(0.95f),
+    (unsigned long)b.flushUs.percentile(0.5f), (unsigned long)b.flushUs.percentile(0.95f),
+    (unsigned long)b.flushUs.maximum());
+}
+
+// ================= 2.2 SERIAL CONSOLE =================
+// Line-based commands typed into the serial monitor (polled by sensorTask).
+// [n] is the plant number as shown on the OLED (1 if omitted):
+//   cal [n]       - show moisture calibration and the live reading
+//   cal dry [n]   - store the current reading as 0 % (probe in air)
+//   cal wet [n]   - store the current reading as 100 % (probe in water)
+//   anim          - animation frame budget: frames drawn, overruns, render/flush times
+//   heap          - free heap, largest free block, low-water mark
+//   lan           - LAN feed subscribers and messages
+//   net           - connectivity (uptime, drops, reconnect times) and transport counters
+//   net rtdb|mqtt - switch the cloud backend (saved; restarts)
+//   ota           - firmware slot and update checks; asks the update server now
+//   sense         - sensor read periods and the sensor time they save
+//   prof          - stage timings (GAIA_PROFILING builds); prof reset clears them
+void runCommand(const char *cmd) {
+  SoilMoistureAdc &probe = boardSensors.moistureProbe();
+  char word[8] = "";
+  int  n = 1;
+
+  if (strcmp(cmd, "anim") == 0) {
+    printFrameBudget();
+    return;
+  }
+  if (strcmp(cmd, "heap") == 0) {
+    printHeapStats(readHeapStats());
+    return;
+  }
+  if (strcmp(cmd, "lan") == 0) {
+    printLanStats();
+    return;
+  }
+  if (strcmp(cmd, "sense") == 0) {
+    printSampling();
+    return;
+  }
+  if (strcmp(cmd, "ota") == 0) {
+    printOtaStats();
+    if (otaTaskHandle) xTaskNotifyGive(otaTaskHandle);
+    return;
+  }
+  if (strcmp(cmd, "net") == 0) {
+    Serial.printf("[Net] Backend: %s\n", cloudName);
+    printLinkStats();
+    printTransportStats(cloud->transportStats());
+    return;
+  }
+  if (strcmp(cmd, "net rtdb") == 0 || strcmp(cmd, "net mqtt") == 0) {
+    switchCloudBackend(cmd[4] == 'm' ? CLOUD_MQTT : CLOUD_RTDB);
+    return;
+  }
+  if (strcmp(cmd, "prof") == 0 || strcmp(cmd, "prof reset") == 0) {
+#if GAIA_PROFILING
+    if (cmd[4] == '\0') {
+      printProfile();
+    } else {
+      for (uint8_t s = 0; s < STAGE_COUNT; s++) stageTimes[s].reset();
+      Serial.println("[Prof] Histograms cleared");
     }
+#else
+    Serial.println("[Prof] Profiling is off (build with -DGAIA_PROFILING=1)");
+#endif
+    return;
+  }
+  if (strncmp(cmd, "cal", 3) != 0 || (cmd[3] != '\0' && cmd[3] != ' ')) {
+    Serial.printf("Unknown command: %s (try: anim, cal, cal dry, cal wet, heap, lan, net, net rtdb, net mqtt, ota, prof, sense)\n", cmd);
+    return;
+  }
+  sscanf(cmd + 3, "%7s %d", word, &n);
+  if (word[0] >= '0' && word[0] <= '9') {  // "cal 2"
+    n = atoi(word);
+    word[0] = '\0';
+  }
+  if (n < 1 || n > PLANT_COUNT) {
+    Serial.printf("[Cal] No plant %d (1-%u)\n", n, PLANT_COUNT);
+    return;
+  }
+  uint8_t p = n - 1;
 
-    case FACE_OVERWATERED: {
-      // @_@ dizzy spiral eyes (concentric circles + center dot)
-      display.drawCircle(44, 28, 10, SSD1306_WHITE);
-      display.drawCircle(44, 28, 6, SSD1306_WHITE);
-      display.fillCircle(44, 28, 2, SSD1306_WHITE);
-      display.drawCircle(84, 28, 10, SSD1306_WHITE);
-      display.drawCircle(84, 28, 6, SSD1306_WHITE);
-      display.fillCircle(84, 28, 2, SSD1306_WHITE);
-      // Wavy/queasy mouth (zigzag sine)
-      display.drawLine(36, 50, 44, 46, SSD1306_WHITE);
-      display.drawLine(44, 46, 52, 54, SSD1306_WHITE);
-      display.drawLine(52, 54, 60, 46, SSD1306_WHITE);
-      display.drawLine(60, 46, 68, 54, SSD1306_WHITE);
-      display.drawLine(68, 54, 76, 46, SSD1306_WHITE);
-      display.drawLine(76, 46, 84, 50, SSD1306_WHITE);
-      // Sweat drops on sides
-      display.fillCircle(20, 35, 2, SSD1306_WHITE);
-      display.fillCircle(108, 35, 2, SSD1306_WHITE);
-      break;
+  if (strcmp(word, "dry") == 0 || strcmp(word, "wet") == 0) {
+    MoistureCalibration cal = probe.calibration(p);
+    if (word[0] == 'd') cal.dryMv = probe.millivolts(p);
+    else                cal.wetMv = probe.millivolts(p);
+    probe.setCalibration(p, cal);
+    Serial.printf("[Cal] %s saved: dry %u mV, wet %u mV\n", PLANTS[p].id, cal.dryMv, cal.wetMv);
+  } else if (word[0] == '\0') {
+    MoistureCalibration cal = probe.calibration(p);
+    Serial.printf("[Cal] %s: dry %u mV, wet %u mV | now %.0f raw = %lu mV = %d%% | %lu readings/s (%s)\n",
+      PLANTS[p].id, cal.dryMv, cal.wetMv, probe.raw(p), (unsigned long)probe.millivolts(p), probe.percent(p),
+      (unsigned long)probe.readingsPerSecond(), probe.continuous() ? "DMA" : "analogRead");
+  } else {
+    Serial.printf("Unknown command: %s (try: anim, cal, cal dry, cal wet, heap, lan, net, net rtdb, net mqtt, ota, prof, sense)\n", cmd);
+  }
+}
+
+void pollSerialConsole() {
+  static char    line[32];
+  static uint8_t len = 0;
+
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      if (len == 0) continue;
+      line[len] = '\0';
+      len = 0;
+      runCommand(line);
+    } else if (len < sizeof(line) - 1) {
+      line[len++] = c;
     }
+  }
+}
 
-    case FACE_HOT: {
-      // >_< angry - V-shaped eyebrows slanting inward
-      display.drawLine(30, 17, 56, 23, SSD1306_WHITE);
-      display.drawLine(30, 18, 56, 24, SSD1306_WHITE);
-      display.drawLine(30, 19, 56, 25, SSD1306_WHITE);
-      display.drawLine(98, 17, 72, 23, SSD1306_WHITE);
-      display.drawLine(98, 18, 72, 24, SSD1306_WHITE);
-      display.drawLine(98, 19, 72, 25, SSD1306_WHITE);
-      // Small angry dot eyes under brows
-      display.fillCircle(44, 31, 4, SSD1306_WHITE);
-      display.fillCircle(84, 31, 4, SSD1306_WHITE);
-      // Angry frown (inverted U)
-      display.drawLine(40, 56, 48, 48, SSD1306_WHITE);
-      display.drawLine(48, 48, 80, 48, SSD1306_WHITE);
-      display.drawLine(80, 48, 88, 56, SSD1306_WHITE);
-      display.drawLine(40, 57, 48, 49, SSD1306_WHITE);
-      display.drawLine(48, 49, 80, 49, SSD1306_WHITE);
-      display.drawLine(80, 49, 88, 57, SSD1306_WHITE);
-      // Heat waves above
-      display.drawLine(20, 14, 24, 12, SSD1306_WHITE);
-      display.drawLine(24, 12, 28, 14, SSD1306_WHITE);
-      display.drawLine(100, 14, 104, 12, SSD1306_WHITE);
-      display.drawLine(104, 12, 108, 14, SSD1306_WHITE);
-      break;
+// ================= 3. PIPELINE TASKS =================
+// sensorTask (core 1): fixed-rate sampling + face selection. Never blocks on
+// the network - it only pushes into sampleRing and reads thresholdsBuf.
+// Frames are drawn by animTask (section 2.1.1).
+void sensorTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+
+  // The first tick runs immediately, so a face is up right after setup()
+  for (;; vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_PERIOD_MS))) {
+    PROFILE_STAGE(STAGE_SENSOR_CYCLE);
+    pollSerialConsole();
+
+    // Pick up thresholds published by the network task (if any)
+    if (thresholdsBuf.update()) {
+      rackSetThresholds(rack, thresholdsBuf.front());
+      layoutStatusLabels(thresholdsBuf.front());
+      sceneSelector.markDirty();   // Species name may have changed
     }
 
-    case FACE_COLD: {
-      // O_O wide shocked eyes with pupils
-      display.drawCircle(44, 28, 10, SSD1306_WHITE);
-      display.drawCircle(44, 28, 11, SSD1306_WHITE);
-      display.fillCircle(44, 28, 4, SSD1306_WHITE);
-      display.drawCircle(84, 28, 10, SSD1306_WHITE);
-      display.drawCircle(84, 28, 11, SSD1306_WHITE);
-      display.fillCircle(84, 28, 4, SSD1306_WHITE);
-      // Zigzag chattering teeth mouth
-      display.drawLine(38, 50, 46, 44, SSD1306_WHITE);
-      display.drawLine(46, 44, 54, 50, SSD1306_WHITE);
-      display.drawLine(54, 50, 62, 44, SSD1306_WHITE);
-      display.drawLine(62, 44, 70, 50, SSD1306_WHITE);
-      display.drawLine(70, 50, 78, 44, SSD1306_WHITE);
-      display.drawLine(78, 44, 86, 50, SSD1306_WHITE);
-      display.drawLine(38, 51, 46, 45, SSD1306_WHITE);
-      display.drawLine(46, 45, 54, 51, SSD1306_WHITE);
-      display.drawLine(54, 51, 62, 45, SSD1306_WHITE);
-      display.drawLine(62, 45, 70, 51, SSD1306_WHITE);
-      display.drawLine(70, 51, 78, 45, SSD1306_WHITE);
-      display.drawLine(78, 45, 86, 51, SSD1306_WHITE);
-      // Shiver lines on sides
-      display.drawLine(8, 30, 16, 26, SSD1306_WHITE);
-      display.drawLine(16, 26, 8, 22, SSD1306_WHITE);
-      display.drawLine(120, 30, 112, 26, SSD1306_WHITE);
-      display.drawLine(112, 26, 120, 22, SSD1306_WHITE);
-      break;
+    // One clock reading per tick: the sample, its windows and the face rules
+    // all see the same time (pipeline_steps.h)
+    unsigned long now = millis();
+
+    // --- STEP A: READ THE SENSORS THAT ARE DUE (every plant) ---
+    // The rest keep their last value (senseScheduler); `fresh` marks what was read now
+    RackSample sample;
+    uint8_t    fresh[MAX_PLANTS];
+    uint8_t    airFailed = readDueSensors(sensors, senseScheduler, rack, PLANT_COUNT, now, sample, fresh);
+
+    // --- FOLD INTO THE WINDOW STATISTICS (NAN air fields are skipped) ---
+    WindowSummary closed[MAX_PLANTS * AGG_WINDOWS];
+    size_t        closedCount = foldIntoWindows(aggregators, sample, fresh, bootCount, closed);
+    for (size_t i = 0; i < closedCount; i++) {
+      if (!summaryRing.push(closed[i])) droppedSummaries++;
     }
 
-    case FACE_DARK: {
-      // -_- sleeping closed eyes (thick horizontal bars)
-      display.fillRect(34, 26, 20, 4, SSD1306_WHITE);
-      display.fillRect(74, 26, 20, 4, SSD1306_WHITE);
-      // Small peaceful mouth
-      display.fillRect(56, 50, 16, 2, SSD1306_WHITE);
-      // Zzz floating to the upper right
-      display.setTextSize(2);
-      display.setTextColor(SSD1306_WHITE);
-      display.setCursor(102, 13);
-      display.print("Z");
-      display.setTextSize(1);
-      display.setCursor(110, 16);
-      display.print("z");
-      display.setCursor(116, 22);
-      display.print("z");
-      break;
+    // --- DISPLAY ON OLED (new scene only when something on it changed) ---
+    classifyRack(rack, faceClassifier, sample, now);
+    publishScene(now);
+
+    // --- HAND OFF TO LAN SUBSCRIBERS (dropped if lanTask is behind) ---
+    if (lanSamples.push(sample)) {
+      xTaskNotifyGive(lanTaskHandle);
+    } else {
+      lanDroppedSamples++;
     }
 
-    case FACE_BRIGHT: {
-      // Squinting ≡_≡ eyes (three lines per eye)
-      // Left eye
-      display.fillRect(34, 22, 20, 2, SSD1306_WHITE);
-      display.fillRect(34, 27, 20, 2, SSD1306_WHITE);
-      display.fillRect(34, 32, 20, 2, SSD1306_WHITE);
-      // Right eye
-      display.fillRect(74, 22, 20, 2, SSD1306_WHITE);
-      display.fillRect(74, 27, 20, 2, SSD1306_WHITE);
-      display.fillRect(74, 32, 20, 2, SSD1306_WHITE);
-      // Wide cheery smile
-      display.drawLine(34, 48, 40, 56, SSD1306_WHITE);
-      display.drawLine(40, 56, 88, 56, SSD1306_WHITE);
-      display.drawLine(88, 56, 94, 48, SSD1306_WHITE);
-      display.drawLine(34, 49, 40, 57, SSD1306_WHITE);
-      display.drawLine(40, 57, 88, 57, SSD1306_WHITE);
-      display.drawLine(88, 57, 94, 49, SSD1306_WHITE);
-      // Sun rays at top corners
-      display.drawLine(6, 14, 14, 14, SSD1306_WHITE);
-      display.drawLine(10, 12, 10, 16, SSD1306_WHITE);
-      display.drawLine(114, 14, 122, 14, SSD1306_WHITE);
-      display.drawLine(118, 12, 118, 16, SSD1306_WHITE);
-      break;
+    // Check for sensor error (the network task skips plants without air readings)
+    if (airFailed) {
+      Serial.println("Failed to read from DHT sensor!");
+      if (airFailed == PLANT_COUNT) continue;
     }
 
-    case FACE_HUMID: {
-      // Droopy half-closed eyes (heavy moisture)
-      display.fillRect(34, 28, 20, 4, SSD1306_WHITE);   // Left eye slit
-      display.drawLine(34, 28, 34, 22, SSD1306_WHITE);  // Left eyelid
-      display.drawLine(54, 28, 54, 22, SSD1306_WHITE);
-      display.drawLine(34, 22, 54, 22, SSD1306_WHITE);
-      display.fillRect(74, 28, 20, 4, SSD1306_WHITE);   // Right eye slit
-      display.drawLine(74, 28, 74, 22, SSD1306_WHITE);
-      display.drawLine(94, 28, 94, 22, SSD1306_WHITE);
-      display.drawLine(74, 22, 94, 22, SSD1306_WHITE);
-      // Flat uneasy mouth
-      display.fillRect(44, 50, 40, 3, SSD1306_WHITE);
-      // Droplets around face
-      display.fillCircle(18, 20, 2, SSD1306_WHITE);
-      display.fillCircle(110, 24, 2, SSD1306_WHITE);
-      display.fillCircle(24, 42, 2, SSD1306_WHITE);
-      display.fillCircle(104, 46, 2, SSD1306_WHITE);
-      break;
+    // --- HAND OFF TO THE NETWORK TASK ---
+    if (sampleRing.push(sample)) {
+      xTaskNotifyGive(networkTaskHandle);
+    } else {
+      droppedSamples++;
     }
 
-    case FACE_DRY_AIR: {
-      // Squished/cracked eyes (parched)
-      display.drawCircle(44, 28, 8, SSD1306_WHITE);
-      display.drawCircle(84, 28, 8, SSD1306_WHITE);
-      display.fillCircle(44, 28, 3, SSD1306_WHITE);
-      display.fillCircle(84, 28, 3, SSD1306_WHITE);
-      // Small O-shaped mouth (gasping)
-      display.drawCircle(64, 52, 6, SSD1306_WHITE);
-      display.drawCircle(64, 52, 5, SSD1306_WHITE);
-      // Crack lines on cheeks
-      display.drawLine(18, 36, 28, 32, SSD1306_WHITE);
-      display.drawLine(28, 32, 22, 28, SSD1306_WHITE);
-      display.drawLine(100, 36, 110, 32, SSD1306_WHITE);
-      display.drawLine(110, 32, 104, 28, SSD1306_WHITE);
-      break;
+    if (millis() - lastOledReport > OLED_REPORT_INTERVAL_MS) {
+      lastOledReport = millis();
+      Serial.printf("[OLED] %lu frames, %lu unchanged, %.1f I2C bytes/frame (full redraw ≈ %d)\n",
+        (unsigned long)frameFlusher.frames, (unsigned long)frameFlusher.cleanFrames,
+        frameFlusher.frames ? (float)frameFlusher.i2cBytes / frameFlusher.frames : 0.0f,
+        OLED_FULL_FRAME_I2C_BYTES);
+      Serial.printf("[Face] %lu samples, %lu face changes, %lu flips debounced, %lu unchanged scenes\n",
+        (unsigned long)faceClassifier.stats.evaluations, (unsigned long)faceClassifier.stats.transitions,
+        (unsigned long)faceClassifier.stats.debounced, (unsigned long)sceneSelector.skipped);
+      printFrameBudget();
+      printSampling();
+      printLanStats();
     }
   }
 }
 
-void updateScreen(float temp, int moisture, float humid, float lux) {
-  display.clearDisplay();
-  
-  // Update Battery Placeholder
-  static int batteryPercent = 85; 
-  
-  // Draw Status Bar
-  drawStatusBar(batteryPercent);
+// Keep a failed/offline sample for later (rate-limited to save flash)
+void logOffline(const RackSample &sample) {
+  unsigned long now = sample.plant[0].timestamp;
+  if (lastOfflineLog != 0 && now - lastOfflineLog < OFFLINE_LOG_INTERVAL_MS) return;
+  lastOfflineLog = now;
+  for (uint8_t p = 0; p < sample.count; p++) {
+    if (airValid(sample.plant[p]) && !sampleLog.append(sample.plant[p], p)) Serial.println("[Log] Append failed!");
+  }
+}
 
-  // ---- Determine Face using DYNAMIC thresholds from Firebase ----
-  int faceType = FACE_HAPPY; // Default — all vitals are within range!
+// Upload one batch of the offline backlog (one HTTPS request)
+void drainBacklog() {
+  if (sampleLog.pending() == 0) return;
+  PROFILE_STAGE(STAGE_BACKLOG);
+  if (backlogStartMs == 0) {
+    backlogStartMs = millis();
+    backlogRequests = backlogSent = 0;
+    Serial.printf("[Log] Catching up on %lu offline sample(s)\n", (unsigned long)sampleLog.pending());
+  }
 
-  // 1. CRITICAL: Soil Moisture
-  if (moisture < thresholds.moistureLow) {
-    faceType = FACE_THIRSTY;
-  } 
-  else if (moisture > thresholds.moistureHigh) {
-    faceType = FACE_OVERWATERED;
+  size_t n = sampleLog.peek(backlogBatch, BACKLOG_BATCH);
+  if (n > 0 && !cloud->uploadBacklog(backlogBatch, n)) {
+    Serial.print("[Log] Batch upload FAILED: ");
+    Serial.println(cloud->lastError());
+    return;
   }
-  // 2. WARNING: Temperature
-  else if (temp > thresholds.tempHigh) {
-    faceType = FACE_HOT;
+  sampleLog.consumePeeked();
+  backlogRequests++;
+  backlogSent += n;
+
+  if (sampleLog.pending() == 0) {
+    Serial.printf("[Log] Backlog drained: %lu sample(s) in %lu request(s), %lu ms\n",
+      (unsigned long)backlogSent, (unsigned long)backlogRequests, millis() - backlogStartMs);
+    backlogStartMs = 0;
   }
-  else if (temp < thresholds.tempLow) {
-    faceType = FACE_COLD;
+}
+
+// Move closed windows from the sensor task into the pending list (the
+// oldest minutes make room while offline, queueSummary())
+void collectSummaries() {
+  WindowSummary s;
+  while (summaryRing.pop(s)) {
+    if (!queueSummary(pendingSummaries, pendingSummaryCount, STATS_PENDING_MAX, s)) droppedSummaries++;
+
+    const RunningStats &soil = s.field[FIELD_SOIL_MOISTURE];
+    if (s.window == AGG_MINUTE && soil.n && s.plant < PLANT_COUNT) {
+      if (forecasters[s.plant].update(soil.mean, s.startMs + s.lengthMs)) {
+        Serial.printf("[Forecast] %s: watering detected\n", PLANTS[s.plant].id);
+      }
+      forecastDirty = true;
+    }
   }
-  // 3. WARNING: Humidity
-  else if (humid > thresholds.humidityHigh) {
-    faceType = FACE_HUMID;
+}
+
+// Write every plant's forecast after a minute closed (kept dirty on failure)
+void uploadForecasts() {
+  bool report = millis() - lastForecastReport > FORECAST_REPORT_INTERVAL_MS;
+  if (!forecastDirty && !report) return;
+
+  ThirstForecast f[MAX_PLANTS];
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    f[p] = forecasters[p].forecast(cloudThresholds.plant[p].moistureLow);
   }
-  else if (humid < thresholds.humidityLow) {
-    faceType = FACE_DRY_AIR;
+  if (report) {
+    lastForecastReport = millis();
+    for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+      if (!forecasters[p].primed()) continue;
+      Serial.printf("[Forecast] %s: %.1f %% drying %.2f %%/h, thirsty in ", PLANTS[p].id, f[p].level, f[p].dryingRate);
+      if (isnan(f[p].hoursToThirsty)) Serial.println("- (no forecast)");
+      else Serial.printf("%.1f h\n", f[p].hoursToThirsty);
+    }
+  }
+  if (!forecastDirty) return;
+
+  if (!cloud->uploadForecasts(f, PLANT_COUNT)) {
+    Serial.print("[Forecast] Write FAILED: ");
+    Serial.println(cloud->lastError());
+    return;
   }
-  // 4. MINOR: Light
-  else if (lux < thresholds.luxLow) {
-    faceType = FACE_DARK;
+  forecastDirty = false;
+}
+
+// Upload every pending summary (one request). Kept for the next cycle on failure.
+void uploadSummaries() {
+  if (pendingSummaryCount == 0) return;
+  if (!uploadWindows(*cloud, pendingSummaries, pendingSummaryCount, PLANT_COUNT)) {
+    Serial.print("[Stats] Summary upload FAILED: ");
+    Serial.println(cloud->lastError());
+    return;
   }
-  else if (lux > thresholds.luxHigh) {
-    faceType = FACE_BRIGHT;
+  Serial.printf("[Stats] %u window summar%s uploaded (%lu dropped so far)\n",
+    (unsigned)pendingSummaryCount, pendingSummaryCount == 1 ? "y" : "ies",
+    (unsigned long)droppedSummaries);
+  pendingSummaryCount = 0;
+  if (!boot.metrics.firstUploadMs) {
+    boot.markFirstUpload(millis());
+    reportBootMetrics();
+    confirmFirmware();
   }
-  // Else stays Happy — the plant is thriving!
+}
 
-  // Draw face using primitives (guaranteed pixel-perfect rendering)
-  drawFace(faceType);
-  
-  display.display();
+// Print (and reset) what delta uploads saved over the last report period
+void reportDeltaSavings() {
+  DeltaStats st = {0, 0, 0, 0};
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    DeltaStats &ps = deltaFilters[p].stats;
+    st.samples   += ps.samples;
+    st.requests  += ps.requests;
+    st.fullBytes += ps.fullBytes;
+    st.sentBytes += ps.sentBytes;
+    ps = DeltaStats{0, 0, 0, 0};
+  }
+  float hours = (millis() - lastDeltaReport) / 3600000.0f;
+  lastDeltaReport = millis();
+  if (st.samples == 0 || hours <= 0) return;
+
+  Serial.printf("[Delta] %lu/%lu writes (%.0f/h saved) | %lu of %lu payload bytes (%.1f B/s saved)\n",
+    (unsigned long)st.requests, (unsigned long)st.samples,
+    (st.samples - st.requests) / hours,
+    (unsigned long)st.sentBytes, (unsigned long)st.fullBytes,
+    (st.fullBytes - st.sentBytes) / (hours * 3600.0f));
 }
 
-// ================= 3. SETUP =================
-void setup() {
+// Serial always; the upload only when online (the next report catches up)
+void reportHeap(bool online) {
+  lastHeapReport = millis();
+  HeapStats h = readHeapStats();
+  printHeapStats(h);
+  if (online && !cloud->uploadHeapStats(h)) {
+    Serial.print("[Heap] Diagnostics write FAILED: ");
+    Serial.println(cloud->lastError());
+  }
+}
+
+void reportTransport(bool online) {
+  printLinkStats();
+  TransportStats t = cloud->transportStats();
+  printTransportStats(t);
+  if (online && !cloud->uploadTransportStats(t)) {
+    Serial.print("[Net] Diagnostics write FAILED: ");
+    Serial.println(cloud->lastError());
+  }
+}
+
+// Write each plant's newest face change to its node (retried until it lands)
+void syncFaceStatus() {
+  PROFILE_STAGE(STAGE_FACE_STATUS);
+  static FaceEvent pending[MAX_PLANTS];
+  static uint32_t  havePending = 0;   // Plant mask
+
+  FaceEvent ev;
+  while (faceEvents.pop(ev)) {
+    pending[ev.plant] = ev;
+    havePending |= 1u << ev.plant;
+  }
+
+  for (uint8_t p = 0; havePending && p < PLANT_COUNT; p++) {
+    if (!(havePending & (1u << p))) continue;
+    if (!cloud->uploadFaceState(p, faceName(pending[p].to), pending[p].atMs)) {
+      Serial.print("[Face] Status write FAILED: ");
+      Serial.println(cloud->lastError());
+      return;
+    }
+    havePending &= ~(1u << p);
+  }
+}
+
+// networkTask (core 0): threshold sync + uploads. Free to block for as long
+// as HTTPS takes; the sensor task keeps its rate regardless.
+void networkTask(void *) {
+  for (;;) {
+    // Wake on a new sample, or at least every 500 ms to keep the token fresh
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+    PROFILE_STAGE(STAGE_NETWORK_CYCLE);
+
+    // The live nodes only ever show the latest reading, so if we fell behind
+    // only the newest sample matters.
+    RackSample sample;
+    bool haveSample = false;
+    while (sampleRing.pop(sample)) haveSample = true;
+    collectSummaries();
+
+    // --- BRING THE NETWORK UP / BACK (non-blocking, backs off between attempts) ---
+    {
+      PROFILE_STAGE(STAGE_BOOT_STEP);
+      runBootStep();
+    }
+    cloudReachable = boot.online() && cloud->ready();
+
+    if (millis() - lastHeapReport > HEAP_REPORT_INTERVAL_MS) {
+      reportHeap(boot.online() && cloud->ready());
+      reportTransport(boot.online() && cloud->ready());
+    }
+#if GAIA_PROFILING
+    if (millis() - lastProfileReport > PROFILE_REPORT_INTERVAL_MS) {
+      reportProfile(boot.online() && cloud->ready());
+    }
+#endif
+
+    if (!boot.online() || !cloud->ready()) {
+      if (haveSample) logOffline(sample);
+      continue;
+    }
+
+    // --- SYNC THRESHOLDS FROM FIREBASE (pushed; polled only as a fallback) ---
+    syncThresholds();
+
+    // --- PUBLISH FACE CHANGES (only on transitions) ---
+    syncFaceStatus();
+
+    // --- STEP B: UPLOAD CLOSED WINDOW SUMMARIES + FORECASTS (all plants, one request each) ---
+    uploadSummaries();
+    uploadForecasts();
+
+#if LIVE_UPLOADS
+    // --- STEP B.1: UPLOAD WHAT CHANGED TO FIREBASE (all plants, one request) ---
+    uint8_t      fields[MAX_PLANTS];
+    ChangeUpload sent = haveSample ? uploadChanges(*cloud, deltaFilters, sample, millis(), fields) : CHANGES_NONE;
+
+    if (sent != CHANGES_NONE) {
+      bool allFull = true;
+      for (uint8_t p = 0; p < PLANT_COUNT; p++) allFull &= fields[p] == 0 || fields[p] == FIELD_MASK_ALL;
+      Serial.printf("Sending to %s... ", cloudName);
+
+      if (sent == CHANGES_SENT) {
+        if (!boot.metrics.firstUploadMs) {
+          boot.markFirstUpload(millis());
+          reportBootMetrics();
+          confirmFirmware();
+        }
+        Serial.println(allFull ? "SUCCESS! Data saved." : "SUCCESS! Changes saved.");
+        for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+          if (!fields[p]) continue;
+          const Telemetry &t = sample.plant[p];
+          if (PLANT_COUNT > 1) Serial.printf("[%s] ", PLANTS[p].id);
+          Serial.print("Temp: "); Serial.print(t.temperature);
+          Serial.print("°C | Humid: "); Serial.print(t.humidity);
+          Serial.print("% | Soil: "); Serial.print(t.soilMoisture);
+          Serial.print("% | Light: "); Serial.print(t.lux);
+          Serial.println(" lux");
+        }
+      } else {
+        Serial.print("FAILED: ");
+        Serial.println(cloud->lastError());
+        logOffline(sample);
+        continue;
+      }
+    }
+
+    if (millis() - lastDeltaReport > DELTA_REPORT_INTERVAL_MS) {
+      reportDeltaSavings();
+    }
+#endif
+
+    // --- STEP C: CATCH UP ON THE OFFLINE LOG ---
+    drainBacklog();
+
+    // --- STEP D: THRESHOLD ANSWERS NO UPLOAD PICKED UP ---
+    cloud->finishRequests();
+    collectThresholds();
+  }
+}
+
+#if GAIA_LOW_POWER
+// ================= 3.1 LOW-POWER MODE =================
+// setup() hands over to lowPowerWake() before any of the normal start-up. Each
+// wake runs one cycle: one-shot sensor reads, face rules, an OLED redraw only
+// if the face changed, and an upload only when DutyCycle says one is due.
+// Then the board sleeps. Everything that must survive deep sleep sits in `rtc`.
+//   - Samples wait in rtc.batch. At upload time they go through the offline
+//     log into /history, so no sample taken while asleep is lost.
+//   - The live nodes are updated through the delta filters as before.
+//   - Thresholds are fetched once per upload (no stream).
+//   - Racks show the next plant on every wake.
+
+// Trivially copyable objects parked in RTC memory as raw bytes, so no
+// constructor runs over them when the chip wakes up
+template <typename T>
+struct RtcImage {
+  static_assert(std::is_trivially_copyable<T>::value, "RtcImage needs a trivially copyable type");
+  alignas(T) uint8_t bytes[sizeof(T)];
+  void save(const T &obj) { memcpy(bytes, &obj, sizeof(T)); }
+  void load(T &obj) const { memcpy(&obj, bytes, sizeof(T)); }
+};
+
+struct LowPowerRtc {
+  DutyCycleState                    duty;
+  RtcImage<DeltaFilter[MAX_PLANTS]> delta;        // Last uploaded values
+  RtcImage<FaceClassifier>          face;         // Rule latches + dwell timers
+  float                             moistureEma[MAX_PLANTS];  // Soil probe filter states
+  PackedThresholds                  thresholds[MAX_PLANTS];   // No String: heap memory doesn't survive deep sleep
+  uint32_t                          boot;         // Boot counter of the last cold boot (duty.nowMs() restarts there)
+  uint8_t                           shownPlant;
+  uint8_t                           shownFace;    // On the OLED (FACE_NONE = panel not drawn yet)
+  bool                              shownOnline;
+  uint8_t                           uploadedFace[MAX_PLANTS]; // Last face written to each plant node
+  uint8_t                           pending;      // Samples in batch[]
+  RackSample                        batch[LP_BATCH_MAX];
+};
+
+RTC_DATA_ATTR LowPowerRtc rtc;
+
+Esp32Power boardPower;
+PowerHal  &power = boardPower;
+DutyCycle  duty(DUTY_CONFIG, rtc.duty);
+
+void saveRtcState() {
+  rtc.delta.save(deltaFilters);
+  rtc.face.save(faceClassifier);
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    rtc.moistureEma[p] = boardSensors.moistureProbe().filterState(p);
+    packThresholds(cloudThresholds.plant[p], rtc.thresholds[p]);
+  }
+}
+
+// Returns false after a cold boot (RTC memory not ours yet)
+bool restoreRtcState() {
+  if (!power.wokeFromDeepSleep() || !duty.resumed()) return false;
+  rtc.delta.load(deltaFilters);
+  rtc.face.load(faceClassifier);
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    boardSensors.moistureProbe().restoreFilter(p, rtc.moistureEma[p]);
+    unpackThresholds(rtc.thresholds[p], cloudThresholds.plant[p]);
+  }
+  return true;
+}
+
+// Draw straight to the panel; the face cache is too slow to build every wake
+void lowPowerRedraw(bool online) {
+  uint8_t p = rtc.shownPlant;
+  if (!screen.begin()) return;
+  screen.clear();
+  drawFace(display, faceClassifier.face(p));
+  layoutStatusLabel(statusLabels[p], p, PLANT_COUNT, PLANTS[p].id, cloudThresholds.plant[p]);
+  drawStatusBar(display, 85, statusLabels[p], online);
+  screen.flush();
+  rtc.shownFace   = faceClassifier.face(p);
+  rtc.shownOnline = online;
+}
+
+// Move batched samples into the flash log (its sequence numbers key /history)
+void spillBatch() {
+  for (uint8_t i = 0; i < rtc.pending; i++) {
+    const RackSample &s = rtc.batch[i];
+    for (uint8_t p = 0; p < s.count; p++) {
+      if (airValid(s.plant[p]) && !sampleLog.append(s.plant[p], p)) Serial.println("[Log] Append failed!");
+    }
+  }
+  rtc.pending = 0;
+}
+
+bool lowPowerUpload(const RackSample &latest, uint64_t nowMs) {
+  sampleLog.begin(bootCount);
+  spillBatch();
+
+  // Cached BSSID/channel first (no scan), then a normal join
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  bool     fast = loadCachedAp();
+  uint32_t t0   = millis();
+  if (fast) WiFi.begin(WIFI_SSID, WIFI_PASSWORD, apChannel, apBssid);
+  else      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  while (WiFi.status() != WL_CONNECTED && millis() - t0 < LP_WIFI_TIMEOUT_MS) {
+    if (fast && millis() - t0 > BOOT_TIMEOUTS.fastLinkMs) {
+      fast = false;
+      WiFi.disconnect();
+      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    }
+    delay(10);
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    Serial.println("[Power] WiFi timeout - samples stay in the offline log");
+    return false;
+  }
+  saveCachedAp();
+
+  cloud->begin();
+  t0 = millis();
+  while (!cloud->ready() && millis() - t0 < LP_CLOUD_TIMEOUT_MS) delay(10);
+  if (!cloud->ready()) return false;
+
+  // The reads ride along with the first write
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) fetchThresholdsFromFirebase(p);
+
+  uint8_t fields[MAX_PLANTS];
+  bool    anyFields = false;
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    // A failed DHT22 read would go out as null and delete the keys
+    const Telemetry &t = latest.plant[p];
+    fields[p] = airValid(t) ? deltaFilters[p].changedFields(t, nowMs) : 0;
+    anyFields |= fields[p] != 0;
+  }
+  if (anyFields && cloud->uploadTelemetry(latest.plant, fields, PLANT_COUNT)) {
+    for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+      if (fields[p]) deltaFilters[p].commit(latest.plant[p], fields[p], nowMs);
+    }
+  }
+  cloud->finishRequests();
+  collectThresholds();
+  rackSetThresholds(rack, cloudThresholds);
+
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    uint8_t face = faceClassifier.face(p);
+    if (rtc.uploadedFace[p] != face && cloud->uploadFaceState(p, faceName(face), nowMs)) {
+      rtc.uploadedFace[p] = face;
+    }
+  }
+
+  // One request per BACKLOG_BATCH samples; stop early if one fails
+  while (sampleLog.pending() > 0) {
+    size_t before = sampleLog.pending();
+    drainBacklog();
+    if (sampleLog.pending() == before) return false;
+  }
+  return true;
+}
+
+void reportPower(uint32_t awakeUs, uint32_t radioUs, const SleepPlan &sleep) {
+  const EnergyLedger &l = duty.ledger();
+  float avgMa  = l.averageMa(POWER_MODEL);
+  float perDay = avgMa * 24.0f;
+  Serial.printf("[Power] Cycle %lu: awake %lu ms (radio %lu ms), %s sleep %lu ms | "
+                "avg %.2f mA = %.1f mAh/day (~%.0f days on %d mAh), %.2f mAh used\n",
+    (unsigned long)l.cycles, (unsigned long)(awakeUs / 1000), (unsigned long)(radioUs / 1000),
+    sleep.kind == SLEEP_DEEP ? "deep" : "light", (unsigned long)sleep.ms,
+    avgMa, perDay, perDay > 0 ? BATTERY_CAPACITY_MAH / perDay : 0.0f, BATTERY_CAPACITY_MAH,
+    l.mAh(POWER_MODEL));
+}
+
+// Never returns: light sleep loops here, deep sleep reboots into setup()
+void lowPowerWake() {
   Serial.begin(115200);
-  delay(2000);
+  Wire.begin(SDA_PIN, SCL_PIN);
+  sensors.beginOneShot();
+
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) deltaFilters[p] = DeltaFilter(DELTA_CONFIG);
+  if (!restoreRtcState()) {
+    Serial.println("\n========== GAIA LOW-POWER MODE (cold boot) ==========");
+    duty.reset();
+    for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+      loadCachedThresholds(p, cloudThresholds.plant[p]);
+      rtc.uploadedFace[p] = FACE_NONE;
+    }
+    rtc.pending    = 0;
+    rtc.shownPlant = 0;
+    rtc.shownFace  = FACE_NONE;
+    rtc.boot       = countBoot();
+  }
+  bootCount = rtc.boot;
+  rackSetThresholds(rack, cloudThresholds);
+
+  uint64_t cycleStartUs = 0;  // Deep sleep wake: the cycle began at boot
+  for (;;) {
+    uint32_t awakeUs = power.nowUs() - cycleStartUs;
+    uint64_t nowMs   = duty.nowMs(awakeUs);
+
+    RackSample sample;
+    sample.count = PLANT_COUNT;
+    bool sampled = sensors.sampleOnce();
+    for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+      Telemetry &t   = sample.plant[p];
+      t.temperature  = sensors.readTemperature(p);
+      t.humidity     = sensors.readHumidity(p);
+      t.soilMoisture = sensors.readMoisturePercent(p);
+      t.soilRaw      = sensors.readMoistureRaw(p);
+      float lux      = sensors.readLux(p);
+      t.lux          = lux >= 0 ? lux : 0;
+      t.timestamp    = nowMs;
+    }
+
+    if (sampled) {
+      rackSetReadings(rack, sample);
+      faceClassifier.evaluate(rack, nowMs);
+      rtc.batch[rtc.pending++] = sample;
+    } else {
+      Serial.println("Failed to read from sensors!");
+    }
+
+    // --- RADIO (only when an upload is due) ---
+    bool faceUnsent = false;
+    for (uint8_t p = 0; p < PLANT_COUNT; p++) faceUnsent |= rtc.uploadedFace[p] != faceClassifier.face(p);
+    bool upload     = duty.uploadDue(rtc.pending, faceUnsent, power.nowUs() - cycleStartUs);
+    bool uploaded   = false;
+    uint64_t radioStartUs = power.nowUs();
+    if (upload) {
+      uploaded = lowPowerUpload(sample, nowMs);
+      WiFi.disconnect(true);
+      WiFi.mode(WIFI_OFF);
+    } else if (rtc.pending >= LP_BATCH_MAX) {
+      sampleLog.begin(bootCount);  // Offline for a while: park the full batch in flash
+      spillBatch();
+    }
+    uint32_t radioUs = upload ? power.nowUs() - radioStartUs : 0;
+
+    // --- OLED (only when something on it changed) ---
+    bool online = upload ? uploaded : !rtc.duty.lastFailed;
+    if (PLANT_COUNT > 1) {
+      rtc.shownPlant = (rtc.shownPlant + 1) % PLANT_COUNT;
+      rtc.shownFace  = FACE_NONE;
+    }
+    if (rtc.shownFace != faceClassifier.face(rtc.shownPlant) || rtc.shownOnline != online) lowPowerRedraw(online);
+
+    // --- SLEEP ---
+    awakeUs = power.nowUs() - cycleStartUs;
+    SleepPlan sleep = duty.finish(upload, uploaded, awakeUs, radioUs);
+    reportPower(awakeUs, radioUs, sleep);
+    saveRtcState();
+
+    if (sleep.kind == SLEEP_DEEP) power.deepSleep(sleep.ms);
+    power.lightSleep(sleep.ms);
+    cycleStartUs = power.nowUs();
+  }
+}
+#endif
+
+// ================= 4. SETUP =================
+// Everything up to the first face, before the pipeline tasks exist (so the
+// STAGE_SETUP timing isn't stretched by the sensor task preempting setup())
+void localStartup() {
+  PROFILE_STAGE(STAGE_SETUP);
+  Serial.begin(115200);  // No wait for the monitor: boot time matters more
   Serial.println("\n========== GAIA SYSTEM STARTUP ==========");
   
   // Initialize I2C
@@ -439,223 +1586,97 @@ void setup() {
   Serial.println(" device(s)\n");
   
   // Initialize OLED - try 0x3C first, then 0x3D
-  bool oledOK = false;
-  if(display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-    Serial.println("✓ OLED initialized at 0x3C");
-    oledOK = true;
-  } else if(display.begin(SSD1306_SWITCHCAPVCC, 0x3D)) {
-    Serial.println("✓ OLED initialized at 0x3D");
-    oledOK = true;
-  } else {
-    Serial.println("✗ OLED initialization FAILED!");
-    Serial.println("  Check: VCC->3.3V, GND->GND, SDA->21, SCL->22");
-  }
-  
-  if (oledOK) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0, 32);
-    display.println("=== GAIA System ===");
-    display.println();
-    display.println("Initializing...");
-    display.println("WiFi connecting...");
-    display.display();
+  {
+    PROFILE_STAGE(STAGE_SETUP_DISPLAY);
+    screen.begin();
   }
-  
-  // Initialize BH1750
-  if (lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE)) {
-    Serial.println("✓ BH1750 initialized (ADDR->GND)");
-  } else {
-    Serial.println("✗ BH1750 initialization failed!");
-    Serial.println("  Check: ADDR->GND for 0x23 address");
+
+  // Initialize BH1750, DHT22 and the soil probe
+  {
+    PROFILE_STAGE(STAGE_SETUP_SENSORS);
+    sensors.begin();
   }
-  
-  // Start Other Sensors
-  dht.begin();
-  pinMode(MOISTURE_PIN, INPUT);
-  Serial.println("✓ DHT22 and Moisture sensors initialized");
-  Serial.println();
 
-  // Start Wi-Fi
-  Serial.println("WiFi Configuration:");
-  Serial.print("  SSID: ");
-  Serial.println(WIFI_SSID);
-  Serial.print("  Password Length: ");
-  Serial.println(strlen(WIFI_PASSWORD));
-  Serial.println();
-  
-  // Power cycle WiFi for clean start
-  WiFi.mode(WIFI_OFF);
-  delay(500);
-  WiFi.mode(WIFI_STA);
-  delay(500);
-  WiFi.disconnect(true);
-  delay(1000);
-  
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  Serial.print("Connecting to Wi-Fi");
-  
-  int wifiAttempts = 0;
-  while (WiFi.status() != WL_CONNECTED && wifiAttempts < 50) {
-    Serial.print(".");
-    
-    // Update OLED every 5 attempts
-    if (wifiAttempts % 5 == 0) {
-      display.clearDisplay();
-      display.setCursor(0, 32);
-      display.println("WiFi Connecting...");
-      display.println();
-      display.print("Attempt: ");
-      display.print(wifiAttempts + 1);
-      display.print("/50");
-      for (int i = 0; i < (wifiAttempts / 5) % 4; i++) {
-        display.print(".");
-      }
-      display.display();
-    }
-    
-    // Retry connection every 10 attempts
-    if (wifiAttempts > 0 && wifiAttempts % 10 == 0) {
-      Serial.println();
-      Serial.println("  Retrying connection...");
-      WiFi.disconnect();
-      delay(500);
-      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  // Offline sample log (LittleFS); records carry the boot they were taken in
+  bootCount = countBoot();
+  sampleLog.begin(bootCount);
+
+  // Last-known thresholds, so the first face already fits the species.
+  // The network task replaces them once Firebase is reachable.
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    deltaFilters[p] = DeltaFilter(DELTA_CONFIG);
+    aggregators[p]  = WindowAggregator(STATS_MINUTE_MS, STATS_HOUR_MS);
+    if (loadCachedThresholds(p, cloudThresholds.plant[p])) {
+      Serial.printf("[Thresholds] %s: restored last-known values from NVS\n", PLANTS[p].id);
+    } else {
+      Serial.printf("[Thresholds] %s: no cached values - using defaults\n", PLANTS[p].id);
     }
-    
-    delay(500);
-    wifiAttempts++;
+    publishThresholds(p);
   }
-  Serial.println();
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print("✓ Connected with IP: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("  Signal Strength: ");
-    Serial.print(WiFi.RSSI());
-    Serial.println(" dBm");
-    
-    display.clearDisplay();
-    display.setCursor(0, 32);
-    display.println("WiFi: Connected!");
-    display.println();
-    display.print("IP: ");
-    display.println(WiFi.localIP());
-    display.display();
-    delay(3000);
-  } else {
-    Serial.println("✗ WiFi connection failed!");
-    Serial.println();
-    Serial.println("Troubleshooting:");
-    Serial.println("  1. Check SSID name is correct");
-    Serial.println("  2. Check password is correct");
-    Serial.println("  3. Make sure WiFi is 2.4GHz (ESP32 doesn't support 5GHz)");
-    Serial.println("  4. Check WiFi router is powered on");
-    Serial.println("  5. Move ESP32 closer to router");
-    Serial.println();
-    Serial.println("Current WiFi Status Code: ");
-    Serial.println(WiFi.status());
-    Serial.println("  0=IDLE, 1=NO_SSID, 3=CONNECTED, 4=FAILED, 6=DISCONNECTED");
-    Serial.println();
-    
-    display.clearDisplay();
-    display.setCursor(0, 32);
-    display.println("WiFi FAILED!");
-    display.println();
-    display.println("Check settings");
-    display.print("Status: ");
-    display.println(WiFi.status());
-    display.display();
-    
-    // Continue without WiFi for sensor testing
-    Serial.println("Continuing without WiFi...");
-    Serial.println("Sensors will still work locally.");
-  }
-
-  // Start Firebase
-  config.api_key = API_KEY;
-  config.database_url = DATABASE_URL;
-
-  display.clearDisplay();
-  display.setCursor(0, 32);
-  display.println("Connecting to");
-  display.println("Firebase...");
-  display.display();
-
-  // Sign up anonymously (Test Mode allows this)
-  if (Firebase.signUp(&config, &auth, "", "")) {
-    Serial.println("✓ Firebase Auth Successful");
-    signupOK = true;
-  } else {
-    Serial.printf("✗ Firebase Error: %s\n", config.signer.signupError.message.c_str());
+  senseScheduler.configure(SENSE_CONFIG, PLANT_COUNT, SAMPLE_PERIOD_MS);
+  sceneSelector.configure(PLANT_COUNT, OLED_PLANT_PERIOD_MS);
+
+  // Rasterize every face once; from here on frames are memcpy + dirty-span flushes
+  unsigned long cacheStart = millis();
+  {
+    PROFILE_STAGE(STAGE_SETUP_FACE_CACHE);
+    faceCache.build(screen, renderFace);
   }
+  frameFlusher.invalidate();
+  faceClassifier.subscribe(onFaceChanged);
+  faceClassifier.subscribe(queueFaceStatus);
+  faceClassifier.subscribe(queueLanFace);
+  Serial.printf("[OLED] Cached %d faces (%u bytes) in %lu ms\n",
+    FACE_COUNT, (unsigned)sizeof(FaceCache), millis() - cacheStart);
 
-  Firebase.begin(&config, &auth);
-  Firebase.reconnectWiFi(true);
+  // WiFi + Firebase come up in the background (runBootStep() in the network task)
+  WiFi.persistent(false);  // Credentials come from this file; don't rewrite flash on every begin()
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);  // Rejoins back off in the boot sequence instead
+  boot.setCachedAp(loadCachedAp());
+  boot.setSeed(esp_random());
 
-  // Fetch plant thresholds on startup
-  delay(2000); // Give Firebase a moment to connect
-  fetchThresholdsFromFirebase();
-  
-  Serial.println("\n========== SYSTEM READY ==========");
-  Serial.print("Plant Species: ");
-  Serial.println(thresholds.speciesName);
+  Serial.printf("\n========== LOCAL START-UP DONE (%lu ms) ==========\n", millis());
+  Serial.printf("Cloud backend: %s\n", cloudName);
+  Serial.printf("Firmware slot: %s%s\n", otaUpdater.runningSlot(),
+    otaUpdater.pendingVerify() ? " (new image: on probation until the first upload)" : "");
+  for (uint8_t p = 0; p < PLANT_COUNT; p++) {
+    Serial.printf("Plant %s: %s\n", PLANTS[p].id, cloudThresholds.plant[p].speciesName);
+  }
   Serial.println();
 }
 
-// ================= 4. MAIN LOOP =================
-void loop() {
-  // Update every 1 second (1000ms)
-  if (Firebase.ready() && signupOK && (millis() - sendDataPrevMillis > 1000 || sendDataPrevMillis == 0)) {
-    sendDataPrevMillis = millis();
-
-    // --- STEP A: READ SENSORS ---
-    float temp = dht.readTemperature();
-    float humid = dht.readHumidity();
-    int rawMoisture = analogRead(MOISTURE_PIN);
-    float lux = lightMeter.readLightLevel();
-
-    // Convert Moisture to Percentage
-    int moistPercent = map(rawMoisture, DRY_VAL, WET_VAL, 0, 100);
-    moistPercent = constrain(moistPercent, 0, 100);
-
-    // Check for sensor error
-    if (isnan(temp) || isnan(humid)) {
-      Serial.println("Failed to read from DHT sensor!");
-      return;
-    }
+void setup() {
+#if GAIA_PROFILING
+  profilerBegin();
+#endif
+  selectCloudBackend();
+#if GAIA_LOW_POWER
+  lowPowerWake();  // Battery mode never comes back here
+#endif
+  // Before the rest of start-up: a new image that crashes in it still uses
+  // up its trial boots (ota_update.h)
+  otaUpdater.begin(OTA_SERVER_URL, OTA_SIGNING_KEY);
+  localStartup();
+  startLanServer();
 
-    // --- SYNC THRESHOLDS FROM FIREBASE (every 30s) ---
-    if (millis() - lastThresholdFetch > THRESHOLD_FETCH_INTERVAL) {
-      lastThresholdFetch = millis();
-      fetchThresholdsFromFirebase();
-    }
-
-    // --- DISPLAY ON OLED ---
-    updateScreen(temp, moistPercent, humid, lux);
-
-    // --- STEP B: UPLOAD TO FIREBASE ---
-    Serial.print("Sending to Firebase... ");
-
-    FirebaseJson json;
-    json.set("temperature", temp);
-    json.set("humidity", humid);
-    json.set("soil_moisture", moistPercent);
-    json.set("soil_raw", rawMoisture);
-    json.set("light_intensity", lux >= 0 ? lux : 0);
-    json.set("timestamp", millis());
-
-    if (Firebase.RTDB.setJSON(&fbdo, "/plants/gaia_01", &json)) {
-      Serial.println("SUCCESS! Data saved.");
-      Serial.print("Temp: "); Serial.print(temp);
-      Serial.print("°C | Humid: "); Serial.print(humid);
-      Serial.print("% | Soil: "); Serial.print(moistPercent);
-      Serial.print("% | Light: "); Serial.print(lux);
-      Serial.println(" lux");
-    } else {
-      Serial.print("FAILED: ");
-      Serial.println(fbdo.errorReason());
-    }
-  }
-}
\ No newline at end of file
+  // Hand over to the pipeline tasks (see section 3), the animation (2.1.1),
+  // the LAN feed (2.0.0.9) and firmware updates (2.0.0.10). The sensor task
+  // starts last: its first tick runs at once and notifies the others.
+  xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, NULL,
+                          NETWORK_TASK_PRIO, &networkTaskHandle, NETWORK_TASK_CORE);
+  xTaskCreatePinnedToCore(lanTask, "lan", LAN_TASK_STACK, NULL,
+                          LAN_TASK_PRIO, &lanTaskHandle, LAN_TASK_CORE);
+  xTaskCreatePinnedToCore(otaTask, "ota", OTA_TASK_STACK, NULL,
+                          OTA_TASK_PRIO, &otaTaskHandle, OTA_TASK_CORE);
+  xTaskCreatePinnedToCore(animTask, "anim", ANIM_TASK_STACK, NULL,
+                          ANIM_TASK_PRIO, NULL, ANIM_TASK_CORE);
+  xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, NULL,
+                          SENSOR_TASK_PRIO, &sensorTaskHandle, SENSOR_TASK_CORE);
+}
+
+// ================= 5. MAIN LOOP =================
+// All work happens in sensorTask/networkTask; the Arduino loop task is retired.
+void loop() {
+  vTaskDelete(NULL);
+}
@@ -0,0 +1,237 @@
+#include "mqtt_client.h"
+
+void MqttClient::begin(const char *brokerUrl, const char *clientId, const char *user, const char *password,
+                       const char *caCert) {
+  // "mqtts://host[:port]" -> "host", port
+  const char *p = strstr(brokerUrl, "://");
+  p = p ? p + 3 : brokerUrl;
+  size_t n = strcspn(p, ":/");
+  if (n >= sizeof(host)) n = sizeof(host) - 1;
+  memcpy(host, p, n);
+  host[n] = '\0';
+  port = p[n] == ':' ? (uint16_t)atoi(p + n + 1) : 8883;
+  this->clientId = clientId;
+  this->user     = user;
+  this->password = password;
+  tls.setCaCert(caCert);
+}
+
+void MqttClient::onMessage(Handler handler, void *ctx) {
+  this->handler = handler;
+  handlerCtx    = ctx;
+}
+
+void MqttClient::drop() {
+  tls.stop();
+  session       = false;
+  inflightCount = 0;
+  pingOut       = false;
+}
+
+bool MqttClient::fail(const char *reason) {
+  strlcpy(error, reason, sizeof(error));
+  st.failures++;
+  drop();
+  return false;
+}
+
+void MqttClient::stop() {
+  if (session) {
+    JsonOut out(tx, sizeof(tx), drain, this);
+    mqttDisconnect(out);
+    out.finish();
+  }
+  drop();
+}
+
+bool MqttClient::drain(void *ctx, const char *data, size_t len) {
+  MqttClient &c = *(MqttClient *)ctx;
+  c.st.txBytes += len;
+  return c.tls.write((const uint8_t *)data, len);
+}
+
+bool MqttClient::connect() {
+  drop();
+  error[0] = '\0';
+  if (!tls.connect(host, port, MQTT_TIMEOUT_MS)) return fail("TLS connect failed");
+
+  JsonOut out(tx, sizeof(tx), drain, this);
+  mqttConnect(out, clientId, user, password, MQTT_KEEPALIVE_S);
+  if (!out.finish()) return fail("Write failed");
+
+  // Nothing comes before the CONNACK
+  if (!readPacket() || MQTT_TYPE(rxHeader) != MQTT_CONNACK || rxLen < 2) return fail("No CONNACK");
+  if (rx[1] != 0) {
+    char reason[32];
+    snprintf(reason, sizeof(reason), "Connection refused (%u)", rx[1]);   // 4 = bad user/password, 5 = not authorized
+    return fail(reason);
+  }
+  session = true;
+  return true;
+}
+
+uint16_t MqttClient::nextPacketId() {
+  if (++packetId == 0) packetId = 1;
+  return packetId;
+}
+
+void MqttClient::track(uint16_t id) {
+  if (inflightCount) st.pipelined++;
+  inflight[inflightCount++] = { id, millis() };
+}
+
+void MqttClient::acked(uint16_t id) {
+  for (uint8_t i = 0; i < inflightCount; i++) {
+    if (inflight[i].packetId != id) continue;
+    st.latencyMs.record(millis() - inflight[i].sentMs);
+    memmove(&inflight[i], &inflight[i + 1], (inflightCount - i - 1) * sizeof(Inflight));
+    inflightCount--;
+    return;
+  }
+}
+
+bool MqttClient::publish(const char *topic, BodyWriter body, const void *ctx, uint8_t qos, bool retain) {
+  if (!session) {
+    strlcpy(error, "Not connected", sizeof(error));
+    return false;
+  }
+  qos = qos ? 1 : 0;
+  if (qos && inflightCount == MQTT_INFLIGHT && !awaitAcks()) return false;
+
+  JsonOut count(NULL, 0);
+  body(count, ctx);
+  uint16_t id = qos ? nextPacketId() : 0;
+
+  JsonOut out(tx, sizeof(tx), drain, this);
+  mqttPublishHead(out, topic, count.total(), qos, retain, id);
+  body(out, ctx);
+  if (!out.finish()) return fail("Write failed");
+  st.published++;
+  if (qos) track(id);
+  return true;
+}
+
+bool MqttClient::subscribe(const char *const *filters, uint8_t n, uint8_t qos) {
+  if (!session) {
+    strlcpy(error, "Not connected", sizeof(error));
+    return false;
+  }
+  if (inflightCount == MQTT_INFLIGHT && !awaitAcks()) return false;
+
+  uint16_t id = nextPacketId();
+  JsonOut out(tx, sizeof(tx), drain, this);
+  mqttSubscribe(out, id, filters, n, qos ? 1 : 0);
+  if (!out.finish()) return fail("Write failed");
+  track(id);
+  return true;
+}
+
+bool MqttClient::sendPing() {
+  JsonOut out(tx, sizeof(tx), drain, this);
+  mqttPingreq(out);
+  if (!out.finish()) return fail("Write failed");
+  pingOut    = true;
+  pingSentMs = millis();
+  return true;
+}
+
+bool MqttClient::awaitAcks() {
+  while (session && inflightCount) {
+    if (!readPacket()) return fail("No ack");
+    handlePacket();
+  }
+  return session;
+}
+
+bool MqttClient::roundTrip() {
+  if (!session || (!pingOut && !sendPing())) return false;
+  while (session && pingOut) {
+    if (!readPacket()) return fail("No PINGRESP");
+    handlePacket();
+  }
+  return session;
+}
+
+bool MqttClient::service() {
+  if (!session) return false;
+  // A few packets per call: a burst of pushes can't hold up the caller
+  for (uint8_t i = 0; i < 8 && tls.readable(); i++) {
+    if (!readPacket()) return fail("Connection lost");
+    handlePacket();
+  }
+
+  // QoS 0 traffic gets no answers, so silence is normal: ping to find out
+  // whether the broker is still there
+  unsigned long now = millis();
+  if (pingOut) {
+    if (now - pingSentMs > MQTT_TIMEOUT_MS) return fail("No PINGRESP");
+  } else if (now - lastRxMs > MQTT_KEEPALIVE_S * 500UL) {
+    return sendPing();
+  }
+  return session;
+}
+
+// Fixed header, Remaining Length, then the body. Whatever doesn't fit the
+// buffer is read and dropped (rxTruncated).
+bool MqttClient::readPacket() {
+  uint8_t  b;
+  uint32_t len = 0;
+  uint8_t  lenBytes = 0;
+  int      r;
+  if (tls.read(&rxHeader, 1) != 1) return false;
+  do {
+    if (tls.read(&b, 1) != 1) return false;
+    r = mqttLengthByte(b, len, lenBytes);
+  } while (r == 0);
+  if (r < 0) return false;
+
+  uint8_t scrap[32];
+  size_t  got = 0;
+  rxLen = 0;
+  while (got < len) {
+    size_t   room = sizeof(rx) - rxLen;
+    size_t   want = min((size_t)(len - got), room ? room : sizeof(scrap));
+    uint8_t *dst  = room ? rx + rxLen : scrap;
+    size_t   k = tls.read(dst, want);
+    if (k == 0) return false;
+    if (room) rxLen += k;
+    got += k;
+  }
+  rxTruncated = rxLen < len;
+  st.rxBytes += 1 + lenBytes + len;
+  lastRxMs = millis();
+  return true;
+}
+
+void MqttClient::handlePacket() {
+  uint8_t type = MQTT_TYPE(rxHeader);
+  MqttAck ack;
+  if (mqttParseAck(rxHeader, rx, rxLen, ack)) {
+    if (ack.type == MQTT_PINGRESP) {
+      if (pingOut) st.latencyMs.record(millis() - pingSentMs);
+      pingOut = false;
+    } else {
+      if (ack.type == MQTT_PUBACK) st.acked++;
+      acked(ack.packetId);
+      if (ack.refused) {   // SUBACK return code 0x80
+        st.failures += ack.refused;
+        strlcpy(error, "Subscription refused", sizeof(error));
+      }
+    }
+  } else if (type == MQTT_PUBLISH) {
+    MqttPublish msg;
+    if (!mqttParsePublish(rxHeader, rx, rxLen, msg)) return;
+    st.received++;
+    if (msg.qos) {
+      JsonOut out(tx, sizeof(tx), drain, this);
+      mqttPuback(out, msg.packetId);
+      if (!out.finish()) fail("Write failed");
+    }
+    if (rxTruncated) {
+      st.failures++;
+      strlcpy(error, "Message too large", sizeof(error));
+    } else if (handler) {
+      handler(handlerCtx, msg.topic, msg.topicLen, msg.payload, msg.length);
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#include "mqtt_packet.h"
+#include <string.h>
+
+static void putLength(JsonOut &out, size_t len) {
+  do {
+    uint8_t b = len & 0x7F;
+    len >>= 7;
+    out.put((char)(len ? b | 0x80 : b));
+  } while (len);
+}
+
+static void putU16(JsonOut &out, uint16_t v) {
+  out.put((char)(v >> 8));
+  out.put((char)(v & 0xFF));
+}
+
+// UTF-8 string: 2-byte length, then the bytes
+static void putString(JsonOut &out, const char *s, size_t len) {
+  putU16(out, (uint16_t)len);
+  out.put(s, len);
+}
+
+void mqttConnect(JsonOut &out, const char *clientId, const char *user, const char *password,
+                 uint16_t keepAliveS) {
+  size_t idLen   = strlen(clientId);
+  size_t userLen = user ? strlen(user) : 0;
+  size_t passLen = password ? strlen(password) : 0;
+  uint8_t flags  = 0x02;                  // Clean session
+  size_t  len    = 10 + 2 + idLen;        // "MQTT", level, flags, keep-alive + client id
+  if (userLen) {
+    flags |= 0x80;
+    len   += 2 + userLen;
+    if (passLen) {
+      flags |= 0x40;
+      len   += 2 + passLen;
+    }
+  }
+
+  out.put((char)(MQTT_CONNECT << 4));
+  putLength(out, len);
+  putString(out, "MQTT", 4);
+  out.put((char)4);                       // Protocol level 3.1.1
+  out.put((char)flags);
+  putU16(out, keepAliveS);
+  putString(out, clientId, idLen);
+  if (flags & 0x80) putString(out, user, userLen);
+  if (flags & 0x40) putString(out, password, passLen);
+}
+
+void mqttPublishHead(JsonOut &out, const char *topic, size_t payloadLen, uint8_t qos, bool retain,
+                     uint16_t packetId) {
+  size_t topicLen = strlen(topic);
+  out.put((char)((MQTT_PUBLISH << 4) | (qos ? 0x02 : 0) | (retain ? 0x01 : 0)));
+  putLength(out, 2 + topicLen + (qos ? 2 : 0) + payloadLen);
+  putString(out, topic, topicLen);
+  if (qos) putU16(out, packetId);
+}
+
+void mqttSubscribe(JsonOut &out, uint16_t packetId, const char *const *filters, uint8_t n, uint8_t qos) {
+  size_t len = 2;
+  for (uint8_t i = 0; i < n; i++) len += 2 + strlen(filters[i]) + 1;
+  out.put((char)((MQTT_SUBSCRIBE << 4) | 0x02));   // Reserved flags are 0010
+  putLength(out, len);
+  putU16(out, packetId);
+  for (uint8_t i = 0; i < n; i++) {
+    putString(out, filters[i], strlen(filters[i]));
+    out.put((char)qos);
+  }
+}
+
+void mqttPuback(JsonOut &out, uint16_t packetId) {
+  out.put((char)(MQTT_PUBACK << 4));
+  out.put((char)2);
+  putU16(out, packetId);
+}
+
+void mqttPingreq(JsonOut &out) {
+  out.put((char)(MQTT_PINGREQ << 4));
+  out.put((char)0);
+}
+
+void mqttDisconnect(JsonOut &out) {
+  out.put((char)(MQTT_DISCONNECT << 4));
+  out.put((char)0);
+}
+
+int mqttLengthByte(uint8_t byte, uint32_t &value, uint8_t &count) {
+  if (count == 4) return -1;
+  value |= (uint32_t)(byte & 0x7F) << (7 * count++);
+  return byte & 0x80 ? 0 : 1;
+}
+
+bool mqttParsePublish(uint8_t header, const uint8_t *body, size_t len, MqttPublish &out) {
+  if (len < 2) return false;
+  size_t topicLen = ((size_t)body[0] << 8) | body[1];
+  out.qos    = (header >> 1) & 0x03;
+  out.retain = header & 0x01;
+  size_t head = 2 + topicLen + (out.qos ? 2 : 0);
+  if (out.qos > 1 || head > len) return false;   // QoS 2 is never subscribed to
+
+  out.topic    = (const char *)body + 2;
+  out.topicLen = topicLen;
+  out.packetId = out.qos ? (uint16_t)((body[2 + topicLen] << 8) | body[3 + topicLen]) : 0;
+  out.payload  = body + head;
+  out.length   = len - head;
+  return true;
+}
+
+bool mqttParseAck(uint8_t header, const uint8_t *body, size_t len, MqttAck &out) {
+  out.type     = MQTT_TYPE(header);
+  out.packetId = len >= 2 ? (uint16_t)((body[0] << 8) | body[1]) : 0;
+  out.refused  = 0;
+  switch (out.type) {
+    case MQTT_PUBACK:
+      return header == MQTT_PUBACK << 4 && len == 2;
+    case MQTT_SUBACK:
+      if (header != MQTT_SUBACK << 4 || len < 3) return false;   // At least one return code
+      for (size_t i = 2; i < len; i++) {
+        if (body[i] & 0x80) out.refused++;
+      }
+      return true;
+    case MQTT_PINGRESP:
+      return header == MQTT_PINGRESP << 4 && len == 0;
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,55 @@
+#include "oled_frame.h"
+
+uint8_t frameDiff(const uint8_t *frame, const uint8_t *shown, DirtySpan spans[OLED_PAGES]) {
+  uint8_t dirtyPages = 0;
+
+  for (int p = 0; p < OLED_PAGES; p++) {
+    const uint8_t *a = frame + p * OLED_COLUMNS;
+    const uint8_t *b = shown + p * OLED_COLUMNS;
+    DirtySpan &span = spans[p];
+    span.first = 1;
+    span.last  = 0;
+
+    // Compare a word at a time to find the span quickly; most pages are clean
+    const uint32_t *wa = (const uint32_t *)a;
+    const uint32_t *wb = (const uint32_t *)b;
+    int w0 = 0, w1 = OLED_COLUMNS / 4 - 1;
+    while (w0 <= w1 && wa[w0] == wb[w0]) w0++;
+    if (w0 > w1) continue;
+    while (wa[w1] == wb[w1]) w1--;
+
+    // Narrow to exact columns inside the first/last differing words
+    int c0 = w0 * 4, c1 = w1 * 4 + 3;
+    while (a[c0] == b[c0]) c0++;
+    while (a[c1] == b[c1]) c1--;
+    span.first = c0;
+    span.last  = c1;
+    dirtyPages++;
+  }
+  return dirtyPages;
+}
+
+size_t FrameFlusher::flush(DisplayHal &screen) {
+  uint8_t  *frame = screen.framebuffer();
+  DirtySpan spans[OLED_PAGES];
+  frames++;
+
+  if (!valid) {
+    for (int p = 0; p < OLED_PAGES; p++) spans[p] = { 0, OLED_COLUMNS - 1 };
+  } else if (frameDiff(frame, shown, spans) == 0) {
+    cleanFrames++;
+    return 0;
+  }
+
+  size_t bytes = 0;
+  for (int p = 0; p < OLED_PAGES; p++) {
+    if (spans[p].first > spans[p].last) continue;
+    bytes += screen.writeRegion(p, spans[p].first, spans[p].last);
+    memcpy(shown + p * OLED_COLUMNS + spans[p].first,
+           frame + p * OLED_COLUMNS + spans[p].first,
+           spans[p].last - spans[p].first + 1);
+  }
+  valid = true;
+  i2cBytes += bytes;
+  return bytes;
+}
@@ -0,0 +1,219 @@
+#include "ota_delta.h"
+#include <string.h>
+
+static uint32_t getU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putU32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+bool deltaParseHeader(const uint8_t *buf, size_t len, DeltaHeader &out) {
+  if (len < DELTA_HEADER_SIZE || memcmp(buf, DELTA_MAGIC, 4) != 0) return false;
+  if (buf[4] != DELTA_VERSION || buf[5] != DELTA_WINDOW_BITS) return false;
+  out.oldSize  = getU32(buf + 8);
+  memcpy(out.oldId, buf + 12, DELTA_ID_LEN);
+  out.newSize  = getU32(buf + 44);
+  memcpy(out.newId, buf + 48, DELTA_ID_LEN);
+  out.bodySize = getU32(buf + 80);
+  return out.newSize > 0 && out.bodySize > 0;
+}
+
+void deltaWriteHeader(const DeltaHeader &h, uint8_t *buf) {
+  memset(buf, 0, DELTA_HEADER_SIZE);
+  memcpy(buf, DELTA_MAGIC, 4);
+  buf[4] = DELTA_VERSION;
+  buf[5] = DELTA_WINDOW_BITS;
+  putU32(buf + 8, h.oldSize);
+  memcpy(buf + 12, h.oldId, DELTA_ID_LEN);
+  putU32(buf + 44, h.newSize);
+  memcpy(buf + 48, h.newId, DELTA_ID_LEN);
+  putU32(buf + 80, h.bodySize);
+}
+
+size_t deltaSignature(const uint8_t *prefix, const uint8_t **sig) {
+  size_t len = prefix[DELTA_HEADER_SIZE] | (prefix[DELTA_HEADER_SIZE + 1] << 8);
+  *sig = prefix + DELTA_HEADER_SIZE + 2;
+  return len <= DELTA_SIG_MAX ? len : 0;
+}
+
+void deltaWriteSignature(const uint8_t *sig, size_t len, uint8_t *prefix) {
+  uint8_t *block = prefix + DELTA_HEADER_SIZE;
+  memset(block, 0, DELTA_SIG_SIZE);
+  if (len > DELTA_SIG_MAX) return;
+  block[0] = (uint8_t)len;
+  block[1] = (uint8_t)(len >> 8);
+  if (len) memcpy(block + 2, sig, len);
+}
+
+void DeltaPatcher::begin(const DeltaHeader &h, ReadOld readOld, WriteNew writeNew, void *ctx) {
+  hdr            = h;
+  this->readOld  = readOld;
+  this->writeNew = writeNew;
+  this->ctx      = ctx;
+  err      = "";
+  bits     = 0;
+  bitCount = 0;
+  received = 0;
+  unpacked = 0;
+  step     = ADD_LEN;
+  varValue = 0;
+  varShift = 0;
+  addLeft  = copyLeft = 0;
+  seek     = 0;
+  oldPos   = 0;
+  finished = false;
+  outLen   = 0;
+  total    = 0;
+  oldStart = oldLen = 0;
+  reads    = 0;
+}
+
+bool DeltaPatcher::fail(const char *reason) {
+  if (!*err) err = reason;
+  return false;
+}
+
+uint32_t DeltaPatcher::take(uint8_t n) {
+  uint32_t v = (uint32_t)(bits >> (64 - n));
+  bits     <<= n;
+  bitCount  -= n;
+  return v;
+}
+
+// Tokens are decoded whole: the longest one (a match with a 31-bit length)
+// is 44 bits, so until the last body byte is in, decoding waits for that
+// many. The accumulator never holds more than 51.
+#define DELTA_TOKEN_MAX_BITS (1 + DELTA_WINDOW_BITS + 31)
+
+bool DeltaPatcher::feed(const uint8_t *data, size_t len) {
+  if (*err) return false;
+  if (len > hdr.bodySize - received) return fail("Patch longer than its header says");
+  for (size_t i = 0; i < len; i++) {
+    bits     |= (uint64_t)data[i] << (56 - bitCount);
+    bitCount += 8;
+    received++;
+    bool last = received == hdr.bodySize;
+    while (bitCount >= (last ? 8 : DELTA_TOKEN_MAX_BITS)) {
+      if (!token()) return false;
+    }
+  }
+  // What's left after the last token is padding (under a byte, all zero)
+  if (received == hdr.bodySize && !finished) return fail("Patch ends before the image does");
+  return true;
+}
+
+bool DeltaPatcher::token() {
+  if (finished) {
+    // Only the final byte's zero padding may follow the last record
+    if (bits != 0) return fail("Data after the end of the image");
+    bitCount = 0;
+    return true;
+  }
+  if (take(1)) {
+    if (bitCount < 8) return fail("Truncated patch");
+    uint8_t b = (uint8_t)take(8);
+    window[unpacked++ % DELTA_WINDOW] = b;
+    return command(b);
+  }
+
+  if (bitCount < DELTA_WINDOW_BITS + 1) return fail("Truncated patch");
+  uint32_t dist  = take(DELTA_WINDOW_BITS) + 1;
+  uint8_t  zeros = bits ? (uint8_t)__builtin_clzll(bits) : 64;
+  if (zeros > 15) return fail("Corrupt patch (match length)");
+  if (bitCount < 2 * zeros + 1) return fail("Truncated patch");
+  bits     <<= zeros;   // The gamma prefix
+  bitCount  -= zeros;
+  uint32_t n = take(zeros + 1) + DELTA_MIN_MATCH - 1;
+  if (dist > unpacked || dist > DELTA_WINDOW) return fail("Corrupt patch (match distance)");
+
+  while (n--) {
+    uint8_t b = window[(unpacked - dist) % DELTA_WINDOW];
+    window[unpacked++ % DELTA_WINDOW] = b;
+    if (!command(b)) return false;
+  }
+  return true;
+}
+
+// One decompressed byte: part of a record header, a difference or a new byte
+bool DeltaPatcher::command(uint8_t b) {
+  if (finished) return fail("Data after the end of the image");
+  uint8_t o;
+  switch (step) {
+    case ADD:
+      if (!oldByte(oldPos++, o) || !put((uint8_t)(o + b))) return false;
+      if (--addLeft) return true;
+      if (copyLeft) {
+        step = COPY;
+        return true;
+      }
+      return endRecord();
+
+    case COPY:
+      if (!put(b)) return false;
+      return --copyLeft ? true : endRecord();
+
+    default:
+      if (varShift > 28) return fail("Corrupt patch (varint)");
+      varValue |= (uint32_t)(b & 0x7F) << varShift;
+      varShift += 7;
+      if (b & 0x80) return true;
+      uint32_t v = varValue;
+      varValue = 0;
+      varShift = 0;
+      if (step == ADD_LEN) {
+        addLeft = v;
+        step    = COPY_LEN;
+        return true;
+      }
+      if (step == COPY_LEN) {
+        copyLeft = v;
+        step     = SEEK;
+        return true;
+      }
+      seek = (v & 1) ? -(int64_t)(v >> 1) - 1 : (int64_t)(v >> 1);
+      if ((uint64_t)addLeft + copyLeft > hdr.newSize - total - outLen) return fail("Patch writes past the image");
+      if ((uint64_t)oldPos + addLeft > hdr.oldSize) return fail("Patch reads past the base image");
+      step = addLeft ? ADD : copyLeft ? COPY : ADD_LEN;
+      return step == ADD_LEN ? endRecord() : true;
+  }
+}
+
+bool DeltaPatcher::endRecord() {
+  int64_t pos = (int64_t)oldPos + seek;
+  if (pos < 0 || pos > (int64_t)hdr.oldSize) return fail("Patch seeks outside the base image");
+  oldPos = (uint32_t)pos;
+  step   = ADD_LEN;
+  if (total + outLen < hdr.newSize) return true;
+  finished = true;
+  return flush();
+}
+
+bool DeltaPatcher::put(uint8_t b) {
+  out[outLen++] = b;
+  return outLen < sizeof(out) || flush();
+}
+
+bool DeltaPatcher::flush() {
+  if (!outLen) return true;
+  if (!writeNew(ctx, out, outLen)) return fail("Write failed");
+  total += outLen;
+  outLen = 0;
+  return true;
+}
+
+// Differences walk the old image forward, so one read serves many bytes
+bool DeltaPatcher::oldByte(uint32_t pos, uint8_t &b) {
+  if (pos - oldStart >= oldLen) {
+    oldStart = pos;
+    oldLen   = hdr.oldSize - pos < sizeof(oldBuf) ? hdr.oldSize - pos : sizeof(oldBuf);
+    reads++;
+    if (!readOld(ctx, oldStart, oldBuf, oldLen)) {
+      oldLen = 0;
+      return fail("Base image read failed");
+    }
+  }
+  b = oldBuf[pos - oldStart];
+  return true;
+}
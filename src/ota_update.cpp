@@ -0,0 +1,290 @@
+#include "ota_update.h"
+#include <Preferences.h>
+#include <mbedtls/md.h>
+
+void OtaUpdater::begin(const char *serverUrl, const char *signingKey) {
+  // "http://host[:port]" -> "host", port
+  const char *p = strstr(serverUrl, "://");
+  p = p ? p + 3 : serverUrl;
+  size_t n = strcspn(p, ":/");
+  if (n >= sizeof(host)) n = sizeof(host) - 1;
+  memcpy(host, p, n);
+  host[n] = '\0';
+  port = p[n] == ':' ? (uint16_t)atoi(p + n + 1) : 80;
+
+  mbedtls_pk_init(&releaseKey);
+  haveKey = signingKey &&
+            mbedtls_pk_parse_public_key(&releaseKey, (const unsigned char *)signingKey, strlen(signingKey) + 1) == 0 &&
+            mbedtls_pk_can_do(&releaseKey, MBEDTLS_PK_ECDSA);
+
+  running = esp_ota_get_running_partition();
+  esp_ota_img_states_t state;
+  bootloaderTrial = running && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                    state == ESP_OTA_IMG_PENDING_VERIFY;
+  pending = startTrialBoot() || bootloaderTrial;
+}
+
+// Software probation. install() left the slot on trial in NVS; each boot
+// of it counts until confirm(). A record for another slot means the switch
+// never happened (or the bootloader went back), and a bootloader with
+// rollback support keeps the probation itself: the record is dropped.
+bool OtaUpdater::startTrialBoot() {
+  Preferences prefs;
+  prefs.begin(OTA_NVS_NAMESPACE, false);
+  char trial[sizeof(previousSlot)] = "";
+  prefs.getString("trial", trial, sizeof(trial));
+  if (!trial[0]) {
+    prefs.end();
+    return false;
+  }
+  if (bootloaderTrial || !running || strcmp(trial, running->label) != 0) {
+    prefs.clear();
+    prefs.end();
+    return false;
+  }
+  uint8_t boots = prefs.getUChar("boots", 0) + 1;
+  prefs.putUChar("boots", boots);
+  prefs.getString("prev", previousSlot, sizeof(previousSlot));
+  prefs.end();
+
+  if (boots > OTA_TRIAL_BOOTS) {
+    pending = true;   // rollback() only acts on probation
+    rollback();       // Returns only when there is no previous image
+    strlcpy(error, "No previous image to go back to", sizeof(error));
+    endTrial();
+    return false;
+  }
+  return true;
+}
+
+void OtaUpdater::endTrial() {
+  Preferences prefs;
+  prefs.begin(OTA_NVS_NAMESPACE, false);
+  prefs.clear();
+  prefs.end();
+}
+
+void OtaUpdater::confirm() {
+  if (!pending) return;
+  if (bootloaderTrial) esp_ota_mark_app_valid_cancel_rollback();
+  else                 endTrial();
+  pending = false;
+}
+
+bool OtaUpdater::rollback() {
+  if (bootloaderTrial) {
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+    return false;   // Only comes back if no other slot holds a valid image
+  }
+  // esp_ota_set_boot_partition() checks the image in the slot first
+  const esp_partition_t *previous =
+    esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, previousSlot);
+  if (!pending || !previous || previous == running || esp_ota_set_boot_partition(previous) != ESP_OK) return false;
+  endTrial();
+  esp_restart();
+  return true;
+}
+
+// Only the time between two reachable calls counts
+bool OtaUpdater::probationExpired(bool online, uint32_t limitMs) {
+  unsigned long now = millis();
+  if (online && wasOnline) onlineMs += now - lastProbationMs;
+  wasOnline       = online;
+  lastProbationMs = now;
+  return pending && onlineMs >= limitMs;
+}
+
+OtaResult OtaUpdater::fail(const char *reason) {
+  strlcpy(error, reason, sizeof(error));
+  st.failures++;
+  if (handle) {
+    esp_ota_abort(handle);
+    handle = 0;
+  }
+  unmapRunning();
+  http.stop();
+  return OTA_FAILED;
+}
+
+OtaResult OtaUpdater::check() {
+  st.checks++;
+  error[0] = '\0';
+  if (!running) return fail("No running partition");
+  if (!haveKey) return fail("No signing key");
+  // Reads and checks the whole image: once per boot
+  if (!haveId && esp_partition_get_sha256(running, runningId) != ESP_OK) return fail("Can't read the running image id");
+  haveId = true;
+
+  char idHex[2 * DELTA_ID_LEN + 1];
+  for (int i = 0; i < DELTA_ID_LEN; i++) snprintf(idHex + 2 * i, 3, "%02x", runningId[i]);
+
+  int         status = 0;
+  uint32_t    length = 0;
+  const char *why    = request(idHex, status, length);
+  if (why) return fail(why);
+  if (status == 204) {
+    http.stop();
+    return OTA_UP_TO_DATE;
+  }
+  if (status != 200) {
+    char reason[24];
+    snprintf(reason, sizeof(reason), "Server answered %d", status);
+    return fail(reason);
+  }
+  return install(length);
+}
+
+const char *OtaUpdater::request(const char *idHex, int &status, uint32_t &length) {
+  if (!http.connect(host, port)) return "Can't reach the update server";
+  char req[192];
+  int  n = snprintf(req, sizeof(req), "GET /ota/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", idHex, host);
+  if (http.write((const uint8_t *)req, n) != (size_t)n) return "Write failed";
+
+  char line[96];
+  if (!readLine(line, sizeof(line)) || sscanf(line, "HTTP/1.%*d %d", &status) != 1) return "No answer";
+  for (;;) {
+    if (!readLine(line, sizeof(line))) return "Headers cut off";
+    if (!line[0]) return NULL;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) length = strtoul(line + 15, NULL, 10);
+  }
+}
+
+// One header line without its CRLF; longer lines are cut to max - 1
+bool OtaUpdater::readLine(char *out, size_t max) {
+  size_t  n = 0;
+  uint8_t c;
+  for (;;) {
+    if (!readFully(&c, 1)) return false;
+    if (c == '\n') break;
+    if (c != '\r' && n < max - 1) out[n++] = (char)c;
+  }
+  out[n] = '\0';
+  return true;
+}
+
+// Blocks until len bytes; gives up after OTA_HTTP_TIMEOUT_MS without progress
+bool OtaUpdater::readFully(uint8_t *buf, size_t len) {
+  size_t        got  = 0;
+  unsigned long last = millis();
+  while (got < len) {
+    int n = http.read(buf + got, len - got);
+    if (n > 0) {
+      got += n;
+      last = millis();
+      continue;
+    }
+    if (!http.connected() || millis() - last > OTA_HTTP_TIMEOUT_MS) return false;
+    delay(5);
+  }
+  return true;
+}
+
+// The signature block holds an ECDSA signature of the header's SHA-256
+bool OtaUpdater::signedByRelease(const uint8_t *prefix) {
+  const uint8_t *sig;
+  size_t         len = deltaSignature(prefix, &sig);
+  uint8_t        hash[32];
+  return len && mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), prefix, DELTA_HEADER_SIZE, hash) == 0 &&
+         mbedtls_pk_verify(&releaseKey, MBEDTLS_MD_SHA256, hash, sizeof(hash), sig, len) == 0;
+}
+
+OtaResult OtaUpdater::install(uint32_t length) {
+  uint8_t     head[DELTA_PREFIX_SIZE];
+  DeltaHeader h;
+  if (length < DELTA_PREFIX_SIZE || !readFully(head, sizeof(head)) || !deltaParseHeader(head, sizeof(head), h)) {
+    return fail("Not a patch");
+  }
+  if (!signedByRelease(head)) return fail("Patch not signed by the release key");
+  if (length != DELTA_PREFIX_SIZE + h.bodySize) return fail("Patch size mismatch");
+  if (memcmp(h.newId, runningId, DELTA_ID_LEN) == 0) {
+    http.stop();
+    return OTA_UP_TO_DATE;
+  }
+  if (h.oldSize && (memcmp(h.oldId, runningId, DELTA_ID_LEN) != 0 || h.oldSize > running->size)) {
+    return fail("Patch is for another image");
+  }
+  target = esp_ota_get_next_update_partition(NULL);
+  if (!target || h.newSize > target->size) return fail("Image too large for the OTA slot");
+
+  unsigned long t0 = millis();
+  if (h.oldSize) mapRunning(h.oldSize);
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+  size_t erase = OTA_WITH_SEQUENTIAL_WRITES;   // One sector at a time, just before it's written
+#else
+  size_t erase = h.newSize;
+#endif
+  if (esp_ota_begin(target, erase, &handle) != ESP_OK) {
+    handle = 0;
+    return fail("Can't open the OTA slot");
+  }
+
+  uint8_t  buf[OTA_NET_CHUNK];
+  uint32_t left = h.bodySize;
+  patcher.begin(h, readOld, writeNew, this);
+  while (left) {
+    size_t n = min((size_t)left, sizeof(buf));
+    if (!readFully(buf, n)) return fail("Download interrupted");
+    if (!patcher.feed(buf, n)) return fail(patcher.error());
+    left -= n;
+  }
+  http.stop();
+  unmapRunning();
+  if (!patcher.done()) return fail("Patch incomplete");
+
+  // esp_ota_end() checks the image (segments, checksum, appended SHA-256)
+  esp_err_t err = esp_ota_end(handle);
+  handle = 0;
+  if (err != ESP_OK) return fail("New image failed verification");
+  uint8_t id[DELTA_ID_LEN];
+  if (esp_partition_get_sha256(target, id) != ESP_OK || memcmp(id, h.newId, DELTA_ID_LEN) != 0) {
+    return fail("New image id mismatch");
+  }
+  // Recorded before the switch: a record for a slot that never booted is
+  // dropped by begin(), while a switch without one would skip probation
+  Preferences prefs;
+  prefs.begin(OTA_NVS_NAMESPACE, false);
+  prefs.putString("trial", target->label);
+  prefs.putString("prev", running->label);
+  prefs.putUChar("boots", 0);
+  prefs.end();
+  if (esp_ota_set_boot_partition(target) != ESP_OK) {
+    endTrial();
+    return fail("Can't switch the boot slot");
+  }
+
+  st.updates++;
+  st.patchBytes = length;
+  st.imageBytes = h.newSize;
+  st.updateMs   = millis() - t0;
+  st.delta      = h.oldSize != 0;
+  return OTA_READY;
+}
+
+// Reading the old image through the cache (no SPI flash calls per read);
+// esp_partition_read() if the MMU has no room for the mapping
+bool OtaUpdater::mapRunning(uint32_t size) {
+  const void *ptr = NULL;
+  if (esp_partition_mmap(running, 0, size, SPI_FLASH_MMAP_DATA, &ptr, &mapHandle) != ESP_OK) return false;
+  oldMap = (const uint8_t *)ptr;
+  return true;
+}
+
+void OtaUpdater::unmapRunning() {
+  if (!oldMap) return;
+  spi_flash_munmap(mapHandle);
+  oldMap = NULL;
+}
+
+bool OtaUpdater::readOld(void *ctx, uint32_t offset, uint8_t *buf, size_t len) {
+  OtaUpdater &u = *(OtaUpdater *)ctx;
+  if (u.oldMap) {
+    memcpy(buf, u.oldMap + offset, len);
+    return true;
+  }
+  return esp_partition_read(u.running, offset, buf, len) == ESP_OK;
+}
+
+bool OtaUpdater::writeNew(void *ctx, const uint8_t *data, size_t len) {
+  OtaUpdater &u = *(OtaUpdater *)ctx;
+  return esp_ota_write(u.handle, data, len) == ESP_OK;
+}
@@ -0,0 +1,439 @@
+#include "pipeline_steps.h"
+#include "bitmaps.h"
+#include "gaia_config.h"
+#include "oled_frame.h"
+#include "stage_profiler.h"
+
+// Adafruit_SSD1306.h's value; only Adafruit_GFX is needed to draw
+#ifndef SSD1306_WHITE
+#define SSD1306_WHITE 1
+#endif
+
+// ================= SENSOR TASK =================
+bool airValid(const Telemetry &t) {
+  return !isnan(t.temperature) && !isnan(t.humidity);
+}
+
+uint8_t readDueSensors(SensorHal &sensors, SensorScheduler &sched, const PlantRack &rack,
+                       uint8_t plants, unsigned long nowMs, RackSample &sample, uint8_t *fresh) {
+  uint8_t airFailed = 0;
+  sample.count = plants;
+  for (uint8_t p = 0; p < plants; p++) {
+    Telemetry &t = sample.plant[p];
+    if (sched.due(p, SENSE_AIR, nowMs)) {
+      PROFILE_STAGE(STAGE_READ_AIR);
+      float temperature = sensors.readTemperature(p);
+      float humidity    = sensors.readHumidity(p);
+      sched.store(p, FIELD_TEMPERATURE, temperature, sensors.airReadingMs(p));
+      sched.store(p, FIELD_HUMIDITY, humidity, sensors.airReadingMs(p));
+      sched.reschedule(p, SENSE_AIR, rack, nowMs);
+    }
+    if (sched.due(p, SENSE_SOIL, nowMs)) {
+      PROFILE_STAGE(STAGE_READ_SOIL);
+      sched.store(p, FIELD_SOIL_RAW, sensors.readMoistureRaw(p), nowMs);
+      // Calibrated percentage (DMA-filtered, eFuse mV, NVS dry/wet points)
+      sched.store(p, FIELD_SOIL_MOISTURE, sensors.readMoisturePercent(p), nowMs);
+      sched.reschedule(p, SENSE_SOIL, rack, nowMs);
+    }
+    if (sched.due(p, SENSE_LIGHT, nowMs)) {
+      PROFILE_STAGE(STAGE_READ_LIGHT);
+      float lux = sensors.readLux(p);
+      sched.store(p, FIELD_LIGHT, lux >= 0 ? lux : NAN, nowMs);
+      sched.reschedule(p, SENSE_LIGHT, rack, nowMs);
+    }
+    fresh[p]    = sched.fill(p, t, nowMs);
+    t.timestamp = nowMs;
+    if (!airValid(t)) airFailed++;
+  }
+  return airFailed;
+}
+
+size_t foldIntoWindows(WindowAggregator *aggregators, const RackSample &sample, const uint8_t *fresh,
+                       uint32_t boot, WindowSummary *closed) {
+  PROFILE_STAGE(STAGE_AGGREGATE);
+  size_t n = 0;
+  for (uint8_t p = 0; p < sample.count; p++) {
+    aggregators[p].add(sample.plant[p], sample.plant[p].timestamp, fresh[p]);
+    for (uint8_t w = 0; w < AGG_WINDOWS; w++) {
+      WindowSummary &s = closed[n];
+      if (!aggregators[p].takeClosed((AggWindow)w, s)) continue;
+      s.plant = p;
+      s.boot  = boot;
+      n++;
+    }
+  }
+  return n;
+}
+
+// Rules on a NAN field keep their state, so the face works without the DHT22
+uint32_t classifyRack(PlantRack &rack, FaceClassifier &classifier, const RackSample &sample,
+                      unsigned long nowMs) {
+  rackSetReadings(rack, sample);
+  PROFILE_STAGE(STAGE_FACE_RULES);
+  return classifier.evaluate(rack, nowMs);
+}
+
+// ================= STATUS BAR =================
+void layoutStatusLabel(StatusLabel &label, uint8_t plant, uint8_t plants, const char *plantId,
+                       const PlantThresholds &thresholds) {
+  const char *name  = thresholds.speciesName;
+  bool        known = name[0] != '\0' && strcmp(name, "Unknown") != 0;
+
+  char full[SPECIES_NAME_MAX + 4];
+  if (plants > 1) snprintf(full, sizeof(full), "%u:%s", plant + 1, known ? name : plantId);
+  else            strlcpy(full, known ? name : "", sizeof(full));
+
+  // Truncate long names to fit between icons
+  strlcpy(label.text, full, sizeof(label.text));
+  if (strlen(full) > STATUS_LABEL_CHARS) label.text[STATUS_LABEL_CHARS - 1] = '.';
+
+  // What getTextBounds() gives for the built-in font, without touching the
+  // canvas (the animation task owns it)
+  label.x = (OLED_COLUMNS - STATUS_CHAR_WIDTH * (int16_t)strlen(label.text)) / 2;
+}
+
+void drawStatusBar(Adafruit_GFX &gfx, int batteryPercent, const StatusLabel &label, bool online) {
+  // 1. Divider Line
+  gfx.drawLine(0, 10, 127, 10, SSD1306_WHITE);
+
+  // 2. WiFi Icon (Left)
+  if (online) {
+    gfx.drawBitmap(0, 0, wifi_connected_bits, ICON_WIDTH, ICON_HEIGHT, SSD1306_WHITE);
+  } else {
+    gfx.drawBitmap(0, 0, wifi_disconnected_bits, ICON_WIDTH, ICON_HEIGHT, SSD1306_WHITE);
+  }
+
+  // 3. Species Name (Center), laid out by layoutStatusLabel()
+  if (label.text[0]) {
+    gfx.setTextSize(1);
+    gfx.setTextColor(SSD1306_WHITE);
+    gfx.setCursor(label.x, 1);
+    gfx.print(label.text);
+  }
+
+  // 4. Battery Icon (Right)
+  // Battery Outline: 110, 1 -> 16x8
+  gfx.drawRect(110, 1, 16, 8, SSD1306_WHITE); 
+  // Positive Terminal (Bump)
+  gfx.drawLine(126, 3, 126, 6, SSD1306_WHITE);
+  
+  // Fill Bar
+  if (batteryPercent > 0) {
+    int barWidth = map(constrain(batteryPercent, 0, 100), 0, 100, 0, 12);
+    gfx.fillRect(112, 3, barWidth, 4, SSD1306_WHITE);
+  }
+}
+
+// ================= FACE DRAWING (Primitives) =================
+// Runs once per face at boot to fill the face cache (face_cache.h).
+// Draws faces using Adafruit_GFX shapes - no bitmaps needed!
+// Face area: y=12..63 (52px tall), x=0..127 (128px wide)
+// Eye line Y≈28, Mouth Y≈50, Left eye X=44, Right eye X=84
+void drawFace(Adafruit_GFX &gfx, int faceType) {
+  switch (faceType) {
+
+    case FACE_HAPPY: {
+      // Big round filled eyes
+      gfx.fillCircle(44, 28, 6, SSD1306_WHITE);
+      gfx.fillCircle(84, 28, 6, SSD1306_WHITE);
+      // U-shaped smile
+      gfx.drawLine(38, 48, 44, 54, SSD1306_WHITE);
+      gfx.drawLine(44, 54, 84, 54, SSD1306_WHITE);
+      gfx.drawLine(84, 54, 90, 48, SSD1306_WHITE);
+      gfx.drawLine(38, 49, 44, 55, SSD1306_WHITE);
+      gfx.drawLine(44, 55, 84, 55, SSD1306_WHITE);
+      gfx.drawLine(84, 55, 90, 49, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_THIRSTY: {
+      // X_X dead eyes (crossed lines, thick)
+      // Left X
+      gfx.drawLine(36, 20, 52, 36, SSD1306_WHITE);
+      gfx.drawLine(52, 20, 36, 36, SSD1306_WHITE);
+      gfx.drawLine(37, 20, 53, 36, SSD1306_WHITE);
+      gfx.drawLine(53, 20, 37, 36, SSD1306_WHITE);
+      gfx.drawLine(38, 20, 54, 36, SSD1306_WHITE);
+      gfx.drawLine(54, 20, 38, 36, SSD1306_WHITE);
+      // Right X
+      gfx.drawLine(76, 20, 92, 36, SSD1306_WHITE);
+      gfx.drawLine(92, 20, 76, 36, SSD1306_WHITE);
+      gfx.drawLine(77, 20, 93, 36, SSD1306_WHITE);
+      gfx.drawLine(93, 20, 77, 36, SSD1306_WHITE);
+      gfx.drawLine(78, 20, 94, 36, SSD1306_WHITE);
+      gfx.drawLine(94, 20, 78, 36, SSD1306_WHITE);
+      // Flat line mouth
+      gfx.fillRect(44, 50, 40, 3, SSD1306_WHITE);
+      // Teardrop falling from right eye
+      gfx.fillTriangle(104, 20, 101, 30, 107, 30, SSD1306_WHITE);
+      gfx.fillCircle(104, 32, 4, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_OVERWATERED: {
+      // @_@ dizzy spiral eyes (concentric circles + center dot)
+      gfx.drawCircle(44, 28, 10, SSD1306_WHITE);
+      gfx.drawCircle(44, 28, 6, SSD1306_WHITE);
+      gfx.fillCircle(44, 28, 2, SSD1306_WHITE);
+      gfx.drawCircle(84, 28, 10, SSD1306_WHITE);
+      gfx.drawCircle(84, 28, 6, SSD1306_WHITE);
+      gfx.fillCircle(84, 28, 2, SSD1306_WHITE);
+      // Wavy/queasy mouth (zigzag sine)
+      gfx.drawLine(36, 50, 44, 46, SSD1306_WHITE);
+      gfx.drawLine(44, 46, 52, 54, SSD1306_WHITE);
+      gfx.drawLine(52, 54, 60, 46, SSD1306_WHITE);
+      gfx.drawLine(60, 46, 68, 54, SSD1306_WHITE);
+      gfx.drawLine(68, 54, 76, 46, SSD1306_WHITE);
+      gfx.drawLine(76, 46, 84, 50, SSD1306_WHITE);
+      // Sweat drops on sides
+      gfx.fillCircle(20, 35, 2, SSD1306_WHITE);
+      gfx.fillCircle(108, 35, 2, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_HOT: {
+      // >_< angry - V-shaped eyebrows slanting inward
+      gfx.drawLine(30, 17, 56, 23, SSD1306_WHITE);
+      gfx.drawLine(30, 18, 56, 24, SSD1306_WHITE);
+      gfx.drawLine(30, 19, 56, 25, SSD1306_WHITE);
+      gfx.drawLine(98, 17, 72, 23, SSD1306_WHITE);
+      gfx.drawLine(98, 18, 72, 24, SSD1306_WHITE);
+      gfx.drawLine(98, 19, 72, 25, SSD1306_WHITE);
+      // Small angry dot eyes under brows
+      gfx.fillCircle(44, 31, 4, SSD1306_WHITE);
+      gfx.fillCircle(84, 31, 4, SSD1306_WHITE);
+      // Angry frown (inverted U)
+      gfx.drawLine(40, 56, 48, 48, SSD1306_WHITE);
+      gfx.drawLine(48, 48, 80, 48, SSD1306_WHITE);
+      gfx.drawLine(80, 48, 88, 56, SSD1306_WHITE);
+      gfx.drawLine(40, 57, 48, 49, SSD1306_WHITE);
+      gfx.drawLine(48, 49, 80, 49, SSD1306_WHITE);
+      gfx.drawLine(80, 49, 88, 57, SSD1306_WHITE);
+      // Heat waves above
+      gfx.drawLine(20, 14, 24, 12, SSD1306_WHITE);
+      gfx.drawLine(24, 12, 28, 14, SSD1306_WHITE);
+      gfx.drawLine(100, 14, 104, 12, SSD1306_WHITE);
+      gfx.drawLine(104, 12, 108, 14, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_COLD: {
+      // O_O wide shocked eyes with pupils
+      gfx.drawCircle(44, 28, 10, SSD1306_WHITE);
+      gfx.drawCircle(44, 28, 11, SSD1306_WHITE);
+      gfx.fillCircle(44, 28, 4, SSD1306_WHITE);
+      gfx.drawCircle(84, 28, 10, SSD1306_WHITE);
+      gfx.drawCircle(84, 28, 11, SSD1306_WHITE);
+      gfx.fillCircle(84, 28, 4, SSD1306_WHITE);
+      // Zigzag chattering teeth mouth
+      gfx.drawLine(38, 50, 46, 44, SSD1306_WHITE);
+      gfx.drawLine(46, 44, 54, 50, SSD1306_WHITE);
+      gfx.drawLine(54, 50, 62, 44, SSD1306_WHITE);
+      gfx.drawLine(62, 44, 70, 50, SSD1306_WHITE);
+      gfx.drawLine(70, 50, 78, 44, SSD1306_WHITE);
+      gfx.drawLine(78, 44, 86, 50, SSD1306_WHITE);
+      gfx.drawLine(38, 51, 46, 45, SSD1306_WHITE);
+      gfx.drawLine(46, 45, 54, 51, SSD1306_WHITE);
+      gfx.drawLine(54, 51, 62, 45, SSD1306_WHITE);
+      gfx.drawLine(62, 45, 70, 51, SSD1306_WHITE);
+      gfx.drawLine(70, 51, 78, 45, SSD1306_WHITE);
+      gfx.drawLine(78, 45, 86, 51, SSD1306_WHITE);
+      // Shiver lines on sides
+      gfx.drawLine(8, 30, 16, 26, SSD1306_WHITE);
+      gfx.drawLine(16, 26, 8, 22, SSD1306_WHITE);
+      gfx.drawLine(120, 30, 112, 26, SSD1306_WHITE);
+      gfx.drawLine(112, 26, 120, 22, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_DARK: {
+      // -_- sleeping closed eyes (thick horizontal bars)
+      gfx.fillRect(34, 26, 20, 4, SSD1306_WHITE);
+      gfx.fillRect(74, 26, 20, 4, SSD1306_WHITE);
+      // Small peaceful mouth
+      gfx.fillRect(56, 50, 16, 2, SSD1306_WHITE);
+      // Zzz floating to the upper right
+      gfx.setTextSize(2);
+      gfx.setTextColor(SSD1306_WHITE);
+      gfx.setCursor(102, 13);
+      gfx.print("Z");
+      gfx.setTextSize(1);
+      gfx.setCursor(110, 16);
+      gfx.print("z");
+      gfx.setCursor(116, 22);
+      gfx.print("z");
+      break;
+    }
+
+    case FACE_BRIGHT: {
+      // Squinting ≡_≡ eyes (three lines per eye)
+      // Left eye
+      gfx.fillRect(34, 22, 20, 2, SSD1306_WHITE);
+      gfx.fillRect(34, 27, 20, 2, SSD1306_WHITE);
+      gfx.fillRect(34, 32, 20, 2, SSD1306_WHITE);
+      // Right eye
+      gfx.fillRect(74, 22, 20, 2, SSD1306_WHITE);
+      gfx.fillRect(74, 27, 20, 2, SSD1306_WHITE);
+      gfx.fillRect(74, 32, 20, 2, SSD1306_WHITE);
+      // Wide cheery smile
+      gfx.drawLine(34, 48, 40, 56, SSD1306_WHITE);
+      gfx.drawLine(40, 56, 88, 56, SSD1306_WHITE);
+      gfx.drawLine(88, 56, 94, 48, SSD1306_WHITE);
+      gfx.drawLine(34, 49, 40, 57, SSD1306_WHITE);
+      gfx.drawLine(40, 57, 88, 57, SSD1306_WHITE);
+      gfx.drawLine(88, 57, 94, 49, SSD1306_WHITE);
+      // Sun rays at top corners
+      gfx.drawLine(6, 14, 14, 14, SSD1306_WHITE);
+      gfx.drawLine(10, 12, 10, 16, SSD1306_WHITE);
+      gfx.drawLine(114, 14, 122, 14, SSD1306_WHITE);
+      gfx.drawLine(118, 12, 118, 16, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_HUMID: {
+      // Droopy half-closed eyes (heavy moisture)
+      gfx.fillRect(34, 28, 20, 4, SSD1306_WHITE);   // Left eye slit
+      gfx.drawLine(34, 28, 34, 22, SSD1306_WHITE);  // Left eyelid
+      gfx.drawLine(54, 28, 54, 22, SSD1306_WHITE);
+      gfx.drawLine(34, 22, 54, 22, SSD1306_WHITE);
+      gfx.fillRect(74, 28, 20, 4, SSD1306_WHITE);   // Right eye slit
+      gfx.drawLine(74, 28, 74, 22, SSD1306_WHITE);
+      gfx.drawLine(94, 28, 94, 22, SSD1306_WHITE);
+      gfx.drawLine(74, 22, 94, 22, SSD1306_WHITE);
+      // Flat uneasy mouth
+      gfx.fillRect(44, 50, 40, 3, SSD1306_WHITE);
+      // Droplets around face
+      gfx.fillCircle(18, 20, 2, SSD1306_WHITE);
+      gfx.fillCircle(110, 24, 2, SSD1306_WHITE);
+      gfx.fillCircle(24, 42, 2, SSD1306_WHITE);
+      gfx.fillCircle(104, 46, 2, SSD1306_WHITE);
+      break;
+    }
+
+    case FACE_DRY_AIR: {
+      // Squished/cracked eyes (parched)
+      gfx.drawCircle(44, 28, 8, SSD1306_WHITE);
+      gfx.drawCircle(84, 28, 8, SSD1306_WHITE);
+      gfx.fillCircle(44, 28, 3, SSD1306_WHITE);
+      gfx.fillCircle(84, 28, 3, SSD1306_WHITE);
+      // Small O-shaped mouth (gasping)
+      gfx.drawCircle(64, 52, 6, SSD1306_WHITE);
+      gfx.drawCircle(64, 52, 5, SSD1306_WHITE);
+      // Crack lines on cheeks
+      gfx.drawLine(18, 36, 28, 32, SSD1306_WHITE);
+      gfx.drawLine(28, 32, 22, 28, SSD1306_WHITE);
+      gfx.drawLine(100, 36, 110, 32, SSD1306_WHITE);
+      gfx.drawLine(110, 32, 104, 28, SSD1306_WHITE);
+      break;
+    }
+  }
+}
+
+// ================= SCENE =================
+void SceneSelector::configure(uint8_t plants, unsigned long plantPeriodMs) {
+  this->plants        = plants;
+  this->plantPeriodMs = plantPeriodMs;
+  shownPlant = 0;
+  dirty      = true;
+}
+
+bool SceneSelector::select(const FaceClassifier &classifier, const StatusLabel *labels, bool linkUp,
+                           int batteryPercent, unsigned long nowMs, ScreenScene &scene) {
+  // Racks cycle through their plants
+  if (plants > 1 && nowMs - shownSinceMs >= plantPeriodMs) {
+    shownPlant   = (shownPlant + 1) % plants;
+    shownSinceMs = nowMs;
+    dirty        = true;
+  }
+
+  if (!dirty && linkUp == lastLinkUp) {
+    skipped++;
+    return false;
+  }
+  dirty      = false;
+  lastLinkUp = linkUp;
+
+  scene.face           = classifier.face(shownPlant);
+  scene.label          = labels[shownPlant];
+  scene.online         = linkUp;
+  scene.batteryPercent = batteryPercent;
+  return true;
+}
+
+// A new scene: rasterize its status bar once, then the animator just lays
+// it over each frame
+void showScene(DisplayHal &screen, FaceAnimator &animator, const ScreenScene &scene, unsigned long nowMs) {
+  screen.clear();
+  drawStatusBar(screen.canvas(), scene.batteryPercent, scene.label, scene.online);
+  animator.setStatusBar(screen.framebuffer());
+  animator.setFace(scene.face, nowMs);
+}
+
+// ================= NETWORK TASK =================
+bool queueSummary(WindowSummary *pending, size_t &count, size_t capacity, const WindowSummary &s) {
+  bool kept = true;
+  if (count == capacity) {
+    size_t victim = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (pending[i].window == AGG_MINUTE) { victim = i; break; }
+    }
+    memmove(&pending[victim], &pending[victim + 1], (count - victim - 1) * sizeof(WindowSummary));
+    count--;
+    kept = false;
+  }
+  pending[count++] = s;
+  return kept;
+}
+
+bool uploadMinuteMeans(CloudHal &cloud, const WindowSummary *pending, size_t count, uint8_t plants) {
+  Telemetry live[MAX_PLANTS];
+  uint8_t   fields[MAX_PLANTS] = {0};
+  bool      any = false;
+  for (size_t i = 0; i < count; i++) {
+    const WindowSummary &s = pending[i];
+    if (s.window != AGG_MINUTE || s.plant >= plants) continue;
+    Telemetry &t = live[s.plant];
+    fields[s.plant] = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      if (!s.field[f].n) continue;
+      telemetrySetField(t, f, s.field[f].mean);
+      fields[s.plant] |= FIELD_BIT(f);
+    }
+    t.timestamp = s.startMs + s.lengthMs;
+    any |= fields[s.plant] != 0;
+  }
+  return !any || cloud.uploadTelemetry(live, fields, plants);
+}
+
+bool uploadWindows(CloudHal &cloud, const WindowSummary *pending, size_t count, uint8_t plants) {
+  if (count == 0) return true;
+  PROFILE_STAGE(STAGE_UPLOAD);
+  bool uploaded = cloud.uploadSummaries(pending, count);
+#if !LIVE_UPLOADS
+  uploaded = uploaded && uploadMinuteMeans(cloud, pending, count, plants);
+#endif
+  return uploaded;
+}
+
+ChangeUpload uploadChanges(CloudHal &cloud, DeltaFilter *filters, const RackSample &sample,
+                           unsigned long nowMs, uint8_t *fields) {
+  bool any = false;
+  for (uint8_t p = 0; p < sample.count; p++) {
+    const Telemetry &t = sample.plant[p];
+    fields[p] = airValid(t) ? filters[p].changedFields(t, nowMs) : 0;
+    if (airValid(t)) filters[p].account(t, fields[p]);
+    any |= fields[p] != 0;
+  }
+  if (!any) return CHANGES_NONE;
+
+  bool uploaded;
+  {
+    PROFILE_STAGE(STAGE_UPLOAD);
+    uploaded = cloud.uploadTelemetry(sample.plant, fields, sample.count);
+  }
+  if (!uploaded) return CHANGES_FAILED;
+  for (uint8_t p = 0; p < sample.count; p++) {
+    if (fields[p]) filters[p].commit(sample.plant[p], fields[p], nowMs);
+  }
+  return CHANGES_SENT;
+}
@@ -0,0 +1,31 @@
+#include "plant_rack.h"
+#include "delta_filter.h"
+
+float plantThresholdValue(const PlantThresholds &th, int field) {
+  switch (field) {
+    case TH_MOISTURE_LOW:  return th.moistureLow;
+    case TH_MOISTURE_HIGH: return th.moistureHigh;
+    case TH_TEMP_HIGH:     return th.tempHigh;
+    case TH_TEMP_LOW:      return th.tempLow;
+    case TH_LUX_LOW:       return th.luxLow;
+    case TH_LUX_HIGH:      return th.luxHigh;
+    case TH_HUMIDITY_HIGH: return th.humidityHigh;
+    case TH_HUMIDITY_LOW:  return th.humidityLow;
+  }
+  return NAN;
+}
+
+// Transpose (AoS → SoA). Runs once per tick / threshold change, so the
+// rules can walk contiguous arrays.
+void rackSetReadings(PlantRack &rack, const RackSample &s) {
+  rack.count = s.count;
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    for (uint8_t p = 0; p < s.count; p++) rack.reading[f][p] = telemetryFieldValue(s.plant[p], f);
+  }
+}
+
+void rackSetThresholds(PlantRack &rack, const ThresholdSet &th) {
+  for (int f = 0; f < TH_COUNT; f++) {
+    for (uint8_t p = 0; p < MAX_PLANTS; p++) rack.threshold[f][p] = plantThresholdValue(th.plant[p], f);
+  }
+}
@@ -0,0 +1,32 @@
+#include "plant_thresholds.h"
+#include "telemetry_json.h"
+
+bool thresholdsApplyNumber(const char *key, float v, PlantThresholds &out) {
+  if      (strcmp(key, "moisture_low") == 0)  out.moistureLow  = (int)v;
+  else if (strcmp(key, "moisture_high") == 0) out.moistureHigh = (int)v;
+  else if (strcmp(key, "temp_high") == 0)     out.tempHigh     = v;
+  else if (strcmp(key, "temp_low") == 0)      out.tempLow      = v;
+  else if (strcmp(key, "lux_low") == 0)       out.luxLow       = v;
+  else if (strcmp(key, "lux_high") == 0)      out.luxHigh      = v;
+  else if (strcmp(key, "humidity_high") == 0) out.humidityHigh = v;
+  else if (strcmp(key, "humidity_low") == 0)  out.humidityLow  = v;
+  else return false;
+  return true;
+}
+
+// One member of the object (jsonScanObject)
+static void applyMember(void *ctx, const char *key, const char *value, bool isString) {
+  PlantThresholds &out = *(PlantThresholds *)ctx;
+  if (isString) {
+    if (strcmp(key, "species") == 0) strlcpy(out.speciesName, value, sizeof(out.speciesName));
+  } else if (value[0] == '-' || isdigit((unsigned char)value[0])) {
+    thresholdsApplyNumber(key, strtof(value, NULL), out);
+  }
+}
+
+bool thresholdsApplyJson(const char *json, size_t len, PlantThresholds &out) {
+  PlantThresholds th = out;   // Scanned into a copy: a truncated answer applies nothing
+  if (!jsonScanObject(json, len, applyMember, &th)) return false;
+  out = th;
+  return true;
+}
@@ -0,0 +1,249 @@
+#include "rtdb_rest.h"
+
+void RtdbRest::begin(const char *databaseUrl, const char *caCert) {
+  // "https://host[:port]/" -> "host", port
+  const char *p = strstr(databaseUrl, "://");
+  p = p ? p + 3 : databaseUrl;
+  size_t n = strcspn(p, ":/");
+  if (n >= sizeof(host)) n = sizeof(host) - 1;
+  memcpy(host, p, n);
+  host[n] = '\0';
+  port = p[n] == ':' ? (uint16_t)atoi(p + n + 1) : 443;
+  tls.setCaCert(caCert);
+}
+
+void RtdbRest::stop() {
+  abortPending();
+  tls.stop();
+  keepAlive = false;
+}
+
+bool RtdbRest::fail(const char *reason) {
+  strlcpy(error, reason, sizeof(error));
+  stop();
+  return false;
+}
+
+// Answers that will never come: tell the readers
+void RtdbRest::abortPending() {
+  for (uint8_t i = 0; i < pendingCount; i++) {
+    st.failures++;
+    if (pending[i].reader) pending[i].reader(pending[i].ctx, 0, NULL, 0);
+  }
+  pendingCount = 0;
+}
+
+bool RtdbRest::drain(void *ctx, const char *data, size_t len) {
+  return ((TlsSession *)ctx)->write((const uint8_t *)data, len);
+}
+
+// Reuse the kept-alive session unless the server has closed it while idle
+bool RtdbRest::connect() {
+  if (keepAlive && tls.connected() && (pendingCount > 0 || !tls.stale())) return true;
+  abortPending();
+  if (!tls.connect(host, port, RTDB_TIMEOUT_MS)) return fail("TLS connect failed");
+  keepAlive = true;
+  return true;
+}
+
+bool RtdbRest::patch(const char *path, BodyWriter body, const void *ctx, const char *idToken) {
+  status = 0;
+  error[0] = '\0';
+
+  // A kept-alive connection may have been closed by the server since the
+  // last request: retry once on a fresh one before reporting a failure
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    bool reused = keepAlive && tls.connected();
+    if (sendRequest("PATCH", path, body, ctx, idToken)) {
+      pending[pendingCount++] = { NULL, NULL, millis() };
+      if (readPending()) return status >= 200 && status < 300;
+    }
+    if (!reused) break;
+    st.retries++;
+  }
+  return false;
+}
+
+bool RtdbRest::get(const char *path, BodyReader reader, void *ctx, const char *idToken) {
+  if (!sendRequest("GET", path, NULL, NULL, idToken)) {
+    reader(ctx, 0, NULL, 0);
+    return false;
+  }
+  pending[pendingCount++] = { reader, ctx, millis() };
+  return true;
+}
+
+void RtdbRest::finish() {
+  if (pendingCount) readPending();
+}
+
+bool RtdbRest::sendRequest(const char *method, const char *path, BodyWriter body, const void *ctx,
+                           const char *idToken) {
+  if (pendingCount == RTDB_PIPELINE) readPending();
+  if (!connect()) return false;
+  if (pendingCount) st.pipelined++;
+
+  size_t length = 0;
+  if (body) {
+    JsonOut count(NULL, 0);
+    body(count, ctx);
+    length = count.total();
+  }
+
+  JsonOut out(tx, sizeof(tx), drain, &tls);
+  out.put(method);
+  out.put(" ");
+  out.put(path);
+  out.put(body ? ".json?print=silent&auth=" : ".json?auth=");
+  out.put(idToken);
+  out.put(" HTTP/1.1\r\nHost: ");
+  out.put(host);
+  out.put("\r\nConnection: keep-alive\r\n");
+  if (body) {
+    out.put("Content-Type: application/json\r\nContent-Length: ");
+    out.uinteger(length);
+    out.put("\r\n");
+  }
+  out.put("\r\n");
+  if (body) body(out, ctx);
+  st.requests++;
+  if (!out.finish()) return fail("Write failed");
+  return true;
+}
+
+// Answers come back in request order
+bool RtdbRest::readPending() {
+  for (uint8_t i = 0; i < pendingCount; i++) {
+    if (readResponse(pending[i])) continue;
+    // This one and everything after it is lost with the connection
+    memmove(&pending[0], &pending[i], (pendingCount - i) * sizeof(Pending));
+    pendingCount -= i;
+    stop();
+    return false;
+  }
+  pendingCount = 0;
+  if (!keepAlive) tls.stop();
+  return true;
+}
+
+// One header or chunk-size line into `line` (terminator dropped, '\r' kept).
+// The rest of a longer line is read and dropped, so it can't be taken for the
+// next header. 0 = the connection ended or timed out.
+size_t RtdbRest::readLine(char *line, size_t max) {
+  size_t n = tls.readUntil('\n', line, max - 1);
+  line[n] = '\0';
+  if (n == max - 1) {
+    char rest[32];
+    while (tls.readUntil('\n', rest, sizeof(rest)) == sizeof(rest)) {}
+  }
+  return n;
+}
+
+// Up to len body bytes: what fits goes to rx at `kept`, the rest is dropped.
+// Returns the bytes read, fewer than len if the connection ended first.
+size_t RtdbRest::readBody(size_t len, size_t &kept) {
+  char   scratch[64];
+  size_t got = 0;
+  while (got < len) {
+    size_t room = RTDB_RX_BUFFER - 1 - kept;
+    size_t want = min(len - got, room ? room : sizeof(scratch));
+    char  *dst  = room ? rx + kept : scratch;
+    size_t k = tls.read((uint8_t *)dst, want);
+    if (room) kept += k;
+    got += k;
+    if (k < want) break;
+  }
+  return got;
+}
+
+// Chunk-size line, data, CRLF, until the 0 chunk and the blank line after
+// any trailers. False if the connection ended or a size line was garbled.
+bool RtdbRest::readChunked(size_t &kept, size_t &total) {
+  char line[24];
+  for (;;) {
+    char *end;
+    if (readLine(line, sizeof(line)) == 0) return false;
+    size_t size = strtoul(line, &end, 16);
+    if (end == line) return false;
+    if (size == 0) break;
+    if (readBody(size, kept) < size || readLine(line, sizeof(line)) == 0) return false;
+    total += size;
+  }
+  for (;;) {
+    size_t n = readLine(line, sizeof(line));
+    if (n == 0) return false;
+    if (n == 1 && line[0] == '\r') return true;
+  }
+}
+
+// Status line, headers, then the body: Content-Length, chunked, or (neither)
+// up to the server's close, after which the connection isn't reused. A GET
+// body goes to its reader; for a PATCH, the start of an error body becomes
+// the error text ({"error" : "..."}). The success answer to print=silent is
+// an empty 204.
+bool RtdbRest::readResponse(Pending &p) {
+  char   line[96];
+  int    code = 0;
+  size_t n = readLine(line, sizeof(line));
+  if (n == 0 || sscanf(line, "HTTP/1.%*d %d", &code) != 1) {
+    strlcpy(error, "No response", sizeof(error));
+    return false;
+  }
+
+  size_t contentLength = 0;
+  bool   haveLength = false;
+  bool   chunked    = false;
+  for (;;) {
+    n = readLine(line, sizeof(line));
+    if (n == 0) {
+      strlcpy(error, "Truncated response", sizeof(error));
+      return false;
+    }
+    if (n == 1 && line[0] == '\r') break;   // End of headers
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = strtoul(line + 15, NULL, 10);
+      haveLength    = true;
+    }
+    if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line, "chunked")) chunked = true;
+    if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line, "close")) keepAlive = false;
+  }
+
+  // Whatever doesn't fit the buffer is read and dropped
+  bool   ok    = code >= 200 && code < 300;
+  size_t kept  = 0;
+  size_t total = 0;
+  if (code == 204 || code == 304 || code < 200) {
+    // Never a body
+  } else if (chunked) {
+    if (!readChunked(kept, total)) {
+      strlcpy(error, "Truncated body", sizeof(error));
+      return false;
+    }
+  } else if (haveLength) {
+    total = readBody(contentLength, kept);
+    if (total < contentLength) {
+      strlcpy(error, "Truncated body", sizeof(error));
+      return false;
+    }
+  } else {
+    // Delimited by the close: the connection is done after this answer
+    keepAlive = false;
+    total = readBody(SIZE_MAX, kept);
+  }
+  rx[kept] = '\0';
+  st.latencyMs.record(millis() - p.sentMs);
+
+  if (!ok) {
+    st.failures++;
+    if (kept && !p.reader) strlcpy(error, rx, sizeof(error));
+    else snprintf(error, sizeof(error), "HTTP %d", code);
+  } else if (p.reader && kept < total) {
+    st.failures++;
+    strlcpy(error, "Answer too large", sizeof(error));
+    code = 0;
+  }
+
+  if (p.reader) p.reader(p.ctx, code, rx, kept);
+  else status = code;
+  return true;
+}
@@ -0,0 +1,221 @@
+#include "sample_log.h"
+#include <FS.h>
+#include <LittleFS.h>
+#include "plant_rack.h"
+
+#define LOG_DIR       "/log"
+#define LOG_TAIL_PATH "/log/tail"
+#define LUX_BITS      20                  // 104 klx × 10; the BH1750 tops out at 65535 lx
+#define LUX_MASK      ((1u << LUX_BITS) - 1)
+#define PLANT_SHIFT   LUX_BITS
+#define PLANT_MASK    0x0Fu
+#define BOOT_SHIFT    24
+// Records written before the boot stamp kept the plant in bits 24-31. A
+// different CRC start value makes them fail the check instead of being
+// misread. Updates only install while online, after the backlog has drained.
+#define CRC_INIT      0x5A
+
+static_assert(MAX_PLANTS <= PLANT_MASK + 1, "LogRecord has 4 bits for the plant index");
+
+// ================= RECORD FORMAT =================
+static uint8_t crc8(const uint8_t *data, size_t len) {
+  // CRC-8 (poly 0x07), bitwise - 15 bytes per record, so no table needed
+  uint8_t crc = CRC_INIT;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+  return crc;
+}
+
+void logRecordPack(const Telemetry &t, uint8_t plant, uint32_t boot, LogRecord &out) {
+  out.timestamp    = t.timestamp;
+  out.tempCenti    = (int16_t)lroundf(constrain(t.temperature, -327.0f, 327.0f) * 100.0f);
+  out.humidCenti   = (uint16_t)lroundf(constrain(t.humidity, 0.0f, 100.0f) * 100.0f);
+  out.luxPlantBoot = min((uint32_t)lroundf(max(t.lux, 0.0f) * 10.0f), LUX_MASK) |
+                     (uint32_t)(plant & PLANT_MASK) << PLANT_SHIFT | (boot & 0xFF) << BOOT_SHIFT;
+  out.soilRaw      = (uint16_t)constrain(t.soilRaw, 0, 65535);
+  out.moisture     = (uint8_t)constrain(t.soilMoisture, 0, 100);
+  out.crc          = crc8((const uint8_t *)&out, sizeof(LogRecord) - 1);
+}
+
+void logRecordUnpack(const LogRecord &r, uint32_t currentBoot, LoggedSample &out) {
+  Telemetry &t   = out.data;
+  t.timestamp    = r.timestamp;
+  t.temperature  = r.tempCenti / 100.0f;
+  t.humidity     = r.humidCenti / 100.0f;
+  t.lux          = (r.luxPlantBoot & LUX_MASK) / 10.0f;
+  t.soilRaw      = r.soilRaw;
+  t.soilMoisture = r.moisture;
+  out.plant      = (r.luxPlantBoot >> PLANT_SHIFT) & PLANT_MASK;
+  // The newest boot whose low 8 bits match, not after currentBoot
+  out.boot       = currentBoot - ((currentBoot - (r.luxPlantBoot >> BOOT_SHIFT)) & 0xFF);
+}
+
+bool logRecordValid(const LogRecord &r) {
+  return crc8((const uint8_t *)&r, sizeof(LogRecord) - 1) == r.crc;
+}
+
+// ================= RING ON LITTLEFS =================
+void SampleLog::segPath(uint32_t base, char *out, size_t len) {
+  snprintf(out, len, LOG_DIR "/%08lu.seg", (unsigned long)base);
+}
+
+bool SampleLog::begin(uint32_t boot) {
+  this->boot = boot;
+  if (!LittleFS.begin(true)) {
+    Serial.println("✗ [Log] LittleFS mount failed - offline log disabled");
+    return false;
+  }
+  mounted = true;
+  if (!LittleFS.exists(LOG_DIR)) LittleFS.mkdir(LOG_DIR);
+
+  // Find the oldest and newest segments
+  bool     any = false;
+  uint32_t minBase = 0, maxBase = 0;
+  File dir = LittleFS.open(LOG_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char *name = strrchr(f.name(), '/');
+    name = name ? name + 1 : f.name();
+    if (!strstr(name, ".seg")) continue;
+    uint32_t base = strtoul(name, NULL, 10);
+    if (!any || base < minBase) minBase = base;
+    if (!any || base > maxBase) maxBase = base;
+    any = true;
+  }
+
+  if (!any) {
+    headSeq = tailSeq = 0;
+    if (LittleFS.exists(LOG_TAIL_PATH)) {
+      // Everything was drained; keep numbering monotonic so history keys never repeat
+      File t = LittleFS.open(LOG_TAIL_PATH, "r");
+      if (t && t.read((uint8_t *)&tailSeq, sizeof(tailSeq)) == sizeof(tailSeq)) headSeq = tailSeq;
+    }
+    Serial.println("✓ [Log] Offline log ready (empty)");
+    return true;
+  }
+
+  // head = end of the newest segment. A torn final record (power cut mid-append)
+  // is abandoned by starting the next append in a fresh segment.
+  char path[24];
+  segPath(maxBase, path, sizeof(path));
+  File seg = LittleFS.open(path, "r");
+  size_t size = seg ? seg.size() : 0;
+  headSeq = maxBase + size / sizeof(LogRecord);
+  if (size % sizeof(LogRecord) != 0) {
+    headSeq = maxBase + LOG_SEG_RECORDS;
+    dropped++;
+  }
+  seg.close();
+
+  // tail = persisted pointer, clamped into [oldest segment, head]
+  tailSeq = minBase;
+  File t = LittleFS.open(LOG_TAIL_PATH, "r");
+  uint32_t stored;
+  if (t && t.read((uint8_t *)&stored, sizeof(stored)) == sizeof(stored)) {
+    if (stored >= minBase && stored <= headSeq) tailSeq = stored;
+  }
+
+  Serial.printf("✓ [Log] Offline log recovered: %lu pending sample(s)\n", (unsigned long)pending());
+  return true;
+}
+
+bool SampleLog::append(const Telemetry &t, uint8_t plant) {
+  if (!mounted) return false;
+
+  // Full: sacrifice the oldest segment
+  if (headSeq - tailSeq >= (uint32_t)LOG_SEG_RECORDS * LOG_MAX_SEGMENTS) dropOldestSegment();
+
+  LogRecord rec;
+  logRecordPack(t, plant, boot, rec);
+
+  char path[24];
+  segPath(segBase(headSeq), path, sizeof(path));
+  File f = LittleFS.open(path, "a");
+  if (!f) return false;
+  bool ok = f.write((const uint8_t *)&rec, sizeof(rec)) == sizeof(rec);
+  f.close();  // Commits the append atomically
+  if (ok) headSeq++;
+  return ok;
+}
+
+size_t SampleLog::peek(LoggedSample *out, size_t max) {
+  if (!mounted) return 0;
+
+  size_t   n   = 0;
+  uint32_t seq = tailSeq;
+  char     path[24];
+
+  while (n < max && seq < headSeq) {
+    // Read a contiguous run from one segment
+    uint32_t base = segBase(seq);
+    segPath(base, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    uint32_t segEnd = min(base + (uint32_t)LOG_SEG_RECORDS, headSeq);
+
+    if (!f || !f.seek((seq - base) * sizeof(LogRecord))) {
+      // Missing segment (torn tail abandoned at boot) - nothing left to read in it
+      if (seq == tailSeq && n == 0) {
+        dropped += segEnd - seq;
+        tailSeq = segEnd;
+      }
+      seq = segEnd;
+      continue;
+    }
+
+    while (n < max && seq < segEnd) {
+      LogRecord rec;
+      if (f.read((uint8_t *)&rec, sizeof(rec)) != sizeof(rec)) {
+        seq = segEnd;  // Short segment
+        break;
+      }
+      if (logRecordValid(rec)) {
+        logRecordUnpack(rec, boot, out[n]);
+        out[n].seq = seq;
+        n++;
+      } else {
+        dropped++;
+      }
+      seq++;
+    }
+    f.close();
+  }
+
+  // Remember where this batch ends so consumePeeked() also skips corrupt records
+  peekEnd = seq;
+  return n;
+}
+
+void SampleLog::consumePeeked() {
+  if (!mounted || peekEnd <= tailSeq) return;
+  uint32_t newTail = min(peekEnd, headSeq);
+
+  // Delete segments that are now fully drained
+  char path[24];
+  for (uint32_t base = segBase(tailSeq); base + LOG_SEG_RECORDS <= newTail; base += LOG_SEG_RECORDS) {
+    segPath(base, path, sizeof(path));
+    LittleFS.remove(path);
+  }
+  tailSeq = newTail;
+  persistTail();
+}
+
+void SampleLog::persistTail() {
+  // Small file rewrite = copy-on-write in LittleFS, so the old value survives a crash
+  File t = LittleFS.open(LOG_TAIL_PATH, "w");
+  if (!t) return;
+  t.write((const uint8_t *)&tailSeq, sizeof(tailSeq));
+  t.close();
+}
+
+void SampleLog::dropOldestSegment() {
+  uint32_t base = segBase(tailSeq);
+  char path[24];
+  segPath(base, path, sizeof(path));
+  LittleFS.remove(path);
+
+  uint32_t next = base + LOG_SEG_RECORDS;
+  dropped += next - tailSeq;
+  tailSeq = next;
+  persistTail();
+}
@@ -0,0 +1,103 @@
+#include "sensor_schedule.h"
+#include "delta_filter.h"
+
+// Which sensor measures a field, and the thresholds it is judged against
+struct FieldSense {
+  SenseKind kind;
+  int8_t    low;    // ThresholdField, -1 = none
+  int8_t    high;
+};
+
+static const FieldSense FIELD_SENSE[FIELD_COUNT] = {
+  { SENSE_AIR,   TH_TEMP_LOW,     TH_TEMP_HIGH },       // FIELD_TEMPERATURE
+  { SENSE_AIR,   TH_HUMIDITY_LOW, TH_HUMIDITY_HIGH },   // FIELD_HUMIDITY
+  { SENSE_SOIL,  TH_MOISTURE_LOW, TH_MOISTURE_HIGH },   // FIELD_SOIL_MOISTURE
+  { SENSE_SOIL,  -1,              -1 },                 // FIELD_SOIL_RAW
+  { SENSE_LIGHT, TH_LUX_LOW,      TH_LUX_HIGH },        // FIELD_LIGHT
+};
+
+void SensorScheduler::configure(const SenseConfig *cfg, uint8_t plants, uint32_t tickMs) {
+  this->cfg    = cfg;
+  this->plants = min(plants, (uint8_t)MAX_PLANTS);
+  this->tickMs = tickMs;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) {
+    for (uint8_t k = 0; k < SENSE_COUNT; k++) channels[p][k] = { 0, cfg[k].baseMs };   // Everything due at once
+    for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+      values[p][f]   = { NAN, 0, false };
+      previous[p][f] = NAN;
+    }
+    stored[p] = 0;
+  }
+  for (uint8_t k = 0; k < SENSE_COUNT; k++) st[k] = { 0, 0, 0, 0 };
+}
+
+bool SensorScheduler::due(uint8_t plant, SenseKind kind, unsigned long nowMs) {
+  st[kind].ticks++;
+  return (long)(nowMs - channels[plant][kind].nextMs) >= 0;
+}
+
+void SensorScheduler::store(uint8_t plant, TelemetryField field, float v, unsigned long measuredMs) {
+  previous[plant][field] = values[plant][field].value;
+  if (isnan(v)) return;
+  values[plant][field].value = v;
+  values[plant][field].atMs  = measuredMs;
+  stored[plant] |= FIELD_BIT(field);
+}
+
+void SensorScheduler::reschedule(uint8_t plant, SenseKind kind, const PlantRack &rack, unsigned long nowMs) {
+  const SenseConfig &c  = cfg[kind];
+  Channel           &ch = channels[plant][kind];
+  bool near = false, moved = false, failed = false;
+
+  for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+    const FieldSense &fs = FIELD_SENSE[f];
+    if (fs.kind != kind) continue;
+    if (!(stored[plant] & FIELD_BIT(f))) {
+      failed = true;
+      continue;
+    }
+    if (fs.low < 0) continue;
+
+    float v    = values[plant][f].value;
+    float lo   = rack.threshold[fs.low][plant];
+    float hi   = rack.threshold[fs.high][plant];
+    float span = max(fabsf(hi - lo), 1.0f);
+    if (fabsf(v - lo) < c.nearFraction * span || fabsf(v - hi) < c.nearFraction * span) near = true;
+    float before = previous[plant][f];
+    if (isnan(before) || fabsf(v - before) >= c.stableFraction * span) moved = true;
+  }
+
+  if (failed)     ch.periodMs = c.baseMs;
+  else if (near)  ch.periodMs = c.fastMs;
+  else if (moved) ch.periodMs = c.baseMs;
+  else            ch.periodMs = min(max(ch.periodMs, c.baseMs) * 2, c.slowMs);
+  ch.nextMs = nowMs + ch.periodMs;
+
+  st[kind].reads++;
+  if (near)   st[kind].nearReads++;
+  if (failed) st[kind].failedReads++;
+}
+
+uint8_t SensorScheduler::fill(uint8_t plant, Telemetry &t, unsigned long nowMs) {
+  for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+    SensedValue &s = values[plant][f];
+    s.valid = !isnan(s.value) && nowMs - s.atMs <= cfg[FIELD_SENSE[f].kind].maxAgeMs;
+    float missing = f == FIELD_TEMPERATURE || f == FIELD_HUMIDITY ? NAN : 0.0f;
+    telemetrySetField(t, f, s.valid ? s.value : missing);
+  }
+  uint8_t fresh = stored[plant];
+  stored[plant] = 0;
+  return fresh;
+}
+
+uint32_t SensorScheduler::savedUsPerHour(SenseKind kind) const {
+  uint64_t elapsedMs = plants ? (uint64_t)st[kind].ticks * tickMs / plants : 0;
+  if (elapsedMs == 0) return 0;
+  uint64_t fixedReads = (uint64_t)st[kind].ticks * tickMs / cfg[kind].fixedMs;
+  uint64_t skipped    = fixedReads > st[kind].reads ? fixedReads - st[kind].reads : 0;
+  return (uint32_t)(skipped * cfg[kind].readUs * 3600000ULL / elapsedMs);
+}
+
+uint32_t SensorScheduler::meanPeriodMs(SenseKind kind) const {
+  return st[kind].reads ? (uint32_t)((uint64_t)st[kind].ticks * tickMs / st[kind].reads) : 0;
+}
@@ -0,0 +1,22 @@
+#include "signal_filters.h"
+#include <algorithm>
+
+uint16_t medianU16(uint16_t *buf, size_t n) {
+  std::nth_element(buf, buf + n / 2, buf + n);
+  return buf[n / 2];
+}
+
+float trimmedMeanU16(uint16_t *buf, size_t n, size_t trim) {
+  if (n == 0) return 0;
+  if (2 * trim >= n) return medianU16(buf, n);
+
+  // Partition so [trim, n - trim) holds the kept samples (in any order)
+  if (trim > 0) {
+    std::nth_element(buf, buf + trim, buf + n);
+    std::nth_element(buf + trim, buf + (n - trim - 1), buf + n);
+  }
+
+  uint32_t sum = 0;
+  for (size_t i = trim; i < n - trim; i++) sum += buf[i];
+  return (float)sum / (float)(n - 2 * trim);
+}
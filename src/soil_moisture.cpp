@@ -0,0 +1,199 @@
+#include "soil_moisture.h"
+#include <driver/adc.h>
+#include <Preferences.h>
+
+#define ADC_SAMPLE_HZ     20000  // Lowest continuous rate the ESP32 ADC DMA supports
+#define ADC_FRAME_SAMPLES 200    // 10 ms of samples per reduction
+#define ADC_FRAME_TRIM    40     // Drop the lowest/highest 20 % of each frame
+#define ADC_BURST_SAMPLES 64     // One-shot mode: samples per wake (~3 ms)
+#define ADC_BURST_TRIM    12
+#define ADC_BURST_ALPHA   0.3f   // One reading per wake, so a much faster EMA
+#define ADC_DEFAULT_VREF  1100   // mV, only used if the chip has no eFuse calibration
+#define MOISTURE_TASK_STACK 3072
+#define MOISTURE_TASK_PRIO  1    // Below the sensor/UI task
+#define MOISTURE_TASK_CORE  1
+
+#define NVS_NAMESPACE "moisture"
+
+// NVS keys: probe 0 keeps the single-probe names, others get a suffix
+static void calKey(const char *name, uint8_t probe, char *out, size_t len) {
+  if (probe == 0) snprintf(out, len, "%s", name);
+  else            snprintf(out, len, "%s%u", name, probe);
+}
+
+// Channels, eFuse characterization and calibration points (shared by both modes)
+bool SoilMoistureAdc::setup(int defaultDryRaw, int defaultWetRaw) {
+  if (count == 0 || count > MOISTURE_MAX_CHANNELS) return false;
+  for (uint8_t i = 0; i < count; i++) {
+    int ch = digitalPinToAnalogChannel(pins[i]);
+    if (ch < 0 || ch > 7) {
+      Serial.printf("✗ [Moisture] GPIO %u is not on ADC1\n", pins[i]);
+      return false;
+    }
+    channel[i] = ch;
+  }
+
+  // eFuse calibration (Vref or two-point, whichever the chip was burned with)
+  esp_adc_cal_value_t src = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                                     ADC_DEFAULT_VREF, &chars);
+  Serial.printf("✓ [Moisture] ADC calibration: %s\n",
+    src == ESP_ADC_CAL_VAL_EFUSE_TP ? "eFuse two-point" :
+    src == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref" : "default Vref");
+
+  // Calibration points from NVS, else the compile-time raw defaults
+  uint16_t dryMv = esp_adc_cal_raw_to_voltage(defaultDryRaw, &chars);
+  uint16_t wetMv = esp_adc_cal_raw_to_voltage(defaultWetRaw, &chars);
+  char dryKey[12], wetKey[12];
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, true);
+  for (uint8_t i = 0; i < count; i++) {
+    calKey("dry_mv", i, dryKey, sizeof(dryKey));
+    calKey("wet_mv", i, wetKey, sizeof(wetKey));
+    cal[i].dryMv = prefs.getUShort(dryKey, dryMv);
+    cal[i].wetMv = prefs.getUShort(wetKey, wetMv);
+  }
+  prefs.end();
+  return true;
+}
+
+bool SoilMoistureAdc::begin(int defaultDryRaw, int defaultWetRaw) {
+  if (!setup(defaultDryRaw, defaultWetRaw)) return false;
+
+  // Continuous DMA sampling; the pattern table visits every probe in turn
+  adc_digi_init_config_t initCfg = {};
+  initCfg.max_store_buf_size = ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES * 4;
+  initCfg.conv_num_each_intr = ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES;
+  initCfg.adc2_chan_mask = 0;
+
+  adc_digi_pattern_config_t pattern[MOISTURE_MAX_CHANNELS] = {};
+  for (uint8_t i = 0; i < count; i++) {
+    initCfg.adc1_chan_mask |= BIT(channel[i]);
+    pattern[i].atten = ADC_ATTEN_DB_11;
+    pattern[i].channel = channel[i];
+    pattern[i].unit = 0;  // ADC1
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_configuration_t digiCfg = {};
+  digiCfg.conv_limit_en = ADC_CONV_LIMIT_EN;
+  digiCfg.conv_limit_num = 250;
+  digiCfg.pattern_num = count;
+  digiCfg.adc_pattern = pattern;
+  digiCfg.sample_freq_hz = ADC_SAMPLE_HZ;
+  digiCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  digiCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+  if (adc_digi_initialize(&initCfg) != ESP_OK ||
+      adc_digi_controller_configure(&digiCfg) != ESP_OK ||
+      adc_digi_start() != ESP_OK) {
+    Serial.println("✗ [Moisture] ADC DMA setup failed - falling back to analogRead()");
+    return false;
+  }
+
+  running = true;
+  xTaskCreatePinnedToCore(task, "moisture", MOISTURE_TASK_STACK, this,
+                          MOISTURE_TASK_PRIO, NULL, MOISTURE_TASK_CORE);
+  Serial.printf("✓ [Moisture] DMA sampling %u probe(s) at %d Hz total\n", count, ADC_SAMPLE_HZ);
+  for (uint8_t i = 0; i < count; i++) {
+    Serial.printf("  Probe %u: GPIO %u | dry %u mV, wet %u mV\n", i, pins[i], cal[i].dryMv, cal[i].wetMv);
+  }
+  return true;
+}
+
+void SoilMoistureAdc::task(void *arg) {
+  SoilMoistureAdc *self = (SoilMoistureAdc *)arg;
+  static uint8_t bytes[ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES];
+
+  for (;;) {
+    uint32_t len = 0;
+    esp_err_t err = adc_digi_read_bytes(bytes, sizeof(bytes), &len, ADC_MAX_DELAY);
+    if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {  // INVALID_STATE = overrun, data still usable
+      self->processFrame(bytes, len);
+    }
+  }
+}
+
+// One pass per probe over the frame keeps the scratch buffer (and the task
+// stack) at one frame's worth of samples regardless of the probe count
+void SoilMoistureAdc::processFrame(const uint8_t *bytes, size_t len) {
+  uint16_t samples[ADC_FRAME_SAMPLES];
+  size_t   expected = ADC_FRAME_SAMPLES / count;
+
+  // TYPE1 output: 4-bit channel + 12-bit result per 16-bit word
+  const adc_digi_output_data_t *out = (const adc_digi_output_data_t *)bytes;
+  size_t words = len / SOC_ADC_DIGI_RESULT_BYTES;
+  for (uint8_t p = 0; p < count; p++) {
+    size_t n = 0;
+    for (size_t i = 0; i < words && n < ADC_FRAME_SAMPLES; i++) {
+      if (out[i].type1.channel == channel[p]) samples[n++] = out[i].type1.data;
+    }
+    if (n < expected / 2) continue;  // Mostly-empty frame; skip it
+
+    size_t trim = (ADC_FRAME_TRIM * n) / ADC_FRAME_SAMPLES;
+    filtered[p].store(ema[p].update(trimmedMeanU16(samples, n, trim)), std::memory_order_relaxed);
+  }
+
+  rateCount++;
+  if (millis() - rateStart >= 1000) {
+    rate = rateCount;
+    rateCount = 0;
+    rateStart = millis();
+  }
+}
+
+// Low-power mode: no DMA and no task. Each sampleBurst() converts a short
+// burst with the one-shot driver and feeds its trimmed mean to the EMA.
+bool SoilMoistureAdc::beginOneShot(int defaultDryRaw, int defaultWetRaw) {
+  if (!setup(defaultDryRaw, defaultWetRaw)) return false;
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  for (uint8_t i = 0; i < count; i++) {
+    adc1_config_channel_atten((adc1_channel_t)channel[i], ADC_ATTEN_DB_11);
+    ema[i].alpha = ADC_BURST_ALPHA;
+  }
+  oneShot = true;
+  return true;
+}
+
+void SoilMoistureAdc::sampleBurst() {
+  uint16_t samples[ADC_BURST_SAMPLES];
+  for (uint8_t p = 0; p < count; p++) {
+    for (int i = 0; i < ADC_BURST_SAMPLES; i++) samples[i] = adc1_get_raw((adc1_channel_t)channel[p]);
+    float v = ema[p].update(trimmedMeanU16(samples, ADC_BURST_SAMPLES, ADC_BURST_TRIM));
+    filtered[p].store(v, std::memory_order_relaxed);
+  }
+}
+
+void SoilMoistureAdc::restoreFilter(uint8_t probe, float value) {
+  ema[probe].value  = value;
+  ema[probe].primed = true;
+  filtered[probe].store(value, std::memory_order_relaxed);
+}
+
+float SoilMoistureAdc::raw(uint8_t probe) const {
+  if (!running && !oneShot) return analogRead(pins[probe]);
+  return filtered[probe].load(std::memory_order_relaxed);
+}
+
+uint32_t SoilMoistureAdc::millivolts(uint8_t probe) const {
+  return esp_adc_cal_raw_to_voltage((uint32_t)lroundf(raw(probe)), &chars);
+}
+
+int SoilMoistureAdc::percent(uint8_t probe) const {
+  const MoistureCalibration &c = cal[probe];
+  int span = (int)c.dryMv - (int)c.wetMv;
+  if (span == 0) return 0;
+  int pct = ((int)c.dryMv - (int)millivolts(probe)) * 100 / span;
+  return constrain(pct, 0, 100);
+}
+
+void SoilMoistureAdc::setCalibration(uint8_t probe, const MoistureCalibration &c) {
+  cal[probe] = c;
+  char dryKey[12], wetKey[12];
+  calKey("dry_mv", probe, dryKey, sizeof(dryKey));
+  calKey("wet_mv", probe, wetKey, sizeof(wetKey));
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.putUShort(dryKey, c.dryMv);
+  prefs.putUShort(wetKey, c.wetMv);
+  prefs.end();
+}
@@ -0,0 +1,75 @@
+#include "stage_profiler.h"
+
+// ================= HISTOGRAM =================
+// Below HIST_LINEAR a value is its own bucket. Above, the bucket is the
+// position of the top bit plus the next HIST_SUB_BITS bits.
+uint8_t LogHistogram::bucketOf(uint32_t v) {
+  if (v < HIST_LINEAR) return v;
+  if (v >> HIST_MAX_LOG2) return HIST_BUCKETS - 1;
+  int msb = 31 - __builtin_clz(v);
+  int sub = (v >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1);
+  return HIST_LINEAR + (msb - HIST_SUB_BITS - 1) * HIST_SUB + sub;
+}
+
+uint32_t LogHistogram::bucketHigh(uint8_t b) {
+  if (b < HIST_LINEAR) return b;
+  if (b >= HIST_BUCKETS - 1) return UINT32_MAX;
+  int msb = (b - HIST_LINEAR) / HIST_SUB + HIST_SUB_BITS + 1;
+  int sub = (b - HIST_LINEAR) % HIST_SUB;
+  return ((uint32_t)(HIST_SUB + sub + 1) << (msb - HIST_SUB_BITS)) - 1;
+}
+
+void LogHistogram::record(uint32_t v) {
+  buckets[bucketOf(v)]++;
+  n++;
+  total += v;
+  if (v > maxV) maxV = v;
+}
+
+void LogHistogram::reset() {
+  for (uint8_t b = 0; b < HIST_BUCKETS; b++) buckets[b] = 0;
+  n = maxV = 0;
+  total = 0;
+}
+
+uint32_t LogHistogram::percentile(float q) const {
+  if (n == 0) return 0;
+  uint32_t rank = (uint32_t)(q * n + 0.999f);   // ceil, at least 1
+  if (rank < 1) rank = 1;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < HIST_BUCKETS; b++) {
+    seen += buckets[b];
+    if (seen >= rank) return bucketHigh(b) < maxV ? bucketHigh(b) : maxV;
+  }
+  return maxV;
+}
+
+// ================= STAGES =================
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+  "setup", "setup_display", "setup_sensors", "setup_face_cache",
+  "sensor_cycle", "read_air", "read_soil", "read_light", "aggregate", "face_rules", "screen",
+  "network_cycle", "boot_step", "threshold_sync", "face_status", "upload", "backlog",
+};
+
+const char *stageName(Stage s) {
+  return s < STAGE_COUNT ? STAGE_NAMES[s] : "";
+}
+
+StageSummary summarizeStage(const LogHistogram &h, Stage s) {
+  StageSummary sum;
+  sum.name  = stageName(s);
+  sum.count = h.count();
+  sum.p50Us = h.percentile(0.50f);
+  sum.p95Us = h.percentile(0.95f);
+  sum.maxUs = h.maximum();
+  return sum;
+}
+
+#if GAIA_PROFILING
+LogHistogram stageTimes[STAGE_COUNT];
+uint32_t     profileCyclesPerUs = 240;
+
+void profilerBegin() {
+  profileCyclesPerUs = ESP.getCpuFreqMHz();
+}
+#endif
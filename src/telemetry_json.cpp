@@ -0,0 +1,299 @@
+#include "telemetry_json.h"
+#include <math.h>
+#include <string.h>
+
+#define FIELD_DESC(key, kind, decimals, member) \
+  { key, sizeof(key) - 1, kind, decimals, (uint8_t)offsetof(Telemetry, member) }
+
+// Same order as TelemetryField
+const TelemetryFieldDesc TELEMETRY_FIELDS[FIELD_COUNT] = {
+  FIELD_DESC("temperature",     FIELD_KIND_FLOAT, 2, temperature),
+  FIELD_DESC("humidity",        FIELD_KIND_FLOAT, 1, humidity),
+  FIELD_DESC("soil_moisture",   FIELD_KIND_INT,   0, soilMoisture),
+  FIELD_DESC("soil_raw",        FIELD_KIND_INT,   0, soilRaw),
+  FIELD_DESC("light_intensity", FIELD_KIND_FLOAT, 1, lux),
+};
+
+static_assert(sizeof(int) == sizeof(int32_t), "FIELD_KIND_INT fields are read as int32_t");
+
+static const uint32_t POW10[] = { 1, 10, 100, 1000, 10000, 100000 };
+
+// ================= JSON OUT =================
+void JsonOut::put(char c) {
+  put(&c, 1);
+}
+
+void JsonOut::put(const char *s) {
+  put(s, strlen(s));
+}
+
+void JsonOut::put(const char *s, size_t n) {
+  if (!buf) {             // Counting only
+    len += n;
+    return;
+  }
+  while (n > 0) {
+    if (len == cap) {
+      if (!drainFn || !drainFn(ctx, buf, len)) {
+        good = false;
+        return;
+      }
+      flushed += len;
+      len = 0;
+    }
+    size_t k = n < cap - len ? n : cap - len;
+    memcpy(buf + len, s, k);
+    len += k;
+    s += k;
+    n -= k;
+  }
+}
+
+void JsonOut::key(const char *prefix, const char *name, size_t nameLen) {
+  if (!first) put(',');
+  first = false;
+  put('"');
+  if (prefix) put(prefix);
+  put(name, nameLen);
+  put("\":", 2);
+}
+
+void JsonOut::key(const char *prefix, const char *name) {
+  key(prefix, name, strlen(name));
+}
+
+// Species names come from the app: escape the quote, the
+// backslash and control characters (RFC 8259). Plain runs go out in one put().
+void JsonOut::string(const char *s) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  put('"');
+  const char *run = s;
+  for (; *s; s++) {
+    uint8_t c = (uint8_t)*s;
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    put(run, s - run);
+    run = s + 1;
+    char esc[6] = { '\\', (char)c, '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF] };
+    if      (c == '\n') esc[1] = 'n';
+    else if (c == '\r') esc[1] = 'r';
+    else if (c == '\t') esc[1] = 't';
+    else if (c < 0x20)  esc[1] = 'u';
+    put(esc, esc[1] == 'u' ? 6 : 2);
+  }
+  put(run, s - run);
+  put('"');
+}
+
+void JsonOut::uinteger(uint32_t v) {
+  char digits[10];
+  int  n = 0;
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  char out[10];
+  for (int i = 0; i < n; i++) out[i] = digits[n - 1 - i];
+  put(out, n);
+}
+
+void JsonOut::integer(int32_t v) {
+  if (v < 0) {
+    put('-');
+    uinteger((uint32_t)0 - (uint32_t)v);
+  } else {
+    uinteger((uint32_t)v);
+  }
+}
+
+void JsonOut::fixed(float v, uint8_t decimals) {
+  if (decimals > 5) decimals = 5;
+  uint32_t scale = POW10[decimals];
+  float    a     = fabsf(v) * scale + 0.5f;
+  if (isnan(v) || a >= 4.0e9f) {   // NaN, inf, or beyond 32 bits of fixed point
+    put("null", 4);
+    return;
+  }
+
+  uint32_t q    = (uint32_t)a;
+  uint32_t ip   = q / scale;
+  uint32_t frac = q % scale;
+  if (v < 0 && q) put('-');
+  uinteger(ip);
+
+  // Trim trailing zeros, as FirebaseJson prints 22.5 rather than 22.50
+  while (decimals && frac % 10 == 0) {
+    frac /= 10;
+    decimals--;
+  }
+  if (!decimals) return;
+  char out[6];
+  out[0] = '.';
+  for (int i = decimals; i >= 1; i--) {
+    out[i] = '0' + frac % 10;
+    frac /= 10;
+  }
+  put(out, decimals + 1);
+}
+
+bool JsonOut::finish() {
+  if (buf && len && drainFn) {
+    if (!drainFn(ctx, buf, len)) good = false;
+    flushed += len;
+    len = 0;
+  }
+  return good;
+}
+
+// ================= TELEMETRY =================
+void jsonTelemetry(JsonOut &out, const char *prefix, const Telemetry &t, uint8_t mask) {
+  const uint8_t *base = (const uint8_t *)&t;
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (!(mask & FIELD_BIT(f))) continue;
+    const TelemetryFieldDesc &d = TELEMETRY_FIELDS[f];
+    out.key(prefix, d.key, d.keyLen);
+    if (d.kind == FIELD_KIND_FLOAT) {
+      float v;
+      memcpy(&v, base + d.offset, sizeof(v));
+      out.fixed(v, d.decimals);
+    } else {
+      int32_t v;
+      memcpy(&v, base + d.offset, sizeof(v));
+      out.integer(v);
+    }
+  }
+  out.key(prefix, "timestamp", 9);
+  out.uinteger((uint32_t)t.timestamp);
+}
+
+// ================= CBOR =================
+// Major type in the top 3 bits, then the shortest argument encoding
+static size_t cborHead(uint8_t major, uint32_t arg, uint8_t *out) {
+  major <<= 5;
+  if (arg < 24) {
+    out[0] = major | arg;
+    return 1;
+  }
+  if (arg <= 0xFF) {
+    out[0] = major | 24;
+    out[1] = arg;
+    return 2;
+  }
+  if (arg <= 0xFFFF) {
+    out[0] = major | 25;
+    out[1] = arg >> 8;
+    out[2] = arg;
+    return 3;
+  }
+  out[0] = major | 26;
+  out[1] = arg >> 24;
+  out[2] = arg >> 16;
+  out[3] = arg >> 8;
+  out[4] = arg;
+  return 5;
+}
+
+size_t cborTelemetry(const Telemetry &t, uint8_t mask, uint8_t *out, size_t cap) {
+  if (cap < TELEMETRY_CBOR_MAX) return 0;
+
+  const uint8_t *base = (const uint8_t *)&t;
+  uint8_t pairs = 1;  // Timestamp
+  for (int f = 0; f < FIELD_COUNT; f++) pairs += (mask >> f) & 1;
+
+  size_t n = cborHead(5, pairs, out);   // Map
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (!(mask & FIELD_BIT(f))) continue;
+    const TelemetryFieldDesc &d = TELEMETRY_FIELDS[f];
+    n += cborHead(0, f, out + n);
+    if (d.kind == FIELD_KIND_FLOAT) {
+      uint32_t bits;
+      memcpy(&bits, base + d.offset, sizeof(bits));
+      out[n++] = 0xFA;                  // float32, big-endian
+      out[n++] = bits >> 24;
+      out[n++] = bits >> 16;
+      out[n++] = bits >> 8;
+      out[n++] = bits;
+    } else {
+      int32_t v;
+      memcpy(&v, base + d.offset, sizeof(v));
+      n += v < 0 ? cborHead(1, (uint32_t)(-1 - v), out + n) : cborHead(0, v, out + n);
+    }
+  }
+  n += cborHead(0, TELEMETRY_CBOR_TIMESTAMP_KEY, out + n);
+  n += cborHead(0, (uint32_t)t.timestamp, out + n);
+  return n;
+}
+
+size_t cborLoggedSample(const LoggedSample &s, uint8_t *out, size_t cap) {
+  if (cap < TELEMETRY_CBOR_LOGGED_MAX) return 0;
+  size_t n = cborTelemetry(s.data, FIELD_MASK_ALL, out, cap);
+  out[0]++;   // One more pair: the map head is a single byte below 24 pairs
+  n += cborHead(0, TELEMETRY_CBOR_BOOT_KEY, out + n);
+  n += cborHead(0, s.boot, out + n);
+  return n;
+}
+
+// ================= READER =================
+static const char *skipSpace(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+  return p;
+}
+
+// p at the opening quote; copies into out (truncating), returns past the closing quote
+static const char *scanString(const char *p, const char *end, char *out, size_t cap) {
+  size_t n = 0;
+  for (p++; p < end && *p != '"'; p++) {
+    char c = *p;
+    if (c == '\\' && ++p < end) {
+      c = *p;
+      if (c == 'n') c = '\n';
+      else if (c == 'r') c = '\r';
+      else if (c == 't') c = '\t';
+      else if (c == 'u') {   // Non-ASCII isn't expected in these answers
+        p += 4;
+        c = '?';
+      }
+    }
+    if (n + 1 < cap) out[n++] = c;
+  }
+  out[n] = '\0';
+  return p < end ? p + 1 : NULL;
+}
+
+bool jsonScanObject(const char *json, size_t len, JsonMember member, void *ctx) {
+  const char *p   = json;
+  const char *end = json + len;
+  char key[JSON_SCAN_KEY_MAX];
+  char value[JSON_SCAN_VALUE_MAX];
+
+  p = skipSpace(p, end);
+  if (end - p >= 4 && strncmp(p, "null", 4) == 0) return true;
+  if (p == end || *p++ != '{') return false;
+
+  for (;;) {
+    p = skipSpace(p, end);
+    if (p < end && *p == '}') return true;
+    if (p == end || *p != '"' || !(p = scanString(p, end, key, sizeof(key)))) return false;
+    p = skipSpace(p, end);
+    if (p == end || *p++ != ':') return false;
+    p = skipSpace(p, end);
+    if (p == end || *p == '{' || *p == '[') return false;
+
+    bool isString = *p == '"';
+    if (isString) {
+      if (!(p = scanString(p, end, value, sizeof(value)))) return false;
+    } else {
+      size_t n = 0;
+      while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\r' && *p != '\n') {
+        if (n + 1 < sizeof(value)) value[n++] = *p;
+        p++;
+      }
+      value[n] = '\0';
+      if (n == 0) return false;
+    }
+    member(ctx, key, value, isString);
+
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') p++;
+    else if (p == end || *p != '}') return false;
+  }
+}
@@ -0,0 +1,138 @@
+#include "thirst_forecast.h"
+#include <math.h>
+
+// Prior on a fresh fit: parameters unknown (relative to the reading noise,
+// which RLS takes as 1)
+#define FORECAST_P0   100.0f
+#define RATE_CENTER   50.0f    // Rate model regressor is level - 50 % (well-scaled)
+#define WATERING_SETTLE_MS 1800000
+
+// One RLS step for y ≈ theta · x with forgetting factor lambda
+static void rlsStep(float theta[2], float P[2][2], float x0, float x1, float y, float lambda) {
+  float px0 = P[0][0] * x0 + P[0][1] * x1;
+  float px1 = P[1][0] * x0 + P[1][1] * x1;
+  float denom = lambda + x0 * px0 + x1 * px1;
+  float k0 = px0 / denom;
+  float k1 = px1 / denom;
+  float err = y - (theta[0] * x0 + theta[1] * x1);
+  theta[0] += k0 * err;
+  theta[1] += k1 * err;
+
+  // P = (P - k x' P) / lambda, kept symmetric
+  P[0][0] = (P[0][0] - k0 * px0) / lambda;
+  P[0][1] = (P[0][1] - k0 * px1) / lambda;
+  P[1][1] = (P[1][1] - k1 * px1) / lambda;
+  P[1][0] = P[0][1];
+}
+
+static void rlsInit(float theta[2], float P[2][2], float t0, float t1) {
+  theta[0] = t0;
+  theta[1] = t1;
+  P[0][0] = P[1][1] = FORECAST_P0;
+  P[0][1] = P[1][0] = 0.0f;
+}
+
+void ThirstForecaster::reset() {
+  restart(0.0f);
+  rlsInit(rate, rateP, 0.0f, 0.0f);
+  lastMs    = 0;
+  wateredMs = 0;
+  samples   = 0;
+  rateFits  = 0;
+  waterings = 0;
+}
+
+void ThirstForecaster::restart(float level) {
+  rlsInit(theta, P, level, 0.0f);
+  for (int i = 0; i < 4; i++) age[i] = 0.0f;
+}
+
+// Age the weighted moments by dt hours, then add the new sample at age 0
+void ThirstForecaster::ageMoments(float dt) {
+  float a1 = age[1], a2 = age[2];
+  age[3] = cfg.lambda * (age[3] + dt * (3.0f * a2 + dt * (3.0f * a1 + dt * age[0])));
+  age[2] = cfg.lambda * (a2 + dt * (2.0f * a1 + dt * age[0]));
+  age[1] = cfg.lambda * (a1 + dt * age[0]);
+  age[0] = cfg.lambda * age[0] + 1.0f;
+}
+
+// A line fitted to a curve has the curve's slope at t* = -cov(u, u²) / (2 var(u))
+// hours back (u = sample age, same weights as the fit): half the window for
+// equal weights, twice the mean age for exponential ones. The rate model
+// needs the level where that slope was true, not the level now.
+float ThirstForecaster::slopeAge() const {
+  float e1 = age[1] / age[0], e2 = age[2] / age[0], e3 = age[3] / age[0];
+  float var = e2 - e1 * e1;
+  return var > 0.0f ? (e3 - e1 * e2) / (2.0f * var) : 0.0f;
+}
+
+bool ThirstForecaster::update(float y, unsigned long nowMs) {
+  if (samples == 0) {
+    restart(y);
+    lastMs  = nowMs;
+    samples = 1;
+    return false;
+  }
+
+  // Slide the line to now: level += slope * dt, P = F P F' with F = [1 dt; 0 1]
+  float dt = (nowMs - lastMs) / 3600000.0f;
+  lastMs = nowMs;
+  theta[0] += theta[1] * dt;
+  P[0][0] += dt * (2.0f * P[0][1] + dt * P[1][1]);
+  P[0][1] += dt * P[1][1];
+  P[1][0]  = P[0][1];
+
+  if (y - theta[0] > cfg.wateringStep) {
+    // The probe needs a few minutes to settle: steps close together are one watering
+    bool fresh = !wateredMs || nowMs - wateredMs > WATERING_SETTLE_MS;
+    if (fresh) waterings++;
+    wateredMs = nowMs;
+    restart(y);
+    samples = 1;
+    return fresh;
+  }
+
+  // At the current origin the regressor is [1, 0]
+  rlsStep(theta, P, 1.0f, 0.0f, y, cfg.lambda);
+  ageMoments(dt);
+  samples++;
+
+  // Once per rateEvery samples, teach the rate model slope = a + b (level - 50),
+  // with the slope paired to the fitted level at the time it describes
+  if (samples >= cfg.warmup && samples % cfg.rateEvery == 0) {
+    float levelThen = theta[0] - theta[1] * slopeAge();
+    rlsStep(rate, rateP, 1.0f, levelThen - RATE_CENTER, theta[1], cfg.rateLambda);
+    rateFits++;
+  }
+  return false;
+}
+
+ThirstForecast ThirstForecaster::forecast(int moistureLow) const {
+  ThirstForecast f;
+  f.level          = theta[0];
+  f.dryingRate     = -theta[1];
+  f.atMs           = lastMs;
+  f.lastWateredMs  = wateredMs;
+  f.waterings      = waterings;
+  f.hoursToThirsty = NAN;
+
+  if (samples == 0) f.level = f.dryingRate = NAN;   // No reading yet
+  if (samples < cfg.warmup) return f;
+  if (f.level <= moistureLow) {
+    f.hoursToThirsty = 0.0f;
+    return f;
+  }
+  if (f.dryingRate < cfg.minDryingRate) return f;
+
+  // Exponential drydown towards a residual level: d(level)/dt = -k (level - floor),
+  // once the rate model has seen enough of it. Otherwise extrapolate the line.
+  float hours = (f.level - moistureLow) / f.dryingRate;
+  float k     = -rate[1];
+  if (rateFits >= cfg.rateMinFits && k > 0.0f) {
+    float floorLevel = RATE_CENTER + rate[0] / k;
+    if (moistureLow <= floorLevel) return f;   // Levels off before it gets thirsty
+    hours = logf((f.level - floorLevel) / (moistureLow - floorLevel)) / k;
+  }
+  if (hours <= cfg.maxHours) f.hoursToThirsty = hours;
+  return f;
+}
@@ -0,0 +1,66 @@
+#include "threshold_cache.h"
+#include <Preferences.h>
+
+#define NVS_NAMESPACE "thresholds"
+#define NVS_KEY       "last"
+
+static void nvsKey(uint8_t plant, char *out, size_t len) {
+  if (plant == 0) snprintf(out, len, NVS_KEY);
+  else            snprintf(out, len, NVS_KEY "%u", plant);
+}
+
+void packThresholds(const PlantThresholds &th, PackedThresholds &out) {
+  memset(&out, 0, sizeof(out));  // Padding too, so unchanged values compare equal
+  out.version      = THRESHOLD_CACHE_VERSION;
+  out.moistureLow  = th.moistureLow;
+  out.moistureHigh = th.moistureHigh;
+  out.tempHigh     = th.tempHigh;
+  out.tempLow      = th.tempLow;
+  out.luxLow       = th.luxLow;
+  out.luxHigh      = th.luxHigh;
+  out.humidityHigh = th.humidityHigh;
+  out.humidityLow  = th.humidityLow;
+  strlcpy(out.species, th.speciesName, sizeof(out.species));
+}
+
+bool unpackThresholds(const PackedThresholds &p, PlantThresholds &out) {
+  if (p.version != THRESHOLD_CACHE_VERSION) return false;
+  out.moistureLow  = p.moistureLow;
+  out.moistureHigh = p.moistureHigh;
+  out.tempHigh     = p.tempHigh;
+  out.tempLow      = p.tempLow;
+  out.luxLow       = p.luxLow;
+  out.luxHigh      = p.luxHigh;
+  out.humidityHigh = p.humidityHigh;
+  out.humidityLow  = p.humidityLow;
+  strlcpy(out.speciesName, p.species, sizeof(out.speciesName));
+  return true;
+}
+
+bool loadCachedThresholds(uint8_t plant, PlantThresholds &out) {
+  PackedThresholds p;
+  char key[8];
+  nvsKey(plant, key, sizeof(key));
+
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, true);
+  bool ok = prefs.getBytesLength(key) == sizeof(p) &&
+            prefs.getBytes(key, &p, sizeof(p)) == sizeof(p);
+  prefs.end();
+  return ok && unpackThresholds(p, out);
+}
+
+void saveCachedThresholds(uint8_t plant, const PlantThresholds &th) {
+  PackedThresholds p, stored;
+  packThresholds(th, p);
+  char key[8];
+  nvsKey(plant, key, sizeof(key));
+
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  bool same = prefs.getBytesLength(key) == sizeof(stored) &&
+              prefs.getBytes(key, &stored, sizeof(stored)) == sizeof(stored) &&
+              memcmp(&p, &stored, sizeof(p)) == 0;
+  if (!same) prefs.putBytes(key, &p, sizeof(p));
+  prefs.end();
+}
@@ -0,0 +1,255 @@
+#include "tls_session.h"
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include <mbedtls/version.h>
+#include <esp_crt_bundle.h>
+
+// mbedTLS 3.4+ (Arduino core 3) has accessors for these and keeps the fields
+// private; 2.x (core 2) has no accessors and public fields
+static bool handshakeOver(mbedtls_ssl_context *ssl) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03020000
+  return mbedtls_ssl_is_handshake_over(ssl);
+#else
+  return ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER;
+#endif
+}
+
+static size_t sessionId(const mbedtls_ssl_session *s, const unsigned char **id) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03040000
+  *id = mbedtls_ssl_session_get_id(s);
+  return mbedtls_ssl_session_get_id_len(s);
+#else
+  *id = s->id;
+  return s->id_len;
+#endif
+}
+
+TlsSession::TlsSession() {
+  mbedtls_net_init(&net);
+  mbedtls_ssl_init(&ssl);
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&drbg);
+  mbedtls_ssl_session_init(&saved);
+  mbedtls_x509_crt_init(&ca);
+}
+
+TlsSession::~TlsSession() {
+  stop();
+  mbedtls_ssl_session_free(&saved);
+  mbedtls_ssl_config_free(&conf);
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_ctr_drbg_free(&drbg);
+  mbedtls_entropy_free(&entropy);
+}
+
+void TlsSession::setCaCert(const char *pem) {
+  caPem = pem;
+}
+
+// Once: RNG + client config (certificate and host name verified, tickets on)
+bool TlsSession::setup() {
+  if (configured) return true;
+  static const unsigned char PERS[] = "gaia-tls";
+  if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, PERS, sizeof(PERS) - 1) != 0) return false;
+  if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0) return false;
+  mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  if (caPem) {
+    if (mbedtls_x509_crt_parse(&ca, (const unsigned char *)caPem, strlen(caPem) + 1) != 0) {
+      Serial.println("[TLS] CA certificate doesn't parse");
+      return false;
+    }
+    mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+  } else if (esp_crt_bundle_attach(&conf) != ESP_OK) {
+    return false;
+  }
+  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  configured = true;
+  return true;
+}
+
+bool TlsSession::fail() {
+  st.failures++;
+  stop();
+  return false;
+}
+
+void TlsSession::forgetSession() {
+  mbedtls_ssl_session_free(&saved);
+  mbedtls_ssl_session_init(&saved);
+  haveSession = false;
+}
+
+void TlsSession::stop() {
+  if (open) mbedtls_ssl_close_notify(&ssl);
+  mbedtls_ssl_free(&ssl);       // Releases the record buffers
+  mbedtls_ssl_init(&ssl);
+  mbedtls_net_free(&net);
+  open  = false;
+  rxPos = rxLen = 0;
+}
+
+// TCP connect with a deadline (mbedtls_net_connect would wait for lwIP's own timeout)
+static int connectSocket(const char *host, uint16_t port, uint32_t timeoutMs) {
+  struct addrinfo hints = {};
+  struct addrinfo *res = NULL;
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[6];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res) != 0 || !res) return -1;
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(res);
+    return -1;
+  }
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  int rc = connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+
+  if (rc != 0 && errno == EINPROGRESS) {
+    fd_set wr;
+    FD_ZERO(&wr);
+    FD_SET(fd, &wr);
+    struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000 };
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (select(fd + 1, NULL, &wr, NULL, &tv) == 1 &&
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) rc = 0;
+  }
+  if (rc != 0) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, flags);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // Requests are written whole
+  return fd;
+}
+
+bool TlsSession::connect(const char *host, uint16_t port, uint32_t timeoutMs) {
+  stop();
+  st.connects++;
+  if (!setup()) return fail();
+  mbedtls_ssl_conf_read_timeout(&conf, timeoutMs);
+
+  unsigned long start = millis();
+  net.fd = connectSocket(host, port, timeoutMs);
+  if (net.fd < 0) return fail();
+
+  if (mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) return fail();
+  mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, NULL, mbedtls_net_recv_timeout);
+  bool offered = haveSession && mbedtls_ssl_set_session(&ssl, &saved) == 0;
+  unsigned char offeredId[32];
+  size_t        offeredLen = 0;
+  if (offered) {
+    const unsigned char *id;
+    offeredLen = min(sessionId(&saved, &id), sizeof(offeredId));
+    memcpy(offeredId, id, offeredLen);
+  }
+
+  // Stepped so the deadline is checked between messages
+  while (!handshakeOver(&ssl)) {
+    int ret = mbedtls_ssl_handshake_step(&ssl);
+    if (ret == 0 || ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (millis() - start <= timeoutMs) continue;
+    }
+    if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+      char why[96];
+      mbedtls_x509_crt_verify_info(why, sizeof(why), "", mbedtls_ssl_get_verify_result(&ssl));
+      Serial.printf("[TLS] %s: certificate rejected: %s", host, why);
+    }
+    if (offered) forgetSession();   // Don't offer a session that may be what broke it
+    return fail();
+  }
+  uint32_t ms = millis() - start;
+
+  // Remember this session (a fresh ticket, if the server sent one). A server
+  // that accepted the offer echoes its session ID; a full handshake gets a new one.
+  forgetSession();
+  haveSession = mbedtls_ssl_get_session(&ssl, &saved) == 0;
+  const unsigned char *id = NULL;
+  size_t idLen = haveSession ? sessionId(&saved, &id) : 0;
+  bool   full  = !(offeredLen && idLen == offeredLen && memcmp(id, offeredId, idLen) == 0);
+  if (full) {
+    st.fullHandshakes++;
+    st.fullMsTotal += ms;
+  } else {
+    st.resumed++;
+    st.resumedMsTotal += ms;
+  }
+  if (ms > st.handshakeMsMax) st.handshakeMsMax = ms;
+  open = true;
+  return true;
+}
+
+bool TlsSession::stale() {
+  if (!open) return true;
+  if (rxPos < rxLen) return true;
+  return mbedtls_net_poll(&net, MBEDTLS_NET_POLL_READ, 0) > 0;
+}
+
+bool TlsSession::readable() {
+  if (!open) return false;
+  if (rxPos < rxLen || mbedtls_ssl_get_bytes_avail(&ssl) > 0) return true;
+  return mbedtls_net_poll(&net, MBEDTLS_NET_POLL_READ, 0) > 0;
+}
+
+bool TlsSession::write(const uint8_t *data, size_t len) {
+  while (open && len > 0) {
+    int ret = mbedtls_ssl_write(&ssl, data, len);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+    if (ret <= 0) {
+      stop();
+      return false;
+    }
+    data += ret;
+    len  -= ret;
+  }
+  return open;
+}
+
+// Next chunk into rx. A timeout leaves the connection open; anything else closes it.
+bool TlsSession::fill() {
+  if (!open) return false;
+  for (;;) {
+    int ret = mbedtls_ssl_read(&ssl, rx, sizeof(rx));
+    if (ret > 0) {
+      rxPos = 0;
+      rxLen = ret;
+      return true;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+    if (ret != MBEDTLS_ERR_SSL_TIMEOUT) stop();
+    return false;
+  }
+}
+
+size_t TlsSession::readUntil(char term, char *out, size_t max) {
+  size_t n = 0;
+  while (n < max) {
+    if (rxPos == rxLen && !fill()) break;
+    char c = rx[rxPos++];
+    if (c == term) break;
+    out[n++] = c;
+  }
+  return n;
+}
+
+size_t TlsSession::read(uint8_t *out, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    if (rxPos == rxLen && !fill()) break;
+    size_t k = min(len - n, rxLen - rxPos);
+    memcpy(out + n, rx + rxPos, k);
+    rxPos += k;
+    n     += k;
+  }
+  return n;
+}
@@ -0,0 +1,100 @@
+#include "window_stats.h"
+#include "delta_filter.h"
+#include <math.h>
+
+// ================= RUNNING STATS =================
+void RunningStats::reset() {
+  n = 0;
+  min = max = mean = m2 = 0.0f;
+}
+
+void RunningStats::add(float x) {
+  n++;
+  if (n == 1) {
+    min = max = mean = x;
+    m2 = 0.0f;
+    return;
+  }
+  if (x < min) min = x;
+  if (x > max) max = x;
+  float delta = x - mean;
+  mean += delta / n;
+  m2   += delta * (x - mean);
+}
+
+// Chan et al.: combine two disjoint sets' (n, mean, m2)
+void RunningStats::merge(const RunningStats &o) {
+  if (o.n == 0) return;
+  if (n == 0) {
+    *this = o;
+    return;
+  }
+  uint32_t total = n + o.n;
+  float    delta = o.mean - mean;
+  mean += delta * o.n / total;
+  m2   += o.m2 + delta * delta * ((float)n * o.n / total);
+  n     = total;
+  if (o.min < min) min = o.min;
+  if (o.max > max) max = o.max;
+}
+
+float RunningStats::stddev() const {
+  return sqrtf(variance());
+}
+
+// ================= AGGREGATOR =================
+void WindowAggregator::clear() {
+  started = false;
+  for (uint8_t w = 0; w < AGG_WINDOWS; w++) {
+    index[w] = 0;
+    hasClosed[w] = false;
+    for (int f = 0; f < FIELD_COUNT; f++) open[w][f].reset();
+  }
+}
+
+void WindowAggregator::roll(unsigned long nowMs) {
+  if (!started) {
+    started = true;
+    for (uint8_t w = 0; w < AGG_WINDOWS; w++) index[w] = nowMs / lengthMs[w];
+    return;
+  }
+
+  // Minute first: at an hour boundary its last minute must be merged before the hour closes
+  for (uint8_t w = 0; w < AGG_WINDOWS; w++) {
+    uint32_t i = nowMs / lengthMs[w];
+    if (i == index[w]) continue;
+
+    bool any = false;
+    for (int f = 0; f < FIELD_COUNT; f++) any |= open[w][f].n > 0;
+    if (any) {
+      WindowSummary &s = closed[w];
+      s.window   = (AggWindow)w;
+      s.index    = index[w];
+      s.startMs  = index[w] * lengthMs[w];
+      s.lengthMs = lengthMs[w];
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        s.field[f] = open[w][f];
+        if (w + 1 < AGG_WINDOWS) open[w + 1][f].merge(open[w][f]);
+        open[w][f].reset();
+      }
+      hasClosed[w] = true;
+    }
+    index[w] = i;
+  }
+}
+
+void WindowAggregator::add(const Telemetry &t, unsigned long nowMs, uint8_t fields) {
+  roll(nowMs);
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (!(AGG_FIELD_MASK & fields & FIELD_BIT(f))) continue;
+    float v = telemetryFieldValue(t, f);
+    if (!isnan(v)) open[AGG_MINUTE][f].add(v);
+  }
+}
+
+bool WindowAggregator::takeClosed(AggWindow w, WindowSummary &out) {
+  if (!hasClosed[w]) return false;
+  out = closed[w];
+  hasClosed[w] = false;
+  return true;
+}
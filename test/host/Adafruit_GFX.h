@@ -0,0 +1,122 @@
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// The Adafruit_GFX primitives the firmware draws with (pipeline_steps.cpp),
+// on top of a subclass's drawPixel(), so the faces and the status bar can be
+// rasterized on the host (FakeDisplay). Lines, circles and triangles follow
+// the library's algorithms. Text is not the library's font: each character
+// is a solid 5x7 block per text size, which keeps the label's footprint.
+class Adafruit_GFX {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : w(w), h(h) {}
+  virtual ~Adafruit_GFX() {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  int16_t width() const  { return w; }
+  int16_t height() const { return h; }
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+    if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+    int16_t dx = x1 - x0, dy = abs(y1 - y0);
+    int16_t err = dx / 2, ystep = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+      if (steep) drawPixel(y0, x0, color);
+      else       drawPixel(x0, y0, color);
+      err -= dy;
+      if (err < 0) { y0 += ystep; err += dx; }
+    }
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t len, uint16_t color) {
+    for (int16_t i = 0; i < len; i++) drawPixel(x + i, y, color);
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t len, uint16_t color) {
+    for (int16_t i = 0; i < len; i++) drawPixel(x, y + i, color);
+  }
+
+  void drawRect(int16_t x, int16_t y, int16_t rw, int16_t rh, uint16_t color) {
+    drawFastHLine(x, y, rw, color);
+    drawFastHLine(x, y + rh - 1, rw, color);
+    drawFastVLine(x, y, rh, color);
+    drawFastVLine(x + rw - 1, y, rh, color);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t rw, int16_t rh, uint16_t color) {
+    for (int16_t i = 0; i < rh; i++) drawFastHLine(x, y + i, rw, color);
+  }
+
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    int16_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+    drawPixel(x0, y0 + r, color);
+    drawPixel(x0, y0 - r, color);
+    drawPixel(x0 + r, y0, color);
+    drawPixel(x0 - r, y0, color);
+    while (x < y) {
+      if (f >= 0) { y--; ddy += 2; f += ddy; }
+      x++; ddx += 2; f += ddx;
+      drawPixel(x0 + x, y0 + y, color);
+      drawPixel(x0 - x, y0 + y, color);
+      drawPixel(x0 + x, y0 - y, color);
+      drawPixel(x0 - x, y0 - y, color);
+      drawPixel(x0 + y, y0 + x, color);
+      drawPixel(x0 - y, y0 + x, color);
+      drawPixel(x0 + y, y0 - x, color);
+      drawPixel(x0 - y, y0 - x, color);
+    }
+  }
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    for (int16_t dy = -r; dy <= r; dy++) {
+      int16_t dx = (int16_t)sqrtf((float)(r * r - dy * dy));
+      drawFastHLine(x0 - dx, y0 + dy, 2 * dx + 1, color);
+    }
+  }
+
+  // Scanline fill between the edges, like the library's
+  void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    for (int16_t y = y0; y <= y2; y++) {
+      float a = y2 == y0 ? x0 : x0 + (float)(x2 - x0) * (y - y0) / (y2 - y0);
+      float b = y < y1 ? (y1 == y0 ? x0 : x0 + (float)(x1 - x0) * (y - y0) / (y1 - y0))
+                       : (y2 == y1 ? x1 : x1 + (float)(x2 - x1) * (y - y1) / (y2 - y1));
+      if (a > b) std::swap(a, b);
+      drawFastHLine((int16_t)a, y, (int16_t)b - (int16_t)a + 1, color);
+    }
+  }
+
+  // Rows of (w + 7) / 8 bytes, most significant bit first
+  void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t bw, int16_t bh, uint16_t color) {
+    int16_t rowBytes = (bw + 7) / 8;
+    for (int16_t j = 0; j < bh; j++) {
+      for (int16_t i = 0; i < bw; i++) {
+        if (pgm_read_byte(&bitmap[j * rowBytes + i / 8]) & (0x80 >> (i & 7))) drawPixel(x + i, y + j, color);
+      }
+    }
+  }
+
+  void setTextSize(uint8_t s)    { textSize = s ? s : 1; }
+  void setTextColor(uint16_t c)  { textColor = c; }
+  void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+
+  size_t print(const char *s) {
+    size_t n = 0;
+    for (; *s; s++, n++) {
+      if (*s != ' ') fillRect(cursorX, cursorY, 5 * textSize, 7 * textSize, textColor);
+      cursorX += 6 * textSize;
+    }
+    return n;
+  }
+
+protected:
+  int16_t  w, h;
+  int16_t  cursorX = 0, cursorY = 0;
+  uint8_t  textSize  = 1;
+  uint16_t textColor = 1;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino core for the firmware's pure modules
+// (delta_filter, plant_thresholds, face_rules, pipeline_steps, hal.h types)
+// to compile on the host: the native test env (platformio.ini) and the
+// tools/ builds.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+using std::max;
+using std::min;
+
+// The ESP32 newlib has it; glibc only from 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// Log output of the modules under test; silent unless echo is set
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  void print(const char *s)   { if (echo) fputs(s, stdout); }
+  void println(const char *s = "") { if (echo) puts(s); }
+  template <typename T> void print(const T &) {}
+  template <typename T> void println(const T &) {}
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (!echo) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+
+  bool echo = false;
+};
+
+inline HostSerial Serial;
+
+class String {
+public:
+  String(const char *s = "") : s(s ? s : "") {}
+  const char *c_str() const { return s.c_str(); }
+  unsigned    length() const { return s.size(); }
+  bool operator==(const char *o) const { return s == o; }
+  bool operator!=(const char *o) const { return s != o; }
+
+private:
+  std::string s;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+// In-memory stand-in for the Arduino FS/File API, enough for sample_log.cpp.
+// It also keeps a rough model of what LittleFS would do to the flash, so
+// tests can put a number on wear:
+//   - data is programmed as written; every 4 KB block a file grows into
+//     costs one erase
+//   - each close() of a written file, remove() and mkdir() is one metadata
+//     commit of FS_COMMIT_BYTES (plus the data of small inline files); a
+//     metadata pair that fills up is compacted, which erases both blocks
+// LittleFS wear-levels across the whole partition, so erases per block is
+// roughly erases / blocks.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+
+#define FS_BLOCK_BYTES     4096
+#define FS_COMMIT_BYTES    64     // Tag, struct, CRC and padding of one commit
+#define FS_INLINE_MAX      512    // Files this small live in their metadata pair
+#define FS_COMPACTED_BYTES 1024   // A metadata block right after compaction
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FlashStats {
+  uint64_t programmedBytes;
+  uint32_t erases;
+  uint32_t commits;
+};
+
+class FS;
+
+class File {
+public:
+  File() {}
+  File(FS *fs, const std::string &path, bool dir, bool writing) : fs(fs), path(path), dir(dir), writing(writing) {}
+
+  explicit operator bool() const { return fs != NULL; }
+  size_t write(const uint8_t *data, size_t len);
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t read(uint8_t *out, size_t len);
+  int    read() { uint8_t b; return read(&b, 1) == 1 ? b : -1; }
+  bool   seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t size() const;
+  size_t position() const { return pos; }
+  void   close();
+  void   flush() {}
+  bool   isDirectory() const { return dir; }
+  const char *name() const { return path.c_str(); }
+  File   openNextFile();
+
+private:
+  FS         *fs = NULL;
+  std::string path;
+  bool        dir = false;
+  bool        writing = false;
+  bool        wrote = false;
+  size_t      pos = 0;
+  std::string lastChild;   // Directory iteration
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = FILE_READ) {
+    std::string p(path);
+    if (dirs.count(p)) return File(this, p, true, false);
+    if (mode[0] == 'r') return files.count(p) ? File(this, p, false, false) : File();
+    std::string &data = files[p];
+    File f(this, p, false, true);
+    if (mode[0] == 'w') data.clear();
+    else f.seek(data.size());
+    return f;
+  }
+  bool exists(const char *path) const { return files.count(path) || dirs.count(path); }
+  bool mkdir(const char *path) { dirs.insert(path); commit(0); return true; }
+  bool remove(const char *path) {
+    if (!files.erase(path)) return false;
+    commit(0);
+    return true;
+  }
+
+  // Test helpers
+  void reset() { files.clear(); dirs.clear(); stats = FlashStats{ 0, 0, 0 }; metaFill = 0; }
+  std::string &contents(const char *path) { return files[path]; }
+  size_t fileCount() const { return files.size(); }
+
+  FlashStats stats = { 0, 0, 0 };
+
+private:
+  friend class File;
+
+  void program(size_t oldSize, size_t newSize) {
+    if (newSize <= FS_INLINE_MAX) return;   // Inline: written with the commit
+    size_t from = oldSize > FS_INLINE_MAX ? oldSize : 0;
+    stats.programmedBytes += newSize - from;
+    stats.erases += (newSize + FS_BLOCK_BYTES - 1) / FS_BLOCK_BYTES - (from + FS_BLOCK_BYTES - 1) / FS_BLOCK_BYTES;
+  }
+  void commit(size_t inlineBytes) {
+    size_t bytes = FS_COMMIT_BYTES + inlineBytes;
+    stats.commits++;
+    stats.programmedBytes += bytes;
+    metaFill += bytes;
+    if (metaFill > FS_BLOCK_BYTES) {
+      stats.erases += 2;
+      metaFill = FS_COMPACTED_BYTES;
+    }
+  }
+
+  std::map<std::string, std::string> files;
+  std::set<std::string>              dirs;
+  size_t                             metaFill = 0;
+};
+
+inline size_t File::write(const uint8_t *data, size_t len) {
+  if (!fs || dir || !writing) return 0;
+  std::string &f = fs->files[path];
+  size_t before = f.size();
+  if (pos > f.size()) f.resize(pos);
+  f.replace(pos, len < f.size() - pos ? len : f.size() - pos, (const char *)data, len);
+  pos += len;
+  fs->program(before, f.size());
+  wrote = true;
+  return len;
+}
+
+inline size_t File::read(uint8_t *out, size_t len) {
+  if (!fs || dir) return 0;
+  const std::string &f = fs->files[path];
+  size_t n = pos < f.size() ? (len < f.size() - pos ? len : f.size() - pos) : 0;
+  memcpy(out, f.data() + pos, n);
+  pos += n;
+  return n;
+}
+
+inline bool File::seek(uint32_t to, SeekMode mode) {
+  if (!fs || dir) return false;
+  size_t base = mode == SeekSet ? 0 : mode == SeekCur ? pos : size();
+  if (base + to > size()) return false;
+  pos = base + to;
+  return true;
+}
+
+inline size_t File::size() const {
+  if (!fs || dir) return 0;
+  auto it = fs->files.find(path);
+  return it == fs->files.end() ? 0 : it->second.size();
+}
+
+inline void File::close() {
+  if (fs && wrote) {
+    size_t n = size();
+    fs->commit(n <= FS_INLINE_MAX ? n : 0);
+  }
+  fs = NULL;
+}
+
+// Children in name order, full paths (as arduino-esp32 1.x returned them)
+inline File File::openNextFile() {
+  if (!fs || !dir) return File();
+  std::string prefix = path + "/";
+  auto it = lastChild.empty() ? fs->files.lower_bound(prefix) : fs->files.upper_bound(lastChild);
+  if (it == fs->files.end() || it->first.compare(0, prefix.size(), prefix) != 0) return File();
+  lastChild = it->first;
+  return File(fs, it->first, false, false);
+}
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+// The LittleFS global over the in-memory FS of FS.h. Contents survive a
+// "reboot" (a new SampleLog) until the test calls LittleFS.reset().
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+  bool   begin(bool formatOnFail = false) { (void)formatOnFail; return mountable; }
+  size_t totalBytes() const { return partitionBytes; }
+
+  bool   mountable      = true;
+  size_t partitionBytes = 0x160000;   // spiffs partition of default.csv
+};
+
+inline LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef HOST_FAKE_HAL_H
+#define HOST_FAKE_HAL_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "delta_filter.h"
+#include "oled_frame.h"
+#include "plant_rack.h"
+#include "telemetry_json.h"
+
+// ==========================================
+// HAL FAKES (native tests and benchmarks)
+// ==========================================
+// In-memory implementations of the hal.h interfaces. Nothing here sleeps or
+// waits: the test sets what the sensors read, what the network does and
+// what time it is, then checks what the firmware modules did with it.
+
+// Returns reading[plant] field by field. failAir / failLight make the
+// matching reads fail the way the real drivers do (NAN / negative lux).
+class FakeSensors : public SensorHal {
+public:
+  explicit FakeSensors(uint8_t plants = 1) : plants(plants) {
+    for (uint8_t p = 0; p < MAX_PLANTS; p++) reading[p] = Telemetry{ 22.0f, 50.0f, 50, 2300, 500.0f, 0 };
+  }
+
+  bool    begin() override { return true; }
+  uint8_t plantCount() override { return plants; }
+  float   readTemperature(uint8_t p) override { airReads++; return failAir ? NAN : reading[p].temperature; }
+  float   readHumidity(uint8_t p) override    { return failAir ? NAN : reading[p].humidity; }
+  int     readMoistureRaw(uint8_t p) override { soilReads++; return reading[p].soilRaw; }
+  int     readMoisturePercent(uint8_t p) override { return reading[p].soilMoisture; }
+  float   readLux(uint8_t p) override         { lightReads++; return failLight ? -1.0f : reading[p].lux; }
+  unsigned long airReadingMs(uint8_t) override { return nowMs; }
+  bool    beginOneShot() override { return true; }
+  bool    sampleOnce() override   { oneShots++; return !failAir && !failLight; }
+
+  uint8_t       plants;
+  Telemetry     reading[MAX_PLANTS];
+  unsigned long nowMs     = 0;
+  bool          failAir   = false;
+  bool          failLight = false;
+  uint32_t      airReads = 0, soilReads = 0, lightReads = 0, oneShots = 0;
+};
+
+// Draws into a framebuffer in the SSD1306 layout (bit y % 8 of byte
+// (y / 8) * OLED_COLUMNS + x), like Adafruit_SSD1306 does
+class FakeCanvas : public Adafruit_GFX {
+public:
+  explicit FakeCanvas(uint8_t *fb) : Adafruit_GFX(OLED_COLUMNS, OLED_PAGES * 8), fb(fb) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if (x < 0 || x >= w || y < 0 || y >= h) return;
+    uint8_t &b = fb[(y / 8) * OLED_COLUMNS + x];
+    if (color) b |= (uint8_t)(1 << (y & 7));
+    else       b &= (uint8_t)~(1 << (y & 7));
+  }
+
+private:
+  uint8_t *fb;
+};
+
+// A framebuffer plus a copy of what the "panel" shows. writeRegion() copies
+// the span across and counts bus bytes with the same framing as
+// Ssd1306Display (command transaction, then 64-byte data chunks).
+class FakeDisplay : public DisplayHal {
+public:
+  FakeDisplay() : gfx(&fb[0]) { clear(); memset(panel, 0, sizeof(panel)); }
+
+  bool          begin() override { return true; }
+  Adafruit_GFX &canvas() override { return gfx; }
+  void          clear() override { memset(fb, 0, sizeof(fb)); }
+  void          flush() override {
+    memcpy(panel, fb, sizeof(fb));
+    fullFlushes++;
+    bytes += OLED_FULL_FRAME_I2C_BYTES;
+  }
+  uint8_t      *framebuffer() override { return fb; }
+  size_t        writeRegion(uint8_t page, uint8_t col0, uint8_t col1) override {
+    size_t n = col1 - col0 + 1;
+    memcpy(panel + page * OLED_COLUMNS + col0, fb + page * OLED_COLUMNS + col0, n);
+    size_t sent = (2 + 6) + n + 2 * ((n + 63) / 64);
+    regions++;
+    bytes += sent;
+    return sent;
+  }
+
+  alignas(4) uint8_t fb[OLED_FRAME_BYTES];
+  uint8_t      panel[OLED_FRAME_BYTES];
+  FakeCanvas   gfx;
+  uint32_t     regions     = 0;
+  uint32_t     fullFlushes = 0;
+  uint64_t     bytes       = 0;   // Bus bytes, both paths
+};
+
+// Clock and sleep: sleeps just move the clock. deepSleep() returns (a real
+// one restarts the board), so the caller must end its cycle after it.
+class FakePower : public PowerHal {
+public:
+  bool     wokeFromDeepSleep() override { return deepSleeps > 0; }
+  uint64_t nowUs() override { return us; }
+  void     lightSleep(uint32_t ms) override { lightSleeps++; us += (uint64_t)ms * 1000; }
+  void     deepSleep(uint32_t ms) override  { deepSleeps++; us += (uint64_t)ms * 1000; }
+
+  uint64_t us = 0;
+  uint32_t lightSleeps = 0, deepSleeps = 0;
+};
+
+// Accepts every write while `up` (or fails them all), serializes telemetry
+// with the firmware's own writer so a benchmark pays for it, and records
+// what arrived. Backlog batches are checked for order: seq must grow.
+#define FAKE_CLOUD_BODY_MAX 1024
+
+class FakeCloud : public CloudHal {
+public:
+  bool begin() override { return up; }
+  bool linkUp() override { return link; }
+  bool ready() override { return link && up; }
+
+  bool uploadTelemetry(const Telemetry *samples, const uint8_t *fieldMasks, uint8_t plants) override {
+    if (!ready()) return fail();
+    char     prefix[8];
+    JsonOut  out(body, sizeof(body));
+    out.beginObject();
+    for (uint8_t p = 0; p < plants; p++) {
+      lastMasks[p] = fieldMasks[p];
+      if (!fieldMasks[p]) continue;
+      last[p] = samples[p];
+      snprintf(prefix, sizeof(prefix), "p%u/", (unsigned)p);
+      jsonTelemetry(out, prefix, samples[p], fieldMasks[p]);
+    }
+    out.endObject();
+    bodyLen = out.length();
+    bytes  += out.total();
+    telemetryWrites++;
+    return out.finish();
+  }
+
+  bool uploadBacklog(const LoggedSample *samples, size_t count) override {
+    if (!ready()) return fail();
+    for (size_t i = 0; i < count; i++) {
+      if (backlogSamples && samples[i].seq <= lastBacklogSeq) backlogOutOfOrder++;
+      lastBacklogSeq = samples[i].seq;
+      backlogSamples++;
+      bytes += telemetryPayloadBytes(samples[i].data, FIELD_MASK_ALL);
+    }
+    backlogWrites++;
+    return true;
+  }
+
+  bool uploadFaceState(uint8_t plant, const char *face, unsigned long) override {
+    if (!ready()) return fail();
+    faceWrites++;
+    snprintf(lastFace[plant], sizeof(lastFace[plant]), "%s", face);
+    return true;
+  }
+
+  bool uploadSummaries(const WindowSummary *, size_t count) override {
+    if (!ready()) return fail();
+    summaryWrites++;
+    summaries += count;
+    return true;
+  }
+  bool uploadForecasts(const ThirstForecast *, uint8_t) override { return ready() || fail(); }
+  bool uploadHeapStats(const HeapStats &) override               { return ready() || fail(); }
+  bool uploadStageSummaries(const StageSummary *, uint8_t) override { return ready() || fail(); }
+  bool uploadTransportStats(const TransportStats &) override     { return ready() || fail(); }
+  TransportStats transportStats() override { return TransportStats{}; }
+
+  bool requestThresholds(uint8_t plant, const PlantThresholds &current) override {
+    thresholds[plant] = current;
+    requested |= 1u << plant;
+    return ready();
+  }
+  void finishRequests() override {}
+  bool takeThresholds(uint8_t plant, PlantThresholds &out, bool &ok) override {
+    if (!(requested & (1u << plant))) return false;
+    requested &= ~(1u << plant);
+    out = thresholds[plant];
+    ok  = ready();
+    return true;
+  }
+
+  bool beginThresholdStream() override { return ready(); }
+  bool pollThresholdStream(PlantThresholds &) override { return false; }
+  bool thresholdStreamAlive() override { return ready(); }
+  String lastError() override { return String(up ? "" : "fake cloud down"); }
+
+  bool     link = true;
+  bool     up   = true;
+  char     body[FAKE_CLOUD_BODY_MAX];   // Last telemetry body
+  size_t   bodyLen = 0;
+  uint64_t bytes   = 0;                 // Payload bytes accepted
+  uint32_t failures = 0;
+  uint32_t telemetryWrites = 0, backlogWrites = 0, faceWrites = 0, summaryWrites = 0;
+  uint32_t backlogSamples = 0, backlogOutOfOrder = 0, lastBacklogSeq = 0;
+  size_t   summaries = 0;
+  Telemetry last[MAX_PLANTS]      = {};
+  uint8_t   lastMasks[MAX_PLANTS] = {};
+  char      lastFace[MAX_PLANTS][16] = {};
+  PlantThresholds thresholds[MAX_PLANTS];
+  uint32_t  requested = 0;
+
+private:
+  bool fail() { failures++; return false; }
+};
+
+#endif
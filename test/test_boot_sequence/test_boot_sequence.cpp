@@ -0,0 +1,370 @@
+// Non-blocking boot: the BootSequence state machine stepped the way the
+// network task does, with scripted link/backend inputs. Covers the fast join,
+// the fall back to a scan, timeouts and waits, sign-in, the one-time sync,
+// the boot milestones, and the reconnect backoff (bounds, jitter between
+// units, reset on success) under a flapping link or backend.
+
+#include <unity.h>
+#include <math.h>
+#include <set>
+#include "boot_sequence.h"
+#include "gaia_config.h"
+
+#define TICK_MS 100   // Network task wake-up period
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Steps every TICK_MS from `from` until `until` (exclusive) with fixed inputs;
+// returns the first action that isn't NONE, or NONE
+static BootAction stepUntil(BootSequence &b, bool linkUp, bool cloudReady, uint32_t from, uint32_t until,
+                            uint32_t *at = NULL) {
+  for (uint32_t ms = from; ms < until; ms += TICK_MS) {
+    BootAction a = b.step(linkUp, cloudReady, ms);
+    if (a != BOOT_ACT_NONE) {
+      if (at) *at = ms;
+      return a;
+    }
+  }
+  return BOOT_ACT_NONE;
+}
+
+// ---------------- First join ----------------
+void test_cached_ap_joins_fast_then_signs_in(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  TEST_ASSERT_EQUAL_INT(BOOT_START, b.stage());
+
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_FAST, b.step(false, false, 0));
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_FAST, b.stage());
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, stepUntil(b, false, false, TICK_MS, 700));
+
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_AUTH, b.step(true, false, 700));
+  TEST_ASSERT_EQUAL_INT(BOOT_AUTH, b.stage());
+  TEST_ASSERT_EQUAL_UINT32(700, b.metrics.linkMs);
+  TEST_ASSERT_TRUE(b.metrics.fastLink);
+
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, b.step(true, false, 800));
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_SYNC, b.step(true, true, 1500));
+  TEST_ASSERT_TRUE(b.online());
+  TEST_ASSERT_EQUAL_UINT32(1500, b.metrics.cloudMs);
+  TEST_ASSERT_EQUAL_UINT32(2, b.link.attempts);   // The join and the sign-in
+}
+
+void test_no_cache_scans(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_SCAN, b.step(false, false, 0));
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_AUTH, b.step(true, false, 4200));
+  TEST_ASSERT_FALSE(b.metrics.fastLink);
+  TEST_ASSERT_EQUAL_UINT32(4200, b.metrics.linkMs);
+}
+
+void test_stale_cache_falls_back_to_a_scan(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);   // The AP moved to another channel
+  b.step(false, false, 0);
+
+  uint32_t at = 0;
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_SCAN, stepUntil(b, false, false, TICK_MS, 10000, &at));
+  TEST_ASSERT_EQUAL_UINT32(BOOT_TIMEOUTS.fastLinkMs, at);
+  TEST_ASSERT_EQUAL_UINT32(0, b.link.failures);   // Not a failure: the scan is the fallback
+
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_AUTH, b.step(true, false, 6000));
+  TEST_ASSERT_FALSE(b.metrics.fastLink);
+}
+
+void test_cloud_already_ready_goes_straight_online(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  b.step(false, false, 0);
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_SYNC, b.step(true, true, 900));
+  TEST_ASSERT_EQUAL_UINT32(900, b.metrics.linkMs);
+  TEST_ASSERT_EQUAL_UINT32(900, b.metrics.cloudMs);
+}
+
+// ---------------- Timeouts and waits ----------------
+void test_scan_timeout_waits_then_retries(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.step(false, false, 0);
+
+  uint32_t at = 0;
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, stepUntil(b, false, false, TICK_MS, BOOT_TIMEOUTS.scanLinkMs));
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, b.step(false, false, BOOT_TIMEOUTS.scanLinkMs));
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_WAIT, b.stage());
+  TEST_ASSERT_EQUAL_UINT32(1, b.link.failures);
+
+  // First wait: the upper half of backoffMinMs
+  uint32_t wait = b.retryInMs(BOOT_TIMEOUTS.scanLinkMs);
+  TEST_ASSERT_TRUE(wait >= BOOT_TIMEOUTS.backoffMinMs / 2 && wait <= BOOT_TIMEOUTS.backoffMinMs);
+
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_SCAN, stepUntil(b, false, false, BOOT_TIMEOUTS.scanLinkMs + TICK_MS, 60000, &at));
+  TEST_ASSERT_TRUE(at >= BOOT_TIMEOUTS.scanLinkMs + wait && at < BOOT_TIMEOUTS.scanLinkMs + wait + TICK_MS);
+  TEST_ASSERT_EQUAL_UINT32(0, b.retryInMs(at));
+  TEST_ASSERT_EQUAL_UINT32(2, b.link.attempts);
+}
+
+void test_join_that_lands_while_waiting_is_taken(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.step(false, false, 0);
+  b.step(false, false, BOOT_TIMEOUTS.scanLinkMs);   // Timed out...
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_WAIT, b.stage());
+  // ...but the driver finished the join anyway
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_AUTH, b.step(true, false, BOOT_TIMEOUTS.scanLinkMs + TICK_MS));
+  TEST_ASSERT_EQUAL_UINT32(BOOT_TIMEOUTS.scanLinkMs + TICK_MS, b.metrics.linkMs);
+}
+
+void test_sign_in_timeout_and_retry(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  b.step(false, false, 0);
+  b.step(true, false, 500);
+
+  uint32_t at = 0;
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, stepUntil(b, true, false, 600, 500 + BOOT_TIMEOUTS.authRetryMs + TICK_MS, &at));
+  TEST_ASSERT_EQUAL_INT(BOOT_AUTH_WAIT, b.stage());
+  TEST_ASSERT_EQUAL_UINT32(1, b.link.failures);
+
+  uint32_t from = 500 + BOOT_TIMEOUTS.authRetryMs;
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_AUTH, stepUntil(b, true, false, from + TICK_MS, from + BOOT_TIMEOUTS.backoffMinMs + TICK_MS));
+  TEST_ASSERT_EQUAL_INT(BOOT_AUTH, b.stage());
+
+  // The backend can come up during a wait too
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_SYNC, b.step(true, true, 30000));
+  TEST_ASSERT_EQUAL_UINT32(30000, b.metrics.cloudMs);
+}
+
+void test_link_lost_during_sign_in(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  b.step(false, false, 0);
+  b.step(true, false, 500);
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, b.step(false, false, 1000));
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_WAIT, b.stage());
+  // The AP worked a second ago: the retry uses the fast join
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_FAST, stepUntil(b, false, false, 1100, 10000));
+}
+
+// ---------------- Online ----------------
+void test_sync_runs_once(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.step(false, false, 0);
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_SYNC, b.step(true, true, 2000));
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, stepUntil(b, true, true, 2100, 600000));
+  TEST_ASSERT_TRUE(b.online());
+  TEST_ASSERT_EQUAL_UINT32(0, b.retryInMs(600000));
+}
+
+void test_milestones_first_call_wins(void) {
+  BootSequence b(BOOT_TIMEOUTS);
+  b.markFirstFace(0);                   // Before the first tick: 0 would read as "not yet"
+  TEST_ASSERT_EQUAL_UINT32(1, b.metrics.firstFaceMs);
+  b.markFirstFace(250);
+  TEST_ASSERT_EQUAL_UINT32(1, b.metrics.firstFaceMs);
+
+  TEST_ASSERT_EQUAL_UINT32(0, b.metrics.firstUploadMs);
+  b.markFirstUpload(2600);
+  b.markFirstUpload(12600);
+  TEST_ASSERT_EQUAL_UINT32(2600, b.metrics.firstUploadMs);
+}
+
+// ---------------- Backoff ----------------
+// From LINK_SCAN with no AP: time the join out, returning the wait it drew
+// and leaving `now` where the wait began
+static uint32_t failScan(BootSequence &b, uint32_t &now) {
+  now += BOOT_TIMEOUTS.scanLinkMs;
+  b.step(false, false, now);
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_WAIT, b.stage());
+  return b.retryInMs(now);
+}
+
+// Upper bound of the k-th wait in a row (k from 1)
+static uint32_t backoffCeiling(uint8_t k) {
+  uint64_t d = BOOT_TIMEOUTS.backoffMinMs;
+  for (uint8_t i = 1; i < k && d < BOOT_TIMEOUTS.backoffMaxMs; i++) d *= 2;
+  return d < BOOT_TIMEOUTS.backoffMaxMs ? (uint32_t)d : BOOT_TIMEOUTS.backoffMaxMs;
+}
+
+void test_backoff_doubles_within_bounds_and_caps(void) {
+  // 40 failed joins in a row (past the 31 the counter saturates at)
+  BootSequence b(BOOT_TIMEOUTS);
+  uint32_t now = 0;
+  b.step(false, false, now);
+  for (uint8_t k = 1; k <= 40; k++) {
+    uint32_t wait = failScan(b, now);
+    uint32_t d    = backoffCeiling(k);
+    char msg[48];
+    snprintf(msg, sizeof(msg), "failure %u: wait %lu", k, (unsigned long)wait);
+    TEST_ASSERT_TRUE_MESSAGE(wait >= d / 2 && wait <= d, msg);
+    // Nothing happens before the wait is over, the rejoin right at it
+    TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, b.step(false, false, now + wait - 1));
+    TEST_ASSERT_EQUAL_UINT32(1, b.retryInMs(now + wait - 1));
+    now += wait;
+    TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_SCAN, b.step(false, false, now));
+  }
+  TEST_ASSERT_EQUAL_UINT32(BOOT_TIMEOUTS.backoffMaxMs, backoffCeiling(40));
+  TEST_ASSERT_EQUAL_UINT32(40, b.link.failures);
+  TEST_ASSERT_EQUAL_UINT32(41, b.link.attempts);
+}
+
+void test_jitter_spreads_units_over_the_upper_half(void) {
+  // 200 units (one seed each) that lost the same AP at the same instant:
+  // their 5th waits are spread evenly over [d/2, d]
+  const uint8_t k = 5;
+  const uint32_t d = backoffCeiling(k);
+  std::set<uint32_t> distinct;
+  double sum = 0;
+  uint32_t lowerQuarter = 0, upperQuarter = 0;
+  for (uint32_t unit = 1; unit <= 200; unit++) {
+    BootSequence b(BOOT_TIMEOUTS);
+    b.setSeed(unit * 2654435761u);
+    uint32_t now = 0, wait = 0;
+    b.step(false, false, now);
+    for (uint8_t i = 1; i <= k; i++) {
+      wait = failScan(b, now);
+      now += wait;
+      b.step(false, false, now);
+    }
+    distinct.insert(wait);
+    sum += wait;
+    lowerQuarter += wait < d / 2 + d / 8;
+    upperQuarter += wait > d - d / 8;
+  }
+  printf("# wait %u of %lu ms: mean %.0f, %u distinct of 200\n", k, (unsigned long)d, sum / 200,
+    (unsigned)distinct.size());
+  TEST_ASSERT_TRUE(distinct.size() >= 190);
+  TEST_ASSERT_TRUE(fabs(sum / 200 - 0.75 * d) < 0.05 * d);
+  TEST_ASSERT_TRUE(lowerQuarter > 25 && upperQuarter > 25);   // 50 each if uniform
+}
+
+void test_same_seed_same_waits(void) {
+  BootSequence a(BOOT_TIMEOUTS), b(BOOT_TIMEOUTS), c(BOOT_TIMEOUTS);
+  a.setSeed(1234);
+  b.setSeed(1234);
+  c.setSeed(0);   // Ignored: keeps the default seed, like an unseeded unit
+  uint32_t ta = 0, tb = 0, tc = 0;
+  a.step(false, false, 0);
+  b.step(false, false, 0);
+  c.step(false, false, 0);
+  bool differs = false;
+  for (int i = 0; i < 6; i++) {
+    uint32_t wa = failScan(a, ta), wb = failScan(b, tb), wc = failScan(c, tc);
+    TEST_ASSERT_EQUAL_UINT32(wa, wb);
+    differs |= wa != wc;
+    a.step(false, false, ta += wa);
+    b.step(false, false, tb += wb);
+    c.step(false, false, tc += wc);
+  }
+  TEST_ASSERT_TRUE(differs);
+}
+
+void test_reaching_online_resets_the_backoff(void) {
+  // Five failures escalate the wait; once online, the next drop starts over
+  BootSequence b(BOOT_TIMEOUTS);
+  uint32_t now = 0;
+  b.step(false, false, now);
+  for (int i = 0; i < 5; i++) {
+    now += failScan(b, now);
+    b.step(false, false, now);
+  }
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_SYNC, b.step(true, true, now += TICK_MS));
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_NONE, b.step(false, false, now += 60000));
+  TEST_ASSERT_EQUAL_INT(BOOT_LINK_WAIT, b.stage());
+  uint32_t wait = b.retryInMs(now);
+  TEST_ASSERT_TRUE(wait >= BOOT_TIMEOUTS.backoffMinMs / 2 && wait <= BOOT_TIMEOUTS.backoffMinMs);
+  // The AP was joined before: the retry is a fast join
+  TEST_ASSERT_EQUAL_INT(BOOT_ACT_CONNECT_FAST, b.step(false, false, now + wait));
+}
+
+// ---------------- Flaps ----------------
+void test_flapping_link(void) {
+  // 20 cycles of 30 s with the AP, then 5 s without, and 10 s to settle;
+  // stepped every tick
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  uint32_t drops = 0, syncs = 0, connects = 0, auths = 0;
+  const uint32_t cycle = 35000, up = 30000, end = 20 * cycle + 10000;
+  for (uint32_t ms = 0; ms < end; ms += TICK_MS) {
+    bool linkUp = ms >= 20 * cycle || ms % cycle < up;
+    bool wasOnline = b.online();
+    BootAction a = b.step(linkUp, linkUp, ms);
+    drops    += wasOnline && !b.online();
+    syncs    += a == BOOT_ACT_SYNC;
+    connects += a == BOOT_ACT_CONNECT_FAST || a == BOOT_ACT_CONNECT_SCAN;
+    auths    += a == BOOT_ACT_AUTH;
+    TEST_ASSERT_TRUE(b.retryInMs(ms) <= BOOT_TIMEOUTS.backoffMinMs * 4);   // 5 s outages never escalate far
+  }
+  TEST_ASSERT_TRUE(b.online());
+  TEST_ASSERT_EQUAL_UINT32(20, drops);
+  TEST_ASSERT_EQUAL_UINT32(20, b.link.drops);
+  TEST_ASSERT_EQUAL_UINT32(21, syncs);          // Re-synced after every drop
+  TEST_ASSERT_EQUAL_UINT32(0, auths);           // The sign-in survived every time
+  TEST_ASSERT_EQUAL_UINT32(20, b.link.reconnectMs.count());
+  // Each outage: 5 s of no AP, then up to one backoff wait (and a tick) past it
+  TEST_ASSERT_TRUE(b.link.longestOutageMs >= cycle - up);
+  TEST_ASSERT_TRUE(b.link.longestOutageMs <= cycle - up + BOOT_TIMEOUTS.backoffMinMs * 4 + TICK_MS);
+  TEST_ASSERT_TRUE(b.link.uptime() > 0.7f && b.link.uptime() < (float)up / cycle + 0.01f);
+  TEST_ASSERT_EQUAL_UINT32(connects, b.link.attempts);
+  TEST_ASSERT_EQUAL_UINT32(end - TICK_MS - b.metrics.cloudMs, (uint32_t)b.link.trackedMs);
+}
+
+void test_flapping_backend(void) {
+  // The link stays up while the backend goes away for 20 s of every minute
+  // (ten times, then back for good): waits in AUTH_WAIT and signs in again,
+  // never rejoins the AP
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  uint32_t connects = 0, auths = 0;
+  for (uint32_t ms = 0; ms < 11 * 60000; ms += TICK_MS) {
+    bool cloudReady = ms >= 10 * 60000 || ms % 60000 < 40000;
+    BootAction a = b.step(true, cloudReady, ms);
+    connects += a == BOOT_ACT_CONNECT_FAST || a == BOOT_ACT_CONNECT_SCAN;
+    auths    += a == BOOT_ACT_AUTH;
+    if (!cloudReady && ms % 60000 > 40000) TEST_ASSERT_TRUE(b.stage() == BOOT_AUTH_WAIT || b.stage() == BOOT_AUTH);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, connects);   // The boot's
+  TEST_ASSERT_EQUAL_UINT32(10, b.link.drops);
+  TEST_ASSERT_TRUE(auths >= 10);           // At least one sign-in per outage, after its wait
+  TEST_ASSERT_TRUE(b.online());
+  TEST_ASSERT_EQUAL_UINT32(10, b.link.reconnectMs.count());
+}
+
+// ---------------- A boot with a dead network ----------------
+void test_face_never_waits_for_the_network(void) {
+  // The network task's steps are all instant; nothing in the machine blocks,
+  // so a minute with no AP is just 600 quick steps and a few connect actions
+  BootSequence b(BOOT_TIMEOUTS);
+  b.setCachedAp(true);
+  b.markFirstFace(40);
+  uint32_t connects = 0;
+  for (uint32_t ms = 0; ms < 60000; ms += TICK_MS) {
+    BootAction a = b.step(false, false, ms);
+    connects += a == BOOT_ACT_CONNECT_FAST || a == BOOT_ACT_CONNECT_SCAN;
+  }
+  TEST_ASSERT_EQUAL_UINT32(40, b.metrics.firstFaceMs);
+  TEST_ASSERT_EQUAL_UINT32(0, b.metrics.linkMs);
+  TEST_ASSERT_FALSE(b.online());
+  TEST_ASSERT_EQUAL_UINT32(connects, b.link.attempts);
+  TEST_ASSERT_TRUE(connects >= 4 && connects <= 8);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cached_ap_joins_fast_then_signs_in);
+  RUN_TEST(test_no_cache_scans);
+  RUN_TEST(test_stale_cache_falls_back_to_a_scan);
+  RUN_TEST(test_cloud_already_ready_goes_straight_online);
+  RUN_TEST(test_scan_timeout_waits_then_retries);
+  RUN_TEST(test_join_that_lands_while_waiting_is_taken);
+  RUN_TEST(test_sign_in_timeout_and_retry);
+  RUN_TEST(test_link_lost_during_sign_in);
+  RUN_TEST(test_sync_runs_once);
+  RUN_TEST(test_milestones_first_call_wins);
+  RUN_TEST(test_face_never_waits_for_the_network);
+  RUN_TEST(test_backoff_doubles_within_bounds_and_caps);
+  RUN_TEST(test_jitter_spreads_units_over_the_upper_half);
+  RUN_TEST(test_same_seed_same_waits);
+  RUN_TEST(test_reaching_online_resets_the_backoff);
+  RUN_TEST(test_flapping_link);
+  RUN_TEST(test_flapping_backend);
+  return UNITY_END();
+}
@@ -0,0 +1,187 @@
+// Cycle-time benchmark of the sample → face → frame → upload path, run
+// against the HAL fakes. Each tick calls the same pipeline steps as the
+// firmware's tasks (pipeline_steps.h), with the firmware's configuration
+// (gaia_config.h); only the FreeRTOS hand-offs between the tasks are left out:
+//   sensor   sensorTask: due reads, held values, window stats, face rules, scene
+//   screen   animTask: new scene's status bar, then a tick's worth of frames
+//   upload   networkTask: closed windows + minute means (LIVE_UPLOADS 0), or
+//            the delta-filtered sample as well (LIVE_UPLOADS 1)
+// A compressed day (temperature, humidity and light swings, one soil
+// drydown and a watering) is replayed for BENCH_TICKS one-second ticks.
+// Per-iteration latency percentiles are printed; the test fails when the
+// p99 of a whole iteration goes over BENCH_BUDGET_US, so a regression shows
+// up on a Linux CI box before it reaches a board.
+
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include "fake_hal.h"
+#include "gaia_config.h"
+#include "pipeline_steps.h"
+
+#ifndef BENCH_TICKS
+#define BENCH_TICKS     7200   // Two hours of 1 s ticks, one compressed day
+#endif
+#ifndef BENCH_PLANTS
+#define BENCH_PLANTS    4
+#endif
+#ifndef BENCH_BUDGET_US
+#define BENCH_BUDGET_US 1000   // p99 of one iteration on the host
+#endif
+#define BENCH_FRAMES_PER_TICK (SAMPLE_PERIOD_MS / ANIM_CONFIG.frameMs)
+
+enum BenchStage { B_SENSOR = 0, B_SCREEN, B_UPLOAD, B_ITERATION, B_STAGES };
+static const char *const STAGE_LABEL[B_STAGES] = { "sensor", "screen", "upload", "iteration" };
+
+static uint32_t    samplesNs[B_STAGES][BENCH_TICKS];
+static FakeDisplay screen;
+static FaceCache   faces;
+static SceneSelector scenes;
+
+static const char *const PLANT_IDS[] = { "gaia_01", "gaia_02", "gaia_03", "gaia_04",
+                                         "gaia_05", "gaia_06", "gaia_07", "gaia_08" };
+
+static void renderFace(int face) {
+  drawFace(screen.canvas(), face);
+}
+
+// onFaceChanged() without the log line
+static void onFaceChanged(const FaceEvent &ev) {
+  if (ev.plant == scenes.shown()) scenes.markDirty();
+}
+
+static uint32_t rng = 12345;
+static float noise(float amplitude) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return amplitude * ((rng % 2001) / 1000.0f - 1.0f);
+}
+
+// The plant's environment at tick i: one day squeezed into BENCH_TICKS
+static void traceAt(uint32_t i, uint8_t p, Telemetry &t) {
+  float day = (float)i / BENCH_TICKS;
+  float sun = sinf(2.0f * (float)M_PI * (day - 0.25f));
+  t.temperature  = 22.0f + 9.5f * sun + p * 0.5f + noise(0.3f);
+  t.humidity     = 55.0f - 28.0f * sun + noise(1.0f);
+  t.lux          = sun > 0 ? 2400.0f * sun + noise(20.0f) : 0.0f;
+  float dry      = day < 0.8f ? 70.0f - 50.0f * day : 70.0f;   // Watered at 80 %
+  t.soilMoisture = (int)(dry - p * 3 + noise(0.6f));
+  t.soilRaw      = 3500 - t.soilMoisture * 23;
+}
+
+static uint32_t elapsedNs(std::chrono::steady_clock::time_point since) {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+static uint32_t percentileNs(uint32_t *v, size_t n, float q) {
+  size_t k = (size_t)(q * (n - 1) + 0.5f);
+  std::nth_element(v, v + k, v + n);
+  return v[k];
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_cycle_latency(void) {
+  FakeSensors      sensors(BENCH_PLANTS);
+  FakeCloud        cloud;
+  SensorScheduler  sched;
+  WindowAggregator aggregators[MAX_PLANTS];
+  FaceClassifier   classifier;
+  PlantRack        rack;
+  ThresholdSet     thresholds;
+  StatusLabel      labels[MAX_PLANTS];
+  DeltaFilter      filters[MAX_PLANTS];
+  FrameFlusher     flusher;
+  FaceAnimator     animator(faces, ANIM_CONFIG);
+  WindowSummary    pending[STATS_PENDING_MAX];
+  size_t           pendingCount = 0;
+
+  // What setup() does
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) {
+    thresholds.plant[p] = PLANT_THRESHOLDS_DEFAULT;
+    filters[p]          = DeltaFilter(DELTA_CONFIG);
+    aggregators[p]      = WindowAggregator(STATS_MINUTE_MS, STATS_HOUR_MS);
+  }
+  for (uint8_t p = 0; p < BENCH_PLANTS; p++) layoutStatusLabel(labels[p], p, BENCH_PLANTS, PLANT_IDS[p], thresholds.plant[p]);
+  rackSetThresholds(rack, thresholds);
+  sched.configure(SENSE_CONFIG, BENCH_PLANTS, SAMPLE_PERIOD_MS);
+  scenes.configure(BENCH_PLANTS, OLED_PLANT_PERIOD_MS);
+  faces.build(screen, renderFace);
+  classifier.subscribe(onFaceChanged);
+
+  uint32_t faceChanges = 0, scenesShown = 0, uploads = 0;
+  for (uint32_t i = 0; i < BENCH_TICKS; i++) {
+    unsigned long now = i * (unsigned long)SAMPLE_PERIOD_MS;
+    for (uint8_t p = 0; p < BENCH_PLANTS; p++) traceAt(i, p, sensors.reading[p]);
+    sensors.nowMs = now;
+
+    // --- sensorTask ---
+    auto          t0 = std::chrono::steady_clock::now();
+    RackSample    sample;
+    uint8_t       fresh[MAX_PLANTS];
+    WindowSummary closed[MAX_PLANTS * AGG_WINDOWS];
+    ScreenScene   scene;
+    readDueSensors(sensors, sched, rack, BENCH_PLANTS, now, sample, fresh);
+    size_t closedCount = foldIntoWindows(aggregators, sample, fresh, 1, closed);
+    if (classifyRack(rack, classifier, sample, now)) faceChanges++;
+    bool newScene = scenes.select(classifier, labels, cloud.linkUp(), 85, now, scene);
+    samplesNs[B_SENSOR][i] = elapsedNs(t0);
+
+    // --- animTask: one tick of frames ---
+    auto t1 = std::chrono::steady_clock::now();
+    if (newScene) {
+      showScene(screen, animator, scene, now);
+      scenesShown++;
+    }
+    for (int f = 0; f < BENCH_FRAMES_PER_TICK; f++) {
+      if (animator.render(now + f * ANIM_CONFIG.frameMs, screen.framebuffer())) flusher.flush(screen);
+    }
+    samplesNs[B_SCREEN][i] = elapsedNs(t1);
+
+    // --- networkTask ---
+    auto t2 = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < closedCount; c++) queueSummary(pending, pendingCount, STATS_PENDING_MAX, closed[c]);
+    if (pendingCount && uploadWindows(cloud, pending, pendingCount, BENCH_PLANTS)) {
+      pendingCount = 0;
+      uploads++;
+    }
+#if LIVE_UPLOADS
+    uint8_t fields[MAX_PLANTS];
+    if (uploadChanges(cloud, filters, sample, now, fields) == CHANGES_SENT) uploads++;
+#endif
+    samplesNs[B_UPLOAD][i]    = elapsedNs(t2);
+    samplesNs[B_ITERATION][i] = samplesNs[B_SENSOR][i] + samplesNs[B_SCREEN][i] + samplesNs[B_UPLOAD][i];
+  }
+
+  printf("# %d tick(s), %d plant(s), %d frames/tick, LIVE_UPLOADS %d | %lu face change(s), %lu scene(s), "
+         "%lu upload(s), %lu of %lu frame(s) drawn, %.0f I2C B/drawn frame\n",
+    BENCH_TICKS, BENCH_PLANTS, (int)BENCH_FRAMES_PER_TICK, LIVE_UPLOADS, (unsigned long)faceChanges,
+    (unsigned long)scenesShown, (unsigned long)uploads,
+    (unsigned long)flusher.frames, (unsigned long)BENCH_TICKS * BENCH_FRAMES_PER_TICK,
+    flusher.frames ? (double)flusher.i2cBytes / flusher.frames : 0.0);
+  printf("%-10s %9s %9s %9s %9s\n", "stage", "p50 us", "p95 us", "p99 us", "max us");
+  uint32_t p99[B_STAGES];
+  for (int s = 0; s < B_STAGES; s++) {
+    uint32_t *v = samplesNs[s];
+    uint32_t p50 = percentileNs(v, BENCH_TICKS, 0.50f);
+    uint32_t p95 = percentileNs(v, BENCH_TICKS, 0.95f);
+    p99[s]       = percentileNs(v, BENCH_TICKS, 0.99f);
+    uint32_t mx  = *std::max_element(v, v + BENCH_TICKS);
+    printf("%-10s %9.1f %9.1f %9.1f %9.1f\n", STAGE_LABEL[s], p50 / 1000.0, p95 / 1000.0, p99[s] / 1000.0, mx / 1000.0);
+  }
+
+  // The trace must actually exercise the path being timed
+  TEST_ASSERT_GREATER_THAN_UINT32(2, faceChanges);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, uploads);
+  TEST_ASSERT_LESS_THAN_UINT32(BENCH_TICKS, uploads);
+  TEST_ASSERT_EQUAL_MEMORY(screen.framebuffer(), screen.panel, OLED_FRAME_BYTES);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(BENCH_BUDGET_US * 1000UL, p99[B_ITERATION]);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cycle_latency);
+  return UNITY_END();
+}
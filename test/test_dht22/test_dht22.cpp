@@ -0,0 +1,238 @@
+// DHT22 pulse-train decoding: good frames at the edges of the timing
+// windows, and the ways a capture goes wrong - truncated, corrupted,
+// mistimed or with glitches the RMT filter (< 1.25 µs) let through.
+
+#include <unity.h>
+#include <math.h>
+#include "dht22_decoder.h"
+
+#define MAX_PULSES 100
+
+struct Train {
+  DhtPulse p[MAX_PULSES];
+  size_t   n = 0;
+
+  void add(uint8_t level, uint16_t us) { if (n < MAX_PULSES) p[n++] = { level, us }; }
+};
+
+// Line timings for one frame; zeros/ones are the HIGH widths of each bit
+struct Timing {
+  uint16_t respLow, respHigh, bitLow, zero, one;
+};
+static const Timing NOMINAL = { 80, 80, 50, 27, 70 };
+
+static void frame(const uint8_t bytes[5], Train &t, const Timing &tm = NOMINAL) {
+  t.n = 0;
+  t.add(1, 30);                  // Line released after the start pulse
+  t.add(0, tm.respLow);
+  t.add(1, tm.respHigh);
+  for (int bit = 0; bit < 40; bit++) {
+    t.add(0, tm.bitLow);
+    t.add(1, (bytes[bit / 8] >> (7 - bit % 8)) & 1 ? tm.one : tm.zero);
+  }
+}
+
+// RH and T in tenths; T negative sets the sign bit
+static void encode(int rhTenths, int tTenths, uint8_t b[5]) {
+  uint16_t t = tTenths < 0 ? (uint16_t)(-tTenths) | 0x8000 : (uint16_t)tTenths;
+  b[0] = rhTenths >> 8;
+  b[1] = rhTenths & 0xFF;
+  b[2] = t >> 8;
+  b[3] = t & 0xFF;
+  b[4] = (uint8_t)(b[0] + b[1] + b[2] + b[3]);
+}
+
+static uint32_t rng = 7;
+static uint32_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------- Good frames ----------------
+void test_decode_values(void) {
+  static const int CASES[][2] = { { 652, 351 }, { 0, 0 }, { 1000, 800 }, { 215, -101 }, { 999, -400 } };
+  for (const auto &c : CASES) {
+    uint8_t b[5];
+    Train   t;
+    DhtReading r;
+    encode(c[0], c[1], b);
+    frame(b, t);
+    TEST_ASSERT_EQUAL_INT(DHT_OK, dht22Decode(t.p, t.n, r));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, c[0] / 10.0f, r.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, c[1] / 10.0f, r.temperature);
+  }
+}
+
+void test_decode_bits_at_the_window_edges(void) {
+  uint8_t b[5] = { 0xA5, 0x0F, 0x81, 0x7E, 0 };
+  b[4] = (uint8_t)(b[0] + b[1] + b[2] + b[3]);
+  static const Timing EDGES[] = {
+    { 60, 110, 30, 10, 49 },    // Shortest accepted, 49 µs is still a 1
+    { 110, 60, 85, 48, 95 },    // Longest accepted, 48 µs is still a 0
+  };
+  for (const Timing &tm : EDGES) {
+    Train   t;
+    uint8_t out[5];
+    frame(b, t, tm);
+    TEST_ASSERT_EQUAL_INT(DHT_OK, dhtDecodeBits(t.p, t.n, out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(b, out, 5);
+  }
+}
+
+void test_noise_before_the_response_is_skipped(void) {
+  uint8_t b[5];
+  Train   t, noisy;
+  DhtReading r;
+  encode(500, 200, b);
+  frame(b, t);
+  noisy.add(0, 20);     // Start pulse tail, a short bounce, then the frame
+  noisy.add(1, 5);
+  noisy.add(0, 150);
+  for (size_t i = 0; i < t.n; i++) noisy.add(t.p[i].level, t.p[i].us);
+  TEST_ASSERT_EQUAL_INT(DHT_OK, dht22Decode(noisy.p, noisy.n, r));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, r.humidity);
+}
+
+// ---------------- Broken captures ----------------
+void test_truncated_frames(void) {
+  uint8_t b[5];
+  Train   t;
+  DhtReading r;
+  encode(652, 351, b);
+  frame(b, t);
+  // Every cut after the response is short; before it there is no response
+  for (size_t keep = 0; keep < t.n; keep++) {
+    DhtStatus s = dht22Decode(t.p, keep, r);
+    TEST_ASSERT_EQUAL_INT(keep < 3 ? DHT_ERR_NO_RESPONSE : DHT_ERR_SHORT, s);
+    TEST_ASSERT_TRUE(isnan(r.temperature) && isnan(r.humidity));
+  }
+  TEST_ASSERT_EQUAL_INT(DHT_ERR_NO_RESPONSE, dht22Decode(t.p, 0, r));
+}
+
+void test_bad_checksums(void) {
+  uint8_t b[5];
+  Train   t;
+  DhtReading r;
+  encode(652, 351, b);
+  // Any single flipped bit, data or checksum, is caught
+  for (int bit = 0; bit < 40; bit++) {
+    uint8_t bad[5];
+    memcpy(bad, b, 5);
+    bad[bit / 8] ^= 0x80 >> (bit % 8);
+    frame(bad, t);
+    TEST_ASSERT_EQUAL_INT(DHT_ERR_CHECKSUM, dht22Decode(t.p, t.n, r));
+    TEST_ASSERT_TRUE(isnan(r.temperature));
+  }
+}
+
+void test_out_of_range_values(void) {
+  static const int CASES[][2] = { { 1001, 200 }, { 200, 801 }, { 200, -401 }, { 0xFFFF, 0 } };
+  for (const auto &c : CASES) {
+    uint8_t b[5];
+    Train   t;
+    DhtReading r;
+    encode(c[0], c[1], b);
+    frame(b, t);
+    TEST_ASSERT_EQUAL_INT(DHT_ERR_RANGE, dht22Decode(t.p, t.n, r));
+    TEST_ASSERT_TRUE(isnan(r.humidity));
+  }
+}
+
+void test_out_of_range_pulse_widths(void) {
+  uint8_t b[5];
+  DhtReading r;
+  encode(652, 351, b);
+
+  // Response outside 60..110 µs: not recognized at all
+  static const Timing NO_RESPONSE[] = { { 59, 80, 50, 27, 70 }, { 80, 111, 50, 27, 70 } };
+  for (const Timing &tm : NO_RESPONSE) {
+    Train t;
+    frame(b, t, tm);
+    TEST_ASSERT_EQUAL_INT(DHT_ERR_NO_RESPONSE, dht22Decode(t.p, t.n, r));
+  }
+
+  // One bit pulse just outside its window, at every position
+  static const uint16_t LOWS[]  = { 29, 86 };
+  static const uint16_t HIGHS[] = { 9, 96 };
+  Train good;
+  frame(b, good);
+  for (size_t i = 3; i < good.n; i++) {
+    const uint16_t *bad = good.p[i].level ? HIGHS : LOWS;
+    for (int k = 0; k < 2; k++) {
+      Train t = good;
+      t.p[i].us = bad[k];
+      TEST_ASSERT_EQUAL_INT(DHT_ERR_TIMING, dht22Decode(t.p, t.n, r));
+    }
+  }
+}
+
+void test_glitch_pulses_never_decode(void) {
+  uint8_t b[5];
+  Train   good;
+  encode(652, 351, b);
+  frame(b, good);
+
+  // A 1-9 µs spike of the other level splitting any bit pulse (what an
+  // unfiltered capture of a noisy line looks like) must never be read as a
+  // shifted frame. Only a spike in the very last HIGH can pass: the bit is
+  // complete by then, and its first part still says 0 or 1 correctly (or
+  // the checksum bit flips).
+  for (size_t i = 3; i < good.n; i++) {
+    for (int trial = 0; trial < 8; trial++) {
+      const DhtPulse &victim = good.p[i];
+      uint16_t glitch = 1 + nextRand() % 9;
+      uint16_t before = 1 + nextRand() % (victim.us - 1);
+      Train t;
+      for (size_t k = 0; k < i; k++) t.add(good.p[k].level, good.p[k].us);
+      t.add(victim.level, before);
+      t.add(!victim.level, glitch);
+      t.add(victim.level, victim.us - before);
+      for (size_t k = i + 1; k < good.n; k++) t.add(good.p[k].level, good.p[k].us);
+
+      DhtReading r;
+      if (dht22Decode(t.p, t.n, r) == DHT_OK) {
+        TEST_ASSERT_EQUAL_size_t(good.n - 1, i);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.2f, r.humidity);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 35.1f, r.temperature);
+      } else {
+        TEST_ASSERT_TRUE(isnan(r.temperature));
+      }
+    }
+  }
+}
+
+void test_level_mismatch(void) {
+  uint8_t b[5];
+  Train   t;
+  DhtReading r;
+  encode(652, 351, b);
+  frame(b, t);
+  t.p[20].level ^= 1;   // Two highs in a row (a merged or dropped edge)
+  TEST_ASSERT_EQUAL_INT(DHT_ERR_TIMING, dht22Decode(t.p, t.n, r));
+}
+
+void test_status_names(void) {
+  TEST_ASSERT_EQUAL_STRING("ok", dhtStatusName(DHT_OK));
+  TEST_ASSERT_EQUAL_STRING("checksum", dhtStatusName(DHT_ERR_CHECKSUM));
+  TEST_ASSERT_EQUAL_STRING("?", dhtStatusName((DhtStatus)99));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_values);
+  RUN_TEST(test_decode_bits_at_the_window_edges);
+  RUN_TEST(test_noise_before_the_response_is_skipped);
+  RUN_TEST(test_truncated_frames);
+  RUN_TEST(test_bad_checksums);
+  RUN_TEST(test_out_of_range_values);
+  RUN_TEST(test_out_of_range_pulse_widths);
+  RUN_TEST(test_glitch_pulses_never_decode);
+  RUN_TEST(test_level_mismatch);
+  RUN_TEST(test_status_names);
+  return UNITY_END();
+}
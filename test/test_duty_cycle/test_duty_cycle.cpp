@@ -0,0 +1,229 @@
+// Low-power duty cycle: when the radio comes up, how long each sleep is and
+// which kind, the scheduler clock against a FakePower clock over a day, and
+// the energy ledger against a hand computation.
+
+#include <unity.h>
+#include "fake_hal.h"
+#include "duty_cycle.h"
+#include "gaia_config.h"
+
+#define DAY_MS        (24ULL * 3600 * 1000)
+#define AWAKE_US      150700    // One sample + OLED, not a whole number of ms
+#define RADIO_US      2300400   // WiFi association + TLS + one write
+
+static DutyCycleState state;
+
+void setUp(void) { memset(&state, 0xA5, sizeof(state)); }   // RTC garbage after power-on
+void tearDown(void) {}
+
+// One wake the way lowPowerLoop() runs it: sample, maybe upload, sleep
+struct Wake {
+  uint64_t  startUs;
+  bool      upload;
+  SleepPlan sleep;
+};
+
+static Wake runWake(DutyCycle &duty, FakePower &power, size_t &pending, bool urgent, bool cloudUp) {
+  Wake w;
+  w.startUs = power.us;
+  power.us += AWAKE_US;
+  pending++;
+  w.upload = duty.uploadDue(pending, urgent, (uint32_t)(power.us - w.startUs));
+  uint32_t radioUs = 0;
+  if (w.upload) {
+    power.us += RADIO_US;
+    radioUs = RADIO_US;
+    if (cloudUp) pending = 0;
+  }
+  w.sleep = duty.finish(w.upload, w.upload && cloudUp, (uint32_t)(power.us - w.startUs), radioUs);
+  if (w.sleep.kind == SLEEP_DEEP) power.deepSleep(w.sleep.ms);
+  else                            power.lightSleep(w.sleep.ms);
+  return w;
+}
+
+// ---------------- Cold boot ----------------
+void test_cold_boot_is_not_resumed(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  TEST_ASSERT_FALSE(duty.resumed());
+  duty.reset();
+  TEST_ASSERT_TRUE(duty.resumed());
+  TEST_ASSERT_EQUAL_UINT64(0, duty.nowMs(0));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.ledger().cycles);
+}
+
+// ---------------- Sleep plan ----------------
+void test_sleep_fills_the_rest_of_the_period(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  SleepPlan p = duty.finish(false, false, 150000, 0);
+  TEST_ASSERT_EQUAL_UINT32(LP_SAMPLE_PERIOD_MS - 150, p.ms);
+  TEST_ASSERT_EQUAL_INT(SLEEP_DEEP, p.kind);
+  TEST_ASSERT_EQUAL_UINT64(LP_SAMPLE_PERIOD_MS, duty.nowMs(0));
+}
+
+void test_short_sleeps_are_light(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  // Awake long enough that exactly lightSleepMaxMs is left
+  SleepPlan p = duty.finish(true, true, (LP_SAMPLE_PERIOD_MS - LP_LIGHT_SLEEP_MAX_MS) * 1000u, 0);
+  TEST_ASSERT_EQUAL_UINT32(LP_LIGHT_SLEEP_MAX_MS, p.ms);
+  TEST_ASSERT_EQUAL_INT(SLEEP_LIGHT, p.kind);
+
+  p = duty.finish(true, true, (LP_SAMPLE_PERIOD_MS - LP_LIGHT_SLEEP_MAX_MS - 1) * 1000u, 0);
+  TEST_ASSERT_EQUAL_UINT32(LP_LIGHT_SLEEP_MAX_MS + 1, p.ms);
+  TEST_ASSERT_EQUAL_INT(SLEEP_DEEP, p.kind);
+}
+
+void test_overrun_still_sleeps_the_minimum(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  // A radio session that outlasts the period: 75 s awake
+  SleepPlan p = duty.finish(true, false, 75000000, 74000000);
+  TEST_ASSERT_EQUAL_UINT32(10, p.ms);
+  TEST_ASSERT_EQUAL_INT(SLEEP_LIGHT, p.kind);
+  TEST_ASSERT_EQUAL_UINT64(75010, duty.nowMs(0));
+}
+
+// ---------------- Upload decision ----------------
+void test_first_wake_uploads(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  TEST_ASSERT_TRUE(duty.uploadDue(1, false, AWAKE_US));
+}
+
+void test_upload_waits_for_batch_period_or_urgency(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  duty.finish(true, true, AWAKE_US, 0);
+
+  TEST_ASSERT_FALSE(duty.uploadDue(1, false, AWAKE_US));
+  TEST_ASSERT_FALSE(duty.uploadDue(LP_BATCH_MAX - 1, false, AWAKE_US));
+  TEST_ASSERT_TRUE(duty.uploadDue(LP_BATCH_MAX, false, AWAKE_US));
+  TEST_ASSERT_TRUE(duty.uploadDue(1, true, AWAKE_US));
+
+  // The 15th wake after the attempt is a whole upload period after its wake
+  for (int i = 0; i < LP_UPLOAD_PERIOD_MS / LP_SAMPLE_PERIOD_MS - 2; i++) duty.finish(false, false, AWAKE_US, 0);
+  TEST_ASSERT_FALSE(duty.uploadDue(1, false, AWAKE_US));
+  duty.finish(false, false, AWAKE_US, 0);
+  TEST_ASSERT_TRUE(duty.uploadDue(1, false, AWAKE_US));
+}
+
+void test_offline_retries_once_per_upload_period(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  duty.finish(true, false, AWAKE_US + RADIO_US, RADIO_US);
+
+  // Neither a full batch nor a new face brings a dead network back up
+  TEST_ASSERT_FALSE(duty.uploadDue(LP_BATCH_MAX, true, AWAKE_US));
+  for (int i = 0; i < LP_UPLOAD_PERIOD_MS / LP_SAMPLE_PERIOD_MS - 2; i++) duty.finish(false, false, AWAKE_US, 0);
+  TEST_ASSERT_FALSE(duty.uploadDue(1, true, AWAKE_US));
+  duty.finish(false, false, AWAKE_US, 0);
+  TEST_ASSERT_TRUE(duty.uploadDue(1, false, AWAKE_US));   // Not a wake later for the radio time
+
+  // Back online: the usual rules again
+  duty.finish(true, true, AWAKE_US, RADIO_US);
+  TEST_ASSERT_TRUE(duty.uploadDue(1, true, AWAKE_US));
+}
+
+// ---------------- A day against the board clock ----------------
+void test_day_keeps_the_period_and_the_clock(void) {
+  FakePower power;
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+
+  size_t   pending = 0;
+  uint32_t wakes = 0, uploads = 0, deep = 0;
+  uint64_t prevStartUs = 0;
+  int64_t  worstJitterUs = 0;
+  while (power.us < DAY_MS * 1000) {
+    Wake w = runWake(duty, power, pending, false, true);
+    if (wakes > 0) {
+      int64_t jitter = (int64_t)(w.startUs - prevStartUs) - (int64_t)LP_SAMPLE_PERIOD_MS * 1000;
+      if (jitter < 0) jitter = -jitter;
+      if (jitter > worstJitterUs) worstJitterUs = jitter;
+    }
+    prevStartUs = w.startUs;
+    wakes++;
+    uploads += w.upload;
+    deep += w.sleep.kind == SLEEP_DEEP;
+  }
+
+  // Wake-to-wake stays one period, to the millisecond the sleep timer resolves
+  TEST_ASSERT_TRUE(worstJitterUs < 1000);
+  TEST_ASSERT_EQUAL_UINT32(DAY_MS / LP_SAMPLE_PERIOD_MS, wakes);
+  TEST_ASSERT_EQUAL_UINT32(wakes, deep);
+  // First wake, then every batch of 15 (= the upload period)
+  TEST_ASSERT_EQUAL_UINT32(1 + (wakes - 1) / LP_BATCH_MAX, uploads);
+  TEST_ASSERT_EQUAL_UINT32(uploads, duty.ledger().uploads);
+
+  // The scheduler clock (timestamps) must not drift from the board's
+  int64_t driftUs = (int64_t)duty.nowMs(0) * 1000 - (int64_t)power.us;
+  printf("# day: %lu wakes, %lu uploads, worst jitter %lld us, clock drift %lld us\n",
+    (unsigned long)wakes, (unsigned long)uploads, (long long)worstJitterUs, (long long)driftUs);
+  TEST_ASSERT_TRUE(driftUs > -1000 && driftUs <= 0);
+}
+
+void test_offline_day_brings_the_radio_up_once_per_period(void) {
+  FakePower power;
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+
+  size_t   pending = 0;
+  uint32_t wakes = 0, attempts = 0;
+  while (power.us < DAY_MS * 1000) {
+    attempts += runWake(duty, power, pending, true, false).upload;   // Face changes every wake
+    wakes++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(DAY_MS / LP_UPLOAD_PERIOD_MS, attempts);
+  TEST_ASSERT_EQUAL_UINT32(0, duty.ledger().uploads);
+}
+
+// ---------------- Energy ledger ----------------
+void test_ledger_matches_the_board_clock(void) {
+  FakePower power;
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  size_t pending = 0;
+  while (power.us < DAY_MS * 1000) runWake(duty, power, pending, false, true);
+
+  const EnergyLedger &l = duty.ledger();
+  TEST_ASSERT_EQUAL_UINT64(power.us, l.awakeUs + l.lightSleepUs + l.deepSleepUs);
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)l.uploads * RADIO_US, l.radioUs);
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)l.cycles * AWAKE_US + l.radioUs, l.awakeUs);
+}
+
+void test_ledger_energy_by_hand(void) {
+  DutyCycle duty(DUTY_CONFIG, state);
+  duty.reset();
+  duty.finish(true, true, 2000000, 1500000);   // 0.5 s CPU, 1.5 s radio, 58 s deep
+  duty.finish(false, false, 56000000, 0);      // 56 s CPU, 4 s light
+
+  // mA·s / 3600
+  double cpu   = (0.5 + 56.0) * 35.0;
+  double radio = 1.5 * 120.0;
+  double light = 4.0 * 5.0;
+  double deep  = 58.0 * 4.2;
+  double mAh   = (cpu + radio + light + deep) / 3600.0;
+  const EnergyLedger &l = duty.ledger();
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, (float)mAh, l.mAh(POWER_MODEL));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, (float)(mAh * 3600.0 / 120.0), l.averageMa(POWER_MODEL));
+
+  EnergyLedger empty = {};
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, empty.averageMa(POWER_MODEL));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cold_boot_is_not_resumed);
+  RUN_TEST(test_sleep_fills_the_rest_of_the_period);
+  RUN_TEST(test_short_sleeps_are_light);
+  RUN_TEST(test_overrun_still_sleeps_the_minimum);
+  RUN_TEST(test_first_wake_uploads);
+  RUN_TEST(test_upload_waits_for_batch_period_or_urgency);
+  RUN_TEST(test_offline_retries_once_per_upload_period);
+  RUN_TEST(test_day_keeps_the_period_and_the_clock);
+  RUN_TEST(test_offline_day_brings_the_radio_up_once_per_period);
+  RUN_TEST(test_ledger_matches_the_board_clock);
+  RUN_TEST(test_ledger_energy_by_hand);
+  return UNITY_END();
+}
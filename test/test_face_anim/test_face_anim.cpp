@@ -0,0 +1,261 @@
+// 30 fps face animation: the animator stepped at the animation task's frame
+// period. Covers blink cadence and shape, breathing, the dissolve, frames
+// that must not be redrawn, animation speed that doesn't depend on the
+// frame rate, and FrameBudget's late/overrun accounting with measured
+// render times.
+
+#include <unity.h>
+#include <chrono>
+#include "fake_hal.h"
+#include "bitmaps.h"
+#include "face_anim.h"
+#include "face_cache.h"
+#include "gaia_config.h"
+
+#define EYE_TOP    20    // Test faces: solid eyes over rows 20..36, centred on the eye line
+#define EYE_BOTTOM 36
+#define MOUTH_ROW  50
+
+static FakeDisplay screen;
+static FaceCache   faces;
+alignas(4) static uint8_t frame[OLED_FRAME_BYTES];
+
+static void setPixel(uint8_t *fb, int x, int y) { fb[(y / 8) * OLED_COLUMNS + x] |= 1 << (y % 8); }
+static bool pixel(const uint8_t *fb, int x, int y) { return fb[(y / 8) * OLED_COLUMNS + x] >> (y % 8) & 1; }
+
+// Two solid eyes and a mouth line whose length tells the faces apart
+static void renderFace(int face) {
+  uint8_t *fb = screen.framebuffer();
+  for (int y = EYE_TOP; y <= EYE_BOTTOM; y++) {
+    for (int x = 40; x <= 50; x++) setPixel(fb, x, y);
+    for (int x = 78; x <= 88; x++) setPixel(fb, x, y);
+  }
+  for (int x = 44; x <= 50 + face * 4; x++) setPixel(fb, x, MOUTH_ROW);
+}
+
+// Rows of the left eye that are lit (above the mouth)
+static int eyeRows(const uint8_t *fb) {
+  int n = 0;
+  for (int y = 0; y < MOUTH_ROW; y++) n += pixel(fb, 45, y);
+  return n;
+}
+
+// Top row of the left eye (breathing moves it down)
+static int eyeTop(const uint8_t *fb) {
+  for (int y = 0; y < OLED_PAGES * 8; y++) {
+    if (pixel(fb, 45, y)) return y;
+  }
+  return -1;
+}
+
+static AnimConfig with(uint16_t blinkFaces, uint8_t breathPx) {
+  AnimConfig c = ANIM_CONFIG;
+  c.blinkFaces = blinkFaces;
+  c.breathPx   = breathPx;
+  return c;
+}
+
+void setUp(void) {
+  static bool built = false;
+  if (!built) faces.build(screen, renderFace);
+  built = true;
+  memset(frame, 0, sizeof(frame));
+}
+void tearDown(void) {}
+
+// ---------------- Blink ----------------
+void test_blink_cadence_and_shape(void) {
+  // Two minutes at 30 fps; breathing off so only the lids move
+  FaceAnimator anim(faces, with(0xFFFF, 0));
+  anim.setFace(FACE_HAPPY, 0);
+  const int OPEN = EYE_BOTTOM - EYE_TOP + 1;
+
+  uint32_t blinks = 0, drawn = 0, frames = 0;
+  unsigned long prevStart = 0;
+  int blinkFrames = 0, deepest = OPEN;
+  for (unsigned long t = 0; t < 120000; t += ANIM_CONFIG.frameMs, frames++) {
+    drawn += anim.render(t, frame);
+    int rows = eyeRows(frame);
+    if (rows < OPEN) {
+      if (blinkFrames == 0) {
+        if (blinks) {
+          // Each gap is 0.5-1.5x blinkGapMs after the last blink ended, then up to a frame late
+          unsigned long gap = t - prevStart;
+          TEST_ASSERT_TRUE(gap >= ANIM_CONFIG.blinkMs + ANIM_CONFIG.blinkGapMs / 2UL);
+          TEST_ASSERT_TRUE(gap <= ANIM_CONFIG.blinkMs + ANIM_CONFIG.blinkGapMs * 3 / 2 + ANIM_CONFIG.frameMs * 1UL);
+        }
+        prevStart = t;
+        blinks++;
+        deepest = OPEN;
+      }
+      blinkFrames++;
+      if (rows < deepest) deepest = rows;
+    } else if (blinkFrames) {
+      // 180 ms is 5 frames, and the deepest one leaves only the eye line
+      TEST_ASSERT_INT_WITHIN(1, ANIM_CONFIG.blinkMs / ANIM_CONFIG.frameMs, blinkFrames);
+      TEST_ASSERT_EQUAL_INT(1, deepest);
+      blinkFrames = 0;
+    }
+  }
+  printf("# %lu blinks, %lu of %lu frames drawn\n", (unsigned long)blinks, (unsigned long)drawn, (unsigned long)frames);
+  // Mean gap blinkMs + blinkGapMs: 120 s / 4.18 s ≈ 29
+  TEST_ASSERT_TRUE(blinks >= 20 && blinks <= 40);
+  // Only blink frames (and the first) are drawn: ~6 per blink out of ~3600
+  TEST_ASSERT_TRUE(drawn <= blinks * 6 + 1);
+}
+
+void test_faces_without_blinking_eyes_stay_still(void) {
+  FaceAnimator anim(faces, with(ANIM_CONFIG.blinkFaces, 0));
+  anim.setFace(FACE_THIRSTY, 0);
+  uint32_t drawn = 0;
+  for (unsigned long t = 0; t < 60000; t += ANIM_CONFIG.frameMs) drawn += anim.render(t, frame);
+  TEST_ASSERT_EQUAL_UINT32(1, drawn);
+}
+
+// ---------------- Breathing ----------------
+void test_breathing_period(void) {
+  FaceAnimator anim(faces, with(0, 1));
+  anim.setFace(FACE_HAPPY, 0);
+  uint32_t drawn = 0, sunkMs = 0;
+  for (unsigned long t = 0; t < 40000; t += ANIM_CONFIG.frameMs) {
+    drawn += anim.render(t, frame);
+    int top = eyeTop(frame);
+    TEST_ASSERT_TRUE(top == EYE_TOP || top == EYE_TOP + 1);
+    if (top == EYE_TOP + 1) sunkMs += ANIM_CONFIG.frameMs;
+    // Down for the middle half of each breath
+    unsigned long phase = t % ANIM_CONFIG.breathMs;
+    bool down = phase >= ANIM_CONFIG.breathMs / 4 && phase < ANIM_CONFIG.breathMs * 3 / 4;
+    TEST_ASSERT_EQUAL(down, top == EYE_TOP + 1);
+  }
+  // One row each way per breath: 2 draws per 4 s, plus the first frame
+  TEST_ASSERT_EQUAL_UINT32(2 * 40000 / ANIM_CONFIG.breathMs + 1, drawn);
+  TEST_ASSERT_UINT32_WITHIN(ANIM_CONFIG.frameMs * 10, 20000, sunkMs);
+}
+
+// ---------------- Dissolve ----------------
+void test_dissolve_draws_every_frame_then_settles(void) {
+  FaceAnimator anim(faces, with(0xFFFF, 0));
+  anim.setFace(FACE_HAPPY, 0);
+  anim.render(0, frame);
+
+  const unsigned long start = 1000;
+  anim.setFace(FACE_HOT, start);
+  TEST_ASSERT_TRUE(anim.transitioning());
+  uint32_t drawn = 0;
+  int prevMouth = -1;
+  unsigned long t = start;
+  for (; t < start + ANIM_CONFIG.transitionMs; t += ANIM_CONFIG.frameMs) {
+    drawn += anim.render(t, frame);
+    TEST_ASSERT_EQUAL_INT(EYE_BOTTOM - EYE_TOP + 1, eyeRows(frame));   // No blink mid-dissolve
+    int mouth = 0;
+    for (int x = 0; x < OLED_COLUMNS; x++) mouth += pixel(frame, x, MOUTH_ROW);
+    TEST_ASSERT_TRUE(mouth >= prevMouth);   // The longer mouth fills in, never back
+    prevMouth = mouth;
+  }
+  // 16 dither levels in 400 ms change faster than 30 fps: every frame is new
+  TEST_ASSERT_EQUAL_UINT32((ANIM_CONFIG.transitionMs + ANIM_CONFIG.frameMs - 1) / ANIM_CONFIG.frameMs, drawn);
+
+  TEST_ASSERT_TRUE(anim.render(t, frame));
+  TEST_ASSERT_FALSE(anim.transitioning());
+  alignas(4) static uint8_t expect[OLED_FRAME_BYTES];
+  faces.compose(FACE_HOT, expect);
+  TEST_ASSERT_EQUAL_MEMORY(expect, frame, OLED_FRAME_BYTES);
+}
+
+void test_speed_does_not_depend_on_frame_rate(void) {
+  // A starved task (10 fps, then one 300 ms stall) still finishes the
+  // dissolve at transitionMs: everything is a function of the time
+  FaceAnimator anim(faces, with(0, 0));
+  anim.setFace(FACE_HAPPY, 0);
+  anim.render(0, frame);
+  anim.setFace(FACE_COLD, 100);
+  anim.render(200, frame);
+  TEST_ASSERT_TRUE(anim.transitioning());
+  anim.render(499, frame);
+  TEST_ASSERT_TRUE(anim.transitioning());
+  anim.render(500, frame);
+  TEST_ASSERT_FALSE(anim.transitioning());
+  TEST_ASSERT_FALSE(anim.render(533, frame));
+}
+
+// ---------------- Redraws ----------------
+void test_unchanged_frames_are_not_drawn(void) {
+  FaceAnimator anim(faces, with(0, 0));
+  TEST_ASSERT_FALSE(anim.render(0, frame));   // No face yet
+  anim.setFace(FACE_HAPPY, 0);
+  TEST_ASSERT_TRUE(anim.render(0, frame));
+  memset(frame, 0xAA, sizeof(frame));
+  TEST_ASSERT_FALSE(anim.render(33, frame));
+  TEST_ASSERT_EQUAL_UINT8(0xAA, frame[0]);    // Left untouched
+
+  // A new status bar is a new frame, laid over rows 0..11 only
+  screen.clear();
+  screen.framebuffer()[5] = 0x81;
+  screen.framebuffer()[OLED_COLUMNS + 5] = 0xFF;
+  anim.setStatusBar(screen.framebuffer());
+  TEST_ASSERT_TRUE(anim.render(66, frame));
+  TEST_ASSERT_EQUAL_UINT8(0x81, frame[5]);
+  TEST_ASSERT_EQUAL_UINT8(0x0F, frame[OLED_COLUMNS + 5]);
+  TEST_ASSERT_FALSE(anim.render(99, frame));
+}
+
+// ---------------- Frame budget ----------------
+void test_budget_counts_late_ticks_and_overruns(void) {
+  FrameBudget b;
+  b.begin(ANIM_CONFIG.frameMs * 1000UL);
+  uint32_t now = UINT32_MAX - 100000;   // micros() wraps during the run
+  for (int i = 0; i < 100; i++) b.tick(now += 33000);
+  TEST_ASSERT_EQUAL_UINT32(0, b.late);
+  b.tick(now += 49500);                  // Exactly 1.5 periods: on time
+  TEST_ASSERT_EQUAL_UINT32(0, b.late);
+  b.tick(now += 49501);
+  TEST_ASSERT_EQUAL_UINT32(1, b.late);
+  TEST_ASSERT_EQUAL_UINT32(102, b.ticks);
+
+  b.record(2000, 31000);                 // Exactly the period
+  b.record(2000, 31001);
+  TEST_ASSERT_EQUAL_UINT32(2, b.drawn);
+  TEST_ASSERT_EQUAL_UINT32(1, b.overruns);
+  b.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, b.ticks + b.drawn + b.late + b.overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, b.renderUs.count());
+}
+
+void test_render_fits_the_frame_period(void) {
+  // A minute with a face change every 2 s (dissolves, blinks, breaths),
+  // rendered for real and fed to FrameBudget like animTask does. The host
+  // is much faster than the ESP32; this catches an order-of-magnitude
+  // regression, with the measured times printed.
+  FaceAnimator anim(faces, ANIM_CONFIG);
+  FrameBudget  b;
+  b.begin(ANIM_CONFIG.frameMs * 1000UL);
+  anim.setFace(FACE_HAPPY, 0);
+  for (unsigned long t = 0; t < 60000; t += ANIM_CONFIG.frameMs) {
+    if (t % 2000 < ANIM_CONFIG.frameMs) anim.setFace((int)(t / 2000) % FACE_COUNT, t);
+    b.tick((uint32_t)(t * 1000));
+    auto t0 = std::chrono::steady_clock::now();
+    bool drew = anim.render(t, frame);
+    uint32_t ns = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    if (drew) b.record((ns + 999) / 1000, 0);
+  }
+  printf("# %lu ticks, %lu drawn, render p50 %lu us, p99 %lu us, max %lu us\n",
+    (unsigned long)b.ticks, (unsigned long)b.drawn, (unsigned long)b.renderUs.percentile(0.5f),
+    (unsigned long)b.renderUs.percentile(0.99f), (unsigned long)b.renderUs.maximum());
+  TEST_ASSERT_EQUAL_UINT32(0, b.late);
+  TEST_ASSERT_EQUAL_UINT32(0, b.overruns);
+  TEST_ASSERT_TRUE(b.renderUs.percentile(0.99f) < b.periodUs / 10);
+  TEST_ASSERT_TRUE(b.drawn > 30 * 12 && b.drawn < b.ticks);   // 30 dissolves of 12 frames, most others idle
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blink_cadence_and_shape);
+  RUN_TEST(test_faces_without_blinking_eyes_stay_still);
+  RUN_TEST(test_breathing_period);
+  RUN_TEST(test_dissolve_draws_every_frame_then_settles);
+  RUN_TEST(test_speed_does_not_depend_on_frame_rate);
+  RUN_TEST(test_unchanged_frames_are_not_drawn);
+  RUN_TEST(test_budget_counts_late_ticks_and_overruns);
+  RUN_TEST(test_render_fits_the_frame_period);
+  return UNITY_END();
+}
@@ -0,0 +1,249 @@
+// FaceClassifier: hysteresis and dwell on a reading hovering at a
+// threshold, priority and table-order tie-breaks, several plants at once,
+// and how often a day of noisy readings redraws the face compared with a
+// plain threshold chain (the pre-rule-table behaviour).
+
+#include <unity.h>
+#include <math.h>
+#include "bitmaps.h"
+#include "face_rules.h"
+#include "plant_rack.h"
+
+#define DAY_S 86400
+
+static FaceEvent events[64];
+static uint32_t  eventCount;
+
+static void record(const FaceEvent &ev) {
+  if (eventCount < 64) events[eventCount] = ev;
+  eventCount++;
+}
+
+static uint32_t rng = 4242;
+static float noise(float amplitude) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return amplitude * ((rng % 2001) / 1000.0f - 1.0f);
+}
+
+// Rack of n plants at comfortable readings and default thresholds
+static void makeRack(PlantRack &rack, uint8_t n) {
+  ThresholdSet th;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) th.plant[p] = PLANT_THRESHOLDS_DEFAULT;
+  rackSetThresholds(rack, th);
+  rack.count = n;
+  for (uint8_t p = 0; p < n; p++) {
+    rack.reading[FIELD_TEMPERATURE][p]   = 22;
+    rack.reading[FIELD_HUMIDITY][p]      = 50;
+    rack.reading[FIELD_SOIL_MOISTURE][p] = 50;
+    rack.reading[FIELD_SOIL_RAW][p]      = 2300;
+    rack.reading[FIELD_LIGHT][p]         = 500;
+  }
+}
+
+// What the firmware did before the rule table: first matching comparison wins
+static uint8_t plainChain(const PlantRack &rack, uint8_t p) {
+  for (const FaceRule &r : FACE_RULES) {
+    float v = rack.reading[r.field][p], th = rack.threshold[r.threshold][p];
+    if (r.cmp == CMP_BELOW ? v < th : v > th) return r.face;
+  }
+  return FACE_HAPPY;
+}
+
+void setUp(void) { eventCount = 0; }
+void tearDown(void) {}
+
+void test_first_sample_emits_from_none(void) {
+  FaceClassifier fc;
+  PlantRack rack;
+  makeRack(rack, 1);
+  fc.subscribe(record);
+  TEST_ASSERT_EQUAL_UINT32(1, fc.evaluate(rack, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, eventCount);
+  TEST_ASSERT_EQUAL_UINT8(FACE_NONE, events[0].from);
+  TEST_ASSERT_EQUAL_UINT8(FACE_HAPPY, events[0].to);
+  TEST_ASSERT_EQUAL_INT8(-1, events[0].rule);
+  TEST_ASSERT_EQUAL_UINT32(0, fc.evaluate(rack, 1000));
+  TEST_ASSERT_EQUAL_UINT32(1, fc.stats.transitions);
+  TEST_ASSERT_EQUAL_UINT32(2, fc.stats.evaluations);
+}
+
+void test_boundary_hovering(void) {
+  FaceClassifier fc;
+  PlantRack rack;
+  makeRack(rack, 1);
+  fc.subscribe(record);
+  float *temp = &rack.reading[FIELD_TEMPERATURE][0];
+  const float limit = rack.threshold[TH_TEMP_HIGH][0];   // 30 °C, band 0.5, dwell 10 s
+  unsigned long t = 0;
+
+  // 10 minutes flipping across the threshold every second: never latches
+  *temp = limit - 0.3f;
+  fc.evaluate(rack, t);
+  for (int i = 0; i < 600; i++) {
+    t += 1000;
+    *temp = limit + (i % 2 ? -0.3f : 0.3f);
+    fc.evaluate(rack, t);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, fc.stats.transitions);   // Only the first HAPPY
+  TEST_ASSERT_EQUAL_UINT32(300, fc.stats.debounced);   // Every excursion abandoned
+  TEST_ASSERT_EQUAL_UINT8(FACE_HAPPY, fc.face(0));
+
+  // Over for 9 s: still happy; the 10th second latches HOT
+  *temp = limit + 1.0f;
+  unsigned long rise = t + 1000;
+  for (t = rise; t < rise + 10000; t += 1000) {
+    fc.evaluate(rack, t);
+    TEST_ASSERT_EQUAL_UINT8(FACE_HAPPY, fc.face(0));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1u, fc.evaluate(rack, t));
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, fc.face(0));
+  TEST_ASSERT_EQUAL_UINT32(rise + 10000, events[1].atMs);
+
+  // Hovering inside the band (29.5..30.5) keeps HOT without any debounce
+  uint32_t debounced = fc.stats.debounced;
+  for (int i = 0; i < 600; i++) {
+    t += 1000;
+    *temp = limit + (i % 2 ? -0.4f : 0.4f);
+    fc.evaluate(rack, t);
+  }
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, fc.face(0));
+  TEST_ASSERT_EQUAL_UINT32(debounced, fc.stats.debounced);
+
+  // Clearly back below the band for the dwell time: HAPPY again
+  *temp = limit - 1.0f;
+  for (int i = 0; i <= 10; i++) fc.evaluate(rack, t += 1000);
+  TEST_ASSERT_EQUAL_UINT8(FACE_HAPPY, fc.face(0));
+  TEST_ASSERT_EQUAL_UINT32(3, fc.stats.transitions);
+  TEST_ASSERT_EQUAL_UINT32(3, eventCount);
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, events[2].from);
+}
+
+void test_nan_keeps_the_rule_state(void) {
+  FaceClassifier fc;
+  PlantRack rack;
+  makeRack(rack, 1);
+  rack.reading[FIELD_TEMPERATURE][0] = 35;
+  fc.evaluate(rack, 0);
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, fc.face(0));
+  rack.reading[FIELD_TEMPERATURE][0] = NAN;   // DHT22 read failed
+  for (unsigned long t = 1000; t < 60000; t += 1000) fc.evaluate(rack, t);
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, fc.face(0));
+  TEST_ASSERT_EQUAL_UINT32(1, fc.stats.transitions);
+}
+
+void test_priority_and_table_order(void) {
+  // Each case is a fresh plant, so its first sample applies without dwell
+  PlantRack rack;
+  makeRack(rack, 6);
+  rack.reading[FIELD_SOIL_MOISTURE][0] = 10;   // Thirsty (0) beats hot (1)
+  rack.reading[FIELD_TEMPERATURE][0]   = 35;
+  rack.reading[FIELD_TEMPERATURE][1]   = 35;   // Hot (1) beats dry air (2) and bright (3)
+  rack.reading[FIELD_HUMIDITY][1]      = 10;
+  rack.reading[FIELD_LIGHT][1]         = 5000;
+  rack.reading[FIELD_HUMIDITY][2]      = 90;   // Humid (2) beats dark (3)
+  rack.reading[FIELD_LIGHT][2]         = 10;
+  rack.reading[FIELD_LIGHT][3]         = 10;   // Dark alone
+  // Same priority, both tripped (inverted thresholds): table order decides
+  rack.threshold[TH_MOISTURE_LOW][4]   = 60;
+  rack.threshold[TH_MOISTURE_HIGH][4]  = 40;
+  rack.threshold[TH_HUMIDITY_HIGH][5]  = 40;
+  rack.threshold[TH_HUMIDITY_LOW][5]   = 60;
+
+  FaceClassifier fc;
+  fc.subscribe(record);
+  TEST_ASSERT_EQUAL_UINT32(0x3F, fc.evaluate(rack, 0));
+  static const uint8_t EXPECT[] = { FACE_THIRSTY, FACE_HOT, FACE_HUMID, FACE_DARK, FACE_THIRSTY, FACE_HUMID };
+  for (uint8_t p = 0; p < 6; p++) {
+    TEST_ASSERT_EQUAL_UINT8(EXPECT[p], rack.face[p]);
+    TEST_ASSERT_EQUAL_UINT8(EXPECT[p], fc.face(p));
+    TEST_ASSERT_EQUAL_UINT8(p, events[p].plant);
+    TEST_ASSERT_EQUAL_UINT8(EXPECT[p], FACE_RULES[events[p].rule].face);
+  }
+
+  // The winner clears: the next active rule shows, after its own dwell only
+  rack.reading[FIELD_SOIL_MOISTURE][0] = 50;
+  unsigned long t = 1000;
+  for (; t < 11000; t += 1000) TEST_ASSERT_EQUAL_UINT32(0, fc.evaluate(rack, t));
+  TEST_ASSERT_EQUAL_UINT32(1, fc.evaluate(rack, t));
+  TEST_ASSERT_EQUAL_UINT8(FACE_HOT, fc.face(0));
+}
+
+void test_plants_are_independent(void) {
+  FaceClassifier fc;
+  PlantRack rack;
+  makeRack(rack, MAX_PLANTS);
+  fc.evaluate(rack, 0);
+  uint8_t p = MAX_PLANTS - 1;
+  rack.reading[FIELD_SOIL_MOISTURE][p] = 5;
+  unsigned long t = 0;
+  uint32_t mask = 0;
+  for (int i = 0; i < 11; i++) mask |= fc.evaluate(rack, t += 1000);
+  TEST_ASSERT_EQUAL_UINT32(1u << p, mask);
+  for (uint8_t q = 0; q < p; q++) TEST_ASSERT_EQUAL_UINT8(FACE_HAPPY, fc.face(q));
+  TEST_ASSERT_EQUAL_UINT8(FACE_THIRSTY, fc.face(p));
+}
+
+void test_listener_table(void) {
+  FaceClassifier fc;
+  for (int i = 0; i < FACE_MAX_LISTENERS; i++) TEST_ASSERT_TRUE(fc.subscribe(record));
+  TEST_ASSERT_FALSE(fc.subscribe(record));
+  PlantRack rack;
+  makeRack(rack, 1);
+  fc.evaluate(rack, 0);
+  TEST_ASSERT_EQUAL_UINT32(FACE_MAX_LISTENERS, eventCount);
+}
+
+void test_day_trace_redraws(void) {
+  // A sunny day at 1 Hz with DHT22/BH1750-sized noise: temperature swings
+  // from under 15 °C at night to just over 30 °C, humidity dips under
+  // 30 %, light crosses the dark limit at dawn and dusk and the bright one
+  // at noon
+  FaceClassifier fc;
+  fc.subscribe(record);
+  PlantRack rack;
+  makeRack(rack, 1);
+  uint32_t plainChanges = 0;
+  uint8_t  plainFace = FACE_NONE;
+  uint32_t shown[FACE_DRY_AIR + 1] = {};
+
+  for (int s = 0; s < DAY_S; s++) {
+    float sun = sinf(2.0f * (float)M_PI * (s / (float)DAY_S - 0.25f));
+    rack.reading[FIELD_TEMPERATURE][0] = 21.5f + 9.0f * sun + noise(0.5f);
+    rack.reading[FIELD_HUMIDITY][0]    = 55.0f - 27.0f * sun + noise(2.0f);
+    rack.reading[FIELD_LIGHT][0]       = max(0.0f, 2200.0f * sun) * (1.0f + noise(0.05f)) + noise(3.0f);
+    fc.evaluate(rack, s * 1000UL);
+    shown[fc.face(0)]++;
+
+    uint8_t f = plainChain(rack, 0);
+    if (f != plainFace) plainChanges++;
+    plainFace = f;
+  }
+
+  printf("# day trace: %lu face redraws with hysteresis + dwell, %lu with a plain threshold chain, %lu flips debounced\n",
+    (unsigned long)fc.stats.transitions, (unsigned long)plainChanges, (unsigned long)fc.stats.debounced);
+  // The day passes through cold, dark, happy, dry air, hot, dry air,
+  // bright, happy, dark and cold: one redraw per episode (10), plus a
+  // little slack for the seed
+  TEST_ASSERT_TRUE(shown[FACE_COLD] > 0 && shown[FACE_DARK] > 0 && shown[FACE_HOT] > 0 && shown[FACE_HAPPY] > 0);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(12, fc.stats.transitions);
+  TEST_ASSERT_GREATER_THAN_UINT32(10 * fc.stats.transitions, plainChanges);
+  TEST_ASSERT_EQUAL_UINT32(fc.stats.transitions, eventCount);
+  for (uint32_t i = 1; i < eventCount && i < 64; i++) {
+    TEST_ASSERT_EQUAL_UINT8(events[i - 1].to, events[i].from);
+    TEST_ASSERT_TRUE(events[i].from != events[i].to);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_sample_emits_from_none);
+  RUN_TEST(test_boundary_hovering);
+  RUN_TEST(test_nan_keeps_the_rule_state);
+  RUN_TEST(test_priority_and_table_order);
+  RUN_TEST(test_plants_are_independent);
+  RUN_TEST(test_listener_table);
+  RUN_TEST(test_day_trace_redraws);
+  return UNITY_END();
+}
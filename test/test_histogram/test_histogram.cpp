@@ -0,0 +1,167 @@
+// LogHistogram: bucket edges and their error bound, percentiles against an
+// exact sorted reference on skewed and discrete data, and the stage summary.
+
+#include <unity.h>
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "stage_profiler.h"
+
+#define MAX_REL_ERROR 0.25   // 4 buckets per power of two
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Exact q-quantile: the ceil(q·n)-th smallest value, q taken as the decimal
+// it was written as (0.99f is a little above 0.99)
+static uint32_t exactPercentile(std::vector<uint32_t> v, float q) {
+  std::sort(v.begin(), v.end());
+  uint64_t micro = (uint64_t)llround(q * 1e6);
+  size_t   rank  = (size_t)((micro * v.size() + 999999) / 1000000);
+  if (rank < 1) rank = 1;
+  return v[rank - 1];
+}
+
+// ---------------- Buckets ----------------
+void test_bucket_edges_are_contiguous(void) {
+  TEST_ASSERT_EQUAL_UINT8(0, LogHistogram::bucketOf(0));
+  for (uint8_t b = 0; b + 1 < HIST_BUCKETS - 1; b++) {
+    uint32_t high = LogHistogram::bucketHigh(b);
+    TEST_ASSERT_EQUAL_UINT8(b, LogHistogram::bucketOf(high));
+    TEST_ASSERT_EQUAL_UINT8(b + 1, LogHistogram::bucketOf(high + 1));
+  }
+  TEST_ASSERT_EQUAL_UINT32((1u << HIST_MAX_LOG2) - 1, LogHistogram::bucketHigh(HIST_BUCKETS - 2));
+  TEST_ASSERT_EQUAL_UINT8(HIST_BUCKETS - 1, LogHistogram::bucketOf(1u << HIST_MAX_LOG2));
+  TEST_ASSERT_EQUAL_UINT8(HIST_BUCKETS - 1, LogHistogram::bucketOf(UINT32_MAX));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, LogHistogram::bucketHigh(HIST_BUCKETS - 1));
+}
+
+void test_bucket_width_is_within_a_quarter(void) {
+  // Small values are exact; above, a bucket is at most 25 % wider than its low edge
+  for (uint32_t v = 0; v < HIST_LINEAR; v++) TEST_ASSERT_EQUAL_UINT32(v, LogHistogram::bucketHigh(LogHistogram::bucketOf(v)));
+  uint32_t low = HIST_LINEAR;
+  for (uint8_t b = HIST_LINEAR; b < HIST_BUCKETS - 1; b++) {
+    uint32_t high = LogHistogram::bucketHigh(b);
+    TEST_ASSERT_TRUE((double)(high - low) / low < MAX_REL_ERROR);
+    low = high + 1;
+  }
+}
+
+void test_every_value_below_its_bucket_high(void) {
+  uint8_t prev = 0;
+  for (uint32_t v = 0; v < (1u << 20); v++) {
+    uint8_t b = LogHistogram::bucketOf(v);
+    TEST_ASSERT_TRUE(b >= prev);
+    TEST_ASSERT_TRUE(v <= LogHistogram::bucketHigh(b));
+    prev = b;
+  }
+}
+
+// ---------------- Percentiles ----------------
+void test_empty_and_single(void) {
+  LogHistogram h;
+  TEST_ASSERT_EQUAL_UINT32(0, h.percentile(0.5f));
+  TEST_ASSERT_EQUAL_UINT32(0, h.mean());
+  h.record(1234);
+  TEST_ASSERT_EQUAL_UINT32(1234, h.percentile(0.5f));   // Capped at the maximum
+  TEST_ASSERT_EQUAL_UINT32(1234, h.percentile(0.0f));
+  TEST_ASSERT_EQUAL_UINT32(1234, h.percentile(1.0f));
+  TEST_ASSERT_EQUAL_UINT32(1, h.count());
+}
+
+static void checkAgainstReference(const std::vector<uint32_t> &v) {
+  LogHistogram h;
+  uint64_t sum = 0;
+  for (uint32_t x : v) {
+    h.record(x);
+    sum += x;
+  }
+  TEST_ASSERT_EQUAL_UINT32(v.size(), h.count());
+  TEST_ASSERT_EQUAL_UINT32(*std::max_element(v.begin(), v.end()), h.maximum());
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(sum / v.size()), h.mean());
+
+  const float qs[] = { 0.01f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 0.95f, 0.99f, 0.999f, 1.0f };
+  for (float q : qs) {
+    uint32_t exact = exactPercentile(v, q);
+    uint32_t got   = h.percentile(q);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "q=%.3f n=%zu exact=%u got=%u", q, v.size(), exact, got);
+    // Never below the true value, never past its bucket
+    TEST_ASSERT_TRUE_MESSAGE(got >= exact, msg);
+    TEST_ASSERT_TRUE_MESSAGE(got <= LogHistogram::bucketHigh(LogHistogram::bucketOf(exact)), msg);
+    TEST_ASSERT_TRUE_MESSAGE(exact < HIST_LINEAR ? got == exact : (double)(got - exact) / exact < MAX_REL_ERROR, msg);
+  }
+}
+
+void test_lognormal_latencies(void) {
+  // HTTPS write times: ~300 ms typical, long tail
+  std::mt19937 rng(7);
+  std::lognormal_distribution<double> d(log(300000.0), 0.6);
+  for (size_t n : { 10, 100, 1000, 20000 }) {
+    std::vector<uint32_t> v(n);
+    for (auto &x : v) x = (uint32_t)d(rng);
+    checkAgainstReference(v);
+  }
+}
+
+void test_discrete_values(void) {
+  // Integer counts that land exactly on bucket edges and in the linear range
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<uint32_t> d(0, 40);
+  for (size_t n : { 1, 2, 3, 7, 100, 1000 }) {
+    std::vector<uint32_t> v(n);
+    for (auto &x : v) x = d(rng);
+    checkAgainstReference(v);
+  }
+}
+
+void test_bimodal_and_huge(void) {
+  // Mostly fast flushes, a few stalls past the last bucket
+  std::vector<uint32_t> v;
+  for (int i = 0; i < 990; i++) v.push_back(900 + i % 50);
+  for (int i = 0; i < 10; i++) v.push_back(80000000u + i);
+  LogHistogram h;
+  for (uint32_t x : v) h.record(x);
+  TEST_ASSERT_TRUE(h.percentile(0.5f) >= 900 && h.percentile(0.5f) < 1200);
+  TEST_ASSERT_TRUE(h.percentile(0.99f) < 1200);                   // The 990th value is still fast
+  TEST_ASSERT_EQUAL_UINT32(80000009u, h.percentile(0.999f));      // Overflow bucket: the maximum
+}
+
+void test_reset(void) {
+  LogHistogram h;
+  for (uint32_t v = 0; v < 1000; v++) h.record(v * 97);
+  h.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, h.count());
+  TEST_ASSERT_EQUAL_UINT32(0, h.maximum());
+  TEST_ASSERT_EQUAL_UINT32(0, h.percentile(0.99f));
+  h.record(5);
+  TEST_ASSERT_EQUAL_UINT32(5, h.percentile(0.5f));
+}
+
+// ---------------- Stage summary ----------------
+void test_stage_summary(void) {
+  LogHistogram h;
+  for (uint32_t v = 1; v <= 100; v++) h.record(v * 1000);
+  StageSummary s = summarizeStage(h, STAGE_READ_AIR);
+  TEST_ASSERT_EQUAL_STRING("read_air", s.name);
+  TEST_ASSERT_EQUAL_UINT32(100, s.count);
+  TEST_ASSERT_EQUAL_UINT32(100000, s.maxUs);
+  TEST_ASSERT_TRUE(s.p50Us >= 50000 && s.p50Us < 50000 * 1.25);
+  TEST_ASSERT_TRUE(s.p95Us >= 95000 && s.p95Us <= 100000);
+  TEST_ASSERT_EQUAL_STRING("", stageName(STAGE_COUNT));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_edges_are_contiguous);
+  RUN_TEST(test_bucket_width_is_within_a_quarter);
+  RUN_TEST(test_every_value_below_its_bucket_high);
+  RUN_TEST(test_empty_and_single);
+  RUN_TEST(test_lognormal_latencies);
+  RUN_TEST(test_discrete_values);
+  RUN_TEST(test_bimodal_and_huge);
+  RUN_TEST(test_reset);
+  RUN_TEST(test_stage_summary);
+  return UNITY_END();
+}
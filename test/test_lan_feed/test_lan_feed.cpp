@@ -0,0 +1,215 @@
+// LAN feed: the exact sample and snapshot messages (species names escaped
+// like every other string), a busy subscriber resuming where it stopped, a
+// lagging one skipping ahead, and no heap use on the publish, pump and
+// snapshot paths (global operator new is counted).
+
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "bitmaps.h"
+#include "lan_feed.h"
+
+static size_t allocations = 0;
+
+void *operator new(size_t n) {
+  allocations++;
+  void *p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static const PlantConfig PLANTS[] = {
+  { "gaia_01", 34, 4,      NO_PIN },
+  { "gaia_02", 35, NO_PIN, 0      },
+  { "gaia_03", 36, NO_PIN, 1      },
+};
+
+static char buf[LAN_FEED_BYTES + 2048];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::string snapshot(const LanFeed &feed, const ThresholdSet &th, unsigned long nowMs) {
+  JsonOut out(buf, sizeof(buf));
+  feed.writeSnapshot(out, th, nowMs);
+  TEST_ASSERT_TRUE(out.ok());
+  return std::string(out.data(), out.length());
+}
+
+static RackSample rack(uint8_t count, unsigned long ms) {
+  RackSample s = {};
+  s.count = count;
+  for (uint8_t p = 0; p < count; p++) s.plant[p] = Telemetry{ 21.5f + p, 50.0f, 40 + p, 2000, 300.0f, ms };
+  return s;
+}
+
+// Every message a client was handed, and the clients that report a full queue
+struct Transport {
+  std::vector<std::string> got[4];
+  bool                     busy[4] = {};
+};
+
+static bool deliver(void *ctx, uint8_t client, const char *msg, size_t len) {
+  Transport *t = (Transport *)ctx;
+  if (t->busy[client]) return false;
+  t->got[client].emplace_back(msg, len);
+  return true;
+}
+
+// ---------------- Messages ----------------
+void test_multi_plant_sample(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 3, 4);
+  TEST_ASSERT_EQUAL_INT(0, feed.attach());
+  feed.publishSample(rack(3, 1000));
+
+  Transport t;
+  TEST_ASSERT_EQUAL_UINT32(1, feed.pump(deliver, &t));
+  const char *expect =
+    "{\"type\":\"sample\",\"seq\":1,\"plants\":{"
+    "\"gaia_01\":{\"temperature\":21.5,\"humidity\":50,\"soil_moisture\":40,\"soil_raw\":2000,\"light_intensity\":300,\"timestamp\":1000},"
+    "\"gaia_02\":{\"temperature\":22.5,\"humidity\":50,\"soil_moisture\":41,\"soil_raw\":2000,\"light_intensity\":300,\"timestamp\":1000},"
+    "\"gaia_03\":{\"temperature\":23.5,\"humidity\":50,\"soil_moisture\":42,\"soil_raw\":2000,\"light_intensity\":300,\"timestamp\":1000}}}";
+  TEST_ASSERT_EQUAL_STRING(expect, t.got[0][0].c_str());
+}
+
+void test_snapshot_of_an_empty_rack(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 0, 4);
+  static ThresholdSet th;
+  std::string json = snapshot(feed, th, 5000);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":0,\"uptime_ms\":5000,\"thresholds\":{},\"faces\":{},\"recent\":[]}", json.c_str());
+}
+
+void test_species_name_is_escaped(void) {
+  // Names come from the app: a quote, a backslash or a newline must not break the snapshot
+  static LanFeed feed;
+  feed.configure(PLANTS, 1, 4);
+  static ThresholdSet th;
+  th.plant[0] = PLANT_THRESHOLDS_DEFAULT;
+  strcpy(th.plant[0].speciesName, "Aloe \"vera\"\\\n");
+  std::string json = snapshot(feed, th, 0);
+  TEST_ASSERT_TRUE(json.find("\"species\":\"Aloe \\\"vera\\\"\\\\\\n\"}") != std::string::npos);
+}
+
+void test_snapshot_then_live_messages(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 2, 4);
+  static ThresholdSet th;
+  feed.publishSample(rack(2, 1000));
+  feed.publishFace(FaceEvent{ 1, FACE_HAPPY, FACE_THIRSTY, 0, 1500 });
+  std::string json = snapshot(feed, th, 2000);
+  TEST_ASSERT_EQUAL_UINT32(0, json.find("{\"seq\":2,"));
+  TEST_ASSERT_TRUE(json.find("\"faces\":{\"gaia_01\":\"none\",\"gaia_02\":\"thirsty\"}") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"recent\":[{\"type\":\"sample\",\"seq\":1,") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find(",{\"type\":\"face\",\"seq\":2,\"plant\":\"gaia_02\",\"face\":\"thirsty\","
+                             "\"from\":\"happy\",\"at_ms\":1500}]}") != std::string::npos);
+
+  // A subscriber attached after the snapshot gets seq 3 on
+  feed.attach();
+  feed.publishSample(rack(2, 3000));
+  Transport t;
+  feed.pump(deliver, &t);
+  TEST_ASSERT_EQUAL_UINT32(1, t.got[0].size());
+  TEST_ASSERT_EQUAL_UINT32(0, t.got[0][0].find("{\"type\":\"sample\",\"seq\":3,"));
+}
+
+// ---------------- Subscribers ----------------
+void test_busy_client_resumes_where_it_stopped(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 1, 4);
+  feed.attach();
+  feed.attach();
+  Transport t;
+  t.busy[1] = true;
+  for (int i = 1; i <= 5; i++) feed.publishSample(rack(1, i * 1000));
+  TEST_ASSERT_EQUAL_UINT32(5, feed.pump(deliver, &t));
+  TEST_ASSERT_EQUAL_UINT32(0, t.got[1].size());
+  TEST_ASSERT_EQUAL_UINT32(1, feed.stats().busy);
+
+  t.busy[1] = false;
+  TEST_ASSERT_EQUAL_UINT32(5, feed.pump(deliver, &t));
+  TEST_ASSERT_TRUE(t.got[0] == t.got[1]);
+  TEST_ASSERT_EQUAL_UINT32(0, feed.stats().lagged);
+}
+
+void test_lagging_client_skips_to_the_oldest_kept(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 3, 4);
+  feed.attach();
+  Transport t;
+  t.busy[0] = true;
+  const uint32_t total = 3 * LAN_FEED_ENTRIES;
+  for (uint32_t i = 1; i <= total; i++) feed.publishSample(rack(3, i * 1000));
+  feed.pump(deliver, &t);
+
+  t.busy[0] = false;
+  uint32_t sent = feed.pump(deliver, &t);
+  TEST_ASSERT_TRUE(sent > 0);
+  TEST_ASSERT_TRUE(sent <= LAN_FEED_ENTRIES);
+  TEST_ASSERT_EQUAL_UINT32(total - sent, feed.stats().lagged);
+  char last[40];
+  snprintf(last, sizeof(last), "{\"type\":\"sample\",\"seq\":%u,", total);
+  TEST_ASSERT_EQUAL_UINT32(0, t.got[0].back().find(last));
+}
+
+void test_slots_are_limited_and_reused(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 1, 2);
+  TEST_ASSERT_EQUAL_INT(0, feed.attach());
+  TEST_ASSERT_EQUAL_INT(1, feed.attach());
+  TEST_ASSERT_EQUAL_INT(-1, feed.attach());
+  feed.detach(0);
+  feed.detach(0);   // Twice: counted once
+  TEST_ASSERT_EQUAL_UINT8(1, feed.stats().clients);
+  TEST_ASSERT_EQUAL_INT(0, feed.attach());
+  TEST_ASSERT_EQUAL_UINT32(1, feed.stats().refused);
+  TEST_ASSERT_EQUAL_UINT8(2, feed.stats().peakClients);
+}
+
+// ---------------- Heap ----------------
+void test_no_allocations(void) {
+  static LanFeed feed;
+  feed.configure(PLANTS, 3, 4);
+  feed.attach();
+  static ThresholdSet th;
+  for (uint8_t p = 0; p < 3; p++) th.plant[p] = PLANT_THRESHOLDS_DEFAULT;
+  strcpy(th.plant[1].speciesName, "Aloe \"vera\"");
+  RackSample s = rack(3, 1000);
+
+  size_t before = allocations;
+  for (int i = 0; i < 100; i++) {
+    s.plant[0].timestamp = i;
+    feed.publishSample(s);
+    feed.publishFace(FaceEvent{ (uint8_t)(i % 3), FACE_HAPPY, FACE_THIRSTY, 0, (unsigned long)i });
+    feed.pump([](void *, uint8_t, const char *, size_t) { return true; }, NULL);
+    JsonOut snap(buf, sizeof(buf));
+    feed.writeSnapshot(snap, th, i);
+  }
+  TEST_ASSERT_EQUAL_size_t(0, allocations - before);
+
+  // The counter works
+  std::string *probe = new std::string("x");
+  delete probe;
+  TEST_ASSERT_TRUE(allocations > before);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_multi_plant_sample);
+  RUN_TEST(test_snapshot_of_an_empty_rack);
+  RUN_TEST(test_species_name_is_escaped);
+  RUN_TEST(test_snapshot_then_live_messages);
+  RUN_TEST(test_busy_client_resumes_where_it_stopped);
+  RUN_TEST(test_lagging_client_skips_to_the_oldest_kept);
+  RUN_TEST(test_slots_are_limited_and_reused);
+  RUN_TEST(test_no_allocations);
+  return UNITY_END();
+}
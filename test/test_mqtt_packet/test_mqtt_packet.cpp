@@ -0,0 +1,199 @@
+// MQTT 3.1.1 codec: Remaining Length at its byte-count boundaries, the
+// exact bytes of CONNECT, PUBLISH (QoS 0/1, retain) and the small outgoing
+// packets, parsing of the incoming PUBLISH, PUBACK, SUBACK and PINGRESP,
+// and rejection of truncated, oversized and malformed packets.
+
+#include <unity.h>
+#include <string>
+#include "mqtt_packet.h"
+
+static char buf[256];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The bytes write() produced
+template <typename F>
+static std::string packet(F write) {
+  JsonOut out(buf, sizeof(buf));
+  write(out);
+  TEST_ASSERT_TRUE(out.ok());
+  return std::string(out.data(), out.length());
+}
+
+static std::string bytes(const char *s, size_t n) { return std::string(s, n); }
+
+// Feeds p[from..] to mqttLengthByte; returns its last result, with the value and byte count
+static int decodeLength(const std::string &p, size_t from, uint32_t &value, uint8_t &count) {
+  value = 0;
+  count = 0;
+  int r = 0;
+  for (size_t i = from; i < p.size() && r == 0; i++) r = mqttLengthByte((uint8_t)p[i], value, count);
+  return r;
+}
+
+// ---------------- Remaining Length ----------------
+// A PUBLISH head on topic "t" at QoS 0 has a Remaining Length of 3 + payloadLen
+void test_length_byte_boundaries(void) {
+  struct { uint32_t length; const char *encoded; uint8_t n; } cases[] = {
+    { 127,   "\x7F",         1 },
+    { 128,   "\x80\x01",     2 },
+    { 16383, "\xFF\x7F",     2 },
+    { 16384, "\x80\x80\x01", 3 },
+  };
+  for (const auto &c : cases) {
+    std::string p = packet([&](JsonOut &o) { mqttPublishHead(o, "t", c.length - 3, 0, false, 0); });
+    TEST_ASSERT_EQUAL_UINT32(1 + c.n + 3, p.size());
+    TEST_ASSERT_TRUE(p.substr(1, c.n) == bytes(c.encoded, c.n));
+
+    uint32_t value;
+    uint8_t  count;
+    TEST_ASSERT_EQUAL_INT(1, decodeLength(p, 1, value, count));
+    TEST_ASSERT_EQUAL_UINT32(c.length, value);
+    TEST_ASSERT_EQUAL_UINT8(c.n, count);
+  }
+}
+
+void test_longest_length_and_a_fifth_byte(void) {
+  uint32_t value;
+  uint8_t  count;
+  TEST_ASSERT_EQUAL_INT(1, decodeLength(bytes("\xFF\xFF\xFF\x7F", 4), 0, value, count));
+  TEST_ASSERT_EQUAL_UINT32(268435455, value);
+
+  // A continuation bit on the fourth byte makes it malformed
+  TEST_ASSERT_EQUAL_INT(-1, decodeLength(bytes("\xFF\xFF\xFF\xFF\x01", 5), 0, value, count));
+}
+
+// ---------------- Outgoing packets ----------------
+void test_connect_with_credentials(void) {
+  std::string p = packet([](JsonOut &o) { mqttConnect(o, "gaia", "u", "pw", 60); });
+  const char expect[] =
+    "\x10\x17"                      // CONNECT, 23 bytes follow
+    "\x00\x04MQTT\x04"              // Protocol name, level 4 (3.1.1)
+    "\xC2"                          // User + password + clean session
+    "\x00\x3C"                      // Keep-alive 60 s
+    "\x00\x04gaia" "\x00\x01u" "\x00\x02pw";
+  TEST_ASSERT_TRUE(p == bytes(expect, sizeof(expect) - 1));
+}
+
+void test_connect_leaves_out_empty_credentials(void) {
+  std::string p = packet([](JsonOut &o) { mqttConnect(o, "gaia", "", "pw", 30); });
+  const char expect[] = "\x10\x10\x00\x04MQTT\x04\x02\x00\x1E\x00\x04gaia";
+  TEST_ASSERT_TRUE(p == bytes(expect, sizeof(expect) - 1));
+
+  // A password without a user is not allowed by the protocol
+  p = packet([](JsonOut &o) { mqttConnect(o, "gaia", NULL, "pw", 30); });
+  TEST_ASSERT_TRUE(p == bytes(expect, sizeof(expect) - 1));
+}
+
+void test_publish_qos0(void) {
+  std::string p = packet([](JsonOut &o) {
+    mqttPublishHead(o, "a/b", 2, 0, false, 7);   // The packet id is only sent at QoS 1
+    o.put("hi");
+  });
+  const char expect[] = "\x30\x07\x00\x03" "a/b" "hi";
+  TEST_ASSERT_TRUE(p == bytes(expect, sizeof(expect) - 1));
+}
+
+void test_publish_qos1_retained(void) {
+  std::string p = packet([](JsonOut &o) {
+    mqttPublishHead(o, "a/b", 2, 1, true, 0x1234);
+    o.put("hi");
+  });
+  const char expect[] = "\x33\x09\x00\x03" "a/b" "\x12\x34" "hi";
+  TEST_ASSERT_TRUE(p == bytes(expect, sizeof(expect) - 1));
+
+  // Reads back as the same message
+  MqttPublish msg;
+  TEST_ASSERT_TRUE(mqttParsePublish((uint8_t)p[0], (const uint8_t *)p.data() + 2, p.size() - 2, msg));
+  TEST_ASSERT_EQUAL_UINT8(1, msg.qos);
+  TEST_ASSERT_TRUE(msg.retain);
+  TEST_ASSERT_EQUAL_UINT16(0x1234, msg.packetId);
+  TEST_ASSERT_TRUE(bytes(msg.topic, msg.topicLen) == "a/b");
+  TEST_ASSERT_TRUE(bytes((const char *)msg.payload, msg.length) == "hi");
+}
+
+void test_small_packets(void) {
+  const char *filters[] = { "gaia/+/thresholds", "x" };
+  std::string p = packet([&](JsonOut &o) { mqttSubscribe(o, 5, filters, 2, 1); });
+  const char sub[] = "\x82\x1A\x00\x05" "\x00\x11gaia/+/thresholds\x01" "\x00\x01x\x01";
+  TEST_ASSERT_TRUE(p == bytes(sub, sizeof(sub) - 1));
+
+  TEST_ASSERT_TRUE(packet([](JsonOut &o) { mqttPuback(o, 0x0102); }) == bytes("\x40\x02\x01\x02", 4));
+  TEST_ASSERT_TRUE(packet([](JsonOut &o) { mqttPingreq(o); }) == bytes("\xC0\x00", 2));
+  TEST_ASSERT_TRUE(packet([](JsonOut &o) { mqttDisconnect(o); }) == bytes("\xE0\x00", 2));
+}
+
+// ---------------- Incoming packets ----------------
+void test_parse_publish_qos0(void) {
+  const uint8_t body[] = { 0x00, 0x01, 't', '{', '}' };
+  MqttPublish msg;
+  TEST_ASSERT_TRUE(mqttParsePublish(0x30, body, sizeof(body), msg));
+  TEST_ASSERT_EQUAL_UINT8(0, msg.qos);
+  TEST_ASSERT_FALSE(msg.retain);
+  TEST_ASSERT_EQUAL_UINT16(0, msg.packetId);
+  TEST_ASSERT_EQUAL_UINT32(1, msg.topicLen);
+  TEST_ASSERT_EQUAL_UINT32(2, msg.length);
+
+  // Empty payload
+  TEST_ASSERT_TRUE(mqttParsePublish(0x30, body, 3, msg));
+  TEST_ASSERT_EQUAL_UINT32(0, msg.length);
+}
+
+void test_parse_acks(void) {
+  MqttAck ack;
+  const uint8_t puback[] = { 0x00, 0x2A };
+  TEST_ASSERT_TRUE(mqttParseAck(0x40, puback, sizeof(puback), ack));
+  TEST_ASSERT_EQUAL_UINT8(MQTT_PUBACK, ack.type);
+  TEST_ASSERT_EQUAL_UINT16(42, ack.packetId);
+
+  // One granted filter (QoS 1), one refused
+  const uint8_t suback[] = { 0x01, 0x00, 0x01, 0x80 };
+  TEST_ASSERT_TRUE(mqttParseAck(0x90, suback, sizeof(suback), ack));
+  TEST_ASSERT_EQUAL_UINT8(MQTT_SUBACK, ack.type);
+  TEST_ASSERT_EQUAL_UINT16(256, ack.packetId);
+  TEST_ASSERT_EQUAL_UINT8(1, ack.refused);
+
+  TEST_ASSERT_TRUE(mqttParseAck(0xD0, NULL, 0, ack));
+  TEST_ASSERT_EQUAL_UINT8(MQTT_PINGRESP, ack.type);
+  TEST_ASSERT_EQUAL_UINT16(0, ack.packetId);
+}
+
+void test_reject_truncated_and_oversized_acks(void) {
+  MqttAck ack;
+  const uint8_t body[] = { 0x00, 0x2A, 0x00 };
+  TEST_ASSERT_FALSE(mqttParseAck(0x40, body, 1, ack));   // PUBACK without its full packet id
+  TEST_ASSERT_FALSE(mqttParseAck(0x40, body, 3, ack));   // PUBACK with a byte too many
+  TEST_ASSERT_FALSE(mqttParseAck(0x42, body, 2, ack));   // Reserved flags set
+  TEST_ASSERT_FALSE(mqttParseAck(0x90, body, 2, ack));   // SUBACK without return codes
+  TEST_ASSERT_FALSE(mqttParseAck(0xD0, body, 1, ack));   // PINGRESP with a body
+  TEST_ASSERT_FALSE(mqttParseAck(0x20, body, 2, ack));   // CONNACK is not an ack
+  TEST_ASSERT_FALSE(mqttParseAck(0x30, body, 3, ack));   // Neither is a PUBLISH
+}
+
+void test_reject_malformed_publish(void) {
+  MqttPublish msg;
+  const uint8_t body[] = { 0x00, 0x03, 'a', '/', 'b', 0x00, 0x07 };
+  TEST_ASSERT_FALSE(mqttParsePublish(0x30, body, 1, msg));   // Topic length cut off
+  TEST_ASSERT_FALSE(mqttParsePublish(0x30, body, 4, msg));   // Topic longer than the packet
+  TEST_ASSERT_FALSE(mqttParsePublish(0x32, body, 6, msg));   // QoS 1 without its full packet id
+  TEST_ASSERT_FALSE(mqttParsePublish(0x34, body, 7, msg));   // QoS 2 is never subscribed to
+  TEST_ASSERT_TRUE(mqttParsePublish(0x32, body, 7, msg));
+  TEST_ASSERT_EQUAL_UINT16(7, msg.packetId);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_length_byte_boundaries);
+  RUN_TEST(test_longest_length_and_a_fifth_byte);
+  RUN_TEST(test_connect_with_credentials);
+  RUN_TEST(test_connect_leaves_out_empty_credentials);
+  RUN_TEST(test_publish_qos0);
+  RUN_TEST(test_publish_qos1_retained);
+  RUN_TEST(test_small_packets);
+  RUN_TEST(test_parse_publish_qos0);
+  RUN_TEST(test_parse_acks);
+  RUN_TEST(test_reject_truncated_and_oversized_acks);
+  RUN_TEST(test_reject_malformed_publish);
+  return UNITY_END();
+}
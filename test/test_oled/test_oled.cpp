@@ -0,0 +1,178 @@
+// SSD1306 partial updates: frameDiff spans, what FrameFlusher puts on the
+// bus (FakeDisplay counts bytes the way Ssd1306Display::writeRegion sends
+// them), and the pre-rasterized faces.
+
+#include <unity.h>
+#include "fake_hal.h"
+#include "face_cache.h"
+#include "oled_frame.h"
+
+// Bytes writeRegion() sends for an n-column span: address + 6 commands,
+// then the data in 64-byte chunks behind a control byte each
+static size_t regionBytes(size_t n) { return 8 + n + 2 * ((n + 63) / 64); }
+
+static FakeDisplay screen;
+static FaceCache   faces;
+alignas(4) static uint8_t shown[OLED_FRAME_BYTES];
+
+// A distinct solid block per face, reaching up into page 1's status rows
+static void renderFace(int face) {
+  uint8_t *fb = screen.framebuffer();
+  for (int page = FACE_FIRST_PAGE; page < OLED_PAGES; page++) {
+    for (int c = 16 + face * 8; c < 48 + face * 8; c++) fb[page * OLED_COLUMNS + c] = 0xFF;
+  }
+}
+
+void setUp(void) {
+  screen = FakeDisplay();
+  memset(shown, 0, sizeof(shown));
+}
+void tearDown(void) {}
+
+// ---------------- frameDiff ----------------
+void test_diff_clean_frame(void) {
+  DirtySpan spans[OLED_PAGES];
+  TEST_ASSERT_EQUAL_UINT8(0, frameDiff(screen.framebuffer(), shown, spans));
+  for (int p = 0; p < OLED_PAGES; p++) TEST_ASSERT_TRUE(spans[p].first > spans[p].last);
+}
+
+void test_diff_exact_columns(void) {
+  // Edges of the page and of the words the diff compares
+  static const int16_t CASES[][2] = { { 0, 0 }, { 127, 127 }, { 3, 4 }, { 5, 6 }, { 1, 126 }, { 64, 64 } };
+  for (const auto &c : CASES) {
+    uint8_t *fb = screen.framebuffer();
+    memset(fb, 0, OLED_FRAME_BYTES);
+    fb[3 * OLED_COLUMNS + c[0]] = 0x01;
+    fb[3 * OLED_COLUMNS + c[1]] = 0x80;
+
+    DirtySpan spans[OLED_PAGES];
+    TEST_ASSERT_EQUAL_UINT8(1, frameDiff(fb, shown, spans));
+    TEST_ASSERT_EQUAL_INT16(c[0], spans[3].first);
+    TEST_ASSERT_EQUAL_INT16(c[1], spans[3].last);
+  }
+}
+
+void test_diff_several_pages(void) {
+  uint8_t *fb = screen.framebuffer();
+  fb[0 * OLED_COLUMNS + 10] = 1;
+  fb[5 * OLED_COLUMNS + 20] = 1;
+  fb[5 * OLED_COLUMNS + 90] = 1;
+  fb[7 * OLED_COLUMNS + 127] = 1;
+  DirtySpan spans[OLED_PAGES];
+  TEST_ASSERT_EQUAL_UINT8(3, frameDiff(fb, shown, spans));
+  TEST_ASSERT_EQUAL_INT16(10, spans[0].first);
+  TEST_ASSERT_EQUAL_INT16(20, spans[5].first);
+  TEST_ASSERT_EQUAL_INT16(90, spans[5].last);
+  TEST_ASSERT_EQUAL_INT16(127, spans[7].first);
+  TEST_ASSERT_TRUE(spans[1].first > spans[1].last);
+}
+
+// ---------------- FrameFlusher ----------------
+void test_flush_bytes(void) {
+  FrameFlusher flusher;
+  uint8_t *fb = screen.framebuffer();
+
+  // Nothing known about the panel yet: every page in full
+  TEST_ASSERT_EQUAL_size_t(OLED_PAGES * regionBytes(OLED_COLUMNS), flusher.flush(screen));
+  TEST_ASSERT_EQUAL_UINT32(OLED_PAGES, screen.regions);
+
+  // Unchanged: nothing on the bus
+  TEST_ASSERT_EQUAL_size_t(0, flusher.flush(screen));
+  TEST_ASSERT_EQUAL_UINT32(1, flusher.cleanFrames);
+
+  // One pixel: one 1-column region
+  fb[2 * OLED_COLUMNS + 50] ^= 0x10;
+  TEST_ASSERT_EQUAL_size_t(regionBytes(1), flusher.flush(screen));
+
+  // A 70-column span takes two data chunks
+  for (int c = 30; c < 100; c++) fb[6 * OLED_COLUMNS + c] = 0xAA;
+  TEST_ASSERT_EQUAL_size_t(regionBytes(70), flusher.flush(screen));
+  TEST_ASSERT_EQUAL_size_t(8 + 70 + 4, regionBytes(70));
+
+  // Changed back: the same span again, and the panel matches
+  fb[2 * OLED_COLUMNS + 50] ^= 0x10;
+  TEST_ASSERT_EQUAL_size_t(regionBytes(1), flusher.flush(screen));
+  TEST_ASSERT_EQUAL_MEMORY(screen.framebuffer(), screen.panel, OLED_FRAME_BYTES);
+
+  TEST_ASSERT_EQUAL_UINT32(5, flusher.frames);
+  TEST_ASSERT_EQUAL_UINT32(screen.bytes, flusher.i2cBytes);
+}
+
+void test_flush_after_invalidate_is_full(void) {
+  FrameFlusher flusher;
+  flusher.flush(screen);
+  flusher.invalidate();
+  TEST_ASSERT_EQUAL_size_t(OLED_PAGES * regionBytes(OLED_COLUMNS), flusher.flush(screen));
+}
+
+void test_full_frame_comparison_constant(void) {
+  // The reported "full redraw" figure is a little under the first-frame cost
+  // of the region path, which also readdresses every page
+  TEST_ASSERT_TRUE(OLED_FULL_FRAME_I2C_BYTES < OLED_PAGES * regionBytes(OLED_COLUMNS));
+  TEST_ASSERT_TRUE(OLED_FULL_FRAME_I2C_BYTES > OLED_FRAME_BYTES);
+}
+
+// ---------------- FaceCache ----------------
+void test_cache_masks_the_status_rows(void) {
+  faces.build(screen, renderFace);
+  TEST_ASSERT_TRUE(faces.ready());
+  for (int face = 0; face < FACE_COUNT; face++) {
+    const uint8_t *pages = faces.facePages(face);
+    // Page 1 keeps rows 12..15 only; the pages below are untouched
+    TEST_ASSERT_EQUAL_HEX8(0xF0, pages[16 + face * 8]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, pages[OLED_COLUMNS + 16 + face * 8]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pages[15 + face * 8]);
+  }
+  // build() leaves the screen blank
+  for (int i = 0; i < OLED_FRAME_BYTES; i++) TEST_ASSERT_EQUAL_HEX8(0, screen.framebuffer()[i]);
+}
+
+void test_compose(void) {
+  faces.build(screen, renderFace);
+  uint8_t *fb = screen.framebuffer();
+  memset(fb, 0x55, OLED_FRAME_BYTES);
+  faces.compose(2, fb);
+  for (int c = 0; c < OLED_COLUMNS; c++) TEST_ASSERT_EQUAL_HEX8(0, fb[c]);   // Status bar page cleared
+  TEST_ASSERT_EQUAL_MEMORY(faces.facePages(2), fb + OLED_COLUMNS, FACE_PAGES * OLED_COLUMNS);
+
+  faces.compose(FACE_COUNT, fb);   // Out of range: face 0
+  TEST_ASSERT_EQUAL_MEMORY(faces.facePages(0), fb + OLED_COLUMNS, FACE_PAGES * OLED_COLUMNS);
+}
+
+void test_face_change_redraw_bytes(void) {
+  faces.build(screen, renderFace);
+  FrameFlusher flusher;
+  uint8_t *fb = screen.framebuffer();
+  faces.compose(0, fb);
+  flusher.flush(screen);
+
+  // Adjacent faces' blocks are 8 columns apart: every face page redraws a
+  // 40-column span (old and new block), page 0 is never touched
+  uint32_t before = screen.regions;
+  for (int face = 1; face < FACE_COUNT; face++) {
+    faces.compose(face, fb);
+    size_t sent = flusher.flush(screen);
+    TEST_ASSERT_EQUAL_size_t(FACE_PAGES * regionBytes(40), sent);
+    TEST_ASSERT_TRUE(sent < OLED_FULL_FRAME_I2C_BYTES / 2);
+    TEST_ASSERT_EQUAL_MEMORY(fb, screen.panel, OLED_FRAME_BYTES);
+  }
+  TEST_ASSERT_EQUAL_UINT32((FACE_COUNT - 1) * FACE_PAGES, screen.regions - before);
+
+  // Re-composing the same face costs nothing
+  faces.compose(FACE_COUNT - 1, fb);
+  TEST_ASSERT_EQUAL_size_t(0, flusher.flush(screen));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_diff_clean_frame);
+  RUN_TEST(test_diff_exact_columns);
+  RUN_TEST(test_diff_several_pages);
+  RUN_TEST(test_flush_bytes);
+  RUN_TEST(test_flush_after_invalidate_is_full);
+  RUN_TEST(test_full_frame_comparison_constant);
+  RUN_TEST(test_cache_masks_the_status_rows);
+  RUN_TEST(test_compose);
+  RUN_TEST(test_face_change_redraw_bytes);
+  return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// The two lock-free hand-offs between the pipeline tasks: SpscRing (samples,
+// sensor task → network task) and TripleBuffer (thresholds and scenes).
+// The concurrent cases run producer and consumer on two host threads, with
+// payloads big enough that a torn copy would show.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "spsc_ring.h"
+#include "triple_buffer.h"
+
+#define STRESS_ITEMS 1000000u
+
+// Every word derived from seq, so a half-written copy is detectable
+struct Payload {
+  uint32_t seq;
+  uint32_t words[15];
+
+  void fill(uint32_t s) {
+    seq = s;
+    for (int i = 0; i < 15; i++) words[i] = s * 2654435761u + i;
+  }
+  bool consistent() const {
+    for (int i = 0; i < 15; i++) {
+      if (words[i] != seq * 2654435761u + i) return false;
+    }
+    return true;
+  }
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------- SpscRing ----------------
+void test_ring_fifo_and_bounds(void) {
+  SpscRing<int, 4> ring;
+  int v;
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_FALSE(ring.pop(v));
+
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+  TEST_ASSERT_FALSE(ring.push(99));            // Full: dropped, not overwritten
+  TEST_ASSERT_EQUAL_size_t(4, ring.size());
+
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(ring.pop(v));
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+  TEST_ASSERT_FALSE(ring.pop(v));
+}
+
+void test_ring_wraps_around(void) {
+  SpscRing<int, 8> ring;
+  int v, next = 0;
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_TRUE(ring.push(i));
+    if (i % 3 != 0) continue;
+    while (ring.pop(v)) TEST_ASSERT_EQUAL_INT(next++, v);
+  }
+  while (ring.pop(v)) TEST_ASSERT_EQUAL_INT(next++, v);
+  TEST_ASSERT_EQUAL_INT(1000, next);
+}
+
+void test_ring_concurrent_no_loss_no_tearing(void) {
+  static SpscRing<Payload, 16> ring;
+  std::thread producer([&] {
+    Payload p;
+    for (uint32_t s = 1; s <= STRESS_ITEMS; s++) {
+      p.fill(s);
+      while (!ring.push(p)) std::this_thread::yield();   // One core on some CI boxes
+    }
+  });
+
+  uint32_t expect = 1, torn = 0, gaps = 0;
+  Payload  p;
+  while (expect <= STRESS_ITEMS) {
+    if (!ring.pop(p)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (!p.consistent()) torn++;
+    if (p.seq != expect) gaps++;
+    expect = p.seq + 1;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, gaps);
+  TEST_ASSERT_TRUE(ring.empty());
+}
+
+// ---------------- TripleBuffer ----------------
+void test_triple_buffer_latest_wins(void) {
+  Payload init;
+  init.fill(0);
+  TripleBuffer<Payload> buf(init);
+
+  TEST_ASSERT_FALSE(buf.update());             // Nothing published yet
+  TEST_ASSERT_EQUAL_UINT32(0, buf.front().seq);
+
+  for (uint32_t s = 1; s <= 3; s++) {
+    buf.back().fill(s);
+    buf.publish();
+  }
+  TEST_ASSERT_TRUE(buf.update());
+  TEST_ASSERT_EQUAL_UINT32(3, buf.front().seq);   // Intermediate values are skipped
+  TEST_ASSERT_FALSE(buf.update());
+  TEST_ASSERT_EQUAL_UINT32(3, buf.front().seq);   // front() stays put until the next publish
+}
+
+void test_triple_buffer_writer_never_touches_front(void) {
+  Payload init;
+  init.fill(0);
+  TripleBuffer<Payload> buf(init);
+  buf.back().fill(1);
+  buf.publish();
+  TEST_ASSERT_TRUE(buf.update());
+
+  const Payload *front = &buf.front();
+  for (uint32_t s = 2; s < 50; s++) {
+    TEST_ASSERT_TRUE(&buf.back() != front);
+    buf.back().fill(s);
+    buf.publish();
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, front->seq);
+  TEST_ASSERT_TRUE(front->consistent());
+}
+
+void test_triple_buffer_concurrent_snapshots(void) {
+  Payload init;
+  init.fill(0);
+  static TripleBuffer<Payload> buf(init);
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+    for (uint32_t s = 1; s <= STRESS_ITEMS; s++) {
+      buf.back().fill(s);
+      buf.publish();
+    }
+    done = true;
+  });
+
+  uint32_t last = 0, torn = 0, backwards = 0, updates = 0;
+  for (;;) {
+    bool finished = done;
+    if (buf.update()) {
+      updates++;
+      const Payload &p = buf.front();
+      if (!p.consistent()) torn++;
+      if (p.seq < last) backwards++;
+      last = p.seq;
+    } else if (finished) {
+      break;   // Everything was published before `done`, and nothing is left
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, backwards);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, updates);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_ITEMS, last);   // The final value always gets through
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_fifo_and_bounds);
+  RUN_TEST(test_ring_wraps_around);
+  RUN_TEST(test_ring_concurrent_no_loss_no_tearing);
+  RUN_TEST(test_triple_buffer_latest_wins);
+  RUN_TEST(test_triple_buffer_writer_never_touches_front);
+  RUN_TEST(test_triple_buffer_concurrent_snapshots);
+  return UNITY_END();
+}
@@ -0,0 +1,214 @@
+// Offline sample log: record format, boot stamps, recovery after a reboot or
+// a torn append, overflow, and a 24 h outage drained through the fake cloud
+// with the flash wear it cost (FS.h model).
+
+#include <unity.h>
+#include <chrono>
+#include "fake_hal.h"
+#include "gaia_config.h"
+#include "sample_log.h"
+#include <LittleFS.h>
+
+#define OUTAGE_MS      (24UL * 3600 * 1000)
+#define REQUEST_MS     300      // Assumed round trip of one batch write (resumed TLS)
+#define FLASH_CYCLES   100000   // NOR flash endurance per block
+#define MIN_LIFETIME_YEARS 10
+
+static Telemetry sampleAt(unsigned long ms, uint32_t i) {
+  return Telemetry{ 20.0f + (i % 100) / 10.0f, 40.0f + (i % 50), (int)(60 - i % 40), (int)(2000 + i % 900),
+                    (float)(i % 2000), ms };
+}
+
+void setUp(void) { LittleFS.reset(); }
+void tearDown(void) {}
+
+// ---------------- Record format ----------------
+void test_record_round_trip(void) {
+  Telemetry t = { -12.34f, 56.78f, 42, 3012, 65535.0f, 123456789UL };
+  LogRecord r;
+  logRecordPack(t, 7, 300, r);
+  TEST_ASSERT_EQUAL_size_t(16, sizeof(LogRecord));
+  TEST_ASSERT_TRUE(logRecordValid(r));
+
+  LoggedSample s;
+  logRecordUnpack(r, 300, s);
+  TEST_ASSERT_EQUAL_UINT8(7, s.plant);
+  TEST_ASSERT_EQUAL_UINT32(300, s.boot);
+  TEST_ASSERT_EQUAL_UINT32(123456789UL, s.data.timestamp);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -12.34f, s.data.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 56.78f, s.data.humidity);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 65535.0f, s.data.lux);
+  TEST_ASSERT_EQUAL_INT(42, s.data.soilMoisture);
+  TEST_ASSERT_EQUAL_INT(3012, s.data.soilRaw);
+
+  r.tempCenti ^= 1;
+  TEST_ASSERT_FALSE(logRecordValid(r));
+}
+
+void test_record_boot_widening(void) {
+  Telemetry t = { 20, 50, 50, 2000, 100, 1000 };
+  LogRecord r;
+  LoggedSample s;
+
+  logRecordPack(t, 0, 255, r);         // Written in boot 255, read in boot 256
+  logRecordUnpack(r, 256, s);
+  TEST_ASSERT_EQUAL_UINT32(255, s.boot);
+
+  logRecordPack(t, 0, 1000, r);        // 200 boots ago
+  logRecordUnpack(r, 1200, s);
+  TEST_ASSERT_EQUAL_UINT32(1000, s.boot);
+
+  logRecordPack(t, 0, 5, r);           // Same boot
+  logRecordUnpack(r, 5, s);
+  TEST_ASSERT_EQUAL_UINT32(5, s.boot);
+}
+
+void test_old_format_records_are_rejected(void) {
+  // Pre-boot-stamp layout: CRC-8 starting from 0 over the same 15 bytes
+  LogRecord r;
+  memset(&r, 0, sizeof(r));
+  r.timestamp = 5000;
+  r.luxPlantBoot = 1234 | (1u << 24);
+  uint8_t crc = 0;
+  const uint8_t *b = (const uint8_t *)&r;
+  for (size_t i = 0; i < sizeof(r) - 1; i++) {
+    crc ^= b[i];
+    for (int k = 0; k < 8; k++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+  r.crc = crc;
+  TEST_ASSERT_FALSE(logRecordValid(r));
+}
+
+// ---------------- Ring on flash ----------------
+void test_samples_across_a_reboot_keep_their_boot(void) {
+  {
+    SampleLog log;
+    TEST_ASSERT_TRUE(log.begin(41));
+    for (uint32_t i = 0; i < 10; i++) TEST_ASSERT_TRUE(log.append(sampleAt(900000 + i * 1000, i), 0));
+  }
+  SampleLog log;                       // Reboot: millis() starts over
+  TEST_ASSERT_TRUE(log.begin(42));
+  TEST_ASSERT_EQUAL_UINT32(10, log.pending());
+  for (uint32_t i = 0; i < 5; i++) TEST_ASSERT_TRUE(log.append(sampleAt(2000 + i * 1000, i), 1));
+
+  LoggedSample out[32];
+  size_t n = log.peek(out, 32);
+  TEST_ASSERT_EQUAL_size_t(15, n);
+  for (size_t i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_UINT32(i, out[i].seq);
+    TEST_ASSERT_EQUAL_UINT32(i < 10 ? 41 : 42, out[i].boot);
+    TEST_ASSERT_EQUAL_UINT8(i < 10 ? 0 : 1, out[i].plant);
+  }
+  // Later seq but an earlier timestamp: only the boot orders them
+  TEST_ASSERT_TRUE(out[10].data.timestamp < out[9].data.timestamp);
+}
+
+void test_torn_append_is_abandoned(void) {
+  {
+    SampleLog log;
+    log.begin(1);
+    for (uint32_t i = 0; i < 20; i++) log.append(sampleAt(i * 1000, i), 0);
+  }
+  // Power cut halfway through the 21st record
+  LittleFS.contents("/log/00000000.seg").append(7, '\xAA');
+
+  SampleLog log;
+  log.begin(2);
+  TEST_ASSERT_EQUAL_UINT32(LOG_SEG_RECORDS, log.pending());   // Head moved to the next segment
+  TEST_ASSERT_EQUAL_UINT32(1, log.droppedRecords());
+  TEST_ASSERT_TRUE(log.append(sampleAt(0, 99), 0));
+
+  LoggedSample out[BACKLOG_BATCH];
+  uint32_t got = 0, last = 0;
+  for (size_t n; (n = log.peek(out, BACKLOG_BATCH)) > 0; log.consumePeeked()) {
+    got += n;
+    last = out[n - 1].seq;
+  }
+  TEST_ASSERT_EQUAL_UINT32(21, got);                        // 20 whole records + the new one
+  TEST_ASSERT_EQUAL_UINT32(LOG_SEG_RECORDS, last);
+  TEST_ASSERT_EQUAL_UINT32(0, log.pending());
+}
+
+void test_overflow_drops_the_oldest_segment(void) {
+  SampleLog log;
+  log.begin(1);
+  const uint32_t capacity = (uint32_t)LOG_SEG_RECORDS * LOG_MAX_SEGMENTS;
+  for (uint32_t i = 0; i < capacity + 10; i++) TEST_ASSERT_TRUE(log.append(sampleAt(i, i), 0));
+
+  TEST_ASSERT_EQUAL_UINT32(LOG_SEG_RECORDS, log.droppedRecords());
+  TEST_ASSERT_EQUAL_UINT32(capacity - LOG_SEG_RECORDS + 10, log.pending());
+  LoggedSample out[1];
+  TEST_ASSERT_EQUAL_size_t(1, log.peek(out, 1));
+  TEST_ASSERT_EQUAL_UINT32(LOG_SEG_RECORDS, out[0].seq);   // Oldest surviving sample
+  TEST_ASSERT_TRUE(LittleFS.fileCount() <= LOG_MAX_SEGMENTS + 1);   // Segments + tail
+}
+
+// ---------------- 24 h outage ----------------
+void test_outage_24h_drain_and_wear(void) {
+  FakeCloud cloud;
+  const uint32_t records = OUTAGE_MS / OFFLINE_LOG_INTERVAL_MS;
+
+  // Offline for a day, with a reboot halfway through
+  fs::FlashStats before = LittleFS.stats;
+  uint32_t i = 0;
+  for (uint32_t boot = 7; boot <= 8; boot++) {
+    SampleLog log;
+    log.begin(boot);
+    for (unsigned long ms = 0; ms < OUTAGE_MS / 2; ms += OFFLINE_LOG_INTERVAL_MS, i++) {
+      TEST_ASSERT_TRUE(log.append(sampleAt(ms, i), 0));
+    }
+  }
+  fs::FlashStats logged = LittleFS.stats;
+
+  // Back online: drain the way drainBacklog() does
+  SampleLog log;
+  log.begin(9);
+  TEST_ASSERT_EQUAL_UINT32(records, log.pending());
+  LoggedSample batch[BACKLOG_BATCH];
+  uint32_t requests = 0, boot7 = 0, boot8 = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t n; (n = log.peek(batch, BACKLOG_BATCH)) > 0; log.consumePeeked()) {
+    TEST_ASSERT_TRUE(cloud.uploadBacklog(batch, n));
+    requests++;
+    for (size_t k = 0; k < n; k++) (batch[k].boot == 7 ? boot7 : boot8)++;
+  }
+  double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  fs::FlashStats drained = LittleFS.stats;
+
+  TEST_ASSERT_EQUAL_UINT32(0, log.pending());
+  TEST_ASSERT_EQUAL_UINT32(records, cloud.backlogSamples);
+  TEST_ASSERT_EQUAL_UINT32(0, cloud.backlogOutOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(records / 2, boot7);
+  TEST_ASSERT_EQUAL_UINT32(records / 2, boot8);
+  TEST_ASSERT_EQUAL_UINT32((records + BACKLOG_BATCH - 1) / BACKLOG_BATCH, requests);
+  TEST_ASSERT_EQUAL_size_t(2, LittleFS.fileCount());      // The tail pointer and the head segment, kept for appends
+
+  uint32_t blocks      = LittleFS.partitionBytes / FS_BLOCK_BYTES;
+  uint32_t erases      = drained.erases - before.erases;
+  float    perBlockDay = (float)erases / blocks;
+  printf("# 24 h outage: %lu samples, %lu KB of records\n", (unsigned long)records,
+    (unsigned long)(records * sizeof(LogRecord) / 1024));
+  printf("# drain: %lu requests of %d, %.0f KB payload, %.0f s at %d ms/request, %.1f ms host CPU\n",
+    (unsigned long)requests, BACKLOG_BATCH, cloud.bytes / 1024.0, requests * REQUEST_MS / 1000.0, REQUEST_MS, cpuMs);
+  printf("# flash: logging %lu KB programmed, %lu erases; draining %lu KB, %lu erases\n",
+    (unsigned long)((logged.programmedBytes - before.programmedBytes) / 1024), (unsigned long)(logged.erases - before.erases),
+    (unsigned long)((drained.programmedBytes - logged.programmedBytes) / 1024), (unsigned long)(drained.erases - logged.erases));
+  printf("# wear: %.2f erases per block (%lu blocks); %.0f years of daily outages to %d cycles\n",
+    perBlockDay, (unsigned long)blocks, FLASH_CYCLES / perBlockDay / 365.0f, FLASH_CYCLES);
+
+  // One commit per append dominates; even a day-long outage every day must
+  // leave the partition a product lifetime
+  TEST_ASSERT_TRUE(FLASH_CYCLES / perBlockDay / 365.0f > MIN_LIFETIME_YEARS);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_record_round_trip);
+  RUN_TEST(test_record_boot_widening);
+  RUN_TEST(test_old_format_records_are_rejected);
+  RUN_TEST(test_samples_across_a_reboot_keep_their_boot);
+  RUN_TEST(test_torn_append_is_abandoned);
+  RUN_TEST(test_overflow_drops_the_oldest_segment);
+  RUN_TEST(test_outage_24h_drain_and_wear);
+  return UNITY_END();
+}
@@ -0,0 +1,225 @@
+// Adaptive sensor periods: the sensor task's loop run against FakeSensors at
+// 1 s ticks. Covers the back-off to slowMs on steady readings, fastMs near a
+// threshold, baseMs on movement and failures, held values ageing out, and
+// the read counts and savings the [Sense] report prints.
+
+#include <unity.h>
+#include <vector>
+#include "fake_hal.h"
+#include "gaia_config.h"
+#include "sensor_schedule.h"
+
+static FakeSensors     sensors(2);
+static SensorScheduler sched;
+static PlantRack       rack;
+
+// One plant's turn of sensorTask; the times at which `kind` was read are appended to `reads`
+static Telemetry tick(uint8_t p, unsigned long now, std::vector<unsigned long> *reads = NULL, SenseKind kind = SENSE_AIR) {
+  sensors.nowMs = now;
+  if (sched.due(p, SENSE_AIR, now)) {
+    sched.store(p, FIELD_TEMPERATURE, sensors.readTemperature(p), sensors.airReadingMs(p));
+    sched.store(p, FIELD_HUMIDITY, sensors.readHumidity(p), sensors.airReadingMs(p));
+    sched.reschedule(p, SENSE_AIR, rack, now);
+    if (reads && kind == SENSE_AIR) reads->push_back(now);
+  }
+  if (sched.due(p, SENSE_SOIL, now)) {
+    sched.store(p, FIELD_SOIL_RAW, sensors.readMoistureRaw(p), now);
+    sched.store(p, FIELD_SOIL_MOISTURE, sensors.readMoisturePercent(p), now);
+    sched.reschedule(p, SENSE_SOIL, rack, now);
+    if (reads && kind == SENSE_SOIL) reads->push_back(now);
+  }
+  if (sched.due(p, SENSE_LIGHT, now)) {
+    float lux = sensors.readLux(p);
+    sched.store(p, FIELD_LIGHT, lux >= 0 ? lux : NAN, now);
+    sched.reschedule(p, SENSE_LIGHT, rack, now);
+    if (reads && kind == SENSE_LIGHT) reads->push_back(now);
+  }
+  Telemetry t;
+  sched.fill(p, t, now);
+  return t;
+}
+
+// Gaps between consecutive reads
+static std::vector<unsigned long> gaps(const std::vector<unsigned long> &reads) {
+  std::vector<unsigned long> g;
+  for (size_t i = 1; i < reads.size(); i++) g.push_back(reads[i] - reads[i - 1]);
+  return g;
+}
+
+void setUp(void) {
+  ThresholdSet th;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) th.plant[p] = PLANT_THRESHOLDS_DEFAULT;   // 30..85 %, 15..30 °C, 100..2000 lx, 30..80 %RH
+  rackSetThresholds(rack, th);
+  sensors = FakeSensors(2);
+  sched.configure(SENSE_CONFIG, 2, SAMPLE_PERIOD_MS);
+}
+void tearDown(void) {}
+
+// ---------------- Periods ----------------
+void test_steady_readings_back_off_to_slow(void) {
+  // Defaults are mid-range for every threshold: nothing near, nothing moving
+  std::vector<unsigned long> air, soil, light;
+  for (unsigned long now = 0; now < 300000; now += SAMPLE_PERIOD_MS) tick(0, now, &air, SENSE_AIR);
+  sched.configure(SENSE_CONFIG, 2, SAMPLE_PERIOD_MS);
+  for (unsigned long now = 0; now < 300000; now += SAMPLE_PERIOD_MS) tick(0, now, &soil, SENSE_SOIL);
+  sched.configure(SENSE_CONFIG, 2, SAMPLE_PERIOD_MS);
+  for (unsigned long now = 0; now < 300000; now += SAMPLE_PERIOD_MS) tick(0, now, &light, SENSE_LIGHT);
+
+  // First read "moves" (nothing before it) so baseMs, then doubling per steady read
+  const unsigned long airExpect[]   = { 2000, 4000, 8000, 8000 };
+  const unsigned long soilExpect[]  = { 5000, 10000, 20000, 40000, 60000, 60000 };
+  const unsigned long lightExpect[] = { 2000, 4000, 8000, 10000, 10000 };
+  std::vector<unsigned long> g = gaps(air);
+  for (size_t i = 0; i < 4; i++) TEST_ASSERT_EQUAL_UINT32(airExpect[i], g[i]);
+  g = gaps(soil);
+  for (size_t i = 0; i < 6; i++) TEST_ASSERT_EQUAL_UINT32(soilExpect[i], g[i]);
+  g = gaps(light);
+  for (size_t i = 0; i < 5; i++) TEST_ASSERT_EQUAL_UINT32(lightExpect[i], g[i]);
+  TEST_ASSERT_EQUAL_UINT32(8000, sched.period(0, SENSE_AIR));
+  TEST_ASSERT_EQUAL_UINT32(60000, sched.period(0, SENSE_SOIL));
+  TEST_ASSERT_EQUAL_UINT32(10000, sched.period(0, SENSE_LIGHT));
+}
+
+void test_near_a_threshold_reads_fast(void) {
+  // Soil slides from 50 % to the moistureLow of 30 %; within 10 % of the
+  // 55-point span (5.5 points) it's read every fastMs
+  std::vector<unsigned long> soil;
+  unsigned long now = 0;
+  for (; now < 600000; now += SAMPLE_PERIOD_MS) {
+    sensors.reading[0].soilMoisture = 50 - (int)(now / 30000);   // -1 point per 30 s, down to 30
+    tick(0, now, &soil, SENSE_SOIL);
+  }
+  bool sawFast = false;
+  for (size_t i = 1; i < soil.size(); i++) {
+    int level = 50 - (int)(soil[i - 1] / 30000);
+    unsigned long gap = soil[i] - soil[i - 1];
+    if (level - 30 < 5.5) {
+      TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_SOIL].fastMs, gap);
+      sawFast = true;
+    } else {
+      TEST_ASSERT_TRUE(gap >= SENSE_CONFIG[SENSE_SOIL].baseMs && gap <= SENSE_CONFIG[SENSE_SOIL].slowMs);
+    }
+  }
+  TEST_ASSERT_TRUE(sawFast);
+  TEST_ASSERT_TRUE(sched.stats(SENSE_SOIL).nearReads > 0);
+
+  // Watered back to mid-range: the jump is movement (baseMs), then back off again
+  sensors.reading[0].soilMoisture = 60;
+  std::vector<unsigned long> after;
+  for (unsigned long end = now + 120000; now < end; now += SAMPLE_PERIOD_MS) tick(0, now, &after, SENSE_SOIL);
+  std::vector<unsigned long> g = gaps(after);
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_SOIL].fastMs, after[0] - soil.back());   // Scheduled before the jump
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_SOIL].baseMs, g[0]);
+  TEST_ASSERT_EQUAL_UINT32(2 * SENSE_CONFIG[SENSE_SOIL].baseMs, g[1]);
+}
+
+void test_movement_resets_to_base(void) {
+  // Air backed off to slowMs; a 2 °C step (more than 2 % of the 15 °C span) snaps it back
+  unsigned long now = 0;
+  for (; now < 60000; now += SAMPLE_PERIOD_MS) tick(0, now);
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_AIR].slowMs, sched.period(0, SENSE_AIR));
+
+  sensors.reading[0].temperature = 24.0f;
+  std::vector<unsigned long> air;
+  for (unsigned long end = now + 30000; now < end; now += SAMPLE_PERIOD_MS) tick(0, now, &air);
+  TEST_ASSERT_TRUE(air.size() >= 2);
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_AIR].baseMs, air[1] - air[0]);
+
+  // A change below stableFraction (0.2 °C < 0.3 °C) is not movement
+  for (unsigned long end = now + 60000; now < end; now += SAMPLE_PERIOD_MS) tick(0, now);
+  sensors.reading[0].temperature = 24.2f;
+  air.clear();
+  for (unsigned long end = now + 30000; now < end; now += SAMPLE_PERIOD_MS) tick(0, now, &air);
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_AIR].slowMs, air[1] - air[0]);
+}
+
+void test_threshold_change_is_seen_at_the_next_read(void) {
+  // The app moves plant 0's luxLow up to just below the current light level
+  unsigned long now = 0;
+  for (; now < 60000; now += SAMPLE_PERIOD_MS) {
+    tick(0, now);
+    tick(1, now);
+  }
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_LIGHT].slowMs, sched.period(0, SENSE_LIGHT));
+  rack.threshold[TH_LUX_LOW][0] = 480.0f;   // 20 lx below 500, within 3 % of the 1520 lx span
+  std::vector<unsigned long> light;
+  for (unsigned long end = now + 30000; now < end; now += SAMPLE_PERIOD_MS) {
+    tick(0, now, &light, SENSE_LIGHT);
+    tick(1, now);
+  }
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_LIGHT].fastMs, light[1] - light[0]);
+  TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_LIGHT].slowMs, sched.period(1, SENSE_LIGHT));   // Other plant unaffected
+}
+
+// ---------------- Failures and ageing ----------------
+void test_failed_reads_retry_at_base_and_values_age_out(void) {
+  unsigned long now = 0;
+  for (; now < 60000; now += SAMPLE_PERIOD_MS) tick(0, now);
+  sensors.failAir = true;
+  std::vector<unsigned long> air;
+  unsigned long failedAt = now;
+  unsigned long lastGood = 0;
+  bool sawNan = false;
+  for (unsigned long end = now + 40000; now < end; now += SAMPLE_PERIOD_MS) {
+    Telemetry t = tick(0, now, &air);
+    lastGood = sched.value(0, FIELD_TEMPERATURE).atMs;
+    // Held until maxAgeMs after the last good read, then missing
+    bool fresh = now - lastGood <= SENSE_CONFIG[SENSE_AIR].maxAgeMs;
+    TEST_ASSERT_EQUAL(fresh, !isnan(t.temperature));
+    if (fresh) TEST_ASSERT_EQUAL_FLOAT(22.0f, t.temperature);
+    sawNan |= isnan(t.temperature);
+  }
+  TEST_ASSERT_TRUE(sawNan);
+  TEST_ASSERT_TRUE(lastGood < failedAt);
+  std::vector<unsigned long> g = gaps(air);
+  for (unsigned long x : g) TEST_ASSERT_EQUAL_UINT32(SENSE_CONFIG[SENSE_AIR].baseMs, x);
+  TEST_ASSERT_EQUAL_UINT32(air.size(), sched.stats(SENSE_AIR).failedReads);
+
+  // A failed light read is 0 lux once it ages out, as before
+  sensors.failLight = true;
+  Telemetry t;
+  for (unsigned long end = now + 40000; now < end; now += SAMPLE_PERIOD_MS) t = tick(0, now);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, t.lux);
+  TEST_ASSERT_FALSE(sched.value(0, FIELD_LIGHT).valid);
+
+  // Recovery: fresh again at the next base-period read
+  sensors.failAir = false;
+  t = tick(0, now + SENSE_CONFIG[SENSE_AIR].baseMs);
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, t.temperature);
+}
+
+// ---------------- Report ----------------
+void test_read_counts_and_savings(void) {
+  // Two plants for an hour, steady: what the [Sense] line reports
+  for (unsigned long now = 0; now < 3600000UL; now += SAMPLE_PERIOD_MS) {
+    tick(0, now);
+    tick(1, now);
+  }
+  const SenseStats &air = sched.stats(SENSE_AIR);
+  TEST_ASSERT_EQUAL_UINT32(2 * 3600, air.ticks);
+  // Per plant: reads at 0, 2, 6, 14 s, then every 8 s
+  uint32_t perPlant = 4 + (3600000UL - 14000 - 1) / 8000;
+  TEST_ASSERT_EQUAL_UINT32(2 * perPlant, sensors.airReads);
+  TEST_ASSERT_EQUAL_UINT32(2 * perPlant, air.reads);
+  TEST_ASSERT_EQUAL_UINT32(0, air.nearReads);
+  TEST_ASSERT_UINT32_WITHIN(100, 8000, sched.meanPeriodMs(SENSE_AIR));
+
+  // Skipped against one read per 2 s per plant, 5.7 ms each
+  uint32_t skipped = 2 * 1800 - air.reads;
+  TEST_ASSERT_EQUAL_UINT32(skipped * 5700, sched.savedUsPerHour(SENSE_AIR));
+  TEST_ASSERT_EQUAL_UINT32(0, sched.savedUsPerHour(SENSE_SOIL));   // readUs 0
+  printf("# air 1 read per %.1f s, %lu ms/h saved; soil per %.1f s; light per %.1f s\n",
+    sched.meanPeriodMs(SENSE_AIR) / 1000.0, (unsigned long)(sched.savedUsPerHour(SENSE_AIR) / 1000),
+    sched.meanPeriodMs(SENSE_SOIL) / 1000.0, sched.meanPeriodMs(SENSE_LIGHT) / 1000.0);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_readings_back_off_to_slow);
+  RUN_TEST(test_near_a_threshold_reads_fast);
+  RUN_TEST(test_movement_resets_to_base);
+  RUN_TEST(test_threshold_change_is_seen_at_the_next_read);
+  RUN_TEST(test_failed_reads_retry_at_base_and_values_age_out);
+  RUN_TEST(test_read_counts_and_savings);
+  return UNITY_END();
+}
@@ -0,0 +1,155 @@
+// ADC frame reductions and the EMA smoother against plain references:
+// sort-then-average for the trimmed mean, the closed-form step response and
+// noise gain for the EMA. Frame sizes are the ones soil_moisture.cpp uses.
+
+#include <unity.h>
+#include <math.h>
+#include <algorithm>
+#include "signal_filters.h"
+
+#define FRAME_SAMPLES 200   // Continuous mode: 10 ms at 20 kHz, trim 20 %
+#define FRAME_TRIM    40
+#define BURST_SAMPLES 64    // One-shot mode
+#define BURST_TRIM    12
+
+static uint32_t rng = 99;
+static uint32_t nextRand() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+// Roughly Gaussian (sum of uniforms), zero mean, unit variance
+static float gauss() {
+  float s = 0;
+  for (int i = 0; i < 12; i++) s += (nextRand() % 10000) / 10000.0f;
+  return s - 6.0f;
+}
+
+static float referenceTrimmedMean(const uint16_t *in, size_t n, size_t trim) {
+  uint16_t sorted[FRAME_SAMPLES];
+  std::copy(in, in + n, sorted);
+  std::sort(sorted, sorted + n);
+  double sum = 0;
+  for (size_t i = trim; i < n - trim; i++) sum += sorted[i];
+  return (float)(sum / (n - 2 * trim));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------- Reductions ----------------
+void test_median(void) {
+  uint16_t odd[]  = { 9, 1, 5, 3, 7 };
+  uint16_t even[] = { 4, 1, 3, 2 };
+  uint16_t one[]  = { 42 };
+  TEST_ASSERT_EQUAL_UINT16(5, medianU16(odd, 5));
+  TEST_ASSERT_EQUAL_UINT16(3, medianU16(even, 4));   // Upper of the two middle values
+  TEST_ASSERT_EQUAL_UINT16(42, medianU16(one, 1));
+}
+
+void test_trimmed_mean_matches_reference(void) {
+  uint16_t frame[FRAME_SAMPLES], work[FRAME_SAMPLES];
+  static const size_t SIZES[][2] = {
+    { FRAME_SAMPLES, FRAME_TRIM }, { BURST_SAMPLES, BURST_TRIM }, { 17, 3 }, { 10, 0 }, { 3, 1 }, { 2, 0 },
+  };
+  for (const auto &sz : SIZES) {
+    for (int trial = 0; trial < 200; trial++) {
+      for (size_t i = 0; i < sz[0]; i++) {
+        // Mostly a noisy level, sometimes a full-scale spike, often repeats
+        uint32_t r = nextRand();
+        frame[i] = r % 20 == 0 ? (r >> 8) % 4096 : 2000 + (r >> 8) % 16;
+      }
+      std::copy(frame, frame + sz[0], work);
+      float got = trimmedMeanU16(work, sz[0], sz[1]);
+      TEST_ASSERT_FLOAT_WITHIN(1e-3f, referenceTrimmedMean(frame, sz[0], sz[1]), got);
+      // Only reordered: the same multiset is still in the buffer
+      std::sort(work, work + sz[0]);
+      std::sort(frame, frame + sz[0]);
+      TEST_ASSERT_EQUAL_UINT16_ARRAY(frame, work, sz[0]);
+    }
+  }
+}
+
+void test_trimmed_mean_rejects_spikes(void) {
+  // 200-sample frame at 1800 ± 8 counts with 15 % of it full-scale spikes
+  uint16_t frame[FRAME_SAMPLES];
+  double   plain = 0;
+  for (int i = 0; i < FRAME_SAMPLES; i++) {
+    frame[i] = i % 7 == 0 ? 4095 : 1800 + (int)(nextRand() % 17) - 8;
+    plain += frame[i];
+  }
+  plain /= FRAME_SAMPLES;
+  float trimmed = trimmedMeanU16(frame, FRAME_SAMPLES, FRAME_TRIM);
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, 1800.0f, trimmed);
+  TEST_ASSERT_TRUE(fabs(plain - 1800.0) > 50.0);   // What the spikes do to a plain mean
+}
+
+void test_trimmed_mean_edge_cases(void) {
+  uint16_t empty[1] = { 0 };
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, trimmedMeanU16(empty, 0, 0));
+
+  uint16_t four[] = { 10, 1000, 20, 30 };
+  TEST_ASSERT_EQUAL_FLOAT(265.0f, trimmedMeanU16(four, 4, 0));   // trim 0 = plain mean
+  uint16_t over[] = { 10, 1000, 20, 30, 40 };
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, trimmedMeanU16(over, 5, 3));    // 2 * trim >= n: median
+  uint16_t same[BURST_SAMPLES];
+  std::fill(same, same + BURST_SAMPLES, 4095);
+  TEST_ASSERT_EQUAL_FLOAT(4095.0f, trimmedMeanU16(same, BURST_SAMPLES, BURST_TRIM));
+}
+
+// ---------------- EMA ----------------
+void test_ema_primes_on_the_first_sample(void) {
+  EmaFilter ema(0.1f);
+  TEST_ASSERT_FALSE(ema.primed);
+  TEST_ASSERT_EQUAL_FLOAT(1234.0f, ema.update(1234.0f));
+  TEST_ASSERT_EQUAL_FLOAT(1234.0f + 0.1f * (1000.0f - 1234.0f), ema.update(1000.0f));
+
+  EmaFilter pass(1.0f);
+  pass.update(5.0f);
+  TEST_ASSERT_EQUAL_FLOAT(-3.0f, pass.update(-3.0f));
+}
+
+void test_ema_step_response(void) {
+  static const float ALPHAS[] = { 0.05f, 0.1f, 0.3f };
+  for (float alpha : ALPHAS) {
+    EmaFilter ema(alpha);
+    ema.update(0.0f);
+    for (int k = 1; k <= 100; k++) {
+      float y = ema.update(1.0f);
+      TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f - powf(1.0f - alpha, (float)k), y);
+    }
+  }
+}
+
+void test_ema_noise_gain(void) {
+  // White noise through y += a (x - y) keeps a / (2 - a) of its variance
+  static const float ALPHAS[] = { 0.1f, 0.3f };
+  for (float alpha : ALPHAS) {
+    EmaFilter ema(alpha);
+    const int n = 200000, settle = 1000;
+    double sum = 0, sumSq = 0;
+    for (int i = 0; i < n; i++) {
+      float y = ema.update(100.0f + gauss());
+      if (i < settle) continue;
+      sum   += y;
+      sumSq += (double)y * y;
+    }
+    double mean = sum / (n - settle);
+    double var  = sumSq / (n - settle) - mean * mean;
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 100.0f, (float)mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f * alpha / (2 - alpha), alpha / (2 - alpha), (float)var);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_median);
+  RUN_TEST(test_trimmed_mean_matches_reference);
+  RUN_TEST(test_trimmed_mean_rejects_spikes);
+  RUN_TEST(test_trimmed_mean_edge_cases);
+  RUN_TEST(test_ema_primes_on_the_first_sample);
+  RUN_TEST(test_ema_step_response);
+  RUN_TEST(test_ema_noise_gain);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+// Allocation-free serializer: number formatting, string escaping, commas
+// between nested objects, the counting pass and draining, and no heap use
+// on the upload paths (global operator new is counted).
+
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include "telemetry_json.h"
+
+static size_t allocations = 0;
+
+void *operator new(size_t n) {
+  allocations++;
+  void *p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static char buf[2048];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Terminated copy of what write() produced; valid until the next call
+template <typename F>
+static const char *render(F write) {
+  static char text[sizeof(buf) + 1];
+  JsonOut out(buf, sizeof(buf));
+  write(out);
+  TEST_ASSERT_TRUE(out.ok());
+  memcpy(text, out.data(), out.length());
+  text[out.length()] = '\0';
+  return text;
+}
+
+// ---------------- Numbers ----------------
+void test_fixed_formatting(void) {
+  TEST_ASSERT_EQUAL_STRING("22.5", render([](JsonOut &o) { o.fixed(22.5f, 2); }));
+  TEST_ASSERT_EQUAL_STRING("22.46", render([](JsonOut &o) { o.fixed(22.456f, 2); }));
+  TEST_ASSERT_EQUAL_STRING("-3.1", render([](JsonOut &o) { o.fixed(-3.1f, 1); }));
+  TEST_ASSERT_EQUAL_STRING("0", render([](JsonOut &o) { o.fixed(-0.004f, 2); }));
+  TEST_ASSERT_EQUAL_STRING("100", render([](JsonOut &o) { o.fixed(99.996f, 2); }));
+  TEST_ASSERT_EQUAL_STRING("null", render([](JsonOut &o) { o.fixed(NAN, 1); }));
+  TEST_ASSERT_EQUAL_STRING("null", render([](JsonOut &o) { o.fixed(INFINITY, 1); }));
+}
+
+void test_integers(void) {
+  TEST_ASSERT_EQUAL_STRING("-2147483648", render([](JsonOut &o) { o.integer(INT32_MIN); }));
+  TEST_ASSERT_EQUAL_STRING("4294967295", render([](JsonOut &o) { o.uinteger(UINT32_MAX); }));
+  TEST_ASSERT_EQUAL_STRING("0", render([](JsonOut &o) { o.integer(0); }));
+}
+
+// ---------------- Strings ----------------
+void test_string_escaping(void) {
+  TEST_ASSERT_EQUAL_STRING("\"Monstera\"", render([](JsonOut &o) { o.string("Monstera"); }));
+  TEST_ASSERT_EQUAL_STRING("\"say \\\"hi\\\"\"", render([](JsonOut &o) { o.string("say \"hi\""); }));
+  TEST_ASSERT_EQUAL_STRING("\"C:\\\\pots\"", render([](JsonOut &o) { o.string("C:\\pots"); }));
+  TEST_ASSERT_EQUAL_STRING("\"a\\nb\\tc\\rd\"", render([](JsonOut &o) { o.string("a\nb\tc\rd"); }));
+  TEST_ASSERT_EQUAL_STRING("\"\\u0001\\u001f\"", render([](JsonOut &o) { o.string("\x01\x1f"); }));
+  TEST_ASSERT_EQUAL_STRING("\"Φίκος\"", render([](JsonOut &o) { o.string("Φίκος"); }));   // UTF-8 as is
+}
+
+static void keepSpecies(void *ctx, const char *key, const char *value, bool isString) {
+  if (isString && !strcmp(key, "species")) strcpy((char *)ctx, value);
+}
+
+void test_escaped_string_reads_back(void) {
+  const char *name = "Aloe \"vera\" \\ 2\n";
+  std::string json = render([&](JsonOut &o) {
+    o.beginObject();
+    o.key(NULL, "species");
+    o.string(name);
+    o.endObject();
+  });
+  char back[JSON_SCAN_VALUE_MAX] = "";
+  TEST_ASSERT_TRUE(jsonScanObject(json.data(), json.size(), keepSpecies, back));
+  TEST_ASSERT_EQUAL_STRING(name, back);
+}
+
+// ---------------- Objects ----------------
+void test_commas_after_nested_objects(void) {
+  std::string json = render([](JsonOut &o) {
+    o.beginObject();
+    o.key(NULL, "a");
+    o.beginObject();
+    o.endObject();                  // Empty member object
+    o.key(NULL, "b");
+    o.beginObject();
+    o.key(NULL, "x");
+    o.integer(1);
+    o.endObject();
+    o.key(NULL, "c");
+    o.integer(2);
+    o.endObject();
+  });
+  TEST_ASSERT_EQUAL_STRING("{\"a\":{},\"b\":{\"x\":1},\"c\":2}", json.c_str());
+}
+
+// ---------------- Buffering ----------------
+static std::string drained;
+static bool drainAll(void *, const char *data, size_t len) {
+  drained.append(data, len);
+  return true;
+}
+
+static void rackBody(JsonOut &o) {
+  Telemetry t = { 22.25f, 48.5f, 61, 2105, 812.5f, 123456 };
+  o.beginObject();
+  jsonTelemetry(o, "gaia_01/", t, FIELD_MASK_ALL);
+  jsonTelemetry(o, "gaia_02/", t, FIELD_BIT(FIELD_TEMPERATURE) | FIELD_BIT(FIELD_LIGHT));
+  o.endObject();
+}
+
+void test_counting_pass_and_drain_match(void) {
+  std::string whole = render(rackBody);
+
+  JsonOut count(NULL, 0);
+  rackBody(count);
+  TEST_ASSERT_EQUAL_size_t(whole.size(), count.total());
+
+  // A 7-byte buffer drains mid-key and mid-number
+  drained.clear();
+  char small[7];
+  JsonOut out(small, sizeof(small), drainAll, NULL);
+  rackBody(out);
+  TEST_ASSERT_TRUE(out.finish());
+  TEST_ASSERT_EQUAL_STRING(whole.c_str(), drained.c_str());
+  TEST_ASSERT_EQUAL_size_t(whole.size(), out.total());
+}
+
+void test_overflow_without_drain_is_reported(void) {
+  char small[16];
+  JsonOut out(small, sizeof(small));
+  rackBody(out);
+  TEST_ASSERT_FALSE(out.ok());
+  TEST_ASSERT_FALSE(out.finish());
+}
+
+// ---------------- Heap ----------------
+void test_no_allocations(void) {
+  Telemetry t = { 21.5f, 50.0f, 40, 2000, 300.0f, 1000 };
+  char small[64];
+  uint8_t cbor[TELEMETRY_CBOR_MAX];
+
+  size_t before = allocations;
+  for (int i = 0; i < 100; i++) {
+    JsonOut count(NULL, 0);
+    rackBody(count);
+    JsonOut out(small, sizeof(small), [](void *, const char *, size_t) { return true; }, NULL);
+    rackBody(out);
+    out.finish();
+    t.timestamp = i;
+    cborTelemetry(t, FIELD_MASK_ALL, cbor, sizeof(cbor));
+  }
+  TEST_ASSERT_EQUAL_size_t(0, allocations - before);
+
+  // The counter works
+  std::string *probe = new std::string("x");
+  delete probe;
+  TEST_ASSERT_TRUE(allocations > before);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_formatting);
+  RUN_TEST(test_integers);
+  RUN_TEST(test_string_escaping);
+  RUN_TEST(test_escaped_string_reads_back);
+  RUN_TEST(test_commas_after_nested_objects);
+  RUN_TEST(test_counting_pass_and_drain_match);
+  RUN_TEST(test_overflow_without_drain_is_reported);
+  RUN_TEST(test_no_allocations);
+  return UNITY_END();
+}
@@ -0,0 +1,256 @@
+// Thirst forecast: the float RLS fit against a brute-force weighted least
+// squares solve in double over every sample since the last watering, and the
+// forecast against the time the simulated pot actually crosses moistureLow.
+
+#include <unity.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "thirst_forecast.h"
+
+#define MINUTE_MS 60000UL
+#define HOUR_MS   3600000UL
+#define P0        100.0    // FORECAST_P0 in thirst_forecast.cpp
+
+static const ForecastConfig CFG = FORECAST_CONFIG_DEFAULT;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Minimises, at the newest sample's time tn,
+//   sum_i lambda^(n-i) (y_i - level - slope (t_i - tn))^2
+//   + lambda^n ((level + slope (t0 - tn) - y0)^2 + slope^2) / P0
+// where y0 at t0 is the reading that (re)started the fit. This is what the
+// recursion computes, solved from scratch each time.
+struct Reference {
+  double t0 = 0, y0 = 0;
+  std::vector<double> t, y;
+  double level = 0, slope = 0;   // At lastH
+  double lastH = 0;
+  bool primed = false;
+  uint32_t waterings = 0;
+  unsigned long wateredMs = 0;
+
+  void update(double y, unsigned long ms) {
+    double hours = ms / (double)HOUR_MS;
+    if (!primed) {
+      primed = true;
+      restart(y, hours);
+      return;
+    }
+    if (y - (level + slope * (hours - lastH)) > CFG.wateringStep) {
+      if (!wateredMs || ms - wateredMs > 1800000) waterings++;
+      wateredMs = ms;
+      restart(y, hours);
+      return;
+    }
+    this->t.push_back(hours);
+    this->y.push_back(y);
+    lastH = hours;
+    solve();
+  }
+
+  void restart(double y, double hours) {
+    t0 = lastH = hours;
+    y0 = y;
+    t.clear();
+    this->y.clear();
+    level = y;
+    slope = 0;
+  }
+
+  void solve() {
+    size_t n  = t.size();
+    double tn = t.back();
+    double lam = CFG.lambda;
+    double prior = pow(lam, (double)n) / P0;
+    // Normal equations A [level slope]' = b
+    double d0 = t0 - tn;
+    double a00 = prior, a01 = prior * d0, a11 = prior * (d0 * d0 + 1);
+    double b0 = prior * y0, b1 = prior * y0 * d0;
+    for (size_t i = 0; i < n; i++) {
+      double w = pow(lam, (double)(n - 1 - i));
+      double d = t[i] - tn;
+      a00 += w;
+      a01 += w * d;
+      a11 += w * d * d;
+      b0  += w * y[i];
+      b1  += w * y[i] * d;
+    }
+    double det = a00 * a11 - a01 * a01;
+    level = (b0 * a11 - b1 * a01) / det;
+    slope = (a00 * b1 - a01 * b0) / det;
+  }
+};
+
+// A pot drying exponentially towards a residual level, read at 1 Hz as an
+// integer percent and averaged per minute (what main.cpp feeds the forecaster)
+struct Pot {
+  double floorLevel, k;   // %, 1/h
+  double start;           // Level after watering
+  double wateredH;
+
+  double at(double hours) const { return floorLevel + (start - floorLevel) * exp(-k * (hours - wateredH)); }
+
+  // Hours from `hours` until the true level drops to `low`, by stepping a minute at a time
+  double hoursUntil(double hours, int low) const {
+    for (double h = hours; h < hours + 2000; h += 1.0 / 60) {
+      if (at(h) <= low) return h - hours;
+    }
+    return INFINITY;
+  }
+};
+
+static float minuteMean(const Pot &pot, unsigned long endMs, std::mt19937 &rng) {
+  std::normal_distribution<double> noise(0.0, 0.7);
+  double sum = 0;
+  for (int s = 0; s < 60; s++) {
+    double h = (endMs - MINUTE_MS + s * 1000UL) / (double)HOUR_MS;
+    sum += lround(pot.at(h) + noise(rng));
+  }
+  return (float)(sum / 60);
+}
+
+// ---------------- Fit ----------------
+void test_rls_matches_weighted_least_squares(void) {
+  // Three days of drying, then a watering and two more, from a boot three
+  // weeks in (large millis() values)
+  const unsigned long boot = 21 * 24 * HOUR_MS;
+  Pot pot = { 18.0, 0.02, 85.0, boot / (double)HOUR_MS };
+  std::mt19937 rng(4);
+  ThirstForecaster f;
+  Reference ref;
+  double worstLevel = 0, worstSlope = 0;
+  for (unsigned long m = 1; m <= 5 * 24 * 60; m++) {
+    unsigned long ms = boot + m * MINUTE_MS;
+    if (m == 3 * 24 * 60) {
+      pot.start    = 80.0;
+      pot.wateredH = ms / (double)HOUR_MS;
+    }
+    float y = minuteMean(pot, ms, rng);
+    bool watered = f.update(y, ms);
+    uint32_t before = ref.waterings;
+    ref.update(y, ms);
+    TEST_ASSERT_EQUAL(ref.waterings != before, watered);
+
+    ThirstForecast got = f.forecast(25);
+    worstLevel = fmax(worstLevel, fabs(got.level - ref.level));
+    worstSlope = fmax(worstSlope, fabs(-got.dryingRate - ref.slope));
+  }
+  printf("# worst |level| %.2e %%, |slope| %.2e %%/h\n", worstLevel, worstSlope);
+  TEST_ASSERT_EQUAL_UINT32(1, f.forecast(25).waterings);
+  TEST_ASSERT_EQUAL_UINT32(1, ref.waterings);
+  TEST_ASSERT_TRUE(worstLevel < 0.01);
+  TEST_ASSERT_TRUE(worstSlope < 0.005);
+}
+
+void test_first_reading_and_warmup(void) {
+  ThirstForecaster f;
+  ThirstForecast none = f.forecast(25);
+  TEST_ASSERT_TRUE(isnan(none.level));
+  TEST_ASSERT_TRUE(isnan(none.hoursToThirsty));
+  TEST_ASSERT_FALSE(f.primed());
+
+  for (uint16_t i = 0; i < CFG.warmup - 1; i++) f.update(60.0f - i * 0.01f, 5000 + i * MINUTE_MS);
+  TEST_ASSERT_TRUE(isnan(f.forecast(25).hoursToThirsty));   // One short
+  f.update(60.0f - (CFG.warmup - 1) * 0.01f, 5000 + (CFG.warmup - 1) * MINUTE_MS);
+  TEST_ASSERT_FALSE(isnan(f.forecast(25).hoursToThirsty));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.6f, f.forecast(25).dryingRate);
+}
+
+void test_steps_close_together_are_one_watering(void) {
+  ThirstForecaster f;
+  unsigned long ms = 0;
+  for (int i = 0; i < 200; i++) f.update(40.0f, ms += MINUTE_MS);
+  TEST_ASSERT_TRUE(f.update(60.0f, ms += MINUTE_MS));
+  TEST_ASSERT_FALSE(f.update(75.0f, ms += 10 * MINUTE_MS));   // Still soaking in
+  TEST_ASSERT_EQUAL_UINT32(1, f.forecast(25).waterings);
+  TEST_ASSERT_EQUAL_FLOAT(75.0f, f.forecast(25).level);
+  TEST_ASSERT_TRUE(isnan(f.forecast(25).hoursToThirsty));    // Warming up again
+  for (int i = 0; i < 60; i++) f.update(75.0f, ms += MINUTE_MS);
+  TEST_ASSERT_TRUE(f.update(90.0f, ms += MINUTE_MS));
+  TEST_ASSERT_EQUAL_UINT32(2, f.forecast(25).waterings);
+  TEST_ASSERT_EQUAL_UINT32(ms, f.forecast(25).lastWateredMs);
+}
+
+// ---------------- Forecast ----------------
+void test_line_forecast_before_the_rate_model(void) {
+  // Linear drying at 0.5 %/h: the line is the truth
+  ForecastConfig dayCfg = CFG;
+  dayCfg.maxHours = 24;
+  ThirstForecaster f, day(dayCfg);
+  std::mt19937 rng(8);
+  std::normal_distribution<double> noise(0.0, 0.1);
+  unsigned long ms = 0;
+  for (int m = 0; m < 6 * 60; m++) {
+    ms += MINUTE_MS;
+    float y = (float)(70.0 - 0.5 * ms / HOUR_MS + noise(rng));
+    f.update(y, ms);
+    day.update(y, ms);
+  }
+  ThirstForecast got = f.forecast(25);
+  double truth = (70.0 - 0.5 * ms / HOUR_MS - 25) / 0.5;   // 84 h
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, (float)truth, got.hoursToThirsty);   // 3 h of noisy samples
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, f.forecast(80).hoursToThirsty);   // Already below
+  TEST_ASSERT_TRUE(isnan(day.forecast(25).hoursToThirsty));       // Past maxHours
+}
+
+void test_exponential_forecast_against_the_pot(void) {
+  // A week of drydowns, watered back to 85 % whenever it reaches 30 %. Once
+  // the rate model has learned the curve, each forecast is compared with the
+  // minute the simulated pot actually crosses moistureLow.
+  const int low = 30;
+  Pot pot = { 15.0, 0.03, 85.0, 0.0 };
+  std::mt19937 rng(12);
+  ThirstForecaster f;
+  double worst = 0;
+  uint32_t checked = 0;
+  for (unsigned long m = 1; m <= 10 * 24 * 60; m++) {
+    unsigned long ms = m * MINUTE_MS;
+    double hours = ms / (double)HOUR_MS;
+    if (pot.at(hours) <= low) {
+      pot.wateredH = hours;
+    }
+    f.update(minuteMean(pot, ms, rng), ms);
+
+    ThirstForecast got = f.forecast(low);
+    if (m < 3 * 24 * 60 || isnan(got.hoursToThirsty) || m % 60) continue;
+    double truth = pot.hoursUntil(hours, low);
+    if (truth < 6) continue;   // The last hours are dominated by the reading noise
+    worst = fmax(worst, fabs(got.hoursToThirsty - truth) / truth);
+    checked++;
+  }
+  printf("# %u hourly forecasts, worst relative error %.3f\n", checked, worst);
+  TEST_ASSERT_TRUE(checked > 50);
+  TEST_ASSERT_TRUE(worst < 0.10);
+
+  // The line alone would be early by far near the top of a drydown
+  Pot top = pot;
+  top.wateredH = 0;
+  double lineHours = (top.at(0) - low) / (top.k * (top.at(0) - top.floorLevel));
+  TEST_ASSERT_TRUE(lineHours < 0.6 * top.hoursUntil(0, low));
+}
+
+void test_levels_off_above_low(void) {
+  // Residual level above moistureLow: never thirsty
+  Pot pot = { 35.0, 0.05, 85.0, 0.0 };
+  std::mt19937 rng(3);
+  ThirstForecaster f;
+  for (unsigned long m = 1; m <= 4 * 24 * 60; m++) {
+    unsigned long ms = m * MINUTE_MS;
+    if (m % (24 * 60) == 0) pot.wateredH = ms / (double)HOUR_MS;   // Watered daily
+    f.update(minuteMean(pot, ms, rng), ms);
+  }
+  TEST_ASSERT_TRUE(isnan(f.forecast(25).hoursToThirsty));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rls_matches_weighted_least_squares);
+  RUN_TEST(test_first_reading_and_warmup);
+  RUN_TEST(test_steps_close_together_are_one_watering);
+  RUN_TEST(test_line_forecast_before_the_rate_model);
+  RUN_TEST(test_exponential_forecast_against_the_pot);
+  RUN_TEST(test_levels_off_above_low);
+  return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// Threshold parsing: the flat-object reader (jsonScanObject) and how the
+// app's thresholds node is applied from a GET answer or an MQTT message.
+
+#include <unity.h>
+#include "plant_thresholds.h"
+#include "telemetry_json.h"
+
+static const PlantThresholds DEFAULTS = PLANT_THRESHOLDS_DEFAULT;
+
+struct Seen {
+  int  count;
+  char keys[8][JSON_SCAN_KEY_MAX];
+  char values[8][JSON_SCAN_VALUE_MAX];
+  bool strings[8];
+};
+
+static void collect(void *ctx, const char *key, const char *value, bool isString) {
+  Seen &s = *(Seen *)ctx;
+  if (s.count >= 8) return;
+  strcpy(s.keys[s.count], key);
+  strcpy(s.values[s.count], value);
+  s.strings[s.count] = isString;
+  s.count++;
+}
+
+static bool scan(const char *json, Seen &seen) {
+  seen = Seen{};
+  return jsonScanObject(json, strlen(json), collect, &seen);
+}
+
+static bool apply(const char *json, PlantThresholds &th) {
+  return thresholdsApplyJson(json, strlen(json), th);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------- Reader ----------------
+void test_scan_members_and_types(void) {
+  Seen s;
+  TEST_ASSERT_TRUE(scan(" {\n \"a\" : 12 , \"b\":-3.5,\"c\":\"x y\",\"d\":true,\"e\":null}\r\n", s));
+  TEST_ASSERT_EQUAL_INT(5, s.count);
+  TEST_ASSERT_EQUAL_STRING("a", s.keys[0]);
+  TEST_ASSERT_EQUAL_STRING("12", s.values[0]);
+  TEST_ASSERT_EQUAL_STRING("-3.5", s.values[1]);
+  TEST_ASSERT_EQUAL_STRING("x y", s.values[2]);
+  TEST_ASSERT_TRUE(s.strings[2]);
+  TEST_ASSERT_FALSE(s.strings[3]);
+  TEST_ASSERT_EQUAL_STRING("true", s.values[3]);
+  TEST_ASSERT_EQUAL_STRING("null", s.values[4]);
+}
+
+void test_scan_escapes_and_truncation(void) {
+  Seen s;
+  TEST_ASSERT_TRUE(scan("{\"k\":\"a\\\"b\\\\c\\nd\\u00e9\"}", s));
+  TEST_ASSERT_EQUAL_STRING("a\"b\\c\nd?", s.values[0]);
+
+  char json[256];
+  snprintf(json, sizeof(json), "{\"long\":\"%0100d\"}", 0);
+  TEST_ASSERT_TRUE(scan(json, s));
+  TEST_ASSERT_EQUAL_size_t(JSON_SCAN_VALUE_MAX - 1, strlen(s.values[0]));
+}
+
+void test_scan_empty_and_null(void) {
+  Seen s;
+  TEST_ASSERT_TRUE(scan("{}", s));
+  TEST_ASSERT_EQUAL_INT(0, s.count);
+  TEST_ASSERT_TRUE(scan("null", s));   // Node deleted in the app
+  TEST_ASSERT_EQUAL_INT(0, s.count);
+}
+
+void test_scan_rejects_malformed(void) {
+  static const char *const BAD[] = {
+    "", "[1,2]", "{\"a\":{\"b\":1}}", "{\"a\":[1]}", "{\"a\" 1}", "{a:1}",
+    "{\"a\":1", "{\"a\":\"open", "{\"a\":}", "{\"a\":1 \"b\":2}",
+  };
+  for (const char *json : BAD) {
+    Seen s;
+    TEST_ASSERT_FALSE_MESSAGE(scan(json, s), json);
+  }
+}
+
+// ---------------- Thresholds node ----------------
+void test_apply_full_node(void) {
+  PlantThresholds th = DEFAULTS;
+  TEST_ASSERT_TRUE(apply("{\"humidity_high\":70,\"humidity_low\":40,\"lux_high\":15000,\"lux_low\":800,"
+                         "\"moisture_high\":60,\"moisture_low\":10,\"species\":\"Cactus\","
+                         "\"temp_high\":38.5,\"temp_low\":-2}", th));
+  TEST_ASSERT_EQUAL_INT(10, th.moistureLow);
+  TEST_ASSERT_EQUAL_INT(60, th.moistureHigh);
+  TEST_ASSERT_EQUAL_FLOAT(38.5f, th.tempHigh);
+  TEST_ASSERT_EQUAL_FLOAT(-2.0f, th.tempLow);
+  TEST_ASSERT_EQUAL_FLOAT(800.0f, th.luxLow);
+  TEST_ASSERT_EQUAL_FLOAT(15000.0f, th.luxHigh);
+  TEST_ASSERT_EQUAL_FLOAT(70.0f, th.humidityHigh);
+  TEST_ASSERT_EQUAL_FLOAT(40.0f, th.humidityLow);
+  TEST_ASSERT_EQUAL_STRING("Cactus", th.speciesName);
+}
+
+void test_apply_partial_keeps_the_rest(void) {
+  PlantThresholds th = DEFAULTS;
+  TEST_ASSERT_TRUE(apply("{\"temp_high\":27.25}", th));
+  TEST_ASSERT_EQUAL_FLOAT(27.25f, th.tempHigh);
+  TEST_ASSERT_EQUAL_INT(DEFAULTS.moistureLow, th.moistureLow);
+  TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.luxHigh, th.luxHigh);
+  TEST_ASSERT_EQUAL_STRING(DEFAULTS.speciesName, th.speciesName);
+}
+
+void test_apply_skips_unknown_keys_and_wrong_types(void) {
+  PlantThresholds th = DEFAULTS;
+  TEST_ASSERT_TRUE(apply("{\"watering\":\"daily\",\"moisture_low\":null,\"moisture_high\":\"90\","
+                         "\"temp_low\":true,\"species\":12,\"lux_low\":250.5}", th));
+  TEST_ASSERT_EQUAL_INT(DEFAULTS.moistureLow, th.moistureLow);
+  TEST_ASSERT_EQUAL_INT(DEFAULTS.moistureHigh, th.moistureHigh);
+  TEST_ASSERT_EQUAL_FLOAT(DEFAULTS.tempLow, th.tempLow);
+  TEST_ASSERT_EQUAL_STRING(DEFAULTS.speciesName, th.speciesName);
+  TEST_ASSERT_EQUAL_FLOAT(250.5f, th.luxLow);
+}
+
+void test_apply_truncates_long_species(void) {
+  PlantThresholds th = DEFAULTS;
+  TEST_ASSERT_TRUE(apply("{\"species\":\"Monstera deliciosa var. borsigiana albo\"}", th));
+  TEST_ASSERT_EQUAL_size_t(SPECIES_NAME_MAX - 1, strlen(th.speciesName));
+  TEST_ASSERT_EQUAL_STRING("Monstera deliciosa var. borsigi", th.speciesName);
+}
+
+void test_apply_malformed_changes_nothing(void) {
+  PlantThresholds th = DEFAULTS;
+  // Cut off mid-answer: the keys before the cut must not be applied either
+  TEST_ASSERT_FALSE(apply("{\"moisture_low\":5,\"temp_high\":40,\"lux_lo", th));
+  TEST_ASSERT_EQUAL_MEMORY(&DEFAULTS, &th, sizeof(th));
+
+  TEST_ASSERT_TRUE(apply("null", th));
+  TEST_ASSERT_EQUAL_MEMORY(&DEFAULTS, &th, sizeof(th));
+}
+
+void test_apply_number_keys(void) {
+  PlantThresholds th = DEFAULTS;
+  TEST_ASSERT_TRUE(thresholdsApplyNumber("moisture_low", 22.9f, th));
+  TEST_ASSERT_EQUAL_INT(22, th.moistureLow);   // Int fields truncate, as FirebaseJson's intValue
+  TEST_ASSERT_FALSE(thresholdsApplyNumber("species", 1.0f, th));
+  TEST_ASSERT_FALSE(thresholdsApplyNumber("moisture", 1.0f, th));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_scan_members_and_types);
+  RUN_TEST(test_scan_escapes_and_truncation);
+  RUN_TEST(test_scan_empty_and_null);
+  RUN_TEST(test_scan_rejects_malformed);
+  RUN_TEST(test_apply_full_node);
+  RUN_TEST(test_apply_partial_keeps_the_rest);
+  RUN_TEST(test_apply_skips_unknown_keys_and_wrong_types);
+  RUN_TEST(test_apply_truncates_long_species);
+  RUN_TEST(test_apply_malformed_changes_nothing);
+  RUN_TEST(test_apply_number_keys);
+  return UNITY_END();
+}
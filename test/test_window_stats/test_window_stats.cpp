@@ -0,0 +1,219 @@
+// Windowed aggregation: float Welford and Chan merges against a two-pass
+// double reference (including a large offset that breaks sum/sum-of-squares),
+// and the aggregator's window closing, NaN/mask handling and hour roll-up.
+
+#include <unity.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "window_stats.h"
+
+#define MINUTE_MS 60000
+#define HOUR_MS   3600000
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct Reference {
+  double mean, variance, min, max;
+};
+
+// Two passes in double: mean first, then squared deviations from it
+static Reference twoPass(const std::vector<float> &v) {
+  Reference r = { 0, 0, v[0], v[0] };
+  for (float x : v) {
+    r.mean += x;
+    if (x < r.min) r.min = x;
+    if (x > r.max) r.max = x;
+  }
+  r.mean /= v.size();
+  for (float x : v) r.variance += (x - r.mean) * (x - r.mean);
+  r.variance = v.size() > 1 ? r.variance / (v.size() - 1) : 0;
+  return r;
+}
+
+// Float against double: the mean to ~100 ulps, the variance to varRelTol
+static void assertMatches(const Reference &r, const RunningStats &s, size_t n, double varRelTol, const char *what) {
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%s: mean %.6f/%.6f var %.6g/%.6g", what, s.mean, r.mean, s.variance(), r.variance);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(n, s.n, msg);
+  TEST_ASSERT_TRUE_MESSAGE((float)r.min == s.min, msg);
+  TEST_ASSERT_TRUE_MESSAGE((float)r.max == s.max, msg);
+  TEST_ASSERT_TRUE_MESSAGE(fabs(s.mean - r.mean) <= 1e-5 * fabs(r.mean), msg);
+  TEST_ASSERT_TRUE_MESSAGE(fabs(s.variance() - r.variance) <= varRelTol * r.variance + 1e-9, msg);
+}
+
+static std::vector<float> series(double offset, double sd, size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> d(offset, sd);
+  std::vector<float> v(n);
+  for (auto &x : v) x = (float)d(rng);
+  return v;
+}
+
+// ---------------- Running stats ----------------
+void test_welford_matches_two_pass(void) {
+  struct Case { const char *what; double offset, sd; size_t n; double tol; } cases[] = {
+    { "temperature minute", 22.4,  0.15,  60,   1e-4 },
+    { "humidity hour",      55.0,  2.0,   3600, 1e-3 },
+    { "lux at 65 klx",      65000, 3.0,   3600, 2e-3 },   // Noise ~5e-5 of the level
+  };
+  for (const Case &c : cases) {
+    std::vector<float> v = series(c.offset, c.sd, c.n, 11);
+    RunningStats s;
+    s.reset();
+    for (float x : v) s.add(x);
+    assertMatches(twoPass(v), s, c.n, c.tol, c.what);
+  }
+}
+
+void test_sum_of_squares_would_fail(void) {
+  // Why Welford: the textbook one-pass formula in float loses the variance
+  // entirely at a large offset, while Welford stays within 0.2 %
+  std::vector<float> v = series(65000, 3.0, 3600, 5);
+  Reference r = twoPass(v);
+  float sum = 0, sumSq = 0;
+  RunningStats s;
+  s.reset();
+  for (float x : v) {
+    sum += x;
+    sumSq += x * x;
+    s.add(x);
+  }
+  float naive = (sumSq - sum * sum / v.size()) / (v.size() - 1);
+  printf("# 65 klx +- 3: two-pass %.4f, Welford %.4f, sum/sumsq %.1f\n", r.variance, s.variance(), naive);
+  TEST_ASSERT_TRUE(fabs(naive - r.variance) > r.variance);
+  TEST_ASSERT_TRUE(fabs(s.variance() - r.variance) < 2e-3 * r.variance);
+}
+
+void test_small_counts(void) {
+  RunningStats s;
+  s.reset();
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, s.variance());
+  s.add(42.0f);
+  TEST_ASSERT_EQUAL_FLOAT(42.0f, s.mean);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, s.variance());
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, s.stddev());
+  s.add(44.0f);
+  TEST_ASSERT_EQUAL_FLOAT(43.0f, s.mean);
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, s.variance());   // Sample variance (n - 1)
+}
+
+void test_merge_matches_one_pass(void) {
+  // An hour as 60 merged minutes, against every sample in one pass
+  std::vector<float> v = series(48.0, 4.0, 3600, 9);
+  for (size_t i = 1800; i < 3600; i++) v[i] += 6.0f;   // Watered halfway: the mean shifts
+  RunningStats hour, minute;
+  hour.reset();
+  minute.reset();
+  for (size_t i = 0; i < v.size(); i++) {
+    minute.add(v[i]);
+    if (i % 60 == 59) {
+      hour.merge(minute);
+      minute.reset();
+    }
+  }
+  assertMatches(twoPass(v), hour, v.size(), 1e-4, "merged hour");
+
+  // Uneven parts and empty ones
+  RunningStats a, b, empty;
+  a.reset();
+  b.reset();
+  empty.reset();
+  for (size_t i = 0; i < 7; i++) a.add(v[i]);
+  for (size_t i = 7; i < 1000; i++) b.add(v[i]);
+  a.merge(empty);
+  empty.merge(a);
+  empty.merge(b);
+  assertMatches(twoPass(std::vector<float>(v.begin(), v.begin() + 1000)), empty, 1000, 1e-4, "7 + 993");
+}
+
+// ---------------- Aggregator ----------------
+static Telemetry at(float temp, float hum, int soil, float lux) {
+  return Telemetry{ temp, hum, soil, 2000, lux, 0 };
+}
+
+void test_minute_closes_on_the_first_sample_past_it(void) {
+  WindowAggregator agg;
+  WindowSummary s;
+  for (unsigned long ms = 0; ms < MINUTE_MS; ms += 1000) agg.add(at(20.0f + ms / 60000.0f, 50, 40, 100), ms);
+  TEST_ASSERT_FALSE(agg.takeClosed(AGG_MINUTE, s));
+
+  agg.add(at(21, 50, 40, 100), MINUTE_MS);
+  TEST_ASSERT_TRUE(agg.takeClosed(AGG_MINUTE, s));
+  TEST_ASSERT_FALSE(agg.takeClosed(AGG_MINUTE, s));   // Returned once
+  TEST_ASSERT_EQUAL_UINT32(0, s.index);
+  TEST_ASSERT_EQUAL_UINT32(0, s.startMs);
+  TEST_ASSERT_EQUAL_UINT32(MINUTE_MS, s.lengthMs);
+  TEST_ASSERT_EQUAL_UINT32(60, s.field[FIELD_TEMPERATURE].n);
+  TEST_ASSERT_EQUAL_UINT32(0, s.field[FIELD_SOIL_RAW].n);      // Not aggregated
+}
+
+void test_nan_and_masked_fields_are_skipped(void) {
+  WindowAggregator agg;
+  WindowSummary s;
+  for (int i = 0; i < 60; i++) {
+    Telemetry t = at(i % 10 == 0 ? NAN : 22.0f, 50, 40, 100);
+    // Light is read every 5th tick; the others hold the old value
+    agg.add(t, i * 1000, i % 5 == 0 ? FIELD_MASK_ALL : FIELD_MASK_ALL & ~FIELD_BIT(FIELD_LIGHT));
+  }
+  agg.add(at(22, 50, 40, 100), MINUTE_MS);
+  TEST_ASSERT_TRUE(agg.takeClosed(AGG_MINUTE, s));
+  TEST_ASSERT_EQUAL_UINT32(54, s.field[FIELD_TEMPERATURE].n);
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, s.field[FIELD_TEMPERATURE].mean);
+  TEST_ASSERT_EQUAL_UINT32(12, s.field[FIELD_LIGHT].n);
+  TEST_ASSERT_EQUAL_UINT32(60, s.field[FIELD_HUMIDITY].n);
+}
+
+void test_empty_minutes_are_not_reported(void) {
+  WindowAggregator agg;
+  WindowSummary s;
+  agg.add(at(20, 50, 40, 100), 5000);
+  agg.add(at(20, 50, 40, 100), 5 * MINUTE_MS + 1000);   // Four minutes without a sample
+  TEST_ASSERT_TRUE(agg.takeClosed(AGG_MINUTE, s));
+  TEST_ASSERT_EQUAL_UINT32(0, s.index);
+  TEST_ASSERT_EQUAL_UINT32(1, s.field[FIELD_TEMPERATURE].n);
+  TEST_ASSERT_FALSE(agg.takeClosed(AGG_MINUTE, s));
+
+  agg.add(at(20, 50, 40, 100), 6 * MINUTE_MS);
+  TEST_ASSERT_TRUE(agg.takeClosed(AGG_MINUTE, s));
+  TEST_ASSERT_EQUAL_UINT32(5, s.index);
+  TEST_ASSERT_EQUAL_UINT32(5 * MINUTE_MS, s.startMs);
+}
+
+void test_hour_from_minutes_matches_two_pass(void) {
+  // One hour at 1 Hz, starting mid-boot; the hour's summary comes from
+  // merging minute windows, compared with all of its samples at once
+  const unsigned long start = 2 * HOUR_MS;
+  std::vector<float> temp = series(23.0, 0.8, 3600, 21);
+  std::vector<float> lux  = series(800.0, 120.0, 3600, 22);
+  WindowAggregator agg;
+  WindowSummary s;
+  uint32_t minutes = 0;
+  for (size_t i = 0; i < 3600; i++) {
+    agg.add(at(temp[i], 50, 40, lux[i]), start + i * 1000);
+    minutes += agg.takeClosed(AGG_MINUTE, s);
+  }
+  agg.add(at(23, 50, 40, 800), start + HOUR_MS);
+  minutes += agg.takeClosed(AGG_MINUTE, s);
+  TEST_ASSERT_EQUAL_UINT32(60, minutes);
+
+  TEST_ASSERT_TRUE(agg.takeClosed(AGG_HOUR, s));
+  TEST_ASSERT_EQUAL_UINT32(2, s.index);
+  TEST_ASSERT_EQUAL_UINT32(start, s.startMs);
+  assertMatches(twoPass(temp), s.field[FIELD_TEMPERATURE], 3600, 1e-3, "hour temperature");
+  assertMatches(twoPass(lux), s.field[FIELD_LIGHT], 3600, 1e-3, "hour lux");
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_welford_matches_two_pass);
+  RUN_TEST(test_sum_of_squares_would_fail);
+  RUN_TEST(test_small_counts);
+  RUN_TEST(test_merge_matches_one_pass);
+  RUN_TEST(test_minute_closes_on_the_first_sample_past_it);
+  RUN_TEST(test_nan_and_masked_fields_are_skipped);
+  RUN_TEST(test_empty_minutes_are_not_reported);
+  RUN_TEST(test_hour_from_minutes_matches_two_pass);
+  return UNITY_END();
+}
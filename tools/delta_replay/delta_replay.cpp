@@ -0,0 +1,248 @@
+// ==========================================
+// GAIA DELTA UPLOAD REPLAY (host tool)
+// ==========================================
+// Replays a recorded sample trace through the firmware's own DeltaFilter
+// (src/delta_filter.cpp) and reports what each live-upload policy would have
+// written for it:
+//   full    - every field of every plant, every sample (before delta uploads)
+//   delta   - changed fields only, all plants in one write (LIVE_UPLOADS 1)
+//   minute  - the last minute's means, once a minute (LIVE_UPLOADS 0, the
+//             default build)
+// Payload bytes are the JSON bodies from src/telemetry_json.cpp, counted the
+// way the firmware's [Delta] report counts them. HTTP headers and TLS are
+// not included. Uploads are assumed to succeed, so every write is committed.
+//
+// Trace format (CSV, one row per plant per sample, rows of one sample share
+// `ms`); record_feed.py writes it from the device's LAN feed:
+//   ms,plant,temperature,humidity,soil_moisture,soil_raw,light_intensity
+// An empty cell is a failed reading. As on the device, a sample whose
+// temperature or humidity is missing is not offered to the filter.
+
+#include <Arduino.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "delta_filter.h"
+#include "gaia_config.h"   // DELTA_CONFIG: the firmware's deadbands
+#include "telemetry_json.h"
+
+#define REPLAY_MAX_PLANTS 8
+#define MINUTE_MS         60000UL
+
+struct Sample {
+  unsigned long ms;
+  uint8_t       count;
+  Telemetry     plant[REPLAY_MAX_PLANTS];
+};
+
+struct Options {
+  const char   *trace        = NULL;
+  float         syntheticH   = 0;
+  unsigned long heartbeatMs  = DELTA_CONFIG.heartbeatMs;
+};
+static Options opt;
+
+enum Policy { POLICY_FULL = 0, POLICY_DELTA, POLICY_MINUTE, POLICY_COUNT };
+static const char *const POLICY_NAMES[POLICY_COUNT] = { "full", "delta", "minute" };
+
+struct Tally {
+  uint32_t writes;
+  uint64_t bytes;
+};
+
+static bool airValid(const Telemetry &t) { return !isnan(t.temperature) && !isnan(t.humidity); }
+
+// ---------------- Trace input ----------------
+static float cell(char *&p) {
+  char *end = strchr(p, ',');
+  if (end) *end = '\0';
+  float v = *p && *p != '\n' && *p != '\r' ? strtof(p, NULL) : NAN;
+  p = end ? end + 1 : p + strlen(p);
+  return v;
+}
+
+static bool loadTrace(const char *path, std::vector<Sample> &out) {
+  FILE *f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  char line[256];
+  unsigned long lineNo = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNo++;
+    if (!isdigit((unsigned char)line[0])) continue;   // Header, comments
+    char *p = line;
+    unsigned long ms = strtoul(p, &p, 10);
+    if (*p == ',') p++;
+    float plant = cell(p);
+    if (isnan(plant) || plant < 0 || plant >= REPLAY_MAX_PLANTS) {
+      fprintf(stderr, "%s:%lu: bad plant index\n", path, lineNo);
+      continue;
+    }
+    if (out.empty() || out.back().ms != ms) out.push_back(Sample{ ms, 0, {} });
+    Sample &s = out.back();
+    Telemetry &t = s.plant[(int)plant];
+    t.temperature  = cell(p);
+    t.humidity     = cell(p);
+    float moisture = cell(p), raw = cell(p);
+    t.soilMoisture = isnan(moisture) ? 0 : (int)lroundf(moisture);
+    t.soilRaw      = isnan(raw) ? 0 : (int)lroundf(raw);
+    t.lux          = cell(p);
+    t.timestamp    = ms;
+    s.count        = max(s.count, (uint8_t)(plant + 1));
+  }
+  if (f != stdin) fclose(f);
+  return true;
+}
+
+// A quiet indoor day at 1 Hz, for runs without a recording
+static void synthesize(float hours, std::vector<Sample> &out) {
+  uint32_t rng = 1;
+  auto noise = [&rng](float amplitude) {
+    rng = rng * 1664525u + 1013904223u;
+    return amplitude * ((rng >> 8) / 8388608.0f - 1.0f);
+  };
+  for (unsigned long ms = 0; ms < hours * 3600000.0f; ms += 1000) {
+    float day = fmodf(ms / 86400000.0f, 1.0f);
+    float sun = sinf(2.0f * (float)M_PI * (day - 0.25f));
+    Sample s = { ms, 1, {} };
+    Telemetry &t   = s.plant[0];
+    t.temperature  = 22.0f + 3.0f * sun + noise(0.15f);
+    t.humidity     = 50.0f - 8.0f * sun + noise(0.8f);
+    t.soilMoisture = (int)lroundf(65.0f - 10.0f * day + noise(0.6f));
+    t.soilRaw      = 3500 - t.soilMoisture * 23 + (int)noise(25.0f);
+    t.lux          = sun > 0 ? 1800.0f * sun * (1.0f + noise(0.02f)) : 0.0f;
+    t.timestamp    = ms;
+    out.push_back(s);
+  }
+}
+
+// ---------------- Replay ----------------
+static void replay(const std::vector<Sample> &trace) {
+  DeltaConfig cfg = DELTA_CONFIG;
+  cfg.heartbeatMs = opt.heartbeatMs;
+  DeltaFilter filters[REPLAY_MAX_PLANTS];
+  for (int p = 0; p < REPLAY_MAX_PLANTS; p++) filters[p] = DeltaFilter(cfg);
+
+  Tally    tally[POLICY_COUNT] = {};
+  uint32_t fieldWrites[FIELD_COUNT] = {};
+  uint32_t skipped = 0;
+  uint8_t  plants  = 0;
+
+  // Minute means, accumulated per plant and field
+  double        sum[REPLAY_MAX_PLANTS][FIELD_COUNT] = {};
+  uint32_t      n[REPLAY_MAX_PLANTS][FIELD_COUNT]   = {};
+  unsigned long minuteStart = trace.front().ms;
+  auto closeMinute = [&](unsigned long endMs) {
+    uint64_t bytes = 0;
+    for (uint8_t p = 0; p < plants; p++) {
+      Telemetry t = {};
+      uint8_t mask = 0;
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        if (!n[p][f]) continue;
+        telemetrySetField(t, f, (float)(sum[p][f] / n[p][f]));
+        mask |= FIELD_BIT(f);
+        sum[p][f] = 0;
+        n[p][f]   = 0;
+      }
+      t.timestamp = endMs;
+      if (mask) bytes += telemetryPayloadBytes(t, mask);
+    }
+    if (bytes) {
+      tally[POLICY_MINUTE].writes++;
+      tally[POLICY_MINUTE].bytes += bytes;
+    }
+  };
+
+  for (const Sample &s : trace) {
+    plants = max(plants, s.count);
+    if (s.ms - minuteStart >= MINUTE_MS) {
+      closeMinute(s.ms);
+      minuteStart += (s.ms - minuteStart) / MINUTE_MS * MINUTE_MS;
+    }
+
+    bool any = false;
+    for (uint8_t p = 0; p < s.count; p++) {
+      const Telemetry &t = s.plant[p];
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        float v = telemetryFieldValue(t, f);
+        if (!isnan(v)) { sum[p][f] += v; n[p][f]++; }
+      }
+      if (!airValid(t)) {
+        skipped++;
+        continue;
+      }
+      tally[POLICY_FULL].bytes += telemetryPayloadBytes(t, FIELD_MASK_ALL);
+      uint8_t mask = filters[p].changedFields(t, s.ms);
+      if (!mask) continue;
+      any = true;
+      tally[POLICY_DELTA].bytes += telemetryPayloadBytes(t, mask);
+      for (int f = 0; f < FIELD_COUNT; f++) fieldWrites[f] += (mask >> f) & 1;
+      filters[p].commit(t, mask, s.ms);
+    }
+    tally[POLICY_FULL].writes++;
+    if (any) tally[POLICY_DELTA].writes++;
+  }
+  closeMinute(trace.back().ms);
+
+  double hours = (trace.back().ms - trace.front().ms + 1000) / 3600000.0;
+  printf("# %zu sample(s) of %u plant(s) over %.2f h, %lu invalid air reading(s) skipped, heartbeat %lu ms\n",
+    trace.size(), plants, hours, (unsigned long)skipped, opt.heartbeatMs);
+  printf("%-7s %9s %9s %12s %10s %9s %9s\n", "policy", "writes", "writes/h", "payload B", "B/h", "writes %", "bytes %");
+  for (int k = 0; k < POLICY_COUNT; k++) {
+    const Tally &t = tally[k];
+    printf("%-7s %9lu %9.0f %12llu %10.0f %8.1f%% %8.1f%%\n", POLICY_NAMES[k], (unsigned long)t.writes,
+      t.writes / hours, (unsigned long long)t.bytes, t.bytes / hours,
+      100.0 * t.writes / max(tally[POLICY_FULL].writes, 1u),
+      100.0 * t.bytes / max(tally[POLICY_FULL].bytes, (uint64_t)1));
+  }
+  fprintf(stderr, "delta field writes:");
+  for (int f = 0; f < FIELD_COUNT; f++) fprintf(stderr, " %s %lu", telemetryFieldKey(f), (unsigned long)fieldWrites[f]);
+  fprintf(stderr, "\n");
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+    "Usage: %s [options] (--trace FILE | --synthetic HOURS)\n"
+    "  --trace FILE         recorded trace (CSV, see record_feed.py); - = stdin\n"
+    "  --synthetic HOURS    replay a generated 1 Hz indoor trace instead\n"
+    "  --heartbeat-ms MS    delta heartbeat (default %lu, as in gaia_config.h)\n",
+    argv0, DELTA_CONFIG.heartbeatMs);
+}
+
+static bool parseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!v) return false;
+    i++;
+    if      (!strcmp(a, "--trace"))        opt.trace = v;
+    else if (!strcmp(a, "--synthetic"))    opt.syntheticH = atof(v);
+    else if (!strcmp(a, "--heartbeat-ms")) opt.heartbeatMs = strtoul(v, NULL, 10);
+    else return false;
+  }
+  return (opt.trace != NULL) != (opt.syntheticH > 0);
+}
+
+int main(int argc, char **argv) {
+  if (!parseArgs(argc, argv)) {
+    usage(argv[0]);
+    return 2;
+  }
+  std::vector<Sample> trace;
+  if (opt.trace) {
+    if (!loadTrace(opt.trace, trace)) return 1;
+  } else {
+    synthesize(opt.syntheticH, trace);
+  }
+  if (trace.empty()) {
+    fprintf(stderr, "No samples in the trace\n");
+    return 1;
+  }
+  replay(trace);
+  return 0;
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Records a device's LAN feed as a delta_replay trace.
+
+Subscribes to ws://<device>/ws (lan_feed.cpp) and writes one CSV row per
+plant per sample message:
+
+  ms,plant,temperature,humidity,soil_moisture,soil_raw,light_intensity
+
+`ms` is the sample's own timestamp (millis() on the device). Missing or
+null fields are left empty. Face messages are ignored. Stop with Ctrl-C or
+--duration.
+
+Standard library only:  python3 record_feed.py gaia.local --duration 86400 > day.csv
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import sys
+import time
+
+FIELDS = ("temperature", "humidity", "soil_moisture", "soil_raw", "light_intensity")
+
+
+def connect(host, port, path):
+    sock = socket.create_connection((host, port), timeout=30)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall((f"GET {path} HTTP/1.1\r\nHost: {host}:{port}\r\nUpgrade: websocket\r\n"
+                  f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\n"
+                  "Sec-WebSocket-Version: 13\r\n\r\n").encode())
+    head = b""
+    while b"\r\n\r\n" not in head:
+        chunk = sock.recv(1024)
+        if not chunk:
+            raise ConnectionError("closed during the handshake")
+        head += chunk
+    status = head.split(b"\r\n", 1)[0]
+    if b" 101 " not in status:
+        raise ConnectionError(status.decode(errors="replace"))
+    return sock, head.split(b"\r\n\r\n", 1)[1]
+
+
+class Frames:
+    """Text messages from the server (its frames are unmasked; fragments are joined)."""
+
+    def __init__(self, sock, buf):
+        self.sock, self.buf = sock, buf
+
+    def take(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise EOFError
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def __iter__(self):
+        parts = []
+        try:
+            while True:
+                b0, b1 = self.take(2)
+                n = b1 & 0x7F
+                if n == 126:
+                    n = int.from_bytes(self.take(2), "big")
+                elif n == 127:
+                    n = int.from_bytes(self.take(8), "big")
+                payload, opcode = self.take(n), b0 & 0x0F
+                if opcode == 0x8:
+                    return
+                if opcode == 0x9:   # Ping -> masked pong
+                    mask = os.urandom(4)
+                    self.sock.sendall(bytes([0x8A, 0x80 | len(payload)]) + mask +
+                                      bytes(b ^ mask[i % 4] for i, b in enumerate(payload)))
+                elif opcode in (0x0, 0x1):
+                    parts.append(payload)
+                    if b0 & 0x80:
+                        yield b"".join(parts).decode()
+                        parts = []
+        except EOFError:
+            return
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--path", default="/ws")
+    ap.add_argument("--duration", type=float, default=0, help="seconds, 0 = until Ctrl-C")
+    args = ap.parse_args()
+
+    sock, rest = connect(args.host, args.port, args.path)
+    sock.settimeout(None)
+    out = sys.stdout
+    out.write("ms,plant," + ",".join(FIELDS) + "\n")
+    start, samples, gaps, last_seq = time.monotonic(), 0, 0, None
+    try:
+        for text in Frames(sock, rest):
+            msg = json.loads(text)
+            if msg.get("type") != "sample":
+                continue
+            seq = msg.get("seq")
+            if last_seq is not None and seq != last_seq + 1:
+                gaps += 1
+            last_seq = seq
+            for index, plant in enumerate(msg.get("plants", {}).values()):
+                cells = ["" if plant.get(f) is None else str(plant[f]) for f in FIELDS]
+                out.write(f"{plant.get('timestamp', 0)},{index}," + ",".join(cells) + "\n")
+            samples += 1
+            if args.duration and time.monotonic() - start >= args.duration:
+                break
+    except KeyboardInterrupt:
+        pass
+    out.flush()
+    print(f"{samples} samples recorded, {gaps} seq gap(s)", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
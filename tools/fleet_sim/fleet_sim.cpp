@@ -0,0 +1,672 @@
+// ==========================================
+// GAIA FLEET LOAD SIMULATOR (host tool)
+// ==========================================
+// Runs thousands of virtual Gaia devices against an RTDB-compatible endpoint
+// (normally rtdb_standin.py) to size the backend. Each device is a small
+// state machine on one epoll event loop: it samples simulated sensors every
+// period, decides what to write with the firmware's own DeltaFilter
+// (src/delta_filter.cpp), serializes it with src/telemetry_json.cpp, and
+// keeps one keep-alive HTTP connection with one request in flight at a time,
+// like the firmware's network task.
+//
+// Upload strategies (run one after another, --strategies):
+//   full   - every field of every plant, every period, echoed PATCH
+//            (the firmware before delta uploads)
+//   delta  - changed fields only, PATCH ?print=silent, one request per plant
+//   batch  - changed fields of all plants in one multi-path PATCH at /plants
+//            (the firmware built with LIVE_UPLOADS 1; the default build
+//            writes each plant's minute means once a minute instead)
+// Threshold sync is the stream-down fallback: GET /plants/<id>/thresholds
+// every --sync-ms, one plant per interval in turn. Answers are applied with
+// the firmware's parser (src/plant_thresholds.cpp); one it can't read counts
+// as a failed sync.
+//
+// Bytes are counted at the HTTP layer (headers + body). TLS is not
+// simulated, so real traffic adds record overhead and handshakes on reconnect.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <deque>
+#include <queue>
+#include <vector>
+#include "delta_filter.h"
+#include "gaia_config.h"   // DELTA_CONFIG: the firmware's deadbands
+#include "plant_thresholds.h"
+#include "telemetry_json.h"
+
+#define MAX_PLANTS_PER_DEVICE 8
+
+enum Strategy { STRAT_FULL = 0, STRAT_DELTA, STRAT_BATCH, STRAT_COUNT };
+static const char *const STRATEGY_NAMES[STRAT_COUNT] = { "full", "delta", "batch" };
+
+struct Options {
+  const char *host      = "127.0.0.1";
+  int         port      = 8787;
+  int         devices   = 1000;
+  int         plants    = 1;       // Per device
+  uint32_t    periodMs  = 1000;    // Sample cadence
+  uint32_t    durationS = 30;      // Per strategy
+  uint32_t    syncMs    = 30000;   // 0 = no threshold polling
+  uint32_t    timeoutMs = 5000;
+  double      dropRate  = 0;       // Chance the connection is dropped before a request
+  double      offlineRate = 0;     // Chance a device misses a whole period (link down)
+  int         authBytes = 0;       // Length of a fake ?auth= token (Firebase ID tokens are ~1 KB)
+  uint32_t    seed      = 1;
+  bool        run[STRAT_COUNT] = { true, true, true };
+};
+
+static Options opt;
+static std::string authToken;
+
+static uint64_t nowUs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ================= SIMULATED SENSORS =================
+struct Rng {
+  uint64_t s;
+  uint32_t next() { s ^= s << 13; s ^= s >> 7; s ^= s << 17; return (uint32_t)s; }
+  float    uniform() { return (next() >> 8) / 16777216.0f; }               // [0, 1)
+  float    noise(float amp) { return (uniform() * 2 - 1) * amp; }
+};
+
+// Slow drifts plus the sensors' own noise, so the deadbands see realistic input
+struct PlantSim {
+  float temp, humid, soil, lux;
+
+  void init(Rng &r) {
+    temp  = 20 + r.uniform() * 6;
+    humid = 45 + r.uniform() * 20;
+    soil  = 40 + r.uniform() * 40;
+    lux   = 100 + r.uniform() * 900;
+  }
+
+  Telemetry sample(Rng &r, unsigned long nowMs) {
+    temp  += r.noise(0.02f);
+    humid += r.noise(0.1f);
+    soil  -= 0.001f;  // Drying out
+    lux    = max(0.0f, lux * (1 + r.noise(0.01f)));
+    Telemetry t;
+    t.temperature  = temp + r.noise(0.15f);         // DHT22 ±0.1-0.2 °C jitter
+    t.humidity     = humid + r.noise(0.8f);
+    t.soilMoisture = (int)lroundf(std::clamp(soil + r.noise(0.6f), 0.0f, 100.0f));
+    t.soilRaw      = 3500 - (int)(t.soilMoisture * 23) + (int)r.noise(25);
+    t.lux          = lux;
+    t.timestamp    = nowMs;
+    return t;
+  }
+};
+
+// ================= REQUESTS =================
+enum RequestKind { REQ_UPLOAD, REQ_SYNC };
+
+struct Request {
+  RequestKind kind;
+  std::string wire;                            // Full HTTP request
+  uint8_t     plant0, plants;                  // Plants covered (upload), plant0 = plant synced (sync)
+  Telemetry   samples[MAX_PLANTS_PER_DEVICE];  // What to commit on success
+  uint8_t     masks[MAX_PLANTS_PER_DEVICE];
+};
+
+// The firmware's own serializer (src/telemetry_json.cpp), so bodies are
+// byte-for-byte what FirebaseCloud sends
+static void appendTelemetry(std::string &json, const char *prefix, const Telemetry &t, uint8_t mask) {
+  char buf[512];
+  JsonOut out(buf, sizeof(buf));
+  out.beginObject();
+  jsonTelemetry(out, prefix, t, mask);
+  out.endObject();
+  if (json.size() > 1) {   // Merge into the object being built: drop its '{'
+    json.back() = ',';
+    json.append(out.data() + 1, out.length() - 1);
+  } else {
+    json.assign(out.data(), out.length());
+  }
+}
+
+static std::string httpRequest(const char *method, const std::string &path, bool silent, const std::string &body) {
+  std::string q;
+  if (silent) q += "print=silent";
+  if (!authToken.empty()) q += (q.empty() ? "auth=" : "&auth=") + authToken;
+
+  char head[256];
+  std::string req = std::string(method) + " " + path + ".json" + (q.empty() ? "" : "?" + q) + " HTTP/1.1\r\n";
+  snprintf(head, sizeof(head),
+           "Host: %s\r\nUser-Agent: ESP32\r\nConnection: keep-alive\r\n"
+           "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+           opt.host, body.size());
+  return req + head + body;
+}
+
+// ================= DEVICES =================
+struct Stats {
+  uint64_t uploads = 0, uploadsOk = 0, plantWrites = 0;
+  uint64_t syncs = 0, syncsOk = 0, syncParseErrors = 0;
+  uint64_t httpErrors = 0, sockErrors = 0, timeouts = 0;
+  uint64_t superseded = 0, offlinePeriods = 0, connects = 0, drops = 0;
+  uint64_t bytesOut = 0, bytesIn = 0, bodyBytes = 0;
+  std::vector<uint32_t> uploadLatUs, syncLatUs;
+};
+
+enum ConnState { CONN_CLOSED, CONN_CONNECTING, CONN_SENDING, CONN_RECEIVING, CONN_IDLE };
+
+struct Device {
+  int         index;
+  char        id[24];
+  Rng         rng;
+  PlantSim    sim[MAX_PLANTS_PER_DEVICE];
+  DeltaFilter filters[MAX_PLANTS_PER_DEVICE];
+  PlantThresholds thresholds[MAX_PLANTS_PER_DEVICE];
+  uint8_t     nextSyncPlant = 0;
+
+  int         fd = -1;
+  ConnState   state = CONN_CLOSED;
+  std::deque<Request> queue;
+  Request     inflight;
+  bool        busy = false;
+  uint64_t    startUs = 0;
+  size_t      sent = 0;
+  std::string in;
+};
+
+static int       epfd = -1;
+static sockaddr_in server;
+static Strategy  strategy;
+static Stats     stats;
+static std::vector<Device> fleet;
+
+static void plantId(const Device &d, uint8_t plant, char *out, size_t len) {
+  if (opt.plants == 1) snprintf(out, len, "%s", d.id);
+  else                 snprintf(out, len, "%s_%u", d.id, plant);
+}
+
+static void watch(Device &d, uint32_t events) {
+  epoll_event ev = {};
+  ev.events = events;
+  ev.data.u32 = d.index;
+  epoll_ctl(epfd, EPOLL_CTL_MOD, d.fd, &ev);
+}
+
+static void closeConn(Device &d) {
+  if (d.fd >= 0) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, d.fd, NULL);
+    close(d.fd);
+  }
+  d.fd = -1;
+  d.state = CONN_CLOSED;
+  d.in.clear();
+}
+
+static void startNext(Device &d);
+
+// A request finished (status > 0) or failed (status 0 = socket error / timeout)
+static void finish(Device &d, int status) {
+  uint32_t lat = (uint32_t)(nowUs() - d.startUs);
+  bool ok = status >= 200 && status < 300;
+  Request &r = d.inflight;
+
+  if (r.kind == REQ_UPLOAD) {
+    if (ok) {
+      stats.uploadsOk++;
+      stats.uploadLatUs.push_back(lat);
+      for (uint8_t i = 0; i < r.plants; i++) {
+        uint8_t p = r.plant0 + i;
+        if (!r.masks[i]) continue;
+        stats.plantWrites++;
+        if (strategy != STRAT_FULL) d.filters[p].commit(r.samples[i], r.masks[i], r.samples[i].timestamp);
+      }
+    }
+  } else if (ok) {
+    // Like FirebaseCloud::onThresholds: an answer the parser rejects leaves
+    // the plant's thresholds as they were
+    size_t body = d.in.find("\r\n\r\n") + 4;
+    if (thresholdsApplyJson(d.in.data() + body, d.in.size() - body, d.thresholds[r.plant0])) {
+      stats.syncsOk++;
+      stats.syncLatUs.push_back(lat);
+    } else {
+      stats.syncParseErrors++;
+    }
+  }
+  if (status > 0 && !ok) stats.httpErrors++;
+
+  d.busy = false;
+  if (status == 0) closeConn(d);
+  else {
+    d.state = CONN_IDLE;
+    d.in.clear();
+    watch(d, EPOLLIN);  // Notice the server closing the idle connection
+  }
+  startNext(d);
+}
+
+static bool openConn(Device &d) {
+  d.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (d.fd < 0) return false;
+  int one = 1;
+  setsockopt(d.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  epoll_event ev = {};
+  ev.events = EPOLLOUT;
+  ev.data.u32 = d.index;
+  epoll_ctl(epfd, EPOLL_CTL_ADD, d.fd, &ev);
+
+  stats.connects++;
+  if (connect(d.fd, (sockaddr *)&server, sizeof(server)) == 0) {
+    d.state = CONN_SENDING;
+  } else if (errno == EINPROGRESS) {
+    d.state = CONN_CONNECTING;
+  } else {
+    closeConn(d);
+    return false;
+  }
+  return true;
+}
+
+static void pumpSend(Device &d) {
+  const std::string &w = d.inflight.wire;
+  while (d.sent < w.size()) {
+    ssize_t n = send(d.fd, w.data() + d.sent, w.size() - d.sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      d.sent += n;
+      stats.bytesOut += n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      watch(d, EPOLLOUT);
+      return;
+    } else {
+      stats.sockErrors++;
+      finish(d, 0);
+      return;
+    }
+  }
+  d.state = CONN_RECEIVING;
+  watch(d, EPOLLIN);
+}
+
+// Status code once the whole response is in, 0 while incomplete, -1 if malformed
+static int parseResponse(const std::string &in) {
+  size_t end = in.find("\r\n\r\n");
+  if (end == std::string::npos) return 0;
+  int status = 0;
+  if (sscanf(in.c_str(), "HTTP/1.%*d %d", &status) != 1) return -1;
+
+  size_t length = 0;
+  size_t cl = in.find("Content-Length:");
+  if (cl == std::string::npos) cl = in.find("content-length:");
+  if (cl != std::string::npos && cl < end) length = strtoul(in.c_str() + cl + 15, NULL, 10);
+  return in.size() >= end + 4 + length ? status : 0;
+}
+
+static void pumpRecv(Device &d) {
+  char buf[4096];
+  for (;;) {
+    ssize_t n = recv(d.fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      stats.bytesIn += n;
+      d.in.append(buf, n);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    stats.sockErrors++;  // Closed mid-response
+    finish(d, 0);
+    return;
+  }
+  int status = parseResponse(d.in);
+  if (status < 0) {
+    stats.sockErrors++;
+    finish(d, 0);
+  } else if (status > 0) {
+    finish(d, status);
+  }
+}
+
+static void startNext(Device &d) {
+  if (d.busy || d.queue.empty()) return;
+  d.inflight = std::move(d.queue.front());
+  d.queue.pop_front();
+  d.busy    = true;
+  d.sent    = 0;
+  d.startUs = nowUs();
+  if (d.inflight.kind == REQ_UPLOAD) stats.uploads++;
+  else                                stats.syncs++;
+
+  // Failure injection: the link dropped since the last request
+  if (d.fd >= 0 && opt.dropRate > 0 && d.rng.uniform() < opt.dropRate) {
+    stats.drops++;
+    closeConn(d);
+  }
+  if (d.fd < 0 && !openConn(d)) {
+    stats.sockErrors++;
+    finish(d, 0);
+    return;
+  }
+  if (d.state == CONN_IDLE || d.state == CONN_SENDING) pumpSend(d);
+}
+
+// One sensor period: sample every plant and queue what the strategy writes
+static void samplePeriod(Device &d, unsigned long nowMs) {
+  Telemetry t[MAX_PLANTS_PER_DEVICE];
+  uint8_t   mask[MAX_PLANTS_PER_DEVICE];
+  for (int p = 0; p < opt.plants; p++) {
+    t[p] = d.sim[p].sample(d.rng, nowMs);
+  }
+  if (opt.offlineRate > 0 && d.rng.uniform() < opt.offlineRate) {
+    stats.offlinePeriods++;
+    return;
+  }
+  for (int p = 0; p < opt.plants; p++) {
+    mask[p] = strategy == STRAT_FULL ? FIELD_MASK_ALL : d.filters[p].changedFields(t[p], nowMs);
+  }
+
+  // Only the newest sample matters: drop uploads that never got sent
+  for (auto it = d.queue.begin(); it != d.queue.end();) {
+    if (it->kind == REQ_UPLOAD) {
+      stats.superseded++;
+      it = d.queue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  char id[32];
+  if (strategy == STRAT_BATCH) {
+    Request r;
+    r.kind   = REQ_UPLOAD;
+    r.plant0 = 0;
+    r.plants = opt.plants;
+    std::string body = "{";   // Becomes {...} once a plant is appended
+    for (int p = 0; p < opt.plants; p++) {
+      r.samples[p] = t[p];
+      r.masks[p]   = mask[p];
+      if (!mask[p]) continue;
+      char prefix[40];
+      plantId(d, p, id, sizeof(id));
+      snprintf(prefix, sizeof(prefix), "%s/", id);
+      appendTelemetry(body, prefix, t[p], mask[p]);
+    }
+    if (body.size() == 1) return;  // Nothing moved
+    stats.bodyBytes += body.size();
+    r.wire = httpRequest("PATCH", "/plants", true, body);
+    d.queue.push_back(std::move(r));
+  } else {
+    for (int p = 0; p < opt.plants; p++) {
+      if (!mask[p]) continue;
+      Request r;
+      r.kind       = REQ_UPLOAD;
+      r.plant0     = p;
+      r.plants     = 1;
+      r.samples[0] = t[p];
+      r.masks[0]   = mask[p];
+      std::string body;
+      appendTelemetry(body, "", t[p], mask[p]);
+      stats.bodyBytes += body.size();
+      plantId(d, p, id, sizeof(id));
+      r.wire = httpRequest("PATCH", std::string("/plants/") + id, strategy != STRAT_FULL, body);
+      d.queue.push_back(std::move(r));
+    }
+  }
+  startNext(d);
+}
+
+static void syncThresholds(Device &d) {
+  char id[32];
+  plantId(d, d.nextSyncPlant, id, sizeof(id));
+
+  Request r;
+  r.kind   = REQ_SYNC;
+  r.plant0 = d.nextSyncPlant;
+  r.plants = 0;
+  r.wire   = httpRequest("GET", std::string("/plants/") + id + "/thresholds", false, "");
+  d.nextSyncPlant = (d.nextSyncPlant + 1) % opt.plants;
+  d.queue.push_back(std::move(r));
+  startNext(d);
+}
+
+static void onEvent(Device &d, uint32_t events) {
+  switch (d.state) {
+    case CONN_CONNECTING: {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(d.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err) {
+        stats.sockErrors++;
+        finish(d, 0);
+        return;
+      }
+      d.state = CONN_SENDING;
+      pumpSend(d);
+      break;
+    }
+    case CONN_SENDING:
+      pumpSend(d);
+      break;
+    case CONN_RECEIVING:
+      pumpRecv(d);
+      break;
+    case CONN_IDLE:
+      if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) closeConn(d);  // Server closed it; reconnect on demand
+      break;
+    case CONN_CLOSED:
+      break;
+  }
+}
+
+// ================= RUN =================
+enum TimerKind { TIMER_SAMPLE, TIMER_SYNC };
+
+struct Timer {
+  uint64_t  atUs;
+  int       device;
+  TimerKind kind;
+  bool operator>(const Timer &o) const { return atUs > o.atUs; }
+};
+
+static uint32_t percentile(std::vector<uint32_t> &v, double q) {
+  if (v.empty()) return 0;
+  size_t k = (size_t)(q * (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static void report(double secs) {
+  uint32_t p50 = percentile(stats.uploadLatUs, 0.50);
+  uint32_t p99 = percentile(stats.uploadLatUs, 0.99);
+  uint32_t mx  = stats.uploadLatUs.empty() ? 0 : *std::max_element(stats.uploadLatUs.begin(), stats.uploadLatUs.end());
+  uint32_t s50 = percentile(stats.syncLatUs, 0.50);
+  uint32_t s99 = percentile(stats.syncLatUs, 0.99);
+  uint64_t reqs = stats.uploadsOk + stats.syncsOk;
+
+  printf("%-6s %9.0f %11.0f %7.2f %7.2f %7.2f %9.0f %9.0f %10.1f %7.2f/%-7.2f %8llu %8llu\n",
+    STRATEGY_NAMES[strategy], stats.uploadsOk / secs, stats.plantWrites / secs,
+    p50 / 1000.0, p99 / 1000.0, mx / 1000.0,
+    stats.uploadsOk ? (double)stats.bodyBytes / stats.uploads : 0.0,
+    reqs ? (double)(stats.bytesOut + stats.bytesIn) / reqs : 0.0,
+    (stats.bytesOut + stats.bytesIn) / secs / 1024.0,
+    s50 / 1000.0, s99 / 1000.0,
+    (unsigned long long)(stats.httpErrors + stats.sockErrors + stats.timeouts),
+    (unsigned long long)stats.connects);
+  fprintf(stderr, "  [%s] uploads %llu ok / %llu, syncs %llu ok / %llu (%llu unparsable) | http err %llu, socket err %llu, "
+                  "timeouts %llu, drops %llu | superseded %llu, offline periods %llu | out %llu B, in %llu B\n",
+    STRATEGY_NAMES[strategy],
+    (unsigned long long)stats.uploadsOk, (unsigned long long)stats.uploads,
+    (unsigned long long)stats.syncsOk, (unsigned long long)stats.syncs,
+    (unsigned long long)stats.syncParseErrors,
+    (unsigned long long)stats.httpErrors, (unsigned long long)stats.sockErrors,
+    (unsigned long long)stats.timeouts, (unsigned long long)stats.drops,
+    (unsigned long long)stats.superseded, (unsigned long long)stats.offlinePeriods,
+    (unsigned long long)stats.bytesOut, (unsigned long long)stats.bytesIn);
+}
+
+static void runStrategy(Strategy s) {
+  strategy = s;
+  stats = Stats();
+  fleet.assign(opt.devices, Device());
+
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+  uint64_t t0 = nowUs();
+  for (int i = 0; i < opt.devices; i++) {
+    Device &d = fleet[i];
+    d.index = i;
+    d.rng.s = (uint64_t)opt.seed * 0x9E3779B97F4A7C15ull + i + 1;
+    snprintf(d.id, sizeof(d.id), "sim_%05d", i);
+    for (int p = 0; p < opt.plants; p++) {
+      d.sim[p].init(d.rng);
+      d.filters[p] = DeltaFilter(DELTA_CONFIG);
+      d.thresholds[p] = PLANT_THRESHOLDS_DEFAULT;
+    }
+    // Spread the fleet evenly over one period (devices boot at random times)
+    timers.push({ t0 + (uint64_t)(d.rng.uniform() * opt.periodMs * 1000), i, TIMER_SAMPLE });
+    if (opt.syncMs) timers.push({ t0 + (uint64_t)(d.rng.uniform() * opt.syncMs * 1000), i, TIMER_SYNC });
+  }
+
+  uint64_t endUs = t0 + (uint64_t)opt.durationS * 1000000;
+  uint64_t nextTimeoutScan = t0;
+  epoll_event evs[1024];
+
+  for (uint64_t now = t0; now < endUs; now = nowUs()) {
+    int waitMs = timers.empty() ? 100 : (int)min<int64_t>(100, max<int64_t>(0, ((int64_t)timers.top().atUs - (int64_t)now) / 1000));
+    int n = epoll_wait(epfd, evs, 1024, waitMs);
+    for (int i = 0; i < n; i++) onEvent(fleet[evs[i].data.u32], evs[i].events);
+
+    now = nowUs();
+    while (!timers.empty() && timers.top().atUs <= now) {
+      Timer t = timers.top();
+      timers.pop();
+      Device &d = fleet[t.device];
+      unsigned long ms = (unsigned long)((now - t0) / 1000);
+      if (t.kind == TIMER_SAMPLE) {
+        samplePeriod(d, ms);
+        timers.push({ t.atUs + opt.periodMs * 1000ull, t.device, TIMER_SAMPLE });
+      } else {
+        syncThresholds(d);
+        timers.push({ t.atUs + opt.syncMs * 1000ull, t.device, TIMER_SYNC });
+      }
+    }
+
+    if (now >= nextTimeoutScan) {
+      nextTimeoutScan = now + 100000;
+      for (Device &d : fleet) {
+        if (d.busy && now > d.startUs + opt.timeoutMs * 1000ull) {
+          stats.timeouts++;
+          finish(d, 0);
+        }
+      }
+    }
+  }
+
+  double secs = (nowUs() - t0) / 1e6;
+  for (Device &d : fleet) closeConn(d);
+  report(secs);
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  --host H           RTDB endpoint host (default 127.0.0.1)\n"
+    "  --port P           RTDB endpoint port (default 8787)\n"
+    "  --devices N        virtual devices (default 1000)\n"
+    "  --plants K         plants per device, 1-%d (default 1)\n"
+    "  --period-ms MS     sample cadence (default 1000)\n"
+    "  --duration S       seconds per strategy (default 30)\n"
+    "  --strategies LIST  comma-separated: full,delta,batch (default all)\n"
+    "  --sync-ms MS       threshold poll interval, 0 = off (default 30000)\n"
+    "  --timeout-ms MS    request timeout (default 5000)\n"
+    "  --drop-rate P      chance the connection drops before a request (default 0)\n"
+    "  --offline-rate P   chance a device misses a whole period (default 0)\n"
+    "  --auth-bytes N     length of a fake ?auth= token (default 0; real ID tokens ~1000)\n"
+    "  --seed N           RNG seed (default 1)\n"
+    "Server-side failures (503s, latency) are injected by rtdb_standin.py.\n",
+    argv0, MAX_PLANTS_PER_DEVICE);
+}
+
+static bool parseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!v) return false;
+    i++;
+    if      (!strcmp(a, "--host"))         opt.host = v;
+    else if (!strcmp(a, "--port"))         opt.port = atoi(v);
+    else if (!strcmp(a, "--devices"))      opt.devices = atoi(v);
+    else if (!strcmp(a, "--plants"))       opt.plants = atoi(v);
+    else if (!strcmp(a, "--period-ms"))    opt.periodMs = strtoul(v, NULL, 10);
+    else if (!strcmp(a, "--duration"))     opt.durationS = strtoul(v, NULL, 10);
+    else if (!strcmp(a, "--sync-ms"))      opt.syncMs = strtoul(v, NULL, 10);
+    else if (!strcmp(a, "--timeout-ms"))   opt.timeoutMs = strtoul(v, NULL, 10);
+    else if (!strcmp(a, "--drop-rate"))    opt.dropRate = atof(v);
+    else if (!strcmp(a, "--offline-rate")) opt.offlineRate = atof(v);
+    else if (!strcmp(a, "--auth-bytes"))   opt.authBytes = atoi(v);
+    else if (!strcmp(a, "--seed"))         opt.seed = strtoul(v, NULL, 10);
+    else if (!strcmp(a, "--strategies")) {
+      for (int s = 0; s < STRAT_COUNT; s++) opt.run[s] = false;
+      std::string list(v);
+      for (int s = 0; s < STRAT_COUNT; s++) {
+        if (("," + list + ",").find(std::string(",") + STRATEGY_NAMES[s] + ",") != std::string::npos) opt.run[s] = true;
+      }
+    } else {
+      return false;
+    }
+  }
+  return opt.devices > 0 && opt.plants >= 1 && opt.plants <= MAX_PLANTS_PER_DEVICE && opt.periodMs > 0;
+}
+
+int main(int argc, char **argv) {
+  if (!parseArgs(argc, argv)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // One socket per device
+  rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)opt.devices + 16) {
+    fprintf(stderr, "Only %lu file descriptors available for %d devices (raise ulimit -n)\n",
+            (unsigned long)rl.rlim_cur, opt.devices);
+    return 1;
+  }
+
+  addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char port[8];
+  snprintf(port, sizeof(port), "%d", opt.port);
+  if (getaddrinfo(opt.host, port, &hints, &res) != 0 || !res) {
+    fprintf(stderr, "Cannot resolve %s\n", opt.host);
+    return 1;
+  }
+  server = *(sockaddr_in *)res->ai_addr;
+  freeaddrinfo(res);
+
+  authToken.assign(opt.authBytes, 'x');
+  epfd = epoll_create1(0);
+
+  printf("# %d devices x %d plant(s), one sample per %lu ms, %lu s per strategy, threshold poll %lu ms, "
+         "drop %.3f, offline %.3f, auth %d B\n",
+    opt.devices, opt.plants, (unsigned long)opt.periodMs, (unsigned long)opt.durationS,
+    (unsigned long)opt.syncMs, opt.dropRate, opt.offlineRate, opt.authBytes);
+  printf("%-6s %9s %11s %7s %7s %7s %9s %9s %10s %15s %8s %8s\n",
+    "mode", "writes/s", "plant-upd/s", "p50 ms", "p99 ms", "max ms", "body B/wr", "wire B/rq", "wire KiB/s",
+    "sync p50/p99 ms", "errors", "connects");
+  fflush(stdout);
+
+  for (int s = 0; s < STRAT_COUNT; s++) {
+    if (opt.run[s]) runStrategy((Strategy)s);
+    fflush(stdout);
+  }
+  close(epfd);
+  return 0;
+}
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Local stand-in for the Firebase Realtime Database REST API.
+
+Implements the subset the firmware uses, over plain HTTP/1.1 with keep-alive:
+
+  GET    /<path>.json                 -> node (or null)
+  PUT    /<path>.json                 -> replace node
+  PATCH  /<path>.json                 -> multi-path update: every key of the
+                                         body (which may contain '/') replaces
+                                         that child
+  DELETE /<path>.json                 -> remove node
+  ?print=silent                       -> 204 No Content instead of an echo
+
+Query parameters such as auth= are accepted and ignored. Failure injection:
+--fail-rate answers that share of requests with 503, and --latency-ms adds
+a delay (uniform 0..2x the mean) before each response.
+
+With --tls-cert/--tls-key it speaks HTTPS (TLS 1.2, like the ESP32's
+mbedTLS) and counts full and resumed handshakes, so the firmware's session
+resumption can be checked by pointing DATABASE_URL at it. Requests that
+arrive before the previous answer was written (HTTP pipelining) are
+answered in order and counted.
+
+Standard library only:  python3 rtdb_standin.py --port 8787
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import signal
+import ssl
+import time
+from urllib.parse import urlsplit, parse_qs, unquote
+
+REASONS = {200: "OK", 204: "No Content", 400: "Bad Request", 404: "Not Found",
+           405: "Method Not Allowed", 503: "Service Unavailable"}
+
+
+class Tree:
+    """JSON tree addressed by slash-separated paths (RTDB semantics: empty
+    objects and nulls disappear)."""
+
+    def __init__(self):
+        self.root = {}
+
+    @staticmethod
+    def split(path):
+        return [p for p in path.split("/") if p]
+
+    def get(self, path):
+        node = self.root
+        for key in self.split(path):
+            if not isinstance(node, dict) or key not in node:
+                return None
+            node = node[key]
+        return node
+
+    def set(self, path, value):
+        keys = self.split(path)
+        if not keys:
+            self.root = value if isinstance(value, dict) else {}
+            return
+        node = self.root
+        trail = []
+        for key in keys[:-1]:
+            child = node.get(key)
+            if not isinstance(child, dict):
+                child = node[key] = {}
+            trail.append((node, key))
+            node = child
+        if value is None or value == {}:
+            node.pop(keys[-1], None)
+            # Prune parents left empty
+            while trail and not node:
+                parent, key = trail.pop()
+                parent.pop(key, None)
+                node = parent
+        else:
+            node[keys[-1]] = value
+
+    def update(self, path, body):
+        base = "/".join(self.split(path))
+        for key, value in body.items():
+            self.set(base + "/" + key if base else key, value)
+
+
+class Stats:
+    def __init__(self):
+        self.start = time.monotonic()
+        self.requests = {}
+        self.failed = 0
+        self.bytes_in = 0
+        self.bytes_out = 0
+        self.connections = 0
+        self.open = 0
+        self.tls_full = 0
+        self.tls_resumed = 0
+        self.pipelined = 0
+
+    def report(self):
+        secs = max(time.monotonic() - self.start, 1e-9)
+        total = sum(self.requests.values())
+        methods = " ".join(f"{m}={n}" for m, n in sorted(self.requests.items()))
+        print(f"[standin] {secs:.0f} s | {total} req ({total / secs:.0f}/s) {methods} | "
+              f"503 injected {self.failed} | in {self.bytes_in} B, out {self.bytes_out} B | "
+              f"conns {self.connections} ({self.open} open)"
+              + (f" | TLS full {self.tls_full}, resumed {self.tls_resumed}" if self.tls_full + self.tls_resumed else "")
+              + f" | pipelined {self.pipelined}", flush=True)
+
+
+class Server:
+    def __init__(self, args):
+        self.tree = Tree()
+        self.stats = Stats()
+        self.fail_rate = args.fail_rate
+        self.latency = args.latency_ms / 1000.0
+        self.rng = random.Random(args.seed)
+
+    async def handle(self, reader, writer):
+        self.stats.connections += 1
+        self.stats.open += 1
+        tls = writer.get_extra_info("ssl_object")
+        if tls is not None:
+            if tls.session_reused:
+                self.stats.tls_resumed += 1
+            else:
+                self.stats.tls_full += 1
+        try:
+            while True:
+                head = await reader.readuntil(b"\r\n\r\n")
+                lines = head.decode("latin-1").split("\r\n")
+                method, target, _ = lines[0].split(" ", 2)
+                headers = {}
+                for line in lines[1:]:
+                    if ":" in line:
+                        k, v = line.split(":", 1)
+                        headers[k.strip().lower()] = v.strip()
+                length = int(headers.get("content-length", "0"))
+                body = await reader.readexactly(length) if length else b""
+                self.stats.bytes_in += len(head) + len(body)
+                # More already buffered: the client sent it without waiting for this answer
+                if getattr(reader, "_buffer", None):
+                    self.stats.pipelined += 1
+
+                status, payload = self.dispatch(method, target, body)
+                if self.latency:
+                    await asyncio.sleep(self.rng.uniform(0, 2 * self.latency))
+                out = (f"HTTP/1.1 {status} {REASONS.get(status, '')}\r\n"
+                       f"Content-Type: application/json; charset=utf-8\r\n"
+                       f"Content-Length: {len(payload)}\r\n"
+                       f"Connection: keep-alive\r\n\r\n").encode("latin-1") + payload
+                writer.write(out)
+                self.stats.bytes_out += len(out)
+                await writer.drain()
+                if headers.get("connection", "").lower() == "close":
+                    break
+        except (asyncio.IncompleteReadError, ConnectionError, ValueError):
+            pass
+        finally:
+            self.stats.open -= 1
+            writer.close()
+
+    def dispatch(self, method, target, body):
+        self.stats.requests[method] = self.stats.requests.get(method, 0) + 1
+        if self.fail_rate and self.rng.random() < self.fail_rate:
+            self.stats.failed += 1
+            return 503, b'{"error":"injected failure"}'
+
+        url = urlsplit(target)
+        if not url.path.endswith(".json"):
+            return 404, b'{"error":"path must end in .json"}'
+        path = unquote(url.path[:-len(".json")])
+        silent = parse_qs(url.query).get("print") == ["silent"]
+
+        try:
+            data = json.loads(body) if body else None
+        except json.JSONDecodeError:
+            return 400, b'{"error":"Invalid data; couldn\'t parse JSON object."}'
+
+        if method == "GET":
+            return 200, json.dumps(self.tree.get(path), separators=(",", ":")).encode()
+        if method == "PUT":
+            self.tree.set(path, data)
+        elif method == "PATCH":
+            if not isinstance(data, dict):
+                return 400, b'{"error":"Invalid data; couldn\'t parse JSON object."}'
+            self.tree.update(path, data)
+        elif method == "DELETE":
+            self.tree.set(path, None)
+            data = None
+        else:
+            return 405, b'{"error":"method not supported"}'
+
+        if silent:
+            return 204, b""
+        return 200, json.dumps(data, separators=(",", ":")).encode()
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=8787)
+    ap.add_argument("--fail-rate", type=float, default=0.0, help="share of requests answered with 503")
+    ap.add_argument("--latency-ms", type=float, default=0.0, help="mean added response delay")
+    ap.add_argument("--report-s", type=float, default=10.0, help="stats interval (0 = only on exit)")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--backlog", type=int, default=4096, help="listen() backlog")
+    ap.add_argument("--tls-cert", help="PEM certificate: serve HTTPS")
+    ap.add_argument("--tls-key", help="PEM private key for --tls-cert")
+    args = ap.parse_args()
+
+    tls = None
+    if args.tls_cert:
+        tls = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        tls.maximum_version = ssl.TLSVersion.TLSv1_2   # What the ESP32 negotiates
+        tls.load_cert_chain(args.tls_cert, args.tls_key)
+
+    server = Server(args)
+    srv = await asyncio.start_server(server.handle, args.host, args.port, backlog=args.backlog, ssl=tls)
+    scheme = "https" if tls else "http"
+    print(f"[standin] RTDB stand-in on {scheme}://{args.host}:{args.port}", flush=True)
+
+    stop = asyncio.Event()
+    loop = asyncio.get_running_loop()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        loop.add_signal_handler(sig, stop.set)
+
+    async with srv:
+        while not stop.is_set():
+            try:
+                await asyncio.wait_for(stop.wait(), timeout=args.report_s or None)
+            except asyncio.TimeoutError:
+                server.stats.report()
+    server.stats.report()
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Host check of what the firmware's REST client relies on, against the stand-in.
+
+Plays the client side the way rtdb_rest.cpp and tls_session.cpp do:
+
+  1. Full handshake, certificate verified against --ca (the stand-in's
+     self-signed certificate) and its CN against the host, as mbedTLS does
+     for a certificate without subjectAltName; the session is saved.
+  2. Reconnect offering that session: must be resumed (abbreviated).
+  3. A GET and a PATCH?print=silent written back to back without waiting
+     (pipelined): the answers must come back in request order, 200 then 204.
+  4. A connection without --ca trust, or expecting another host name, must
+     be refused.
+
+Prints the handshake times (mean of --rounds) and exits non-zero if any
+check fails.
+
+  python3 rtdb_standin.py --port 8443 --tls-cert cert.pem --tls-key key.pem &
+  python3 tls_check.py --port 8443 --ca cert.pem
+"""
+
+import argparse
+import socket
+import ssl
+import statistics
+import sys
+import time
+
+
+# `name` is what the client expects the certificate to be for (the host in DATABASE_URL)
+def connect(args, ctx, session=None, name=None):
+    name = name or args.host
+    raw = socket.create_connection((args.host, args.port), timeout=5)
+    raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    start = time.perf_counter()
+    tls = ctx.wrap_socket(raw, server_hostname=name, session=session)
+    ms = (time.perf_counter() - start) * 1000
+    subject = dict(x[0] for x in tls.getpeercert()["subject"])
+    if subject.get("commonName", "").lower() != name.lower():
+        tls.close()
+        raise ssl.SSLCertVerificationError(f"CN {subject.get('commonName')!r} is not {name!r}")
+    return tls, ms
+
+
+def read_answer(f):
+    status = int(f.readline().split()[1])
+    length = 0
+    while True:
+        line = f.readline()
+        if line in (b"\r\n", b""):
+            break
+        name, _, value = line.decode("latin-1").partition(":")
+        if name.strip().lower() == "content-length":
+            length = int(value)
+    return status, f.read(length)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--ca", required=True, help="PEM the stand-in serves (its own CA)")
+    ap.add_argument("--rounds", type=int, default=20, help="handshakes of each kind, for the means")
+    args = ap.parse_args()
+
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2   # Sessions as mbedTLS 1.2 resumes them
+    ctx.load_verify_locations(args.ca)
+    ctx.check_hostname = False                      # OpenSSL won't match an IP against the CN; see connect()
+    ok = True
+
+    full, resumed, reused = [], [], 0
+    for _ in range(args.rounds):
+        tls, ms = connect(args, ctx)
+        full.append(ms)
+        session = tls.session
+        tls.close()
+        tls, ms = connect(args, ctx, session)
+        resumed.append(ms)
+        reused += tls.session_reused
+        tls.close()
+    print(f"full handshake    {statistics.mean(full):6.2f} ms  (max {max(full):.2f})")
+    print(f"resumed handshake {statistics.mean(resumed):6.2f} ms  (max {max(resumed):.2f})  "
+          f"{reused}/{args.rounds} resumed")
+    ok &= reused == args.rounds
+
+    tls, _ = connect(args, ctx)
+    body = b'{"tls_check/x":1}'
+    tls.sendall(b"GET /tls_check.json?auth=t HTTP/1.1\r\nHost: x\r\nConnection: keep-alive\r\n\r\n"
+                b"PATCH /.json?print=silent&auth=t HTTP/1.1\r\nHost: x\r\nConnection: keep-alive\r\n"
+                b"Content-Type: application/json\r\nContent-Length: " + str(len(body)).encode() +
+                b"\r\n\r\n" + body)
+    f = tls.makefile("rb")
+    answers = [read_answer(f)[0], read_answer(f)[0]]
+    tls.close()
+    print(f"pipelined GET + PATCH answered {answers[0]}, {answers[1]}")
+    ok &= answers == [200, 204]
+
+    untrusted = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)   # System roots only
+    untrusted.check_hostname = False
+    untrusted.load_default_certs()
+    for what, c, name in (("untrusted certificate", untrusted, None), ("wrong host name", ctx, "gaia-elsewhere")):
+        try:
+            connect(args, c, name=name)[0].close()
+            print(f"{what}: accepted")
+            ok = False
+        except ssl.SSLCertVerificationError:
+            print(f"{what}: refused")
+
+    print("OK" if ok else "FAILED")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
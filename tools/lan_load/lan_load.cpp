@@ -0,0 +1,202 @@
+// LAN feed load test: the firmware's LanFeed (lan_feed.cpp) fanning samples
+// and face changes out to many subscribers, each behind a bounded send queue
+// drained at its own link speed, as AsyncWebSocket clients are on the device.
+//
+// Runs in simulated time (the pump period, link speeds and publish rate are
+// the device's), while the CPU cost of publish() and pump() is measured for
+// real. See README.md.
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+#include <stdlib.h>
+
+#include "lan_feed.h"
+
+struct Options {
+  int      subscribers = 50;
+  int      plants      = 1;
+  double   rate        = 1.0;     // Samples/s
+  double   faceRate    = 0.05;    // Face changes/s
+  int      duration    = 600;     // Simulated seconds
+  int      pumpMs      = 20;
+  int      queue       = 32;      // Messages per client (WS_MAX_QUEUED_MESSAGES)
+  double   fastKBps    = 500;
+  double   slowKBps    = 2;
+  double   slowShare   = 0.1;
+  uint32_t seed        = 1;
+};
+
+struct Queued {
+  size_t   bytes;
+  uint64_t publishedUs;
+};
+
+struct Subscriber {
+  int                slot;
+  double             bytesPerUs;
+  double             credit = 0;   // Bytes the link can still carry this step
+  std::deque<Queued> queue;
+  uint64_t           received = 0;
+  uint64_t           lastSeq  = 0;
+  uint64_t           gaps     = 0;
+};
+
+struct Run {
+  const Options           *opt;
+  std::vector<Subscriber> *subs;
+  uint64_t                 nowUs;
+  std::vector<uint64_t>    latencyUs;
+  uint64_t                 bytes;
+};
+
+static uint64_t parseSeq(const char *msg, size_t len) {
+  const char *p = strstr(msg, "\"seq\":");
+  return p && p < msg + len ? strtoull(p + 6, NULL, 10) : 0;
+}
+
+static bool sendTo(void *ctx, uint8_t slot, const char *msg, size_t len) {
+  Run        &r = *(Run *)ctx;
+  Subscriber &s = (*r.subs)[slot];
+  if ((int)s.queue.size() >= r.opt->queue) return false;
+  // The device's lanSocket.text(id, ...) copies the message into the client's queue
+  std::string copy(msg, len);
+  uint64_t seq = parseSeq(copy.c_str(), len);
+  if (s.lastSeq && seq != s.lastSeq + 1) s.gaps += seq - s.lastSeq - 1;
+  s.lastSeq = seq;
+  s.queue.push_back({ len, r.nowUs });
+  r.bytes += len;
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: lan_load [--subscribers N] [--plants K] [--rate MSG_S] [--face-rate MSG_S]\n"
+    "                [--duration S] [--pump-ms MS] [--queue N] [--fast-kbps KB_S]\n"
+    "                [--slow-kbps KB_S] [--slow-share P] [--seed N]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    const char *a = argv[i], *v = argv[++i];
+    if      (!strcmp(a, "--subscribers")) o.subscribers = atoi(v);
+    else if (!strcmp(a, "--plants"))      o.plants      = atoi(v);
+    else if (!strcmp(a, "--rate"))        o.rate        = atof(v);
+    else if (!strcmp(a, "--face-rate"))   o.faceRate    = atof(v);
+    else if (!strcmp(a, "--duration"))    o.duration    = atoi(v);
+    else if (!strcmp(a, "--pump-ms"))     o.pumpMs      = atoi(v);
+    else if (!strcmp(a, "--queue"))       o.queue       = atoi(v);
+    else if (!strcmp(a, "--fast-kbps"))   o.fastKBps    = atof(v);
+    else if (!strcmp(a, "--slow-kbps"))   o.slowKBps    = atof(v);
+    else if (!strcmp(a, "--slow-share"))  o.slowShare   = atof(v);
+    else if (!strcmp(a, "--seed"))        o.seed        = (uint32_t)atoi(v);
+    else usage();
+  }
+  if (o.subscribers < 1 || o.subscribers > LAN_FEED_CLIENTS || o.plants < 1 || o.plants > MAX_PLANTS ||
+      o.pumpMs < 1 || o.queue < 1 || o.rate <= 0) usage();
+
+  static PlantConfig plants[MAX_PLANTS];
+  static char        ids[MAX_PLANTS][16];
+  for (int p = 0; p < o.plants; p++) {
+    snprintf(ids[p], sizeof(ids[p]), "gaia_%02d", p + 1);
+    plants[p] = { ids[p], 0, -1, -1 };
+  }
+
+  static LanFeed feed;
+  feed.configure(plants, (uint8_t)o.plants, (uint8_t)o.subscribers);
+
+  std::mt19937 rng(o.seed);
+  std::uniform_real_distribution<double> uni(0, 1);
+  std::normal_distribution<double> noise(0, 1);
+
+  std::vector<Subscriber> subs(o.subscribers);
+  int slow = 0;
+  for (int i = 0; i < o.subscribers; i++) {
+    bool isSlow = uni(rng) < o.slowShare;
+    slow += isSlow;
+    subs[i].slot       = feed.attach();
+    subs[i].bytesPerUs = (isSlow ? o.slowKBps : o.fastKBps) * 1024 / 1e6;
+  }
+
+  Run run = { &o, &subs, 0, {}, 0 };
+  RackSample sample;
+  sample.count = (uint8_t)o.plants;
+  double temp = 23, hum = 55, soil = 60, lux = 800;
+
+  uint64_t endUs      = (uint64_t)o.duration * 1000000;
+  uint64_t stepUs     = (uint64_t)o.pumpMs * 1000;
+  uint64_t samplePer  = (uint64_t)(1e6 / o.rate);
+  uint64_t nextSample = 0;
+  double   publishNs  = 0, pumpNs = 0;
+  uint64_t published  = 0;
+
+  for (uint64_t now = 0; now < endUs; now += stepUs) {
+    run.nowUs = now;
+    auto t0 = std::chrono::steady_clock::now();
+    while (nextSample <= now) {
+      temp += 0.02 * noise(rng);
+      hum  += 0.05 * noise(rng);
+      soil -= 0.001;
+      lux   = std::max(0.0, lux + 5 * noise(rng));
+      for (int p = 0; p < o.plants; p++) {
+        sample.plant[p] = { (float)temp, (float)hum, (int)soil, 2400, (float)lux, (unsigned long)(now / 1000) };
+      }
+      feed.publishSample(sample);
+      published++;
+      if (uni(rng) < o.faceRate / o.rate) {
+        FaceEvent ev = { (uint8_t)(rng() % o.plants), (uint8_t)(rng() % 9), (uint8_t)(rng() % 9), -1,
+                         (unsigned long)(now / 1000) };
+        feed.publishFace(ev);
+        published++;
+      }
+      nextSample += samplePer;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    feed.pump(sendTo, &run);
+    auto t2 = std::chrono::steady_clock::now();
+    publishNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+    pumpNs    += std::chrono::duration<double, std::nano>(t2 - t1).count();
+
+    // Each link carries what its speed allows until the next pump
+    for (Subscriber &s : subs) {
+      s.credit += s.bytesPerUs * stepUs;
+      while (!s.queue.empty() && s.credit >= s.queue.front().bytes) {
+        s.credit -= s.queue.front().bytes;
+        run.latencyUs.push_back(now + stepUs - s.queue.front().publishedUs);
+        s.queue.pop_front();
+        s.received++;
+      }
+      if (s.queue.empty()) s.credit = std::min(s.credit, (double)stepUs * s.bytesPerUs);
+    }
+  }
+
+  const LanFeedStats &st = feed.stats();
+  uint64_t received = 0, fastMin = UINT64_MAX, gaps = 0;
+  for (const Subscriber &s : subs) {
+    received += s.received;
+    gaps     += s.gaps;
+    if (s.bytesPerUs * 1e6 / 1024 >= o.fastKBps) fastMin = std::min(fastMin, s.received);
+  }
+  std::sort(run.latencyUs.begin(), run.latencyUs.end());
+  auto pct = [&](double q) {
+    return run.latencyUs.empty() ? 0.0 : run.latencyUs[(size_t)(q * (run.latencyUs.size() - 1))] / 1000.0;
+  };
+
+  printf("# %d subscribers (%d slow at %.0f KB/s, rest %.0f KB/s), %d plant(s), %.1f samples/s + %.2f faces/s, "
+         "pump every %d ms, queue %d, %d s\n",
+         o.subscribers, slow, o.slowKBps, o.fastKBps, o.plants, o.rate, o.faceRate, o.pumpMs, o.queue, o.duration);
+  printf("published  delivered/s  received/s  lagged  oversize  lat p50 ms  p99 ms  publish us/msg  pump ns/delivery\n");
+  printf("%9llu  %11.1f  %10.1f  %6u  %8u  %10.1f  %6.1f  %14.2f  %16.1f\n",
+         (unsigned long long)published, st.delivered / (double)o.duration, received / (double)o.duration,
+         (unsigned)st.lagged, (unsigned)st.oversize, pct(0.50), pct(0.99),
+         published ? publishNs / published / 1000 : 0.0, st.delivered ? pumpNs / st.delivered : 0.0);
+  fprintf(stderr, "fast subscribers: min %llu of %llu messages | seq gaps seen %llu | busy stops %u | avg message %.0f B\n",
+          (unsigned long long)(fastMin == UINT64_MAX ? 0 : fastMin), (unsigned long long)published,
+          (unsigned long long)gaps, (unsigned)st.busy,
+          st.delivered ? (double)run.bytes / st.delivered : 0.0);
+  return 0;
+}
@@ -0,0 +1,404 @@
+#include "delta_encode.h"
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+static double nowMs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// ================= SHA-256 =================
+
+static const uint32_t SHA_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t ror(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static void shaBlock(uint32_t h[8], const uint8_t *p) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) w[i] = (uint32_t)p[4 * i] << 24 | p[4 * i + 1] << 16 | p[4 * i + 2] << 8 | p[4 * i + 3];
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = k + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + SHA_K[i] + w[i];
+    uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    k = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+void sha256(const uint8_t *data, size_t len, uint8_t out[32]) {
+  uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  size_t full = len & ~(size_t)63;
+  for (size_t i = 0; i < full; i += 64) shaBlock(h, data + i);
+
+  uint8_t tail[128] = {0};
+  size_t  rest = len - full;
+  memcpy(tail, data + full, rest);
+  tail[rest] = 0x80;
+  size_t   blocks = rest < 56 ? 1 : 2;
+  uint64_t bitLen = (uint64_t)len * 8;
+  for (int i = 0; i < 8; i++) tail[blocks * 64 - 1 - i] = (uint8_t)(bitLen >> (8 * i));
+  for (size_t b = 0; b < blocks; b++) shaBlock(h, tail + 64 * b);
+  for (int i = 0; i < 32; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+// ESP image header: byte 0 is 0xE9, byte 23 the hash_appended flag
+void imageId(const Bytes &image, uint8_t out[DELTA_ID_LEN]) {
+  size_t n = image.size();
+  if (n > 24 + DELTA_ID_LEN && image[0] == 0xE9 && image[23] == 1) {
+    uint8_t digest[32];
+    sha256(image.data(), n - DELTA_ID_LEN, digest);
+    if (memcmp(digest, image.data() + n - DELTA_ID_LEN, DELTA_ID_LEN) == 0) {
+      memcpy(out, digest, DELTA_ID_LEN);
+      return;
+    }
+  }
+  sha256(image.data(), n, out);
+}
+
+// ================= SUFFIX SORT (Larsson-Sadakane, as in bsdiff) =================
+// I = suffix array of old (with the empty suffix), V = rank of each suffix.
+// Each pass doubles the sorted prefix length h; groups still tied are split
+// by the rank h bytes further on. Negative I entries mark sorted runs.
+
+static void splitGroup(int32_t *I, int32_t *V, int32_t start, int32_t len, int32_t h) {
+  if (len < 16) {
+    for (int32_t k = start; k < start + len;) {
+      int32_t j = 1, x = V[I[k] + h];
+      for (int32_t i = 1; k + i < start + len; i++) {
+        int32_t r = V[I[k + i] + h];
+        if (r < x) {
+          x = r;
+          j = 0;
+        }
+        if (r == x) {
+          std::swap(I[k + j], I[k + i]);
+          j++;
+        }
+      }
+      for (int32_t i = 0; i < j; i++) V[I[k + i]] = k + j - 1;
+      if (j == 1) I[k] = -1;
+      k += j;
+    }
+    return;
+  }
+
+  int32_t x = V[I[start + len / 2] + h];
+  int32_t lt = 0, eq = 0;
+  for (int32_t i = start; i < start + len; i++) {
+    if (V[I[i] + h] < x) lt++;
+    if (V[I[i] + h] == x) eq++;
+  }
+  int32_t eqStart = start + lt, gtStart = eqStart + eq;
+  int32_t i = start, j = 0, k = 0;
+  while (i < eqStart) {
+    int32_t r = V[I[i] + h];
+    if (r < x)       i++;
+    else if (r == x) std::swap(I[i], I[eqStart + j++]);
+    else             std::swap(I[i], I[gtStart + k++]);
+  }
+  while (eqStart + j < gtStart) {
+    if (V[I[eqStart + j] + h] == x) j++;
+    else                            std::swap(I[eqStart + j], I[gtStart + k++]);
+  }
+
+  if (eqStart > start) splitGroup(I, V, start, eqStart - start, h);
+  for (int32_t n = 0; n < gtStart - eqStart; n++) V[I[eqStart + n]] = gtStart - 1;
+  if (eqStart == gtStart - 1) I[eqStart] = -1;
+  if (start + len > gtStart) splitGroup(I, V, gtStart, start + len - gtStart, h);
+}
+
+static void suffixSort(std::vector<int32_t> &I, const Bytes &old) {
+  int32_t n = (int32_t)old.size();
+  std::vector<int32_t> V(n + 1);
+  I.assign(n + 1, 0);
+
+  int32_t buckets[256] = {0};
+  for (uint8_t b : old) buckets[b]++;
+  for (int i = 1; i < 256; i++) buckets[i] += buckets[i - 1];
+  for (int i = 255; i > 0; i--) buckets[i] = buckets[i - 1];
+  buckets[0] = 0;
+  for (int32_t i = 0; i < n; i++) I[++buckets[old[i]]] = i;
+  I[0] = n;
+  for (int32_t i = 0; i < n; i++) V[i] = buckets[old[i]];
+  V[n] = 0;
+  for (int i = 1; i < 256; i++) {
+    if (buckets[i] == buckets[i - 1] + 1) I[buckets[i]] = -1;
+  }
+  I[0] = -1;
+
+  for (int32_t h = 1; I[0] != -(n + 1); h += h) {
+    int32_t len = 0, i = 0;
+    while (i < n + 1) {
+      if (I[i] < 0) {
+        len -= I[i];
+        i   -= I[i];
+      } else {
+        if (len) I[i - len] = -len;
+        len = V[I[i]] + 1 - i;
+        splitGroup(I.data(), V.data(), i, len, h);
+        i  += len;
+        len = 0;
+      }
+    }
+    if (len) I[i - len] = -len;
+  }
+  for (int32_t i = 0; i < n + 1; i++) I[V[i]] = i;
+}
+
+static int32_t matchLen(const uint8_t *a, int32_t an, const uint8_t *b, int32_t bn) {
+  int32_t i = 0;
+  while (i < an && i < bn && a[i] == b[i]) i++;
+  return i;
+}
+
+// Longest match of nw[0..] anywhere in old, by binary search over I
+static int32_t longestMatch(const std::vector<int32_t> &I, const Bytes &old, const uint8_t *nw, int32_t nn,
+                            int32_t &pos) {
+  int32_t on = (int32_t)old.size();
+  int32_t st = 0, en = on;
+  while (en - st >= 2) {
+    int32_t mid = st + (en - st) / 2;
+    int32_t cmp = memcmp(old.data() + I[mid], nw, std::min(on - I[mid], nn));
+    if (cmp < 0) st = mid;
+    else         en = mid;
+  }
+  int32_t x = matchLen(old.data() + I[st], on - I[st], nw, nn);
+  int32_t y = matchLen(old.data() + I[en], on - I[en], nw, nn);
+  pos = x > y ? I[st] : I[en];
+  return std::max(x, y);
+}
+
+// ================= RECORDS =================
+
+static void putVarint(Bytes &out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+static void putRecord(Bytes &raw, const Bytes &old, const Bytes &nw, int32_t newPos, int32_t oldPos,
+                      int32_t addLen, int32_t copyLen, int32_t seek, DeltaEncodeStats &st) {
+  putVarint(raw, (uint32_t)addLen);
+  putVarint(raw, (uint32_t)copyLen);
+  putVarint(raw, seek < 0 ? ((uint32_t)(-(int64_t)seek - 1) << 1) | 1 : (uint32_t)seek << 1);
+  for (int32_t i = 0; i < addLen; i++) raw.push_back((uint8_t)(nw[newPos + i] - old[oldPos + i]));
+  raw.insert(raw.end(), nw.begin() + newPos + addLen, nw.begin() + newPos + addLen + copyLen);
+  st.records++;
+  st.addBytes  += addLen;
+  st.copyBytes += copyLen;
+}
+
+// bsdiff 4's scan: find an exact match of the new data in old; where it
+// stops agreeing with the current alignment by more than 8 bytes, close
+// the previous region. That region is extended forwards from the last
+// match and backwards from the new one as far as over half the bytes
+// still agree, and turned into one add (+ difference) and copy record.
+static Bytes diffRecords(const Bytes &old, const Bytes &nw, DeltaEncodeStats &st) {
+  Bytes   raw;
+  int32_t on = (int32_t)old.size(), nn = (int32_t)nw.size();
+  if (on == 0) {
+    putRecord(raw, old, nw, 0, 0, 0, nn, 0, st);
+    return raw;
+  }
+
+  std::vector<int32_t> I;
+  suffixSort(I, old);
+
+  int32_t scan = 0, len = 0, pos = 0;
+  int32_t lastScan = 0, lastPos = 0, lastOffset = 0;
+  while (scan < nn) {
+    int32_t oldScore = 0;
+    int32_t sc = scan += len;
+    for (; scan < nn; scan++) {
+      len = longestMatch(I, old, nw.data() + scan, nn - scan, pos);
+      for (; sc < scan + len; sc++) {
+        if (sc + lastOffset < on && old[sc + lastOffset] == nw[sc]) oldScore++;
+      }
+      if ((len == oldScore && len != 0) || len > oldScore + 8) break;
+      if (scan + lastOffset < on && old[scan + lastOffset] == nw[scan]) oldScore--;
+    }
+    if (len == oldScore && scan != nn) continue;
+
+    // Forward extension of the last match
+    int32_t s = 0, best = 0, lenF = 0;
+    for (int32_t i = 0; lastScan + i < scan && lastPos + i < on;) {
+      if (old[lastPos + i] == nw[lastScan + i]) s++;
+      i++;
+      if (s * 2 - i > best * 2 - lenF) {
+        best = s;
+        lenF = i;
+      }
+    }
+    // Backward extension of the new one
+    int32_t lenB = 0;
+    if (scan < nn) {
+      s = 0;
+      best = 0;
+      for (int32_t i = 1; scan >= lastScan + i && pos >= i; i++) {
+        if (old[pos - i] == nw[scan - i]) s++;
+        if (s * 2 - i > best * 2 - lenB) {
+          best = s;
+          lenB = i;
+        }
+      }
+    }
+    // Where they overlap, split at the best point
+    if (lastScan + lenF > scan - lenB) {
+      int32_t overlap = (lastScan + lenF) - (scan - lenB);
+      int32_t lenS = 0;
+      s = 0;
+      best = 0;
+      for (int32_t i = 0; i < overlap; i++) {
+        if (nw[lastScan + lenF - overlap + i] == old[lastPos + lenF - overlap + i]) s++;
+        if (nw[scan - lenB + i] == old[pos - lenB + i]) s--;
+        if (s > best) {
+          best = s;
+          lenS = i + 1;
+        }
+      }
+      lenF += lenS - overlap;
+      lenB -= lenS;
+    }
+
+    int32_t copyLen = (scan - lenB) - (lastScan + lenF);
+    int32_t seek    = (pos - lenB) - (lastPos + lenF);
+    putRecord(raw, old, nw, lastScan, lastPos, lenF, copyLen, seek, st);
+    lastScan   = scan - lenB;
+    lastPos    = pos - lenB;
+    lastOffset = pos - scan;
+  }
+  return raw;
+}
+
+// ================= LZ =================
+
+struct BitWriter {
+  Bytes   &out;
+  uint32_t acc   = 0;
+  int      count = 0;
+
+  explicit BitWriter(Bytes &o) : out(o) {}
+  void put(uint32_t v, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+      acc = (acc << 1) | ((v >> i) & 1);
+      if (++count == 8) {
+        out.push_back((uint8_t)acc);
+        acc   = 0;
+        count = 0;
+      }
+    }
+  }
+  void finish() {
+    if (count) out.push_back((uint8_t)(acc << (8 - count)));
+  }
+};
+
+#define LZ_HASH_BITS   16
+#define LZ_CHAIN_DEPTH 128
+
+static uint32_t hash3(const uint8_t *p) {
+  return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+Bytes deltaCompress(const Bytes &raw) {
+  Bytes     out;
+  BitWriter w(out);
+  int32_t   n = (int32_t)raw.size();
+  std::vector<int32_t> head(1 << LZ_HASH_BITS, -1), prev(DELTA_WINDOW, -1);
+
+  auto insert = [&](int32_t i) {
+    if (i + DELTA_MIN_MATCH > n) return;
+    uint32_t h = hash3(&raw[i]);
+    prev[i % DELTA_WINDOW] = head[h];
+    head[h] = i;
+  };
+  auto find = [&](int32_t i, int32_t &dist) {
+    int32_t best = 0;
+    if (i + DELTA_MIN_MATCH > n) return best;
+    int32_t limit = std::min(n - i, (int32_t)DELTA_MAX_MATCH);
+    int32_t cand  = head[hash3(&raw[i])];
+    for (int depth = 0; cand >= 0 && i - cand <= (int32_t)DELTA_WINDOW && depth < LZ_CHAIN_DEPTH; depth++) {
+      int32_t len = matchLen(&raw[cand], n - cand, &raw[i], limit);
+      if (len > best) {
+        best = len;
+        dist = i - cand;
+        if (len == limit) break;
+      }
+      cand = prev[cand % DELTA_WINDOW];
+    }
+    return best >= DELTA_MIN_MATCH ? best : 0;
+  };
+
+  int32_t i = 0;
+  while (i < n) {
+    int32_t dist = 0, len = find(i, dist);
+    if (len) {
+      // Lazy matching: a longer match one byte on is worth a literal
+      insert(i);
+      int32_t nextDist = 0;
+      if (i + 1 < n && find(i + 1, nextDist) > len) {
+        w.put(0x100 | raw[i], 9);
+        i++;
+        continue;
+      }
+      uint32_t v    = (uint32_t)(len - DELTA_MIN_MATCH + 1);
+      int      bits = 32 - __builtin_clz(v);
+      w.put(0, 1);
+      w.put((uint32_t)(dist - 1), DELTA_WINDOW_BITS);
+      w.put(0, bits - 1);
+      w.put(v, bits);
+      for (int32_t k = 1; k < len; k++) insert(i + k);
+      i += len;
+    } else {
+      insert(i);
+      w.put(0x100 | raw[i], 9);
+      i++;
+    }
+  }
+  w.finish();
+  return out;
+}
+
+Bytes deltaEncode(const Bytes &oldImage, const Bytes &newImage, DeltaEncodeStats *stats) {
+  DeltaEncodeStats st = {};
+  double t0  = nowMs();
+  Bytes  raw = diffRecords(oldImage, newImage, st);
+  double t1  = nowMs();
+  Bytes  body = deltaCompress(raw);
+  st.rawBytes   = raw.size();
+  st.matchMs    = t1 - t0;
+  st.compressMs = nowMs() - t1;
+  if (stats) *stats = st;
+
+  DeltaHeader h = {};
+  h.oldSize = (uint32_t)oldImage.size();
+  if (!oldImage.empty()) imageId(oldImage, h.oldId);
+  h.newSize  = (uint32_t)newImage.size();
+  imageId(newImage, h.newId);
+  h.bodySize = (uint32_t)body.size();
+
+  Bytes patch(DELTA_PREFIX_SIZE);   // Unsigned: gaia_diff --key fills in the signature
+  deltaWriteHeader(h, patch.data());
+  deltaWriteSignature(NULL, 0, patch.data());
+  patch.insert(patch.end(), body.begin(), body.end());
+  return patch;
+}
@@ -0,0 +1,41 @@
+#ifndef DELTA_ENCODE_H
+#define DELTA_ENCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "ota_delta.h"
+
+// ==========================================
+// DELTA PATCH ENCODER (host side of ota_delta.h)
+// ==========================================
+// bsdiff's matching (suffix array of the old image, approximate matches
+// extended forwards and backwards), written as interleaved records and
+// LZ-compressed for the firmware's DeltaPatcher.
+
+typedef std::vector<uint8_t> Bytes;
+
+struct DeltaEncodeStats {
+  size_t records;      // addLen/copyLen/seek records
+  size_t addBytes;     // Bytes made from the old image + a difference
+  size_t copyBytes;    // Bytes sent as they are
+  size_t rawBytes;     // Record stream before compression
+  double matchMs;      // Suffix sort + matching
+  double compressMs;
+};
+
+void sha256(const uint8_t *data, size_t len, uint8_t out[32]);
+
+// What esp_partition_get_sha256() reports for the image: the appended
+// SHA-256 if the ESP image header says there is one, else the SHA-256 of
+// everything (also for files that aren't ESP images)
+void imageId(const Bytes &image, uint8_t out[DELTA_ID_LEN]);
+
+// Header, empty signature block, body. An empty oldImage gives the
+// compressed full image.
+Bytes deltaEncode(const Bytes &oldImage, const Bytes &newImage, DeltaEncodeStats *stats = NULL);
+
+// The LZ stage alone (the part DeltaPatcher decompresses)
+Bytes deltaCompress(const Bytes &raw);
+
+#endif
@@ -0,0 +1,156 @@
+// ==========================================
+// GAIA DELTA PATCH GENERATOR (host tool)
+// ==========================================
+// Writes the patch that turns OLD.bin (the image a device runs) into
+// NEW.bin, in the format DeltaPatcher applies (ota_delta.h). With "-" for
+// OLD it writes the compressed full image, for devices whose image is
+// unknown. --key signs the patch header with the release's P-256 private
+// key; devices install nothing else. --verify checks a patch against the
+// public key the way the device does. ota_server.py runs this on demand;
+// it also works standalone.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include "delta_encode.h"
+
+static bool readFile(const char *path, Bytes &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[65536];
+  size_t  n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static void printId(const uint8_t id[DELTA_ID_LEN]) {
+  for (int i = 0; i < DELTA_ID_LEN; i++) printf("%02x", id[i]);
+}
+
+// ECDSA P-256 over the SHA-256 of the header, DER-encoded (what
+// mbedtls_pk_verify() takes on the device)
+static bool sign(const char *keyPath, Bytes &patch) {
+  FILE *f = fopen(keyPath, "r");
+  if (!f) {
+    perror(keyPath);
+    return false;
+  }
+  EVP_PKEY *key = PEM_read_PrivateKey(f, NULL, NULL, NULL);
+  fclose(f);
+  uint8_t     sig[DELTA_SIG_MAX + 8];
+  size_t      len = sizeof(sig);
+  EVP_MD_CTX *md  = EVP_MD_CTX_new();
+  bool ok = key && EVP_PKEY_get_base_id(key) == EVP_PKEY_EC && EVP_PKEY_get_bits(key) == 256 &&
+            EVP_DigestSignInit(md, NULL, EVP_sha256(), NULL, key) == 1 &&
+            EVP_DigestSign(md, sig, &len, patch.data(), DELTA_HEADER_SIZE) == 1 && len <= DELTA_SIG_MAX;
+  EVP_MD_CTX_free(md);
+  EVP_PKEY_free(key);
+  if (!ok) {
+    fprintf(stderr, "%s: not a P-256 private key\n", keyPath);
+    return false;
+  }
+  deltaWriteSignature(sig, len, patch.data());
+  return true;
+}
+
+static bool verify(const char *keyPath, const Bytes &patch) {
+  DeltaHeader    h;
+  const uint8_t *sig;
+  if (patch.size() < DELTA_PREFIX_SIZE || !deltaParseHeader(patch.data(), patch.size(), h)) return false;
+  size_t len = deltaSignature(patch.data(), &sig);
+  FILE  *f   = fopen(keyPath, "r");
+  if (!f) {
+    perror(keyPath);
+    return false;
+  }
+  EVP_PKEY   *key = PEM_read_PUBKEY(f, NULL, NULL, NULL);
+  fclose(f);
+  EVP_MD_CTX *md = EVP_MD_CTX_new();
+  bool ok = key && len && patch.size() == DELTA_PREFIX_SIZE + (size_t)h.bodySize &&
+            EVP_DigestVerifyInit(md, NULL, EVP_sha256(), NULL, key) == 1 &&
+            EVP_DigestVerify(md, sig, len, patch.data(), DELTA_HEADER_SIZE) == 1;
+  EVP_MD_CTX_free(md);
+  EVP_PKEY_free(key);
+  return ok;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: gaia_diff [--key KEY.pem] OLD.bin|- NEW.bin PATCH    patch from OLD (- = full image) to NEW,\n"
+    "                                                           signed with the release key\n"
+    "       gaia_diff --verify PUB.pem PATCH                    check a patch's signature\n"
+    "       gaia_diff --id IMAGE.bin                            image id, as esp_partition_get_sha256() reports it\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3 && !strcmp(argv[1], "--id")) {
+    Bytes   image;
+    uint8_t id[DELTA_ID_LEN];
+    if (!readFile(argv[2], image)) {
+      perror(argv[2]);
+      return 1;
+    }
+    imageId(image, id);
+    printId(id);
+    printf("\n");
+    return 0;
+  }
+  if (argc == 4 && !strcmp(argv[1], "--verify")) {
+    Bytes patch;
+    if (!readFile(argv[3], patch)) {
+      perror(argv[3]);
+      return 1;
+    }
+    bool ok = verify(argv[2], patch);
+    printf("%s: %s\n", argv[3], ok ? "signature ok" : "NOT signed by this key");
+    return ok ? 0 : 1;
+  }
+  const char *keyPath = NULL;
+  if (argc > 2 && !strcmp(argv[1], "--key")) {
+    keyPath = argv[2];
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc != 4) usage();
+
+  Bytes oldImage, newImage;
+  if (strcmp(argv[1], "-") != 0 && !readFile(argv[1], oldImage)) {
+    perror(argv[1]);
+    return 1;
+  }
+  if (!readFile(argv[2], newImage)) {
+    perror(argv[2]);
+    return 1;
+  }
+  if (newImage.empty()) {
+    fprintf(stderr, "%s is empty\n", argv[2]);
+    return 1;
+  }
+
+  DeltaEncodeStats st;
+  Bytes patch = deltaEncode(oldImage, newImage, &st);
+  if (keyPath && !sign(keyPath, patch)) return 1;
+
+  FILE *f = fopen(argv[3], "wb");
+  if (!f || fwrite(patch.data(), 1, patch.size(), f) != patch.size() || fclose(f) != 0) {
+    perror(argv[3]);
+    return 1;
+  }
+
+  DeltaHeader h;
+  deltaParseHeader(patch.data(), patch.size(), h);
+  printf("%s: %zu B, %.1f%% of the %zu B image | %zu records, %.1f%% of the bytes from the old image | match %.0f ms, compress %.0f ms\n",
+    argv[3], patch.size(), 100.0 * patch.size() / newImage.size(), newImage.size(), st.records,
+    100.0 * st.addBytes / newImage.size(), st.matchMs, st.compressMs);
+  printf("old ");
+  if (h.oldSize) printId(h.oldId);
+  else           printf("(none)");
+  printf("\nnew ");
+  printId(h.newId);
+  printf("\n%s\n", keyPath ? "signed" : "unsigned (devices will refuse it)");
+  return 0;
+}
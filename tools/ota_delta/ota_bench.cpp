@@ -0,0 +1,176 @@
+// ==========================================
+// GAIA DELTA OTA BENCHMARK (host tool)
+// ==========================================
+// For each OLD NEW pair of image files, compares what an update costs:
+//   full     - the image as it is (what a plain HTTP OTA sends)
+//   full+lz  - the compressed image: a patch against nothing
+//   delta    - a patch against OLD (gaia_diff)
+// Each patch is applied with the firmware's own DeltaPatcher
+// (src/ota_delta.cpp), fed in --chunk byte pieces as they would come off
+// the socket, and the result is checked byte for byte and by image id
+// against NEW. A second pass feeds random piece sizes (1..4096 B), so
+// every token and record boundary gets cut somewhere.
+//
+// Transfer time is bytes / --link-kbps. Apply time is host CPU; on the
+// device the patch is applied while it downloads, so a patch costs its
+// transfer time plus the flash writes, which are the same for every method.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <random>
+#include <string>
+#include "delta_encode.h"
+
+struct Options {
+  size_t chunk    = 1460;   // TCP segment
+  double linkKBps = 20;     // A busy 2.4 GHz link at the edge of the AP's range
+};
+
+struct Applied {
+  Bytes    out;
+  uint32_t oldReads = 0;
+  double   ms       = 0;
+  bool     ok       = false;
+  std::string error;
+};
+
+struct ApplyCtx {
+  const Bytes *old;
+  Bytes       *out;
+};
+
+static double cpuMs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static bool readFile(const char *path, Bytes &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[65536];
+  size_t  n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool readOld(void *ctx, uint32_t offset, uint8_t *buf, size_t len) {
+  const Bytes &old = *((ApplyCtx *)ctx)->old;
+  if ((size_t)offset + len > old.size()) return false;
+  memcpy(buf, old.data() + offset, len);
+  return true;
+}
+
+static bool writeNew(void *ctx, const uint8_t *data, size_t len) {
+  Bytes &out = *((ApplyCtx *)ctx)->out;
+  out.insert(out.end(), data, data + len);
+  return true;
+}
+
+// chunk 0 = random piece sizes
+static Applied apply(const Bytes &patch, const Bytes &old, const Bytes &expected, size_t chunk, uint32_t seed) {
+  static DeltaPatcher patcher;
+  Applied     r;
+  DeltaHeader h;
+  if (!deltaParseHeader(patch.data(), patch.size(), h)) {
+    r.error = "bad header";
+    return r;
+  }
+  if (patch.size() != DELTA_PREFIX_SIZE + (size_t)h.bodySize) {
+    r.error = "size mismatch";
+    return r;
+  }
+  r.out.reserve(h.newSize);
+  ApplyCtx ctx = { &old, &r.out };
+  std::mt19937 rng(seed);
+
+  double t0 = cpuMs();
+  patcher.begin(h, readOld, writeNew, &ctx);
+  size_t pos = DELTA_PREFIX_SIZE;
+  bool   fed = true;
+  while (fed && pos < patch.size()) {
+    size_t n = chunk ? chunk : 1 + rng() % 4096;
+    n   = std::min(n, patch.size() - pos);
+    fed = patcher.feed(patch.data() + pos, n);
+    pos += n;
+  }
+  r.ms       = cpuMs() - t0;
+  r.oldReads = patcher.oldReads();
+
+  uint8_t id[DELTA_ID_LEN];
+  imageId(r.out, id);
+  if (!fed)                                   r.error = patcher.error();
+  else if (!patcher.done())                   r.error = "incomplete";
+  else if (r.out != expected)                 r.error = "output differs";
+  else if (memcmp(id, h.newId, DELTA_ID_LEN)) r.error = "id mismatch";
+  r.ok = r.error.empty();
+  return r;
+}
+
+static const char *baseName(const char *path) {
+  const char *s = strrchr(path, '/');
+  return s ? s + 1 : path;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: ota_bench [--chunk N] [--link-kbps KB_S] OLD.bin NEW.bin [OLD.bin NEW.bin ...]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (strncmp(a, "--", 2) != 0) {
+      files.push_back(a);
+      continue;
+    }
+    if (i + 1 >= argc) usage();
+    const char *v = argv[++i];
+    if      (!strcmp(a, "--chunk"))     o.chunk    = (size_t)atoi(v);
+    else if (!strcmp(a, "--link-kbps")) o.linkKBps = atof(v);
+    else usage();
+  }
+  if (files.empty() || files.size() % 2 || o.chunk < 1 || o.linkKBps <= 0) usage();
+
+  printf("# %zu pair(s), fed in %zu B chunks, link %.0f KB/s\n", files.size() / 2, o.chunk, o.linkKBps);
+  printf("%-40s %-8s %10s %8s %8s %10s %9s %10s  %s\n",
+    "update", "method", "sent B", "% image", "link s", "encode ms", "apply ms", "old reads", "check");
+
+  int failures = 0;
+  for (size_t f = 0; f < files.size(); f += 2) {
+    Bytes oldImage, newImage;
+    if (!readFile(files[f], oldImage) || !readFile(files[f + 1], newImage) || newImage.empty()) {
+      fprintf(stderr, "can't read %s / %s\n", files[f], files[f + 1]);
+      return 1;
+    }
+    std::string name = std::string(baseName(files[f])) + " -> " + baseName(files[f + 1]);
+    double      size = (double)newImage.size();
+
+    printf("%-40s %-8s %10zu %8.1f %8.1f %10s %9s %10s  %s\n", name.c_str(), "full", newImage.size(), 100.0,
+      size / (o.linkKBps * 1024), "-", "-", "-", "-");
+
+    struct { const char *method; const Bytes *base; } kinds[] = { { "full+lz", NULL }, { "delta", &oldImage } };
+    for (auto &k : kinds) {
+      static const Bytes none;
+      const Bytes &base = k.base ? *k.base : none;
+      DeltaEncodeStats st;
+      Bytes   patch = deltaEncode(base, newImage, &st);
+      Applied a     = apply(patch, base, newImage, o.chunk, 1);
+      Applied b     = apply(patch, base, newImage, 0, (uint32_t)f + 1);
+      bool    ok    = a.ok && b.ok;
+      failures += !ok;
+      printf("%-40s %-8s %10zu %8.1f %8.1f %10.0f %9.1f %10lu  %s\n", "", k.method, patch.size(),
+        100.0 * patch.size() / size, patch.size() / (o.linkKBps * 1024), st.matchMs + st.compressMs, a.ms,
+        (unsigned long)a.oldReads, ok ? "ok" : (a.ok ? b.error : a.error).c_str());
+      fprintf(stderr, "  %s %s: %zu records, %.1f%% of the bytes from the old image, %zu B before LZ\n",
+        name.c_str(), k.method, st.records, 100.0 * st.addBytes / size, st.rawBytes);
+    }
+  }
+  return failures ? 1 : 0;
+}
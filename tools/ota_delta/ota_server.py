@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""Local update server for Gaia delta OTA.
+
+Devices ask with the id of the image they run (what the firmware's
+esp_partition_get_sha256() reports; `./gaia_diff --id IMAGE.bin` prints it):
+
+  GET /ota/<image id>   -> 204 No Content when that image is the release
+                        -> 200 patch from that image to the release, if it
+                           is one of the known images (--images)
+                        -> 200 compressed full image otherwise
+  GET /release          -> release id and size (plain text, for people)
+
+Patches are made with ./gaia_diff the first time a device asks for them,
+signed with the release's private key (--key), and kept in --cache, so a
+fleet on the same image costs one diff. Devices install only patches whose
+header verifies against the public key built into them (OTA_SIGNING_KEY).
+The release is --release, or the newest .bin in --images. Images can be
+added while the server runs; it rescans on each request.
+
+Standard library only:  python3 ota_server.py --key ota_key.pem --images releases/ --port 8070
+"""
+
+import argparse
+import hashlib
+import os
+import subprocess
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+ID_LEN = 32
+
+
+def image_id(data):
+    """Same rule as imageId() in delta_encode.cpp: the appended SHA-256 of an
+    ESP image (magic 0xE9, hash_appended flag at byte 23), else the SHA-256
+    of the whole file."""
+    if len(data) > 24 + ID_LEN and data[0] == 0xE9 and data[23] == 1:
+        digest = hashlib.sha256(data[:-ID_LEN]).digest()
+        if digest == data[-ID_LEN:]:
+            return digest.hex()
+    return hashlib.sha256(data).hexdigest()
+
+
+class Catalog:
+    """Known images by id; ids are cached by (path, size, mtime)."""
+
+    def __init__(self, args):
+        self.args = args
+        # Patches signed with another key are useless: the key is part of the cache name
+        with open(args.key, "rb") as f:
+            self.key_tag = hashlib.sha256(f.read()).hexdigest()[:8]
+        self.ids = {}
+        self.lock = threading.Lock()
+        self.diff_lock = threading.Lock()
+        self.stats = {"checks": 0, "current": 0, "delta": 0, "full": 0, "bytes": 0}
+
+    def scan(self):
+        images = {}
+        for name in sorted(os.listdir(self.args.images)):
+            if not name.endswith(".bin"):
+                continue
+            path = os.path.join(self.args.images, name)
+            st = os.stat(path)
+            key = (path, st.st_size, st.st_mtime)
+            with self.lock:
+                if key not in self.ids:
+                    with open(path, "rb") as f:
+                        self.ids[key] = image_id(f.read())
+                images[self.ids[key]] = (path, st.st_mtime)
+        return images
+
+    def release(self, images):
+        if self.args.release:
+            with open(self.args.release, "rb") as f:
+                return image_id(f.read()), self.args.release
+        if not images:
+            return None, None
+        rid, (path, _) = max(images.items(), key=lambda kv: kv[1][1])
+        return rid, path
+
+    def patch(self, old_path, old_id, new_path, new_id):
+        name = f"{old_id[:16] if old_path else 'full'}-{new_id[:16]}-{self.key_tag}.gdlt"
+        out = os.path.join(self.args.cache, name)
+        with self.diff_lock:
+            if not os.path.exists(out):
+                os.makedirs(self.args.cache, exist_ok=True)
+                t0 = time.monotonic()
+                subprocess.run([self.args.gaia_diff, "--key", self.args.key, old_path or "-", new_path, out + ".tmp"],
+                               check=True, stdout=subprocess.DEVNULL)
+                os.replace(out + ".tmp", out)
+                print(f"[ota] made {name} ({os.path.getsize(out)} B) in {time.monotonic() - t0:.1f} s",
+                      flush=True)
+        with open(out, "rb") as f:
+            return f.read()
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    catalog = None
+
+    def reply(self, status, body=b"", kind="text/plain"):
+        self.send_response(status)
+        self.send_header("Content-Type", kind)
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        c = self.catalog
+        images = c.scan()
+        rid, rpath = c.release(images)
+        if self.path == "/release":
+            if not rid:
+                return self.reply(404, b"no release\n")
+            return self.reply(200, f"{rid} {os.path.getsize(rpath)} {os.path.basename(rpath)}\n".encode())
+
+        parts = self.path.strip("/").split("/")
+        if len(parts) != 2 or parts[0] != "ota" or len(parts[1]) != 2 * ID_LEN:
+            return self.reply(404, b"not found\n")
+        if not rid:
+            return self.reply(503, b"no release\n")
+
+        have = parts[1].lower()
+        c.stats["checks"] += 1
+        if have == rid:
+            c.stats["current"] += 1
+            return self.reply(204)
+
+        old_path = images.get(have, (None,))[0]
+        body = c.patch(old_path, have, rpath, rid)
+        kind = "delta" if old_path else "full"
+        c.stats[kind] += 1
+        c.stats["bytes"] += len(body)
+        print(f"[ota] {self.client_address[0]}: {have[:16]} -> {rid[:16]}, {kind} {len(body)} B", flush=True)
+        self.reply(200, body, "application/octet-stream")
+
+    def log_message(self, fmt, *args):
+        pass   # One line per update above; 204s aren't worth a line
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="0.0.0.0", help="devices connect over the LAN")
+    ap.add_argument("--port", type=int, default=8070)
+    ap.add_argument("--key", required=True, help="release signing key (P-256 private key, PEM)")
+    ap.add_argument("--images", default="releases", help="directory of firmware.bin builds, old and new")
+    ap.add_argument("--release", help="image to roll out (default: newest .bin in --images)")
+    ap.add_argument("--cache", default=os.path.join(here, "cache"), help="generated patches")
+    ap.add_argument("--gaia-diff", default=os.path.join(here, "gaia_diff"))
+    args = ap.parse_args()
+
+    Handler.catalog = Catalog(args)
+    images = Handler.catalog.scan()
+    rid, rpath = Handler.catalog.release(images)
+    print(f"[ota] {len(images)} image(s) in {args.images}; release {rpath} ({rid[:16] if rid else '-'})",
+          flush=True)
+    print(f"[ota] serving http://{args.host}:{args.port}/ota/<image id>", flush=True)
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    s = Handler.catalog.stats
+    print(f"[ota] {s['checks']} checks: {s['current']} up to date, {s['delta']} delta, {s['full']} full, "
+          f"{s['bytes']} B sent", flush=True)
+
+
+if __name__ == "__main__":
+    main()
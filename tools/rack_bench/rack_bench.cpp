@@ -0,0 +1,198 @@
+// ==========================================
+// GAIA RACK SCALING BENCHMARK (host tool)
+// ==========================================
+// What one sensor-task cycle costs as the rack grows from 1 to 32 plants.
+// Each cycle runs the firmware's own code in the order the tasks do:
+//   read   - rackSetReadings(): the tick's RackSample transposed into the
+//            struct-of-arrays PlantRack (plant_rack.cpp)
+//   faces  - FaceClassifier::evaluate() over the whole rack (face_rules.cpp)
+//   json   - the multi-path PATCH body of the tick, every field of every
+//            plant, written as RtdbRest does it: a counting pass for
+//            Content-Length, then through a 1 KB buffer (telemetry_json.cpp)
+// Sensor I/O is not included; it is the same per plant whatever the count.
+//
+// The firmware stops at MAX_PLANTS 8 (ADC1 channels), so this tool builds
+// with -DMAX_PLANTS=32 and only links the files that don't care.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include "face_rules.h"
+#include "gaia_config.h"
+#include "plant_rack.h"
+#include "telemetry_json.h"
+
+#define BENCH_MAX_PLANTS 32
+#define RING_SAMPLES     4096     // One compressed day of ticks, replayed
+#define TICK_MS          SAMPLE_PERIOD_MS
+#define BODY_BUFFER      1024     // RTDB_TX_BUFFER in rtdb_rest.h
+
+#if MAX_PLANTS < BENCH_MAX_PLANTS
+#error "Build with -DMAX_PLANTS=32 (see the Makefile)"
+#endif
+
+struct Options {
+  uint32_t cycles  = 20000;
+  uint8_t  plants  = BENCH_MAX_PLANTS;
+  uint8_t  repeats = 5;
+};
+
+static RackSample   ring[RING_SAMPLES];
+static PlantConfig  plants[BENCH_MAX_PLANTS];
+static char         ids[BENCH_MAX_PLANTS][12];
+static volatile size_t sink;   // Keeps the serializer's output alive
+
+static double nowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// A day per plant, each shifted so faces change at different ticks: air
+// temperature and light follow the sun, the pot dries out and is watered
+static void buildRing() {
+  for (uint32_t i = 0; i < RING_SAMPLES; i++) {
+    RackSample &s = ring[i];
+    s.count = BENCH_MAX_PLANTS;
+    for (uint8_t p = 0; p < BENCH_MAX_PLANTS; p++) {
+      double day = (double)i / RING_SAMPLES + p / (double)BENCH_MAX_PLANTS;
+      double sun = sin(2 * M_PI * day);
+      Telemetry &t   = s.plant[p];
+      t.temperature  = (float)(22.0 + 10.0 * sun + 0.1 * (i % 7));
+      t.humidity     = (float)(55.0 - 28.0 * sun);
+      t.soilMoisture = 90 - (int)(70.0 * fmod(day * 2, 1.0));
+      t.soilRaw      = 3200 - t.soilMoisture * 16;
+      t.lux          = (float)(sun > 0 ? 2500.0 * sun : 0.0);
+      t.timestamp    = i * TICK_MS;
+    }
+  }
+  for (uint8_t p = 0; p < BENCH_MAX_PLANTS; p++) {
+    snprintf(ids[p], sizeof(ids[p]), "gaia_%02u", p + 1);
+    plants[p] = PlantConfig{ ids[p], 0, NO_PIN, NO_PIN };
+  }
+}
+
+static bool drainToSink(void *, const char *, size_t len) {
+  sink += len;
+  return true;
+}
+
+// writeTelemetryBody() in hal_esp32.cpp, every field
+static void writeBody(JsonOut &out, const RackSample &s, uint8_t n) {
+  char prefix[40];
+  out.beginObject();
+  for (uint8_t p = 0; p < n; p++) {
+    snprintf(prefix, sizeof(prefix), "%s/", plants[p].id);
+    jsonTelemetry(out, prefix, s.plant[p], FIELD_MASK_ALL);
+  }
+  out.endObject();
+}
+
+static size_t serialize(const RackSample &s, uint8_t n) {
+  JsonOut count(NULL, 0);
+  writeBody(count, s, n);
+  char buf[BODY_BUFFER];
+  JsonOut out(buf, sizeof(buf), drainToSink, NULL);
+  writeBody(out, s, n);
+  out.finish();
+  return count.total();
+}
+
+struct StageNs {
+  double read, faces, json;
+};
+
+static RackSample tickOf(uint32_t i, uint8_t n) {
+  RackSample s = ring[i % RING_SAMPLES];
+  s.count = n;
+  return s;
+}
+
+// Each stage on its own loop so timer overhead stays out of the numbers;
+// faces = (read + faces) - read
+static StageNs runOnce(const Options &o, uint8_t n, uint32_t &transitions, size_t &bodyBytes) {
+  static RackSample ticks[RING_SAMPLES];
+  for (uint32_t i = 0; i < RING_SAMPLES; i++) ticks[i] = tickOf(i, n);
+
+  ThresholdSet th;
+  for (uint8_t p = 0; p < MAX_PLANTS; p++) th.plant[p] = PLANT_THRESHOLDS_DEFAULT;
+  PlantRack rack = {};
+  rackSetThresholds(rack, th);
+
+  StageNs r;
+  double t0 = nowNs();
+  for (uint32_t i = 0; i < o.cycles; i++) rackSetReadings(rack, ticks[i % RING_SAMPLES]);
+  r.read = (nowNs() - t0) / o.cycles;
+
+  FaceClassifier faces;
+  t0 = nowNs();
+  for (uint32_t i = 0; i < o.cycles; i++) {
+    rackSetReadings(rack, ticks[i % RING_SAMPLES]);
+    faces.evaluate(rack, (unsigned long)i * TICK_MS);
+  }
+  r.faces = std::max(0.0, (nowNs() - t0) / o.cycles - r.read);
+  transitions = faces.stats.transitions;
+
+  t0 = nowNs();
+  for (uint32_t i = 0; i < o.cycles; i++) bodyBytes = serialize(ticks[i % RING_SAMPLES], n);
+  r.json = (nowNs() - t0) / o.cycles;
+  return r;
+}
+
+static double median(double *v, uint8_t n) {
+  std::sort(v, v + n);
+  return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: rack_bench [--cycles N] [--plants K] [--repeats R]\n"
+    "  --cycles N   sensor ticks per run (default 20000)\n"
+    "  --plants K   largest rack, 1-%d (default %d)\n"
+    "  --repeats R  runs per rack size, median reported (default 5)\n",
+    BENCH_MAX_PLANTS, BENCH_MAX_PLANTS);
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+    if      (!strcmp(a, "--cycles") && v)  { o.cycles  = strtoul(v, NULL, 10); i++; }
+    else if (!strcmp(a, "--plants") && v)  { o.plants  = (uint8_t)atoi(v); i++; }
+    else if (!strcmp(a, "--repeats") && v) { o.repeats = (uint8_t)atoi(v); i++; }
+    else { usage(); return 2; }
+  }
+  if (o.cycles == 0 || o.plants < 1 || o.plants > BENCH_MAX_PLANTS || o.repeats < 1 || o.repeats > 31) {
+    usage();
+    return 2;
+  }
+
+  buildRing();
+  printf("# %lu ticks per run, median of %u runs, MAX_PLANTS %d, sizeof(PlantRack) %zu B\n",
+    (unsigned long)o.cycles, o.repeats, MAX_PLANTS, sizeof(PlantRack));
+  printf("plants  read ns  faces ns  json ns  cycle ns  ns/plant  vs 1  body B  faces/1k\n");
+
+  double base = 0;
+  for (uint8_t n = 1; n <= o.plants; n++) {
+    double read[32], faces[32], json[32];
+    uint32_t transitions = 0;
+    size_t   body = 0;
+    for (uint8_t r = 0; r < o.repeats; r++) {
+      StageNs s = runOnce(o, n, transitions, body);
+      read[r] = s.read;
+      faces[r] = s.faces;
+      json[r] = s.json;
+    }
+    double rd = median(read, o.repeats), fc = median(faces, o.repeats), js = median(json, o.repeats);
+    double cycle = rd + fc + js;
+    if (n == 1) base = cycle;
+    printf("%6u  %7.0f  %8.0f  %7.0f  %8.0f  %8.0f  %4.1f  %6zu  %8.2f\n",
+      n, rd, fc, js, cycle, cycle / n, cycle / base, body, transitions * 1000.0 / o.cycles);
+  }
+  return 0;
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Local stand-in for an MQTT 3.1.1 broker.
+
+Implements the subset the firmware and the benchmark use:
+
+  CONNECT     -> CONNACK (every client accepted; user/password ignored)
+  PUBLISH     -> routed to matching subscriptions ('+' and '#' filters);
+                 QoS 1 answered with PUBACK; retain flag stores the message
+                 (an empty retained payload clears it)
+  SUBSCRIBE   -> SUBACK (granted QoS capped at 1), then the retained
+                 messages that match, as a real broker does
+  PINGREQ     -> PINGRESP
+  DISCONNECT  -> close
+
+Packets are handled in arrival order per connection, so a PINGRESP comes
+after every answer to what was sent before the PINGREQ. Sessions are
+always clean (no queued messages across reconnects). --latency-ms adds a
+delay (uniform 0..2x the mean) before each answer, --retain seeds retained
+messages (e.g. a plant's thresholds) and --tls-cert/--tls-key serve
+MQTT over TLS 1.2, like a broker's 8883 port.
+
+Standard library only:  python3 mqtt_standin.py --port 1883
+"""
+
+import argparse
+import asyncio
+import random
+import signal
+import ssl
+import struct
+import time
+
+CONNECT, CONNACK, PUBLISH, PUBACK, SUBSCRIBE, SUBACK = 1, 2, 3, 4, 8, 9
+PINGREQ, PINGRESP, DISCONNECT = 12, 13, 14
+NAMES = {CONNECT: "CONNECT", PUBLISH: "PUBLISH", PUBACK: "PUBACK", SUBSCRIBE: "SUBSCRIBE", PINGREQ: "PINGREQ",
+         DISCONNECT: "DISCONNECT"}
+
+
+def encode_length(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        out.append(b | 0x80 if n else b)
+        if not n:
+            return bytes(out)
+
+
+def packet(header, body=b""):
+    return bytes([header]) + encode_length(len(body)) + body
+
+
+def utf8(s):
+    data = s.encode()
+    return struct.pack("!H", len(data)) + data
+
+
+def matches(filt, topic):
+    f, t = filt.split("/"), topic.split("/")
+    for i, part in enumerate(f):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+class Stats:
+    def __init__(self):
+        self.start = time.monotonic()
+        self.packets = {}
+        self.bytes_in = 0
+        self.bytes_out = 0
+        self.connections = 0
+        self.open = 0
+        self.delivered = 0
+        self.tls_full = 0
+        self.tls_resumed = 0
+
+    def report(self):
+        secs = max(time.monotonic() - self.start, 1e-9)
+        kinds = " ".join(f"{NAMES.get(k, k)}={n}" for k, n in sorted(self.packets.items()))
+        pubs = self.packets.get(PUBLISH, 0)
+        print(f"[broker] {secs:.0f} s | {pubs} publishes ({pubs / secs:.0f}/s) {kinds} | "
+              f"delivered {self.delivered} | in {self.bytes_in} B, out {self.bytes_out} B | "
+              f"conns {self.connections} ({self.open} open)"
+              + (f" | TLS full {self.tls_full}, resumed {self.tls_resumed}" if self.tls_full + self.tls_resumed else ""),
+              flush=True)
+
+
+class Client:
+    def __init__(self, writer):
+        self.writer = writer
+        self.subs = {}          # filter -> granted QoS
+        self.next_id = 0
+
+    def packet_id(self):
+        self.next_id = self.next_id % 0xFFFF + 1
+        return self.next_id
+
+
+class Broker:
+    def __init__(self, args):
+        self.stats = Stats()
+        self.clients = set()
+        self.retained = {}
+        self.latency = args.latency_ms / 1000.0
+        self.rng = random.Random(args.seed)
+        for item in args.retain:
+            topic, _, payload = item.partition("=")
+            self.retained[topic] = payload.encode()
+
+    def send(self, client, data):
+        client.writer.write(data)
+        self.stats.bytes_out += len(data)
+
+    def deliver(self, client, topic, payload, qos, retain):
+        header = (PUBLISH << 4) | (0x02 if qos else 0) | (0x01 if retain else 0)
+        body = utf8(topic) + (struct.pack("!H", client.packet_id()) if qos else b"") + payload
+        self.send(client, packet(header, body))
+        self.stats.delivered += 1
+
+    async def read_packet(self, reader):
+        header = (await reader.readexactly(1))[0]
+        length, shift, n = 0, 0, 1
+        while True:
+            b = (await reader.readexactly(1))[0]
+            length |= (b & 0x7F) << shift
+            shift += 7
+            n += 1
+            if not b & 0x80:
+                break
+            if shift > 21:
+                raise ValueError("bad remaining length")
+        body = await reader.readexactly(length) if length else b""
+        self.stats.bytes_in += n + length
+        return header, body
+
+    async def handle(self, reader, writer):
+        self.stats.connections += 1
+        self.stats.open += 1
+        tls = writer.get_extra_info("ssl_object")
+        if tls is not None:
+            if tls.session_reused:
+                self.stats.tls_resumed += 1
+            else:
+                self.stats.tls_full += 1
+        client = Client(writer)
+        try:
+            header, _ = await self.read_packet(reader)
+            if header >> 4 != CONNECT:
+                return
+            self.stats.packets[CONNECT] = self.stats.packets.get(CONNECT, 0) + 1
+            self.clients.add(client)
+            self.send(client, packet(CONNACK << 4, b"\x00\x00"))
+            await writer.drain()
+            while True:
+                header, body = await self.read_packet(reader)
+                kind = header >> 4
+                self.stats.packets[kind] = self.stats.packets.get(kind, 0) + 1
+                if kind == DISCONNECT:
+                    break
+                if self.latency and kind != PUBACK:
+                    await asyncio.sleep(self.rng.uniform(0, 2 * self.latency))
+                self.dispatch(client, header, body)
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError, ValueError):
+            pass
+        finally:
+            self.clients.discard(client)
+            self.stats.open -= 1
+            writer.close()
+
+    def dispatch(self, client, header, body):
+        kind = header >> 4
+        if kind == PUBLISH:
+            qos, retain = (header >> 1) & 0x03, header & 0x01
+            (tlen,) = struct.unpack_from("!H", body)
+            topic = body[2:2 + tlen].decode()
+            pos = 2 + tlen
+            if qos:
+                packet_id = body[pos:pos + 2]
+                pos += 2
+            payload = body[pos:]
+            if retain:
+                if payload:
+                    self.retained[topic] = payload
+                else:
+                    self.retained.pop(topic, None)
+            for other in self.clients:
+                granted = max((q for f, q in other.subs.items() if matches(f, topic)), default=None)
+                if granted is not None:
+                    self.deliver(other, topic, payload, min(qos, granted), False)
+            if qos:
+                self.send(client, packet(PUBACK << 4, packet_id))
+        elif kind == SUBSCRIBE:
+            packet_id, pos, codes, filters = body[:2], 2, bytearray(), []
+            while pos < len(body):
+                (flen,) = struct.unpack_from("!H", body, pos)
+                filt = body[pos + 2:pos + 2 + flen].decode()
+                qos = min(body[pos + 2 + flen], 1)
+                pos += 3 + flen
+                client.subs[filt] = qos
+                codes.append(qos)
+                filters.append((filt, qos))
+            self.send(client, packet((SUBACK << 4), packet_id + bytes(codes)))
+            for filt, qos in filters:
+                for topic, payload in self.retained.items():
+                    if matches(filt, topic):
+                        self.deliver(client, topic, payload, qos, True)
+        elif kind == PINGREQ:
+            self.send(client, packet(PINGRESP << 4))
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--latency-ms", type=float, default=0.0, help="mean added delay before each answer")
+    ap.add_argument("--retain", action="append", default=[], metavar="TOPIC=PAYLOAD",
+                    help="seed a retained message (repeatable)")
+    ap.add_argument("--report-s", type=float, default=10.0, help="stats interval (0 = only on exit)")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--tls-cert", help="PEM certificate: serve MQTT over TLS")
+    ap.add_argument("--tls-key", help="PEM private key for --tls-cert")
+    args = ap.parse_args()
+
+    tls = None
+    if args.tls_cert:
+        tls = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        tls.maximum_version = ssl.TLSVersion.TLSv1_2   # What the ESP32 negotiates
+        tls.load_cert_chain(args.tls_cert, args.tls_key)
+
+    broker = Broker(args)
+    srv = await asyncio.start_server(broker.handle, args.host, args.port, ssl=tls)
+    scheme = "mqtts" if tls else "mqtt"
+    print(f"[broker] MQTT stand-in on {scheme}://{args.host}:{args.port}", flush=True)
+
+    stop = asyncio.Event()
+    loop = asyncio.get_running_loop()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        loop.add_signal_handler(sig, stop.set)
+
+    async with srv:
+        while not stop.is_set():
+            try:
+                await asyncio.wait_for(stop.wait(), timeout=args.report_s or None)
+            except asyncio.TimeoutError:
+                broker.stats.report()
+    broker.stats.report()
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
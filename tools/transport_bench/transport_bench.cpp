@@ -0,0 +1,523 @@
+// ==========================================
+// GAIA TRANSPORT BENCHMARK (host tool)
+// ==========================================
+// One simulated Gaia uploading the same sample stream through each cloud
+// backend in turn, against local stand-ins:
+//   rtdb   - one multi-path PATCH /plants.json?print=silent&auth=<token> per
+//            sample, written exactly as RtdbRest::sendRequest() does
+//            (1 KB write buffer, counting pass for Content-Length), and
+//            its 204 answer. Server: ../fleet_sim/rtdb_standin.py
+//   mqtt0  - one PUBLISH per plant to gaia/<id>/telemetry with the CBOR
+//            payload, QoS 0: MqttCloud::uploadTelemetry()
+//   mqtt1  - the same at QoS 1, waiting for every PUBACK
+//            Server: mqtt_standin.py
+// The packets come from the firmware's own code (mqtt_packet.cpp,
+// telemetry_json.cpp) and the fields from its DeltaFilter, so both
+// backends carry the same changes. Before the first sample, each backend
+// does the boot-time threshold sync for every plant (a GET per plant; a
+// SUBSCRIBE answered with the retained message, then a ping).
+//
+// Per sample it measures the bytes both ways, the time until the upload is
+// acknowledged (nothing to wait for at QoS 0) and the thread CPU time spent
+// serializing, sending and reading answers. The transport is plain TCP:
+// the TLS cost is estimated from the records each write and answer take.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "delta_filter.h"
+#include "gaia_config.h"   // DELTA_CONFIG: the firmware's deadbands
+#include "mqtt_packet.h"
+#include "telemetry_json.h"
+
+#define MAX_PLANTS_PER_DEVICE 8
+#define RTDB_TX_BUFFER        1024   // As rtdb_rest.h
+#define MQTT_TX_BUFFER        512    // As mqtt_client.h
+#define TLS_RECORD_OVERHEAD   29     // TLS 1.2 AES-GCM: 5 B header + 8 B nonce + 16 B tag
+
+enum Backend { BACKEND_RTDB = 0, BACKEND_MQTT0, BACKEND_MQTT1, BACKEND_COUNT };
+static const char *const BACKEND_NAMES[BACKEND_COUNT] = { "rtdb", "mqtt0", "mqtt1" };
+
+struct Options {
+  const char *rtdbHost   = "127.0.0.1";
+  int         rtdbPort   = 8787;
+  const char *mqttHost   = "127.0.0.1";
+  int         mqttPort   = 1883;
+  int         samples    = 600;
+  int         plants     = 1;
+  int         periodMs   = 5;       // Wall-clock pause between samples
+  int         authBytes  = 1000;    // Firebase ID tokens are ~1000 characters
+  bool        full       = false;   // Every field every sample (no delta filter)
+  bool        backends[BACKEND_COUNT] = { true, true, true };
+  uint32_t    seed       = 1;
+};
+
+static Options opt;
+static std::string authToken;
+
+static uint64_t clockUs(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ================= SIMULATED SENSORS (as fleet_sim) =================
+struct Rng {
+  uint64_t s;
+  uint32_t next() { s ^= s << 13; s ^= s >> 7; s ^= s << 17; return (uint32_t)s; }
+  float    uniform() { return (next() >> 8) / 16777216.0f; }               // [0, 1)
+  float    noise(float amp) { return (uniform() * 2 - 1) * amp; }
+};
+
+struct PlantSim {
+  float temp, humid, soil, lux;
+
+  void init(Rng &r) {
+    temp  = 20 + r.uniform() * 6;
+    humid = 45 + r.uniform() * 20;
+    soil  = 40 + r.uniform() * 40;
+    lux   = 100 + r.uniform() * 900;
+  }
+
+  Telemetry sample(Rng &r, unsigned long nowMs) {
+    temp  += r.noise(0.02f);
+    humid += r.noise(0.1f);
+    soil  -= 0.001f;
+    lux    = max(0.0f, lux * (1 + r.noise(0.01f)));
+    Telemetry t;
+    t.temperature  = temp + r.noise(0.15f);
+    t.humidity     = humid + r.noise(0.8f);
+    t.soilMoisture = (int)lroundf(std::clamp(soil + r.noise(0.6f), 0.0f, 100.0f));
+    t.soilRaw      = 3500 - (int)(t.soilMoisture * 23) + (int)r.noise(25);
+    t.lux          = lux;
+    t.timestamp    = nowMs;
+    return t;
+  }
+};
+
+static char plantIds[MAX_PLANTS_PER_DEVICE][16];
+
+// ================= CONNECTION =================
+// Blocking socket with byte and record accounting
+struct Conn {
+  int      fd = -1;
+  uint64_t txBytes = 0, rxBytes = 0;
+  uint64_t txRecords = 0, rxRecords = 0;   // Writes / answers: one TLS record each
+  char     buf[4096];
+  size_t   pos = 0, len = 0;
+
+  bool open(const char *host, int port) {
+    addrinfo hints = {}, *res = NULL;
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &res) != 0 || !res) return false;
+    fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    bool ok = fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+    freeaddrinfo(res);
+    if (!ok) return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // As the firmware's sockets
+    timeval tv = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return true;
+  }
+
+  void close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+  }
+
+  static bool drain(void *ctx, const char *data, size_t n) {
+    Conn &c = *(Conn *)ctx;
+    c.txBytes += n;
+    c.txRecords++;
+    while (n > 0) {
+      ssize_t k = send(c.fd, data, n, MSG_NOSIGNAL);
+      if (k <= 0) return false;
+      data += k;
+      n    -= k;
+    }
+    return true;
+  }
+
+  bool fill() {
+    ssize_t k = recv(fd, buf, sizeof(buf), 0);
+    if (k <= 0) return false;
+    pos = 0;
+    len = k;
+    rxBytes += k;
+    return true;
+  }
+
+  bool read(void *out, size_t n) {
+    uint8_t *dst = (uint8_t *)out;
+    while (n > 0) {
+      if (pos == len && !fill()) return false;
+      size_t k = std::min(n, len - pos);
+      if (dst) {
+        memcpy(dst, buf + pos, k);
+        dst += k;
+      }
+      pos += k;
+      n   -= k;
+    }
+    return true;
+  }
+
+  bool readLine(std::string &line) {
+    line.clear();
+    for (;;) {
+      char c;
+      if (!read(&c, 1)) return false;
+      if (c == '\n') return true;
+      if (c != '\r') line += c;
+    }
+  }
+};
+
+// ================= RTDB =================
+struct TelemetryBody {
+  const Telemetry *samples;
+  const uint8_t   *masks;
+  int              n;
+};
+
+static void writeTelemetryBody(JsonOut &out, const void *ctx) {
+  const TelemetryBody &b = *(const TelemetryBody *)ctx;
+  char prefix[40];
+  out.beginObject();
+  for (int p = 0; p < b.n; p++) {
+    if (!b.masks[p]) continue;
+    snprintf(prefix, sizeof(prefix), "%s/", plantIds[p]);
+    jsonTelemetry(out, prefix, b.samples[p], b.masks[p]);
+  }
+  out.endObject();
+}
+
+typedef void (*BodyWriter)(JsonOut &out, const void *ctx);
+
+// RtdbRest::sendRequest()
+static bool rtdbSend(Conn &c, const char *method, const char *path, BodyWriter body, const void *ctx) {
+  size_t length = 0;
+  if (body) {
+    JsonOut count(NULL, 0);
+    body(count, ctx);
+    length = count.total();
+  }
+  char tx[RTDB_TX_BUFFER];
+  JsonOut out(tx, sizeof(tx), Conn::drain, &c);
+  out.put(method);
+  out.put(" ");
+  out.put(path);
+  out.put(body ? ".json?print=silent&auth=" : ".json?auth=");
+  out.put(authToken.c_str());
+  out.put(" HTTP/1.1\r\nHost: ");
+  out.put(opt.rtdbHost);
+  out.put("\r\nConnection: keep-alive\r\n");
+  if (body) {
+    out.put("Content-Type: application/json\r\nContent-Length: ");
+    out.uinteger(length);
+    out.put("\r\n");
+  }
+  out.put("\r\n");
+  if (body) body(out, ctx);
+  return out.finish();
+}
+
+// Status line, headers, body; returns the status (0 = no answer)
+static int rtdbRead(Conn &c) {
+  std::string line;
+  int code = 0;
+  if (!c.readLine(line) || sscanf(line.c_str(), "HTTP/1.%*d %d", &code) != 1) return 0;
+  size_t contentLength = 0;
+  for (;;) {
+    if (!c.readLine(line)) return 0;
+    if (line.empty()) break;
+    if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) contentLength = strtoul(line.c_str() + 15, NULL, 10);
+  }
+  if (!c.read(NULL, contentLength)) return 0;
+  c.rxRecords++;
+  return code;
+}
+
+// ================= MQTT =================
+struct CborBody {
+  const uint8_t *data;
+  size_t         len;
+};
+
+static void writeCborBody(JsonOut &out, const void *ctx) {
+  const CborBody &b = *(const CborBody *)ctx;
+  out.put((const char *)b.data, b.len);
+}
+
+static uint16_t mqttPacketId = 0;
+
+// MqttClient::publish()
+static bool mqttPublish(Conn &c, const char *topic, BodyWriter body, const void *ctx, uint8_t qos) {
+  JsonOut count(NULL, 0);
+  body(count, ctx);
+  char tx[MQTT_TX_BUFFER];
+  JsonOut out(tx, sizeof(tx), Conn::drain, &c);
+  uint16_t id = 0;
+  if (qos && ++mqttPacketId == 0) mqttPacketId = 1;
+  if (qos) id = mqttPacketId;
+  mqttPublishHead(out, topic, count.total(), qos, false, id);
+  body(out, ctx);
+  return out.finish();
+}
+
+static bool mqttWrite(Conn &c, void (*write)(JsonOut &out)) {
+  char tx[16];
+  JsonOut out(tx, sizeof(tx), Conn::drain, &c);
+  write(out);
+  return out.finish();
+}
+
+// Next packet; the body is kept (up to 512 B)
+static bool mqttRead(Conn &c, uint8_t &header, std::vector<uint8_t> &body) {
+  uint8_t  b;
+  uint32_t len = 0;
+  uint8_t  n = 0;
+  int      r;
+  if (!c.read(&header, 1)) return false;
+  do {
+    if (!c.read(&b, 1)) return false;
+    r = mqttLengthByte(b, len, n);
+  } while (r == 0);
+  if (r < 0) return false;
+  body.resize(len);
+  c.rxRecords++;
+  return c.read(body.data(), len);
+}
+
+// Read until a packet of `type` arrives (retained messages and acks on the way)
+static bool mqttAwait(Conn &c, uint8_t type, uint32_t *received = NULL) {
+  uint8_t header;
+  std::vector<uint8_t> body;
+  while (mqttRead(c, header, body)) {
+    if (MQTT_TYPE(header) == MQTT_PUBLISH && received) (*received)++;
+    if (MQTT_TYPE(header) == type) return true;
+  }
+  return false;
+}
+
+// ================= RUN =================
+struct Result {
+  int      uploads = 0, messages = 0, errors = 0;
+  uint64_t setupBytes = 0, setupRecords = 0;
+  uint64_t txBytes = 0, rxBytes = 0, records = 0;
+  uint64_t cpuUs = 0;
+  std::vector<double> ackMs;
+  bool     connected = false;
+};
+
+static void runBackend(Backend backend, Result &res) {
+  Conn c;
+  bool mqtt = backend != BACKEND_RTDB;
+  if (!c.open(mqtt ? opt.mqttHost : opt.rtdbHost, mqtt ? opt.mqttPort : opt.rtdbPort)) {
+    fprintf(stderr, "%s: can't connect to %s:%d\n", BACKEND_NAMES[backend],
+            mqtt ? opt.mqttHost : opt.rtdbHost, mqtt ? opt.mqttPort : opt.rtdbPort);
+    return;
+  }
+  res.connected = true;
+
+  // Boot-time sync: threshold reads for the whole rack
+  char topic[160];
+  if (mqtt) {
+    char tx[256];
+    JsonOut out(tx, sizeof(tx), Conn::drain, &c);
+    mqttConnect(out, plantIds[0], "", "", 60);
+    out.finish();
+    if (!mqttAwait(c, MQTT_CONNACK)) res.errors++;
+    char        topics[MAX_PLANTS_PER_DEVICE][48];
+    const char *filters[MAX_PLANTS_PER_DEVICE];
+    for (int p = 0; p < opt.plants; p++) {
+      snprintf(topics[p], sizeof(topics[p]), "gaia/%s/thresholds", plantIds[p]);
+      filters[p] = topics[p];
+      JsonOut sub(tx, sizeof(tx), Conn::drain, &c);
+      mqttSubscribe(sub, ++mqttPacketId, &filters[p], 1, 1);
+      sub.finish();
+    }
+    mqttWrite(c, mqttPingreq);
+    if (!mqttAwait(c, MQTT_PINGRESP)) res.errors++;
+  } else {
+    for (int p = 0; p < opt.plants; p++) {
+      snprintf(topic, sizeof(topic), "/plants/%s/thresholds", plantIds[p]);
+      rtdbSend(c, "GET", topic, NULL, NULL);
+    }
+    for (int p = 0; p < opt.plants; p++) {
+      if (rtdbRead(c) != 200) res.errors++;
+    }
+  }
+  res.setupBytes   = c.txBytes + c.rxBytes;
+  res.setupRecords = c.txRecords + c.rxRecords;
+  c.txBytes = c.rxBytes = c.txRecords = c.rxRecords = 0;
+
+  // The same sensor stream for every backend
+  Rng         rng = { opt.seed * 0x9E3779B97F4A7C15ull | 1 };
+  PlantSim    sim[MAX_PLANTS_PER_DEVICE];
+  DeltaFilter filters[MAX_PLANTS_PER_DEVICE];
+  for (int p = 0; p < opt.plants; p++) {
+    sim[p].init(rng);
+    filters[p] = DeltaFilter(DELTA_CONFIG);
+  }
+
+  Telemetry samples[MAX_PLANTS_PER_DEVICE];
+  uint8_t   masks[MAX_PLANTS_PER_DEVICE];
+  for (int i = 0; i < opt.samples; i++) {
+    unsigned long nowMs = 1000UL * i;   // 1 Hz sampling, in simulated time
+    bool any = false;
+    for (int p = 0; p < opt.plants; p++) {
+      samples[p] = sim[p].sample(rng, nowMs);
+      masks[p]   = opt.full ? FIELD_MASK_ALL : filters[p].changedFields(samples[p], nowMs);
+      any |= masks[p] != 0;
+    }
+
+    uint64_t wall0 = clockUs(CLOCK_MONOTONIC);
+    uint64_t cpu0  = clockUs(CLOCK_THREAD_CPUTIME_ID);
+    bool ok = true;
+    if (any && backend == BACKEND_RTDB) {
+      TelemetryBody body = { samples, masks, opt.plants };
+      ok = rtdbSend(c, "PATCH", "/plants", writeTelemetryBody, &body) && rtdbRead(c) / 100 == 2;
+      res.messages++;
+    } else if (any) {
+      uint8_t qos = backend == BACKEND_MQTT1;
+      int     sent = 0;
+      for (int p = 0; p < opt.plants && ok; p++) {
+        if (!masks[p]) continue;
+        uint8_t cbor[TELEMETRY_CBOR_MAX];
+        snprintf(topic, sizeof(topic), "gaia/%s/telemetry", plantIds[p]);
+        CborBody body = { cbor, cborTelemetry(samples[p], masks[p], cbor, sizeof(cbor)) };
+        ok = mqttPublish(c, topic, writeCborBody, &body, qos);
+        sent++;
+      }
+      for (int k = 0; qos && ok && k < sent; k++) ok = mqttAwait(c, MQTT_PUBACK);
+      res.messages += sent;
+    }
+    res.cpuUs += clockUs(CLOCK_THREAD_CPUTIME_ID) - cpu0;
+    if (any) {
+      res.uploads++;
+      if (backend != BACKEND_MQTT0) res.ackMs.push_back((clockUs(CLOCK_MONOTONIC) - wall0) / 1000.0);
+    }
+    if (!ok) {
+      res.errors++;
+      break;
+    }
+    for (int p = 0; p < opt.plants; p++) {
+      if (masks[p]) filters[p].commit(samples[p], masks[p], nowMs);
+    }
+    if (opt.periodMs) usleep(opt.periodMs * 1000);
+  }
+
+  // QoS 0 got no answers: make sure the broker has taken every message
+  // (not counted per sample)
+  res.txBytes = c.txBytes;
+  res.rxBytes = c.rxBytes;
+  res.records = c.txRecords + c.rxRecords;
+  if (backend == BACKEND_MQTT0) {
+    mqttWrite(c, mqttPingreq);
+    if (!mqttAwait(c, MQTT_PINGRESP)) res.errors++;
+  }
+  if (mqtt) mqttWrite(c, mqttDisconnect);
+  c.close();
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: transport_bench [--backends LIST] [--samples N] [--plants K] [--period-ms MS]\n"
+    "                       [--auth-bytes N] [--full] [--rtdb HOST:PORT] [--mqtt HOST:PORT] [--seed N]\n"
+    "backends: rtdb, mqtt0, mqtt1 (comma-separated)\n");
+  exit(2);
+}
+
+static void parseHostPort(const char *v, const char *&host, int &port) {
+  static std::string hosts[2];
+  static int used = 0;
+  std::string s(v);
+  size_t colon = s.rfind(':');
+  if (colon == std::string::npos) usage();
+  hosts[used] = s.substr(0, colon);
+  host = hosts[used++].c_str();
+  port = atoi(s.c_str() + colon + 1);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (!strcmp(a, "--full")) {
+      opt.full = true;
+      continue;
+    }
+    if (i + 1 >= argc) usage();
+    const char *v = argv[++i];
+    if      (!strcmp(a, "--samples"))    opt.samples   = atoi(v);
+    else if (!strcmp(a, "--plants"))     opt.plants    = atoi(v);
+    else if (!strcmp(a, "--period-ms"))  opt.periodMs  = atoi(v);
+    else if (!strcmp(a, "--auth-bytes")) opt.authBytes = atoi(v);
+    else if (!strcmp(a, "--seed"))       opt.seed      = (uint32_t)atoi(v);
+    else if (!strcmp(a, "--rtdb"))       parseHostPort(v, opt.rtdbHost, opt.rtdbPort);
+    else if (!strcmp(a, "--mqtt"))       parseHostPort(v, opt.mqttHost, opt.mqttPort);
+    else if (!strcmp(a, "--backends")) {
+      std::fill(opt.backends, opt.backends + BACKEND_COUNT, false);
+      std::string list(v);
+      size_t start = 0;
+      while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string name = list.substr(start, end - start);
+        int b = 0;
+        while (b < BACKEND_COUNT && name != BACKEND_NAMES[b]) b++;
+        if (b == BACKEND_COUNT) usage();
+        opt.backends[b] = true;
+        start = end + 1;
+      }
+    } else usage();
+  }
+  if (opt.samples < 1 || opt.plants < 1 || opt.plants > MAX_PLANTS_PER_DEVICE || opt.authBytes < 0) usage();
+
+  authToken.assign(opt.authBytes, 'x');
+  for (int p = 0; p < opt.plants; p++) snprintf(plantIds[p], sizeof(plantIds[p]), "gaia_%02d", p + 1);
+
+  printf("# %d samples x %d plant(s), %s, auth token %d B, TLS estimated at %d B per record\n",
+         opt.samples, opt.plants, opt.full ? "every field" : "delta uploads", opt.authBytes, TLS_RECORD_OVERHEAD);
+  printf("backend  uploads  msgs  setup B  tx B/smp  rx B/smp  +TLS  B/smp  vs rtdb  ack p50 ms  p99 ms  cpu us/smp  errors\n");
+
+  double rtdbBytes = 0;
+  for (int b = 0; b < BACKEND_COUNT; b++) {
+    if (!opt.backends[b]) continue;
+    Result r;
+    runBackend((Backend)b, r);
+    if (!r.connected) continue;
+
+    double n     = opt.samples;
+    double tls   = (double)r.records * TLS_RECORD_OVERHEAD / n;
+    double total = (r.txBytes + r.rxBytes) / n + tls;
+    if (b == BACKEND_RTDB) rtdbBytes = total;
+    std::sort(r.ackMs.begin(), r.ackMs.end());
+    auto pct = [&](double q) { return r.ackMs[(size_t)(q * (r.ackMs.size() - 1))]; };
+
+    char ratio[16] = "-", p50[16] = "-", p99[16] = "-";
+    if (rtdbBytes > 0) snprintf(ratio, sizeof(ratio), "%.3f", total / rtdbBytes);
+    if (!r.ackMs.empty()) {
+      snprintf(p50, sizeof(p50), "%.3f", pct(0.50));
+      snprintf(p99, sizeof(p99), "%.3f", pct(0.99));
+    }
+    printf("%-7s  %7d  %4d  %7llu  %8.1f  %8.1f  %4.0f  %5.0f  %7s  %10s  %6s  %10.2f  %6d\n",
+           BACKEND_NAMES[b], r.uploads, r.messages,
+           (unsigned long long)(r.setupBytes + r.setupRecords * TLS_RECORD_OVERHEAD),
+           r.txBytes / n, r.rxBytes / n, tls, total, ratio, p50, p99, r.cpuUs / n, r.errors);
+    fflush(stdout);
+  }
+  return 0;
+}